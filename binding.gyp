@@ -13,7 +13,27 @@
             "src/c-src/sensor_report_auxialiry_fns.c",
             "src/c-src/error.c",
             "src/c-src/node_c_type_conversions.c",
-            "src/c-src/interrupt.c"
+            "src/c-src/interrupt.c",
+            "src/c-src/poll_timer.c",
+            "src/c-src/decoded_values.c",
+            "src/c-src/latest_table.c",
+            "src/c-src/fanout_ring.c",
+            "src/c-src/report_slab.c",
+            "src/c-src/event_timestamp.c",
+            "src/c-src/clock_sync.c",
+            "src/c-src/girv_ring.c",
+            "src/c-src/q_decode.c",
+            "src/c-src/fast_euler.c",
+            "src/c-src/recorder.c",
+            "src/c-src/log_reader.c",
+            "src/c-src/stream_codec.c",
+            "src/c-src/arrow_writer.c",
+            "src/c-src/history.c",
+            "src/c-src/resampler.c",
+            "src/c-src/stats.c",
+            "src/c-src/allan.c",
+            "src/c-src/spectrum.c",
+            "src/c-src/capture.c"
         ],
         "include_dirs": [
             "src/c-include",
@@ -72,7 +92,26 @@
             "src/c-src/funcs.c",
             "src/c-src/sensor_report_auxialiry_fns.c",
             "src/c-src/error.c",
-            "src/c-src/node_c_type_conversions.c"
+            "src/c-src/node_c_type_conversions.c",
+            "src/c-src/decoded_values.c",
+            "src/c-src/latest_table.c",
+            "src/c-src/fanout_ring.c",
+            "src/c-src/report_slab.c",
+            "src/c-src/event_timestamp.c",
+            "src/c-src/clock_sync.c",
+            "src/c-src/girv_ring.c",
+            "src/c-src/q_decode.c",
+            "src/c-src/fast_euler.c",
+            "src/c-src/recorder.c",
+            "src/c-src/log_reader.c",
+            "src/c-src/stream_codec.c",
+            "src/c-src/arrow_writer.c",
+            "src/c-src/history.c",
+            "src/c-src/resampler.c",
+            "src/c-src/stats.c",
+            "src/c-src/allan.c",
+            "src/c-src/spectrum.c",
+            "src/c-src/capture.c"
         ],
         "include_dirs": [
             "src/c-include/",
@@ -90,5 +129,46 @@
         "dependencies": [
             "sh2"
         ]
+    }, {
+        "target_name": "bench_q_decode",
+        "type": "executable",
+        "sources": [
+            "src/c-tests/bench_q_decode.c",
+            "src/c-src/q_decode.c"
+        ],
+        "include_dirs": [
+            "src/c-include/"
+        ],
+        "cflags": [
+            "-Wall",    # Enable all warnings
+            "-Werror",  # Make them errors
+            "-Wextra",
+            "-pedantic",
+            "-O2"
+        ]
+    }, {
+        "target_name": "bench_euler",
+        "type": "executable",
+        "sources": [
+            "src/c-tests/bench_euler.c",
+            "src/c-src/fast_euler.c"
+        ],
+        "include_dirs": [
+            "src/c-include/",
+            "src/c-src"
+        ],
+        "cflags": [
+            "-Wall",    # Enable all warnings
+            "-Werror",  # Make them errors
+            "-Wextra",
+            "-pedantic",
+            "-O2"
+        ],
+        "libraries": [
+            "-lm"
+        ],
+        "dependencies": [
+            "sh2"
+        ]
     }]
 }
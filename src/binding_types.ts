@@ -39,6 +39,52 @@ export type SensorEvent = {
 
 export type SensorCallback = (event: SensorEvent, cookie: any) => void;
 
+export type SensorCallbackOptions = {
+    /**
+     * How the raw `report` bytes of events are stored.
+     *
+     * - `'buffer'` *(default)* A `Buffer` per event, with its own allocation
+     *   and GC finalizer.
+     * - `'slab'` A `Uint8Array` view into a shared 16 KiB `ArrayBuffer`. A
+     *   new slab is allocated only when the previous one is full, which
+     *   avoids a malloc, free and finalizer per event at high rates. Any
+     *   view kept around keeps its whole slab alive, so copy reports you
+     *   store for long.
+     */
+    report?: 'buffer' | 'slab',
+    /**
+     * How event timestamps are represented.
+     *
+     * - `'bigint'` *(default)* `timestampMicroseconds` is a `bigint` of host
+     *   microseconds.
+     * - `'float64'` `timestampMicroseconds` is a `number` of microseconds
+     *   since the first event after `setSensorCallback(..)`. Add
+     *   `getTimestampEpoch()` for the absolute time. Avoids allocating a
+     *   BigInt per event and converting it in the callback.
+     * - `'hilo'` `timestampMicrosecondsHi` and `timestampMicrosecondsLo`
+     *   hold the upper and lower 32 bits of the `'bigint'` value.
+     */
+    timestamp?: 'bigint' | 'float64' | 'hilo',
+}
+
+/**
+ * `SensorEvent` as delivered with the options `O` of `setSensorCallback(..)`.
+ */
+export type SensorEventOf<O extends SensorCallbackOptions> =
+    Omit<SensorEvent, 'report' | 'timestampMicroseconds'>
+    & (O extends { report: 'slab' } ? { report: Uint8Array }
+        : { report: Buffer })
+    & (O extends { timestamp: 'float64' } ? { timestampMicroseconds: number }
+        : O extends { timestamp: 'hilo' }
+        ? { timestampMicrosecondsHi: number, timestampMicrosecondsLo: number }
+        : { timestampMicroseconds: bigint })
+
+/**
+ * `SensorEvent` whose `report` is a view into a shared slab. See
+ * `SensorCallbackOptions.report`.
+ */
+export type SlabSensorEvent = SensorEventOf<{ report: 'slab' }>
+
 /**
  * Sensor IDs for BNO08x
  * 
@@ -149,6 +195,8 @@ export enum SensorId {
      * - `yaw` ***Yaw** is the rotation about the vertical axis, turning an object left or right.*
      * - `pitch` ***Pitch** is the rotation about the side-to-side (lateral) axis, tilting an object’s nose up or down.*
      * - `roll` ***Roll** is the rotation about the front-to-back (longitudinal) axis, tipping an object’s wings or sides toward the ground.*
+     *
+     * See `setEulerMode(..)` for how these are computed, or turning them off.
      */
     SH2_ROTATION_VECTOR = 0x05,
     SH2_GAME_ROTATION_VECTOR = 0x08,
@@ -191,7 +239,16 @@ export type SensorConfig = {
     /** Interval in microseconds between asynchronous input reports. */
     reportInterval_us: number,
 
-    /** Reserved field, not used. */
+    /** Maximum time in microseconds the hub may hold reports in its FIFO
+     * before sending them. The hub then sends them in large transfers, so the
+     * host wakes up far less often. Reports keep the time they were sampled
+     * at. 0 sends every report as soon as it's ready. Use `flush(..)` to get
+     * the held reports earlier.
+     *
+     * A batch comes in payloads of up to 8 KB (`SH2_HAL_MAX_PAYLOAD_IN`, can
+     * be raised at build time). Larger ones are dropped whole and counted in
+     * `Metrics.transport.rxTooLargePayloads`; shorten the interval if they
+     * show up. */
     batchInterval_us?: number,
 
     /** Meaning is sensor specific */
@@ -202,6 +259,8 @@ export enum AsyncEventId {
     RESET,
     SHTP_EVENT,
     GET_FEATURE_RESP,
+    /** Held reports of a sensor have been sent (see `flush(..)`). */
+    FLUSH_COMPLETED,
 }
 
 export enum ShtpEvent {
@@ -236,10 +295,581 @@ export type AsyncEvent = {
      * Either this or `.shtpEvent`
      */
     sensorConfigResp: SensorConfigResponse | undefined;
+
+    /**
+     * The flushed sensor, set on `FLUSH_COMPLETED`.
+     */
+    sensorId?: SensorId;
 }
 
 export type EventCallback = (cookie: Object, event: AsyncEvent) => void;
 
+/**
+ * Budget for a draining `service(..)` call. A budget of 0 means unlimited,
+ * but not both: a hub streaming faster than it's drained would never let
+ * the call return.
+ */
+export type ServiceOptions = {
+    /**
+     * Max number of SHTP transfers to read. Defaults to 64. 0 for no limit
+     * needs `maxMicros`, or `ARGUMENT_ERROR` is thrown.
+     */
+    maxTransfers?: number,
+
+    /** Max time to spend servicing, in microseconds. Defaults to 0. */
+    maxMicros?: number,
+}
+
+export type ServiceResult = {
+    /** SHTP transfers read from the hub. */
+    transfers: number,
+
+    /** `sh2_service()` rounds run. Each transfer takes two. */
+    serviceCalls: number,
+
+    /** True if the hub ran out of data before the budget did. */
+    idle: boolean,
+
+    elapsedMicros: number,
+}
+
+export type InterruptOptions = {
+    /**
+     * How interrupts reach the main thread.
+     *
+     * - `'worker'` *(default)* A thread waits for the GPIO edge and queues
+     *   the hub servicing on the main thread. Edges are timestamped even
+     *   when the main thread is busy.
+     * - `'uvPoll'` The GPIO is watched by Node's event loop, and the hub is
+     *   serviced in the same callback. Saves a thread hop per interrupt,
+     *   which is the better choice when the main thread is mostly idle.
+     */
+    mode?: 'worker' | 'uvPoll',
+}
+
+/**
+ * Settings for `usePolling(..)`.
+ */
+export type PollingOptions = {
+    /**
+     * Poll period in microseconds. If left out, the period follows the
+     * shortest `reportInterval_us` set with `setSensorConfig(..)`, or 10 ms
+     * if no sensor is enabled.
+     */
+    periodMicros?: number,
+
+    /**
+     * Move the ticks to land shortly after the hub makes a report of the
+     * fastest sensor available. Defaults to false.
+     */
+    phaseAlign?: boolean,
+
+    /**
+     * How long after the expected report arrival to poll, in microseconds.
+     * Defaults to 1/8 of the period.
+     */
+    phaseOffsetMicros?: number,
+}
+
+/**
+ * Latest value of a sensor, as returned by `getLatest(..)`.
+ *
+ * Decoded values are set by name like on `SensorEvent`: `x`, `y`, `z` for
+ * vector sensors, `i`, `j`, `k`, `real` (and `accuracy`) for rotation
+ * vectors, `value` for scalar sensors and so on.
+ */
+export type LatestValue = {
+    sensorId: SensorId,
+    /** Report sequence number, wraps at 256. */
+    sequence: number,
+    timestampMicroseconds: bigint,
+    delayMicroseconds: number,
+    /** Same as `SensorEvent.calibrationStatus`. */
+    calibrationStatus: number,
+    [value: string]: number | bigint,
+}
+
+/**
+ * Delivery settings of a `subscribe(..)` subscriber.
+ */
+export type SubscribeOptions = {
+    /**
+     * Don't call back until at least this many events are pending. All
+     * pending events are then delivered in one array. Defaults to 1.
+     */
+    batchSize?: number,
+
+    /**
+     * Most events to hold for this subscriber before the lag policy kicks
+     * in. Defaults to, and is capped at, the ring size of 1024.
+     */
+    maxPending?: number,
+
+    /**
+     * What to drop when the subscriber falls more than `maxPending` behind.
+     *
+     * - `'dropOldest'` *(default)* Keep the newest `maxPending` events.
+     * - `'skipToLatest'` Keep only the newest event, and deliver it even if
+     *   short of `batchSize`.
+     */
+    lagPolicy?: 'dropOldest' | 'skipToLatest',
+
+    /** Only receive these sensors. Defaults to all. */
+    sensors?: SensorId[],
+}
+
+export type SubscriberStats = {
+    /** Events waiting for delivery. */
+    pending: number,
+    delivered: number,
+    /** Events dropped by the lag policy. */
+    dropped: number,
+    paused: boolean,
+}
+
+export type EulerMode = 'exact' | 'fast' | 'off'
+
+export type RecordingOptions = {
+    /** Only record these sensors. Defaults to all. */
+    sensors?: SensorId[],
+
+    /**
+     * - `'raw'` *(default)* The report bytes as sent by the hub.
+     * - `'decoded'` The values of a `LatestValue`, as float32.
+     */
+    format?: 'raw' | 'decoded',
+
+    /**
+     * Records the file is pre-allocated for, 80 bytes each. Events past
+     * it are counted as dropped. Defaults to 1048576 (80 MiB).
+     */
+    capacity?: number,
+
+    /**
+     * How often new records are flushed to disk and committed to the
+     * header, in milliseconds. Defaults to 1000.
+     */
+    syncIntervalMs?: number,
+}
+
+export type RecordingStats = {
+    /** Records written to the file. */
+    records: number,
+    /** Records flushed to disk and committed to the header. */
+    committed: number,
+    /** Events that didn't fit in the capacity. */
+    dropped: number,
+}
+
+/** Handle of a log opened with `openLog(..)`. */
+export type LogHandle = { readonly __brand: 'LogHandle' }
+
+export type LogInfo = {
+    format: 'raw' | 'decoded',
+    /** Committed records. */
+    records: number,
+    /** Timestamp of the first and last record, 0 if there are none. */
+    startMicros: number,
+    endMicros: number,
+    /**
+     * Timestamp of the first record, and the wall clock in microseconds at
+     * that moment, for dating the records. 0 if there are none.
+     */
+    startMonotonicMicros: number,
+    startRealtimeMicros: number,
+    /** Sensors the recording was limited to, empty for all. */
+    sensors: SensorId[],
+    /** Whether the recording was stopped cleanly. */
+    closed: boolean,
+    /** Whether the time index was loaded from `<path>.idx` or built. */
+    indexLoaded: boolean,
+}
+
+export type LogReadOptions = {
+    sensorId: SensorId,
+    /** First timestamp to read, in microseconds. Defaults to the start. */
+    from?: number,
+    /** Last timestamp to read, inclusive. Defaults to the end. */
+    to?: number,
+}
+
+export type LogRange = {
+    /** Timestamp of each record, in microseconds. */
+    timestamps: Float64Array,
+    /** `lanes` values per record, in the order of a `LatestValue`. */
+    values: Float32Array,
+    lanes: number,
+}
+
+/** Handle of a decoder from `createStreamDecoder()`. */
+export type StreamDecoder = { readonly __brand: 'StreamDecoder' }
+
+export type DecodedStream = LogRange & {
+    /** Sensor of the stream, null until its header was read. */
+    sensorId: SensorId | null,
+}
+
+export type ReplayOptions = {
+    /**
+     * Multiple of the recorded rate. 0 or Infinity replay as fast as
+     * possible. Defaults to 1.
+     */
+    speed?: number,
+    /** Only replay these sensors. Defaults to all in the log. */
+    sensors?: SensorId[],
+    /** First and last timestamp to replay, in microseconds. */
+    from?: number,
+    to?: number,
+}
+
+export type ArrowExportOptions = {
+    /** Only export these sensors. Defaults to all in the log. */
+    sensors?: SensorId[],
+    /** First and last timestamp to export, in microseconds. */
+    from?: number,
+    to?: number,
+    /** Rows per record batch. Defaults to 65536. */
+    batchRows?: number,
+}
+
+export type ArrowExport = {
+    sensorId: SensorId,
+    /** `<directory>/sensor_<id>.arrow` */
+    path: string,
+    rows: number,
+}
+
+/**
+ * Samples of a history query, as views into the history's memory. A sample
+ * is overwritten `capacity` samples later, so `.slice()` what you keep.
+ */
+export type HistoryRange = {
+    /** Number of the first sample, counting from 0 since `setHistory(..)`. */
+    first: number,
+    /** Number after the last sample; pass it to `historySince(..)`. */
+    next: number,
+    /** Host microseconds, as `SensorEvent.timestampMicroseconds`. */
+    timestamps: Float64Array,
+    /** A column per value, named as in a `LatestValue`. */
+    values: { [name: string]: Float32Array },
+}
+
+export type ResamplerOptions = {
+    /** Up to 8 sensors with decoded values, see `LatestValue`. */
+    sensors: SensorId[],
+    /** Microseconds between frames, e.g. 5000 for 200 Hz. */
+    intervalUs: number,
+    /**
+     * Most a stalled sensor holds frames back, in microseconds. Its last
+     * value is held meanwhile. Defaults to 4 intervals.
+     */
+    latencyUs?: number,
+}
+
+/** Where each sensor's values are in a frame. */
+export type ResamplerLayout = {
+    /** Values per frame. */
+    stride: number,
+    /** In ascending sensor id order. */
+    sensors: {
+        sensorId: SensorId,
+        /** Index of its first value in a frame. */
+        offset: number,
+        /** Names of its values, as in a `LatestValue`. */
+        names: string[],
+    }[],
+}
+
+/** Frames made since the last batch. */
+export type ResampledFrames = {
+    /** Host microseconds on the grid, one per frame. */
+    timestamps: Float64Array,
+    /** `stride` values per frame, see `ResamplerLayout`. */
+    values: Float32Array,
+    /** Frames lost as the batch was full or skipped over a gap. */
+    dropped: number,
+}
+
+export type StatsOptions = {
+    /**
+     * - `cumulative`: every sample since `setStats(..)`. The default.
+     * - `tumbling`: consecutive windows of `samples`; statistics are of the
+     *   last complete one, or of the first until it completes.
+     * - `sliding`: the last `samples`, at most 65536.
+     */
+    window?: 'cumulative' | 'tumbling' | 'sliding',
+    samples?: number,
+}
+
+export type ValueStats = {
+    mean: number,
+    /** Of the sample, 0 for a single one. */
+    variance: number,
+    min: number,
+    max: number,
+    rms: number,
+}
+
+export type SensorStats = {
+    /** Samples in the window; the statistics are NaN when 0. */
+    count: number,
+    /** Host microseconds of the last sample. */
+    timestamp: number,
+    /** Named as in a `LatestValue`. */
+    values: { [name: string]: ValueStats },
+}
+
+export type AllanVarianceOptions = {
+    /**
+     * Largest cluster, in samples; clusters are the powers of two up to it.
+     * At most 2^20, defaults to 65536. The last 2 * maxClusterSamples sums
+     * of each axis are kept in memory.
+     */
+    maxClusterSamples?: number,
+}
+
+export type AllanNoise = {
+    /** Angle/velocity random walk, in units per sqrt(Hz). */
+    noiseDensity: number,
+    /** In units. */
+    biasInstability: number,
+    /** In units per sqrt(s); NaN until the curve rises. */
+    rateRandomWalk: number,
+}
+
+export type AllanVariance = {
+    samples: number,
+    /** Mean seconds between samples. */
+    interval: number,
+    /** Allan deviation of each axis at each cluster size with terms. */
+    curve: { tau: number, terms: number, x: number, y: number, z: number }[],
+    /** Read off the curve where it has at least 10 clusters of data. */
+    noise: { x: AllanNoise, y: AllanNoise, z: AllanNoise },
+}
+
+export type SpectrumOptions = {
+    /** Names of 1 to 3 of the sensor's values. Defaults to x, y and z. */
+    axes?: string[],
+    /** Samples per frame, a power of two from 16 to 8192. Defaults to 256. */
+    frameSize?: number,
+    /** Samples shared by consecutive frames. Defaults to frameSize / 2. */
+    overlap?: number,
+    /** Defaults to 'hann'. */
+    window?: 'hann' | 'hamming' | 'rectangular',
+    /**
+     * Edges in Hz of up to 32 bands, ascending. With these, frames hold
+     * the mean square of each band instead of the spectrum.
+     */
+    bands?: number[],
+}
+
+export type SpectrumLayout = {
+    /** Names of the axes, in the order of their values in a frame. */
+    axes: string[],
+    /** Bins, frameSize / 2 + 1, or bands. */
+    valuesPerAxis: number,
+}
+
+/** Frames made since the last batch. */
+export type SpectrumFrames = {
+    sensorId: SensorId,
+    /** Host microseconds of each frame's last sample. */
+    timestamps: Float64Array,
+    /** Bin spacing of each frame, from its samples' timestamps. */
+    binHz: Float64Array,
+    /**
+     * `valuesPerAxis` for each axis of each frame: amplitudes, or mean
+     * squares of the bands in units squared.
+     */
+    values: Float32Array,
+    /** Frames lost as the batch was full. */
+    dropped: number,
+}
+
+/** Triggers a capture when a value crosses a threshold. */
+export type CaptureRule = {
+    sensorId: SensorId,
+    /**
+     * Name of one of the sensor's values, as in a `LatestValue`, or
+     * 'magnitude' of its x, y and z. Defaults to 'magnitude'.
+     */
+    value?: string,
+    above?: number,
+    below?: number,
+}
+
+export type CaptureOptions = {
+    /** Up to 8 sensors with decoded values to capture. */
+    sensors: SensorId[],
+    /** Microseconds captured before the trigger. Defaults to 0. */
+    preUs?: number,
+    /** Microseconds captured after the trigger. Defaults to 0. */
+    postUs?: number,
+    /**
+     * Samples kept of each sensor, at most 65536. Defaults to 4096; it
+     * should cover preUs + postUs at the sensors' rates.
+     */
+    capacity?: number,
+    /** Sensors whose reports trigger, e.g. the tap or shake detector. */
+    triggers?: SensorId[],
+    /** Up to 4 threshold rules. */
+    rules?: CaptureRule[],
+}
+
+export type CaptureLayout = {
+    /** In ascending sensor id order, as in a `CapturedWindow`. */
+    sensors: { sensorId: SensorId, names: string[] }[],
+}
+
+export type CapturedWindow = {
+    /** Host microseconds of the report that triggered. */
+    triggerTimestamp: number,
+    triggerSensorId: SensorId,
+    /** A sensor's samples didn't reach back preUs; raise `capacity`. */
+    truncated: boolean,
+    /** Windows lost since the last one, as it wasn't delivered yet. */
+    missed: number,
+    sensors: {
+        sensorId: SensorId,
+        timestamps: Float64Array,
+        /** The sensor's values for each sample, see `CaptureLayout`. */
+        values: Float32Array,
+    }[],
+}
+
+export type FixedPointLayout = {
+    /** Bytes from the start of one report to the next. */
+    stride: number,
+    /** Bytes before the first value of the first report. Defaults to 0. */
+    offset?: number,
+    /** Little-endian int16 values per report, 1 to 16. */
+    lanes: number,
+    /** Fraction bits, 0 to 15; e.g. 14 for the rotation vector's i/j/k/real. */
+    qPoint: number,
+}
+
+/**
+ * Layout of the Float64Array from `setGirvRing(..)`. Values are indices, or
+ * lengths in values.
+ *
+ * A header is followed by the records. Record `n`, counting from 0, is at
+ * `HEADER + (n % ring[CAPACITY]) * RECORD`. Each record holds:
+ * `timestampMicroseconds, i, j, k, real, angVelX, angVelY, angVelZ`.
+ * The timestamp is in host microseconds, like the BigInt timestamps of
+ * events.
+ */
+export enum GirvRingLayout {
+    /** Records written so far. Increases after the record is written. */
+    WRITTEN = 0,
+    /** Capacity of the ring in records. */
+    CAPACITY = 1,
+    HEADER = 4,
+    RECORD = 8,
+}
+
+export type ClockSyncOptions = {
+    /** Reports each fit covers, 16..128. Longer windows average out more
+     * jitter and estimate drift better, but follow changes slower. Defaults
+     * to 64. */
+    window?: number,
+}
+
+export type ClockSyncStatus = {
+    /** Timestamps of the sensor come from the fit. Sensors that don't report
+     * at a fixed interval don't lock. */
+    locked: boolean,
+    /** Reports in the window. */
+    samples: number,
+    /** Fitted report period in host microseconds. */
+    periodMicros: number,
+    /** Robust standard deviation of the original timestamps around the fit,
+     * mostly interrupt latency. */
+    jitterMicros: number,
+    /** Drift of the hub's clock against the host's, in parts per million,
+     * measured against the configured `reportInterval_us`. Only meaningful if
+     * the hub runs the sensor at exactly that interval. */
+    driftPpm: number,
+}
+
+export type MetricsOptions = {
+    /** Also read the hub's counters of these sensors. Costs a round trip to
+     * the hub per sensor. */
+    sensors?: SensorId[],
+
+    /** Also read the hub's error log, errors of this severity or more severe
+     * (0 is the most severe). Costs a round trip to the hub. */
+    errorSeverity?: number,
+}
+
+/** Counters the hub keeps for a sensor. See the SH-2 Reference Manual. */
+export type SensorCounts = {
+    sensorId: SensorId,
+    /** Samples the sensor offered. */
+    offered: number,
+    /** Offered samples the hub accepted. */
+    accepted: number,
+    /** Accepted samples while the sensor was on. */
+    on: number,
+    /** Samples the hub attempted to send to the host. */
+    attempted: number,
+}
+
+/** Entry of the hub's error log. See the SH-2 Reference Manual. */
+export type HubErrorRecord = {
+    /** 0 is the most severe. */
+    severity: number,
+    sequence: number,
+    /** 1: MotionEngine, 2: MotionHub, 3: SensorHub, 4: Chip */
+    source: number,
+    error: number,
+    module: number,
+    code: number,
+}
+
+/**
+ * Counters for telling apart where data goes missing. All counts are since
+ * `open(..)`, except `host.pollOverruns` which is since `usePolling(..)`.
+ */
+export type Metrics = {
+    /** SHTP transfers dropped or cut short on the host. */
+    transport: {
+        rxBadChannel: number,
+        rxShortFragments: number,
+        rxTooLargePayloads: number,
+        /** A new payload started before the previous one was complete. */
+        rxInterruptedPayloads: number,
+        txBadChannel: number,
+        txDiscards: number,
+        txTooLargePayloads: number,
+    },
+    /** Reports the driver couldn't make sense of. */
+    driver: {
+        unknownReportIds: number,
+        emptyPayloads: number,
+        execBadPayloads: number,
+    },
+    /** I2C traffic. */
+    bus: {
+        transfers: number,
+        /** Reads that found the hub with nothing to send. */
+        idleReads: number,
+        readErrors: number,
+        readBytes: number,
+        writes: number,
+        writeErrors: number,
+        writeBytes: number,
+    },
+    /** Host side lag. */
+    host: {
+        /** Poll timer ticks missed because the main thread was busy. */
+        pollOverruns: number,
+    },
+    /** Set if `MetricsOptions.sensors` was given. */
+    counts?: SensorCounts[],
+    /** Set if `MetricsOptions.errorSeverity` was given. */
+    errors?: HubErrorRecord[],
+}
+
 /**
  * `FrsId` to set or get.
  * 
@@ -393,13 +1023,21 @@ export type BNO08X = {
      * that will be invoked when the device generates certain events.
      * (See `AsyncEventId`)
      *
+     * The addon can be loaded in several threads, so the hub can be driven
+     * from a `worker_thread` to keep it off the main thread. Only one thread
+     * can have the hub open at a time. Until it calls `close()` or exits,
+     * calls that use the hub throw `ERROR_INTERACTING_WITH_DRIVER` in other
+     * threads.
+     *
      * @param callback is called on events other than sensor events.
      * @param  eventCookie Will be passed to callback. It must be an `Object`,
      * so primitives are a no go. It can be a function, object, array, etc.
      * 
      * @throws `ARGUMENT_ERROR` on invalid arguments.
      * @throws `REF_ERROR` on invalid value to create reference from.
-     * @throws `ERROR_INTERACTING_WITH_DRIVER` on failed sh2_open(..).
+     * @throws `ERROR_INTERACTING_WITH_DRIVER` on failed sh2_open(..), or if
+     * another thread has the hub open.
+     * @throws `I2C_ERROR` if reading the hub fails in a known way.
      * @throws `ERROR_TRANSLATING_STRUCT_TO_NODE` from the emitted AsyncEvent
      */
     open: (callback: EventCallback, eventCookie: Object) => void,
@@ -408,7 +1046,8 @@ export type BNO08X = {
      * @brief Close a session with a sensor hub.
      *
      * This should be called at the end of a sensor hub session.  
-     * The underlying SHTP and HAL instances will be closed.
+     * The underlying SHTP and HAL instances will be closed. A thread that
+     * exits with the hub open closes it too.
      *
      */
     close: () => void,
@@ -420,7 +1059,15 @@ export type BNO08X = {
      * This function should be called periodically by the host system to service
      * an open sensor hub.
      *
+     * Called without arguments, the hub is serviced once. Since the HAL needs
+     * two service rounds per transfer, polling this way at e.g. 10 Hz reads
+     * only a handful of transfers per second. Pass `ServiceOptions` to drain
+     * the hub until it has no more data or the budget runs out; the counts
+     * are returned as a `ServiceResult`. Draining stops early if a callback
+     * closes the hub.
+     *
      * @throws Anything event callbacks might throw.
+     * @throws `ARGUMENT_ERROR` On invalid `ServiceOptions`.
      * @throws `REF_ERROR` On being unable to fetch value by napi reference.
      * @throws `ERROR_CREATING_NAPI_VALUE` On being unable to fetch JS global
      * object.
@@ -428,13 +1075,19 @@ export type BNO08X = {
      * thread other than the main thread.
      * @throws `ERROR_TRANSLATING_STRUCT_TO_NODE` from emitted AsyncEvents
      */
-    service: () => void,
+    service: {
+        (): void,
+        (options: ServiceOptions): ServiceResult,
+    },
 
     /**
      * @brief Register a function to be called on received sensor events.
      *
      * @param  callback For sensor events.
      * @param  cookie  Will be passed for the callback.
+     * @param  options See `SensorCallbackOptions`. The report storage and
+     * timestamp format also apply to events delivered to `subscribe(..)`
+     * subscribers.
      * 
      * @throws `ARGUMENT_ERROR` On invalid argument.
      * @throws `ERROR_CREATING_NAPI_VALUE` On Out-Of-Memory.
@@ -444,7 +1097,27 @@ export type BNO08X = {
      * @throws `ERROR_INTERACTING_WITH_DRIVER` On being unable set new cb.
      * 
      */
-    setSensorCallback: (callback: SensorCallback, cookie: Object) => void,
+    setSensorCallback: <O extends SensorCallbackOptions = {}>(
+        callback: (event: SensorEventOf<O>, cookie: any) => void,
+        cookie: Object, options?: O) => void,
+
+    /**
+     * @brief Have the hub send the reports it's holding for a sensor
+     * (see `SensorConfig.batchInterval_us`).
+     *
+     * The reports and the completion arrive as the hub is serviced, so keep
+     * calling `service(..)`, or use interrupts or polling. Calls made while a
+     * flush of the same sensor is pending return the same Promise.
+     *
+     * @param sensorId Sensor whose reports to flush.
+     * @returns Resolves once all the held reports have been delivered.
+     * Rejects with `ERROR_INTERACTING_WITH_DRIVER` if the hub is closed first.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid sensor id.
+     * @throws `ERROR_INTERACTING_WITH_DRIVER` On being unable to request the
+     * flush.
+     */
+    flush: (sensorId: SensorId) => Promise<void>,
 
     /**
      * @brief Reset the sensor hub.
@@ -548,6 +1221,519 @@ export type BNO08X = {
      * 
      * @param chipname e.g. "gpiochip0" or "/dev/gpiochip0"
      * @param gpioPin line offset on the chip
+     * @param options See `InterruptOptions`.
+     * @throws `ERROR_INTERACTING_WITH_DRIVER` If polling is running, or
+     * interrupts can't be set up. Only one of the two services the hub.
+     */
+    useInterrupts: (chipname: string, gpioPin: number,
+        options?: InterruptOptions) => void,
+
+    /**
+     * Service the hub from a native timer thread, for boards that can't route
+     * the INT pin. Every tick drains the hub like `service({..})` does and
+     * dispatches callbacks on the main thread.
+     *
+     * **NOTE:** Like with interrupts, `service()` needn't be called. Calling
+     * this again while polling updates the running timer.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid options.
+     * @throws `ERROR_INTERACTING_WITH_DRIVER` If interrupts are in use, or
+     * the timer can't be started.
+     */
+    usePolling: (options?: PollingOptions) => void,
+
+    /**
+     * Stop the timer started with `usePolling(..)`. `close()` does this too.
      */
-    useInterrupts: (chipname: string, gpioPin: number) => void,
+    stopPolling: () => void,
+
+    /**
+     * Latest decoded value of a sensor, without subscribing to sensor events.
+     *
+     * The native side keeps the freshest report of every sensor as reports
+     * are serviced, whether or not a sensor callback is set. Read it at any
+     * rate; nothing is queued in between.
+     *
+     * @param sensorId Which sensor to read.
+     * @returns `null` if the sensor hasn't reported since `open(..)`.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid sensor id.
+     * @throws `ERROR_TRANSLATING_STRUCT_TO_NODE` If the object can't be built.
+     */
+    getLatest: (sensorId: SensorId) => LatestValue | null,
+
+    /**
+     * Host time, in microseconds, that `'float64'` event timestamps count
+     * from. Set by the first event after `setSensorCallback(..)`.
+     *
+     * @returns The epoch, or null if no event has arrived yet.
+     */
+    getTimestampEpoch: () => bigint | null,
+
+    /**
+     * Subscribe to sensor events with an independent read cursor.
+     *
+     * Events are kept once in a native broadcast ring, and every subscriber
+     * reads it at its own pace. Deliveries happen after the hub has been
+     * serviced, in subscription order. A subscriber that falls behind, or is
+     * paused with `setSubscriberPaused(..)`, only loses its own events per
+     * its `lagPolicy`. Works alongside `setSensorCallback(..)`.
+     *
+     * Up to 8 subscribers are supported.
+     *
+     * @param callback Called with an array of events.
+     * @param options See `SubscribeOptions`.
+     * @returns Subscriber id.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid arguments, or too many subscribers.
+     * @throws `REF_ERROR` On being unable to create a napi reference to cb.
+     */
+    subscribe: (callback: (events: SensorEvent[]) => void,
+        options?: SubscribeOptions) => number,
+
+    /**
+     * @throws `ARGUMENT_ERROR` On unknown subscriber id.
+     */
+    unsubscribe: (id: number) => void,
+
+    /**
+     * Stop or resume deliveries to a subscriber, e.g. on stream backpressure.
+     * Events keep accumulating while paused, subject to the lag policy.
+     *
+     * @throws `ARGUMENT_ERROR` On unknown subscriber id.
+     */
+    setSubscriberPaused: (id: number, paused: boolean) => void,
+
+    /**
+     * @throws `ARGUMENT_ERROR` On unknown subscriber id.
+     */
+    getSubscriberStats: (id: number) => SubscriberStats,
+
+    /**
+     * @brief Read the counters of the transport, driver and I2C bus,
+     * optionally with the hub's own counters and error log.
+     *
+     * Hub-side drops show in `counts`, bus errors in `bus` and `transport`,
+     * and the host falling behind in `host` and `getSubscriberStats(..)`.
+     *
+     * @param options See `MetricsOptions`.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid options.
+     * @throws `ERROR_INTERACTING_WITH_DRIVER` If the hub isn't open, or on
+     * failing to read the counts or the error log from the hub.
+     * @throws `I2C_ERROR` On bus errors while reading from the hub.
+     */
+    getMetrics: (options?: MetricsOptions) => Metrics,
+
+    /**
+     * @brief Smooth the timestamps of sensor events against the hub's clock.
+     *
+     * A sensor reporting at a fixed interval samples on the hub's clock.
+     * Its reports are fitted against their sequence numbers over a sliding
+     * window. The fit is a robust linear regression that ignores latency
+     * outliers. Timestamps then come from the fit instead of the interrupt
+     * time, so interrupt latency jitter drops out and the drift between the
+     * clocks is followed. Timestamps of a sensor never go backwards. The fit
+     * sits on the reports with the least latency, so timestamps stay close
+     * to when the samples were taken.
+     *
+     * Applies to every way events are delivered. A sensor's fit starts over
+     * when its report interval is changed, and all fits when the hub is
+     * closed.
+     *
+     * @param enabled Whether to smooth timestamps. Either way, fits start
+     * over.
+     * @param options See `ClockSyncOptions`.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid arguments.
+     */
+    setClockSync: (enabled: boolean, options?: ClockSyncOptions) => void,
+
+    /**
+     * @returns State of the clock sync of a sensor, or null if the sensor has
+     * no reports in its window.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid sensor id.
+     */
+    getClockSync: (sensorId: SensorId) => ClockSyncStatus | null,
+
+    /**
+     * @brief Send gyro-integrated rotation vector reports into a ring of
+     * decoded values instead of the sensor callback and subscribers.
+     *
+     * The hub can send these at up to 1 kHz. Creating an object for each
+     * one would keep the main thread busy. Read the ring at your own rate,
+     * e.g. once per rendered frame, by comparing
+     * `ring[GirvRingLayout.WRITTEN]` with the count you read last. Records
+     * older than the capacity are overwritten. `getLatest(..)` keeps
+     * working.
+     *
+     * Several reports often arrive in one transfer. They are stamped one
+     * report period apart, ending at the time of the transfer, with the
+     * period estimated from how often transfers arrive.
+     *
+     * @param capacity Records in the ring, at most 65536. 0 removes the
+     * ring, and the reports go to the callbacks again.
+     * @returns The ring, see `GirvRingLayout`, or null for capacity 0.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid capacity.
+     * @throws `ERROR_CREATING_NAPI_VALUE` On Out-Of-Memory.
+     */
+    setGirvRing: (capacity: number) => Float64Array | null,
+
+    /**
+     * @brief Convert Q-format fixed-point values of many reports to floats at
+     * once, e.g. when replaying raw reports from a log.
+     *
+     * Uses NEON or SSE2/AVX2 for 3 and 4 values per report.
+     *
+     * @param bytes The reports, back to back.
+     * @param options Where the values are; see `FixedPointLayout`.
+     * @returns `lanes` floats per whole report in `bytes`.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid bytes or options.
+     * @throws `ERROR_CREATING_NAPI_VALUE` On Out-Of-Memory.
+     */
+    decodeFixedPoint: (bytes: Uint8Array, options: FixedPointLayout) =>
+        Float32Array,
+
+    /**
+     * @brief Choose how yaw, pitch and roll of rotation vector events are
+     * computed.
+     *
+     * - `'exact'` *(default)* With libm `atan2`/`asin`.
+     * - `'fast'` With polynomial approximations, at most 2.5e-6 rad off
+     *   the exact angles. That is far below the 1e-4 resolution of the
+     *   reported quaternion.
+     * - `'off'` Not at all; events only have the quaternion. Use this if
+     *   you don't read the angles, or convert them in bulk with
+     *   `quaternionsToEuler(..)`.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid mode.
+     */
+    setEulerMode: (mode: EulerMode) => void,
+
+    /**
+     * @brief Convert many quaternions to yaw, pitch and roll at once.
+     *
+     * @param quaternions i, j, k, real of each quaternion, e.g. from
+     * `decodeFixedPoint(..)` of rotation vector reports.
+     * @param mode `'exact'` *(default)* or `'fast'`, see `setEulerMode(..)`.
+     * @returns yaw, pitch, roll of each quaternion in radians.
+     *
+     * @throws `ARGUMENT_ERROR` If `quaternions` isn't a Float32Array of a
+     * multiple of 4 values, or on invalid mode.
+     * @throws `ERROR_CREATING_NAPI_VALUE` On Out-Of-Memory.
+     */
+    quaternionsToEuler: (quaternions: Float32Array,
+        mode?: Exclude<EulerMode, 'off'>) => Float32Array,
+
+    /**
+     * @brief Record sensor events natively into a binary file.
+     *
+     * Events are written as they are serviced, without calling into JS, as
+     * fixed 80 byte records appended to a pre-allocated, memory mapped
+     * file. A background thread flushes them to disk every
+     * `syncIntervalMs`, and only then counts them as committed in the
+     * header. After a crash, the committed records are intact. See
+     * `src/c-include/recorder.h` for the layout.
+     *
+     * Timestamps are recorded after clock sync, if enabled. The recording
+     * stops when the hub is closed.
+     *
+     * @param path File to create. An existing file is overwritten.
+     *
+     * @throws `ERROR_INTERACTING_WITH_DRIVER` If the sensor hub isn't open
+     * in this thread.
+     * @throws `ARGUMENT_ERROR` On invalid path or options.
+     * @throws `RECORDING_ERROR` If already recording, or the file couldn't
+     * be created.
+     */
+    startRecording: (path: string, options?: RecordingOptions) => void,
+
+    /**
+     * @brief Flush, trim and close the recording.
+     *
+     * @returns Its final stats, or null if not recording.
+     *
+     * @throws `RECORDING_ERROR` If writing the file failed at any point.
+     */
+    stopRecording: () => RecordingStats | null,
+
+    /** @returns Stats of the running recording, or null if not recording. */
+    getRecordingStats: () => RecordingStats | null,
+
+    /**
+     * @brief Open a recording for reading; it's mapped into memory.
+     *
+     * Seeking by time uses a sparse index, which is built on first open and
+     * saved as `<path>.idx`. A recording that is still being written can be
+     * opened; only the records committed so far are read.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid path.
+     * @throws `RECORDING_ERROR` If the file can't be opened or isn't a
+     * recording.
+     */
+    openLog: (path: string) => LogHandle,
+
+    /**
+     * @brief Unmap the log. It's also closed when the handle is garbage
+     * collected.
+     *
+     * @throws `RECORDING_ERROR` If the log is being replayed.
+     */
+    closeLog: (log: LogHandle) => void,
+
+    /** @throws `ARGUMENT_ERROR` If the log is closed. */
+    getLogInfo: (log: LogHandle) => LogInfo,
+
+    /**
+     * @returns Index of the first record at or after `timestampMicros`, the
+     * number of records if there is none.
+     *
+     * @throws `ARGUMENT_ERROR` If the log is closed, or on invalid timestamp.
+     */
+    seekLog: (log: LogHandle, timestampMicros: number) => number,
+
+    /**
+     * @brief Read the values of one sensor in a range of time at once.
+     *
+     * @throws `ARGUMENT_ERROR` If the log is closed, or on invalid options.
+     * @throws `ERROR_CREATING_NAPI_VALUE` On Out-Of-Memory.
+     */
+    readLog: (log: LogHandle, options: LogReadOptions) => LogRange,
+
+    /**
+     * @brief Feed the events of a raw recording through the sensor callback
+     * and subscribers, as if they came from the hub.
+     *
+     * Events keep their recorded timestamps and are paced by them, divided
+     * by `speed`. Recordings in the `'decoded'` format can only be read.
+     * Records whose length doesn't match their report, as in a corrupt log,
+     * are skipped.
+     *
+     * @returns A promise of the number of events replayed, resolved at the
+     * end of the range or on `stopReplay()`.
+     *
+     * @throws `ERROR_INTERACTING_WITH_DRIVER` If the sensor hub is open or
+     * another replay is running.
+     * @throws `ARGUMENT_ERROR` If the log is closed or decoded, or on invalid
+     * options.
+     */
+    replayLog: (log: LogHandle, options?: ReplayOptions) => Promise<number>,
+
+    /** @brief Stop the running replay, if any. */
+    stopReplay: () => void,
+
+    /**
+     * @brief Compress the reports of one sensor of a raw recording, e.g. to
+     * store or send them.
+     *
+     * Each report is stored as its difference to the one before: the
+     * change in the timestamp interval and in each int16 value as zigzag
+     * varints, and the header bytes only when they change. Smooth streams
+     * like the rotation vector take around a third of the size of their
+     * timestamps and reports. See `src/c-include/stream_codec.h`.
+     *
+     * @throws `ARGUMENT_ERROR` If the log is closed or decoded, or on invalid
+     * options.
+     * @throws `ERROR_CREATING_NAPI_VALUE` On Out-Of-Memory.
+     */
+    encodeLogStream: (log: LogHandle, options: LogReadOptions) => Uint8Array,
+
+    /** @returns A decoder for one stream of `encodeLogStream(..)`. */
+    createStreamDecoder: () => StreamDecoder,
+
+    /**
+     * @brief Decode the next part of a stream, e.g. as it arrives over the
+     * network. It can be split anywhere; a record cut off at the end is
+     * completed by the next call.
+     *
+     * @returns The records completed by `bytes`.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid decoder or bytes.
+     * @throws `RECORDING_ERROR` If the stream is corrupt. The decoder then
+     * expects a new stream.
+     * @throws `ERROR_CREATING_NAPI_VALUE` On Out-Of-Memory.
+     */
+    decodeStream: (decoder: StreamDecoder, bytes: Uint8Array) =>
+        DecodedStream,
+
+    /**
+     * @brief Export a recording as Apache Arrow IPC files, one per sensor,
+     * e.g. for `pyarrow.ipc.open_file(..)` or `polars.read_ipc(..)`.
+     *
+     * Columns are `timestamp_us` (int64), `delay_us` (int32), `sequence`
+     * and `status` (uint8), then the values of a `LatestValue` as
+     * float32, with the same names. The files can be memory
+     * mapped without parsing. Blocks until the files are written.
+     *
+     * @param directory Existing directory to write the files to. Files of
+     * earlier exports are overwritten.
+     *
+     * @throws `ARGUMENT_ERROR` If the log is closed, or on invalid
+     * directory or options.
+     * @throws `RECORDING_ERROR` If a file couldn't be written.
+     */
+    exportLogToArrow: (log: LogHandle, directory: string,
+        options?: ArrowExportOptions) => ArrowExport[],
+
+    /**
+     * @brief Keep a history of a sensor's decoded values natively, for
+     * charts, statistics and the like to share instead of each buffering
+     * its own copy.
+     *
+     * Samples are kept as a column of timestamps and a column per value.
+     * Queries return typed-array views of the columns, never copies, also
+     * across the wrap of the ring. Replayed events are kept too.
+     *
+     * @param capacity Samples to keep, at most 16777216. 0 stops keeping a
+     * history; views of the old one stay valid but aren't updated. The ring
+     * is mirrored, so it takes 2 * (8 + 4 * values) bytes a sample, and at
+     * most 1 GB: 16777216 samples of a 3 value sensor take 640 MB, while a
+     * 13 value sensor fits at most 8947848.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid sensor id or capacity, or a history
+     * of more than 1 GB.
+     * @throws `ERROR_CREATING_NAPI_VALUE` On Out-Of-Memory.
+     */
+    setHistory: (sensorId: SensorId, capacity: number) => void,
+
+    /**
+     * @returns The samples stamped from `fromUs` to `toUs`, inclusive, or
+     * null if the sensor has no history.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid arguments.
+     */
+    historyWindow: (sensorId: SensorId, fromUs: number, toUs: number) =>
+        HistoryRange | null,
+
+    /**
+     * @returns The last `n` samples, fewer if not as many are kept, or null
+     * if the sensor has no history.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid arguments.
+     */
+    historyLast: (sensorId: SensorId, n: number) => HistoryRange | null,
+
+    /**
+     * @returns The samples from number `cursor` on, e.g. `next` of the last
+     * query, or null if the sensor has no history. Starts at the oldest
+     * kept if `cursor` was overwritten; `first` then tells how many were
+     * missed.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid arguments.
+     */
+    historySince: (sensorId: SensorId, cursor: number) =>
+        HistoryRange | null,
+
+    /**
+     * @brief Align sensors to one time grid natively, e.g. accelerometer,
+     * gyro, magnetometer and rotation vector for fusion.
+     *
+     * A frame holds each sensor's values at a grid time, interpolated
+     * linearly, and with SLERP for the quaternion of rotation vectors. It's
+     * made once every sensor has reported past it, or `latencyUs` after.
+     * Frames are passed to `callback` in one batch after each service, with
+     * the subscriber batches. Replayed events are resampled too. Replaces a
+     * running resampler.
+     *
+     * @returns Where each sensor's values are in a frame.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid options.
+     * @throws `UNKNOWN_ERROR` On Out-Of-Memory.
+     */
+    startResampler: (options: ResamplerOptions,
+        callback: (frames: ResampledFrames) => void) => ResamplerLayout,
+
+    /** Stop resampling; frames not passed to the callback yet are lost. */
+    stopResampler: () => void,
+
+    /**
+     * @brief Keep running mean, variance, min, max and RMS of each of a
+     * sensor's decoded values natively, e.g. for health monitoring without
+     * handling every event in JS.
+     *
+     * Replaces earlier statistics of the sensor. Replayed events count too.
+     *
+     * @param options The window, or null to stop keeping statistics.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid sensor id or options.
+     * @throws `UNKNOWN_ERROR` On Out-Of-Memory.
+     */
+    setStats: (sensorId: SensorId, options: StatsOptions | null) => void,
+
+    /**
+     * @returns A snapshot of the sensor's statistics, or null if it has none.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid sensor id.
+     */
+    getStats: (sensorId: SensorId) => SensorStats | null,
+
+    /**
+     * @brief Compute the overlapping Allan variance of a sensor's x, y and
+     * z as reports arrive, e.g. from hours of static raw or uncalibrated
+     * gyro data, to characterize a unit without logging it.
+     *
+     * Replaces an earlier computation for the sensor. Replayed events count
+     * too.
+     *
+     * @param options Cluster sizes, or null to stop.
+     *
+     * @throws `ARGUMENT_ERROR` On a sensor without x, y and z, or invalid
+     * options.
+     * @throws `UNKNOWN_ERROR` On Out-Of-Memory.
+     */
+    setAllanVariance: (sensorId: SensorId,
+        options: AllanVarianceOptions | null) => void,
+
+    /**
+     * @returns The deviation curve and noise coefficients so far, or null
+     * if not computed for the sensor.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid sensor id.
+     */
+    getAllanVariance: (sensorId: SensorId) => AllanVariance | null,
+
+    /**
+     * @brief Compute windowed FFTs of a sensor's values natively, e.g. the
+     * accelerometer's for vibration monitoring, to pass on spectra or band
+     * energies instead of the samples.
+     *
+     * A frame is made every `frameSize - overlap` samples. Frames are passed
+     * to `callback` in one batch after each service, with the subscriber
+     * batches. Replayed events are analyzed too. Replaces a running analyzer
+     * of the sensor.
+     *
+     * @returns Where the values of each axis are in a frame.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid sensor id or options.
+     */
+    startSpectrum: (sensorId: SensorId, options: SpectrumOptions,
+        callback: (frames: SpectrumFrames) => void) => SpectrumLayout,
+
+    /** Stop the analyzer; frames not passed to the callback yet are lost. */
+    stopSpectrum: (sensorId: SensorId) => void,
+
+    /**
+     * @brief Keep the latest samples of high-rate sensors natively and pass
+     * on the window around a trigger: a report of a detector, e.g. tap,
+     * shake, significant motion or stability, or a value crossing a
+     * threshold.
+     *
+     * The window spans from `preUs` before the trigger to `postUs` after
+     * and is passed to `callback` after the service that completes it.
+     * Triggers during a window are ignored. Replayed events are captured
+     * too. Replaces a running capture.
+     *
+     * @returns Names of the captured sensors' values.
+     *
+     * @throws `ARGUMENT_ERROR` On invalid options, or without triggers or
+     * rules.
+     */
+    startCapture: (options: CaptureOptions,
+        callback: (window: CapturedWindow) => void) => CaptureLayout,
+
+    /** Stop capturing; a window not passed to the callback yet is lost. */
+    stopCapture: () => void,
 }
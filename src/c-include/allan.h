@@ -0,0 +1,73 @@
+#ifndef ALLAN_H
+#define ALLAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "decoded_values.h"
+
+// Overlapping Allan variance of the x, y and z of a rate sensor (gyro or
+// accelerometer), computed as samples arrive, for characterizing a unit's
+// noise from hours of static data without logging it.
+//
+// With Θ(n) the sum of the first n samples, the variance at a cluster of m
+// samples (tau = m sample intervals) is
+//   sum over n of (Θ(n) - 2 Θ(n - m) + Θ(n - 2 m))^2 / (2 m^2 terms)
+// The sample interval cancels out, so only tau needs it. Each new sample
+// adds a term to every cluster size, m = 1, 2, 4, .. up to 2^(levels - 1);
+// the last 2^levels sums are kept for that.
+
+#define ALLAN_LANES 3
+#define ALLAN_MAX_LEVELS 21 // Clusters of up to 2^20 samples
+// Clusters a level needs in the data for the noise estimates to use it
+#define ALLAN_MIN_CLUSTERS 10
+
+typedef struct {
+    uint8_t levels;
+    uint32_t capacity; // Sums kept per lane, 2^levels + 1
+    uint64_t samples;
+    uint64_t first_us; // Timestamps of the first and last sample
+    uint64_t last_us;
+    float offset[ALLAN_LANES]; // First sample, taken off to keep Θ small
+    double sum[ALLAN_LANES];   // Θ(samples)
+    double *sums;              // Ring of Θ(n), `capacity` per lane
+    double squares[ALLAN_MAX_LEVELS][ALLAN_LANES];
+    uint64_t terms[ALLAN_MAX_LEVELS];
+} allan_t;
+
+typedef struct {
+    // Angle/velocity random walk, the white noise density in units per
+    // sqrt(Hz), from where the deviation falls as 1/sqrt(tau)
+    double noise_density;
+    // Lowest deviation over sqrt(2 ln 2 / pi), in units
+    double bias_instability;
+    // In units per sqrt(s), from where the deviation rises as sqrt(tau).
+    // NaN until the data reaches that.
+    double rate_random_walk;
+} allan_noise_t;
+
+/// Levels for clusters of the powers of two up to `max_cluster` samples.
+/// Returns 0 unless `max_cluster` is 1 to 2^(ALLAN_MAX_LEVELS - 1).
+uint8_t allan_levels(uint32_t max_cluster);
+
+/// Set up with cluster sizes up to 2^(levels - 1), levels 1 to
+/// ALLAN_MAX_LEVELS. Returns false if out of memory.
+bool allan_init(allan_t *a, uint8_t levels);
+
+void allan_free(allan_t *a);
+
+void allan_push(allan_t *a, uint64_t timestamp_us,
+                const float values[DECODED_VALUES_MAX]);
+
+/// Mean sample interval in seconds, NaN before two samples.
+double allan_interval(const allan_t *a);
+
+/// Allan deviation of `lane` at clusters of 2^level samples, NaN without
+/// terms.
+double allan_deviation(const allan_t *a, uint8_t level, uint8_t lane);
+
+/// Noise coefficients of `lane` read off the deviation curve. NaN where the
+/// curve doesn't have enough levels yet.
+void allan_noise(const allan_t *a, uint8_t lane, allan_noise_t *out);
+
+#endif
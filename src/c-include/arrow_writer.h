@@ -0,0 +1,67 @@
+#ifndef ARROW_WRITER_H
+#define ARROW_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "decoded_values.h"
+#include "recorder.h"
+
+// Export of the events of one sensor as an Apache Arrow IPC file, which
+// pandas, polars and pyarrow can memory-map without parsing, e.g. with
+// `pyarrow.ipc.open_file(..)`. The flatbuffers of the format are written
+// by hand, so there's nothing to link against.
+//
+// Columns, none nullable:
+//   timestamp_us int64, delay_us int32, sequence uint8, status uint8
+//   then a float32 per value of decode_sensor_values(..), named as in
+//   decoded_value_names(..)
+//
+// Rows are buffered and written as one record batch per `batch_rows`.
+
+#define ARROW_DEFAULT_BATCH_ROWS 65536
+
+typedef struct {
+    int64_t offset;          // Of the message in the file
+    int32_t metadata_length; // Prefix and flatbuffer
+    int64_t body_length;
+} arrow_block_t;
+
+typedef struct {
+    FILE *file;
+    int64_t offset; // Bytes written
+    int error;      // errno of the first failure
+
+    uint8_t sensor_id;
+    uint8_t lanes;
+    const char *const *names;
+
+    uint32_t batch_rows;
+    uint32_t rows; // In the batch being filled
+    uint64_t total_rows;
+    int64_t *timestamps;
+    int32_t *delays;
+    uint8_t *sequences;
+    uint8_t *statuses;
+    float *values; // Column after column, `batch_rows` each
+
+    arrow_block_t *blocks; // Of the record batches written
+    size_t block_count;
+    size_t block_capacity;
+} arrow_writer_t;
+
+/// Create `path` and write the schema for `sensor_id`. Returns 0 or an
+/// errno value.
+int arrow_open(arrow_writer_t *w, const char *path, uint8_t sensor_id,
+               uint32_t batch_rows);
+
+/// Add a row of a record and its decoded values. Returns 0 or the errno of
+/// the first failed write.
+int arrow_append(arrow_writer_t *w, const recorder_record_t *record,
+                 const float values[DECODED_VALUES_MAX]);
+
+/// Write the last batch and the footer and close the file. Returns 0 or the
+/// errno of the first failure; the file is then incomplete.
+int arrow_close(arrow_writer_t *w);
+
+#endif
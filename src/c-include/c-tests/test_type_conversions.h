@@ -30,9 +30,159 @@ napi_value test_node_from_c_SensorConfigResp(napi_env env,
  */
 napi_value test_node_from_c_SensorEvent(napi_env env, napi_callback_info info);
 
+/**
+ * Converts two events with slab report storage.
+ */
+napi_value test_node_from_c_SensorEvent_slab(napi_env env,
+                                             napi_callback_info info);
+
+/**
+ * Converts events with the float64 and hilo timestamp formats.
+ */
+napi_value test_node_from_c_SensorEvent_timestamps(napi_env env,
+                                                   napi_callback_info info);
+
 /**
  * Build sh2_AsyncEvent_t for testing.
  */
 napi_value test_node_from_c_AsyncEvent(napi_env env, napi_callback_info info);
 
+/**
+ * Tests that service_stats_t is translated into a ServiceResult object.
+ */
+napi_value test_node_from_c_ServiceStats(napi_env env,
+                                         napi_callback_info info);
+
+/**
+ * Stores a value into the latest-value table, reads it back and translates
+ * it into a LatestValue object.
+ */
+napi_value test_node_from_c_LatestValue(napi_env env,
+                                        napi_callback_info info);
+
+/**
+ * Runs a filtered subscriber past its maxPending in the fan-out ring and
+ * translates its stats into a SubscriberStats object. `overrun` has the
+ * stats of two filtered subscribers the ring wrapped past.
+ */
+napi_value test_node_from_c_SubscriberStats(napi_env env,
+                                            napi_callback_info info);
+
+/**
+ * Tests that metrics_t is translated into a Metrics object.
+ */
+napi_value test_node_from_c_Metrics(napi_env env, napi_callback_info info);
+
+/**
+ * Feeds the clock sync a drifting, jittery report stream and returns its
+ * ClockSyncStatus, with the largest errors of the smoothed and the original
+ * timestamps over the last 100 reports.
+ */
+napi_value test_clock_sync(napi_env env, napi_callback_info info);
+
+/**
+ * Pushes three gyro-integrated RV values into a ring of two and returns the
+ * ring's Float64Array.
+ */
+napi_value test_girv_ring(napi_env env, napi_callback_info info);
+
+/**
+ * Decodes Q14 reports of 1 to 5 lanes with q_decode(..) and the scalar loop.
+ * Returns the implementation name, whether all outputs match, and the four
+ * values of the first report.
+ */
+napi_value test_q_decode(napi_env env, napi_callback_info info);
+
+/**
+ * Converts random unit quaternions, and some at gimbal lock, with the fast and
+ * the exact yaw/pitch/roll. Returns the largest difference and the documented
+ * FAST_EULER_MAX_ERROR.
+ */
+napi_value test_fast_euler(napi_env env, napi_callback_info info);
+
+/**
+ * Records accelerometer events into a temporary file with room for two,
+ * reads it back and returns the stats, the file size, the committed header
+ * and the records.
+ */
+napi_value test_recorder(napi_env env, napi_callback_info info);
+
+/**
+ * Records 3000 accelerometer reports, some out of order, and opens the log
+ * twice. Returns whether the index was built and then loaded, the results of
+ * three seeks and the decoded values of the first record.
+ */
+napi_value test_log_reader(napi_env env, napi_callback_info info);
+
+/**
+ * Records four accelerometer reports and corrupts the length of the last
+ * three. Returns how many of the records replay and decode.
+ */
+napi_value test_log_replay_corrupt(napi_env env, napi_callback_info info);
+
+/**
+ * Encode 2000 rotation vector reports and decode them again in 7 byte
+ * pieces. Returns the records decoded and how many differ, the size of
+ * timestamp and report over the encoded size, and whether a stream without
+ * its header is rejected.
+ */
+napi_value test_stream_codec(napi_env env, napi_callback_info info);
+
+/**
+ * Export 2500 rotation vectors to an Arrow file in batches of 1000. Returns
+ * the error, the magic at the start and end of the file, the batches
+ * written before closing and the first value of the first batch's body.
+ */
+napi_value test_arrow_writer(napi_env env, napi_callback_info info);
+
+/**
+ * Push 250 samples into a history of 100. Returns the [first, end) ranges of
+ * a last, window and since query, and whether the retained samples read
+ * back in one piece across the wrap.
+ */
+napi_value test_history(napi_env env, napi_callback_info info);
+
+/**
+ * Resample an accelerometer and a rotation vector, which stops partway, to
+ * 200 Hz. Returns the number of frames, the first one's timestamp and the
+ * largest error of the accelerometer x and the rotation angle.
+ */
+napi_value test_resampler(napi_env env, napi_callback_info info);
+
+/**
+ * Push 1000 samples into cumulative, tumbling (300) and sliding (100)
+ * statistics. Returns each one's snapshot of the first value, and whether
+ * the sliding one matched its retained samples after every push.
+ */
+napi_value test_stats(napi_env env, napi_callback_info info);
+
+/**
+ * Compute the Allan variance of synthetic white noise, and of white noise
+ * plus a random walking bias. Returns the sample interval, the deviation
+ * at one sample and the noise coefficients read off the curves, and the
+ * levels for maxClusterSamples around the ends of its range.
+ */
+napi_value test_allan(napi_env env, napi_callback_info info);
+
+/**
+ * Analyze a 50 Hz sinusoid with an offset sampled at 400 Hz, as spectra and
+ * as bands. Returns the frames made, the bin spacing, the peak bin and its
+ * amplitude, the DC amplitude and the band mean squares.
+ */
+napi_value test_spectrum(napi_env env, napi_callback_info info);
+
+/**
+ * Capture an accelerometer and a gyro around a tap detector report and an
+ * accelerometer spike. Returns each window's trigger, first timestamp and
+ * samples per sensor, and whether any was truncated.
+ */
+napi_value test_capture(napi_env env, napi_callback_info info);
+
+/**
+ * Drain a stub HAL with service_until_idle(..): until idle, to a transfer
+ * budget, for another hub owner, and with the hub closed. Returns the
+ * ServiceResult of each.
+ */
+napi_value test_service_until_idle(napi_env env, napi_callback_info info);
+
 #endif
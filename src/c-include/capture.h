@@ -0,0 +1,78 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "decoded_values.h"
+
+// Capture of high-rate sensors around a trigger, for the context of a tap,
+// shake or shock without recording everything.
+//
+// The decoded values of the captured sensors go into a ring each. A trigger
+// is a report of one of the trigger sensors, e.g. the tap detector, or a
+// value of a sensor crossing a threshold. Once a sample of any sensor is
+// stamped more than `post` after the trigger, the samples from `pre` before
+// it to `post` after are copied out as the window, and the next trigger is
+// waited for. Triggers during a capture are ignored.
+
+#define CAPTURE_MAX_SENSORS 8
+#define CAPTURE_MAX_RULES 4
+#define CAPTURE_MAX_CAPACITY 65536
+#define CAPTURE_MAGNITUDE (-1) // Rule lane for the magnitude of x, y, z
+
+typedef struct {
+    uint8_t sensor_id;
+    uint8_t lanes;
+    uint32_t capacity;
+    uint64_t written;
+    double *timestamps; // `capacity`
+    float *values;      // `lanes` per sample
+    // The window, once captured
+    uint32_t count;
+    double *window_timestamps;
+    float *window_values;
+} capture_ring_t;
+
+typedef struct {
+    uint8_t sensor_id;
+    int8_t lane;  // Or CAPTURE_MAGNITUDE
+    float above;  // Triggers when the value is above this, NaN to not check
+    float below;  // Likewise, below
+} capture_rule_t;
+
+typedef struct {
+    capture_ring_t rings[CAPTURE_MAX_SENSORS];
+    uint8_t ring_count;
+    uint64_t trigger_mask; // Sensors whose reports trigger
+    capture_rule_t rules[CAPTURE_MAX_RULES];
+    uint8_t rule_count;
+    uint64_t pre_us;
+    uint64_t post_us;
+
+    bool capturing;
+    uint64_t trigger_us;
+    uint8_t trigger_sensor;
+
+    // The last window, until taken
+    bool ready;
+    uint64_t window_trigger_us;
+    uint8_t window_trigger_sensor;
+    bool truncated; // A ring didn't reach back `pre`
+    uint64_t missed; // Windows lost as the last wasn't taken yet
+} capture_t;
+
+/// Set up rings of `capacity` samples for `count` sensors. Triggers and
+/// rules are set in the struct afterwards. Returns false on a repeated or
+/// valueless sensor, or if out of memory.
+bool capture_init(capture_t *c, const uint8_t *sensor_ids, uint8_t count,
+                  uint32_t capacity, uint64_t pre_us, uint64_t post_us);
+
+void capture_free(capture_t *c);
+
+/// Handle a decoded report of any sensor: store it if captured, and check
+/// it for a trigger and the end of a capture.
+void capture_push(capture_t *c, uint8_t sensor_id, uint64_t timestamp_us,
+                  const float values[DECODED_VALUES_MAX]);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Smoothing of sensor event timestamps against the hub's clock.
+//
+// A timestamp from the driver is the host time the INT line (or the poll
+// tick) was seen, plus the hub's delay of the report. Interrupt latency adds
+// jitter to each of them, and the hub and host crystals drift apart. A sensor
+// with a report interval samples on the hub's clock, so its n:th report was
+// taken at `t0 + n * period`, with t0 and period in host time. Unwrapping the
+// 8-bit sequence number gives n, and a robust linear fit of the host
+// timestamps against n over a sliding window gives t0 and period. Reports are
+// then stamped with the fitted line, which is free of jitter and follows the
+// drift. Sensors that don't report periodically never lock and keep their
+// own timestamps.
+
+// Most reports a fit covers.
+#define CLOCK_SYNC_MAX_WINDOW 128
+#define CLOCK_SYNC_DEFAULT_WINDOW 64
+// Reports needed before a sensor locks.
+#define CLOCK_SYNC_MIN_SAMPLES 16
+
+typedef struct {
+    bool locked;       // Timestamps come from the fit
+    uint32_t samples;  // Reports in the window
+    double period_us;  // Fitted report period in host microseconds
+    double jitter_us;  // Robust spread of the timestamps around the fit
+    double drift_ppm;  // Of period_us against the nominal period
+} clock_sync_status_t;
+
+/// Enable or disable smoothing, and forget all fits. `window` is clamped to
+/// CLOCK_SYNC_MIN_SAMPLES..CLOCK_SYNC_MAX_WINDOW.
+void clock_sync_enable(bool enabled, uint32_t window);
+bool clock_sync_enabled(void);
+
+/// Add a report of `sensor_id` with its driver timestamp and return the
+/// smoothed one. `nominal_period_us` is the configured report interval, only
+/// used for drift_ppm; 0 if unknown. Timestamps returned for a sensor never
+/// go backwards.
+uint64_t clock_sync_update(uint8_t sensor_id, uint8_t sequence,
+                           uint64_t timestamp_us, uint32_t nominal_period_us);
+
+/// Returns false if the sensor has no reports in its window.
+bool clock_sync_status(uint8_t sensor_id, clock_sync_status_t *out);
+
+/// Forget the fit of one sensor, e.g. when its report interval changes.
+void clock_sync_reset(uint8_t sensor_id);
+
+/// Forget all fits, e.g. when the hub session is closed.
+void clock_sync_reset_all(void);
+
+#endif
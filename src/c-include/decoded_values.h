@@ -0,0 +1,21 @@
+#ifndef DECODED_VALUES_H
+#define DECODED_VALUES_H
+
+#include <stdint.h>
+
+#include "sh2/sh2_SensorValue.h"
+
+// Most values any sensor decodes to (dead reckoning pose has 13).
+#define DECODED_VALUES_MAX 13
+
+/// Flatten the decoded payload of `sv` into `out`. Integer fields are
+/// converted to float. Returns the number of values written, 0 for sensors
+/// without a flat layout.
+uint8_t decode_sensor_values(const sh2_SensorValue_t *sv,
+                             float out[DECODED_VALUES_MAX]);
+
+/// Names of the values decode_sensor_values(..) produces for `sensor_id`, in
+/// the same order. `count` is set to 0 for sensors without a flat layout.
+const char *const *decoded_value_names(uint8_t sensor_id, uint8_t *count);
+
+#endif
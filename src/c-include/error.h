@@ -22,3 +22,4 @@ extern const char* ERROR_CLOSING_SCOPE;
 extern const char* THREADING_ERROR;
 
 extern const char* I2C_ERROR;
+extern const char* RECORDING_ERROR;
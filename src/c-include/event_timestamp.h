@@ -0,0 +1,30 @@
+#ifndef EVENT_TIMESTAMP_H
+#define EVENT_TIMESTAMP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Representation of the timestamp of SensorEvent objects.
+typedef enum {
+    // `timestampMicroseconds` as a BigInt of host microseconds.
+    TIMESTAMP_BIGINT,
+    // `timestampMicroseconds` as a number of microseconds since the session
+    // epoch, the timestamp of the first event after setSensorCallback(..).
+    TIMESTAMP_FLOAT64,
+    // `timestampMicrosecondsHi` and `timestampMicrosecondsLo`, the upper and
+    // lower 32 bits of the BigInt value as numbers.
+    TIMESTAMP_HILO,
+} timestamp_format_t;
+
+/// Set the format and start a new session; the next event sets the epoch.
+void set_timestamp_format(timestamp_format_t format);
+timestamp_format_t get_timestamp_format(void);
+
+/// Microseconds from the session epoch to `timestamp_us`. The first call of
+/// a session sets the epoch and returns 0.
+double timestamp_relative_us(uint64_t timestamp_us);
+
+/// Returns false if no event has set the epoch yet.
+bool timestamp_epoch(uint64_t *epoch_us);
+
+#endif
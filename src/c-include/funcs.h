@@ -2,8 +2,38 @@
 #define FUNCS_H
 
 #include <node/node_api.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sh2/sh2.h"
+#include "sh2_hal_supplement.h"
+
+// Outcome of a budgeted service(..) call.
+typedef struct {
+    uint32_t transfers;    // Full SHTP transfers read from the hub
+    uint32_t serviceCalls; // sh2_service() rounds run
+    bool idle;             // Hub reported no more data before budget ran out
+    uint32_t elapsed_us;   // Wall time spent draining
+} service_stats_t;
+
+// Host side counters merged by getMetrics(..).
+typedef struct {
+    sh2_DriverStats_t driver; // SHTP transport and sh2 driver
+    hal_stats_t bus;          // I2C reads and writes
+    uint64_t poll_overruns;   // Poll timer ticks the main thread missed
+} metrics_t;
+
+// Set up the state of an environment loading the addon. Returns false on
+// failure.
+bool init_addon_state(napi_env env);
+
+// Call sh2_service() until the hub reports no data, or until either budget
+// runs out. A zero budget means unlimited, but not both. Stops early if a
+// read fails or isn't made, a callback throws, or the hub opened by `owner`
+// (the addon state, NULL for none) is closed or replaced.
+service_stats_t service_until_idle(napi_env env, const void *owner,
+                                   uint32_t max_transfers, uint32_t max_us);
 
-extern napi_env _global_env_dont_touch;
 napi_value cb_setI2CSettings(napi_env env, napi_callback_info info);
 napi_value cb_getI2CSettings(napi_env env, napi_callback_info _);
 napi_value cb_sh2_open(napi_env env, napi_callback_info info);
@@ -12,12 +42,56 @@ napi_value cb_service(napi_env env, napi_callback_info info);
 napi_value cb_setSensorCallback(napi_env env, napi_callback_info info);
 napi_value cb_get_sensor_config(napi_env env, napi_callback_info info);
 napi_value cb_set_sensor_config(napi_env env, napi_callback_info info);
+napi_value cb_flush(napi_env env, napi_callback_info info);
 napi_value cb_devOn(napi_env env, napi_callback_info info);
 napi_value cb_devReset(napi_env env, napi_callback_info info);
 napi_value cb_devSleep(napi_env env, napi_callback_info info);
 napi_value cb_setFrs(napi_env env, napi_callback_info info);
 napi_value cb_getFrs(napi_env env, napi_callback_info info);
 napi_value cb_use_interrupts(napi_env env, napi_callback_info info);
+napi_value cb_use_polling(napi_env env, napi_callback_info info);
+napi_value cb_stop_polling(napi_env env, napi_callback_info info);
+napi_value cb_get_latest(napi_env env, napi_callback_info info);
+napi_value cb_get_timestamp_epoch(napi_env env, napi_callback_info info);
+napi_value cb_subscribe(napi_env env, napi_callback_info info);
+napi_value cb_unsubscribe(napi_env env, napi_callback_info info);
+napi_value cb_set_subscriber_paused(napi_env env, napi_callback_info info);
+napi_value cb_get_subscriber_stats(napi_env env, napi_callback_info info);
+napi_value cb_get_metrics(napi_env env, napi_callback_info info);
+napi_value cb_set_clock_sync(napi_env env, napi_callback_info info);
+napi_value cb_get_clock_sync(napi_env env, napi_callback_info info);
+napi_value cb_set_girv_ring(napi_env env, napi_callback_info info);
+napi_value cb_decode_fixed_point(napi_env env, napi_callback_info info);
+napi_value cb_set_euler_mode(napi_env env, napi_callback_info info);
+napi_value cb_quaternions_to_euler(napi_env env, napi_callback_info info);
+napi_value cb_start_recording(napi_env env, napi_callback_info info);
+napi_value cb_stop_recording(napi_env env, napi_callback_info info);
+napi_value cb_get_recording_stats(napi_env env, napi_callback_info info);
+napi_value cb_open_log(napi_env env, napi_callback_info info);
+napi_value cb_close_log(napi_env env, napi_callback_info info);
+napi_value cb_get_log_info(napi_env env, napi_callback_info info);
+napi_value cb_seek_log(napi_env env, napi_callback_info info);
+napi_value cb_read_log(napi_env env, napi_callback_info info);
+napi_value cb_replay_log(napi_env env, napi_callback_info info);
+napi_value cb_stop_replay(napi_env env, napi_callback_info info);
+napi_value cb_encode_log_stream(napi_env env, napi_callback_info info);
+napi_value cb_create_stream_decoder(napi_env env, napi_callback_info info);
+napi_value cb_decode_stream(napi_env env, napi_callback_info info);
+napi_value cb_export_log_to_arrow(napi_env env, napi_callback_info info);
+napi_value cb_set_history(napi_env env, napi_callback_info info);
+napi_value cb_history_window(napi_env env, napi_callback_info info);
+napi_value cb_history_last(napi_env env, napi_callback_info info);
+napi_value cb_history_since(napi_env env, napi_callback_info info);
+napi_value cb_start_resampler(napi_env env, napi_callback_info info);
+napi_value cb_stop_resampler(napi_env env, napi_callback_info info);
+napi_value cb_set_stats(napi_env env, napi_callback_info info);
+napi_value cb_get_stats(napi_env env, napi_callback_info info);
+napi_value cb_set_allan_variance(napi_env env, napi_callback_info info);
+napi_value cb_get_allan_variance(napi_env env, napi_callback_info info);
+napi_value cb_start_spectrum(napi_env env, napi_callback_info info);
+napi_value cb_stop_spectrum(napi_env env, napi_callback_info info);
+napi_value cb_start_capture(napi_env env, napi_callback_info info);
+napi_value cb_stop_capture(napi_env env, napi_callback_info info);
 napi_value cb_store_current_dynamic_calibration(napi_env env,
                                                 napi_callback_info info);
 
@@ -0,0 +1,35 @@
+#ifndef GIRV_RING_H
+#define GIRV_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sh2/sh2_SensorValue.h"
+
+// Ring of decoded gyro-integrated rotation vector reports in a Float64Array,
+// for head tracking at the full report rate without an object per report.
+//
+// The array starts with a header of GIRV_RING_HEADER values:
+//   [0] Records written since the ring was set up
+//   [1] Capacity, in records
+// followed by `capacity` records of GIRV_RING_RECORD values each:
+//   timestamp (host microseconds), i, j, k, real, angVelX, angVelY, angVelZ
+// Record `n` (counting from 0) is at GIRV_RING_HEADER + (n % capacity) *
+// GIRV_RING_RECORD. The count is updated after the record is written.
+
+#define GIRV_RING_HEADER 4
+#define GIRV_RING_RECORD 8
+#define GIRV_RING_MAX_CAPACITY 65536
+
+/// Number of doubles a ring of `capacity` records takes.
+size_t girv_ring_length(uint32_t capacity);
+
+/// Set up the header of a zeroed ring.
+void girv_ring_init(double *ring, uint32_t capacity);
+
+/// Append a decoded SH2_GYRO_INTEGRATED_RV value stamped `timestamp_us`,
+/// overwriting the oldest record once the ring is full.
+void girv_ring_push(double *ring, const sh2_SensorValue_t *sv,
+                    uint64_t timestamp_us);
+
+#endif
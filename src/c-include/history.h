@@ -0,0 +1,63 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "decoded_values.h"
+
+// History of the decoded values of one sensor, kept as a structure of
+// arrays: a column of timestamps and a column per value. Charting,
+// statistics and the like read their windows straight from the columns.
+//
+// Each sample is written twice, at slot n % capacity and capacity slots
+// after it. Any run of up to `capacity` consecutive samples is then in one
+// piece in every column, so a query is a view into the columns and never a
+// copy, even where it wraps around.
+//
+// Samples are numbered from 0 in the order they were pushed; a range is
+// [first, end) of these numbers and only covers retained samples.
+
+typedef struct {
+    uint32_t capacity;
+    uint8_t lanes;
+    uint64_t written;   // Samples pushed
+    double *timestamps; // 2 * capacity, host microseconds
+    float *values;      // `lanes` columns of 2 * capacity, one after another
+} history_t;
+
+/// Bytes of memory a history takes: the timestamps, then the values.
+size_t history_bytes(uint32_t capacity, uint8_t lanes);
+
+/// Set up a history in `memory` of history_bytes(..), 8 byte aligned.
+/// `capacity` is at least 1.
+void history_init(history_t *h, void *memory, uint32_t capacity,
+                  uint8_t lanes);
+
+/// Append a sample, overwriting the oldest once full.
+void history_push(history_t *h, uint64_t timestamp_us,
+                  const float values[DECODED_VALUES_MAX]);
+
+/// Number of the oldest retained sample.
+uint64_t history_oldest(const history_t *h);
+
+/// Samples stamped from `from_us` to `to_us`, inclusive. Assumes that
+/// timestamps don't decrease, as with the host timestamps of one sensor.
+void history_window(const history_t *h, uint64_t from_us, uint64_t to_us,
+                    uint64_t *first, uint64_t *end);
+
+/// The last `n` samples, or fewer if not as many are retained.
+void history_last(const history_t *h, uint64_t n, uint64_t *first,
+                  uint64_t *end);
+
+/// Samples from number `cursor` on, e.g. the `end` of the previous query.
+/// Starts at the oldest retained if `cursor` was overwritten.
+void history_since(const history_t *h, uint64_t cursor, uint64_t *first,
+                   uint64_t *end);
+
+/// Slot in each column where the range starting at sample `first` is.
+static inline size_t history_slot(const history_t *h, uint64_t first) {
+    return first % h->capacity;
+}
+
+#endif
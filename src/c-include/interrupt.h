@@ -11,15 +11,31 @@
 
 typedef void (*irq_main_cb_t)(void *user);
 
+// How edges reach the main thread.
+typedef enum {
+    IRQ_MODE_NONE,
+    // A thread blocks in poll() and hands each edge over with uv_async.
+    // Latency doesn't depend on what the main thread is doing.
+    IRQ_MODE_WORKER,
+    // The GPIO fd is watched by the Node loop itself with uv_poll, and the
+    // hub is drained in the same callback. No extra thread or context
+    // switch, but edges wait whenever the main thread is busy.
+    IRQ_MODE_UV_POLL,
+} irq_mode_t;
+
 // Request falling-edge events. Returns FD on success, -1 on error.
 int setup_interrupts(const char *chipname, unsigned int line_num);
 
-// Start background watcher; on_main runs on Node’s main thread.
-int start_irq_worker(uv_loop_t *loop, irq_main_cb_t on_main, void *user);
+// Start watching for edges; on_main runs on Node’s main thread.
+int start_irq_worker(uv_loop_t *loop, irq_mode_t mode, irq_main_cb_t on_main,
+                     void *user);
 
-// Stop background watcher and close async handle (call on main thread).
+// Stop watching and close the libuv handles (call on main thread).
 void stop_irq_worker(void);
 
+// True between start_irq_worker() and stop_irq_worker().
+bool irq_worker_running(void);
+
 // Release GPIO line/chip (call after stopping).
 void teardown_interrupts(void);
 
@@ -0,0 +1,37 @@
+#ifndef LATEST_TABLE_H
+#define LATEST_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "decoded_values.h"
+#include "sh2/sh2_SensorValue.h"
+
+// Latest decoded value of each sensor, for consumers that only want the
+// current state and read it at their own rate.
+//
+// Slots are written on the main thread as reports are dispatched. Each slot
+// is guarded by a seqlock, so a reader on any thread gets a consistent copy
+// without blocking the writer.
+
+typedef struct {
+    uint8_t sensorId;
+    uint8_t sequence;
+    uint8_t accuracy; // 0..3, same as SensorEvent.calibrationStatus
+    uint8_t count;    // Number of valid entries in values
+    uint64_t timestamp_us;
+    int64_t delay_us;
+    float values[DECODED_VALUES_MAX];
+} latest_value_t;
+
+/// Store the decoded value as the latest of its sensor.
+void latest_table_store(const sh2_SensorValue_t *sv, int64_t delay_us);
+
+/// Copy the latest value of `sensor_id` into `out`. Returns false if the
+/// sensor hasn't reported since the last reset.
+bool latest_table_load(uint8_t sensor_id, latest_value_t *out);
+
+/// Forget all values, e.g. when the hub session is closed.
+void latest_table_reset(void);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LOG_READER_H
+#define LOG_READER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "decoded_values.h"
+#include "recorder.h"
+#include "sh2/sh2.h"
+
+// Reading of files written by the recorder, mapped into memory.
+//
+// Seeking by time uses a sparse index: for every LOG_INDEX_STRIDE records,
+// the latest timestamp up to the end of that block. Timestamps of different
+// sensors may be slightly out of order in a log, and the running maximum
+// still allows a binary search: every record before the first block whose
+// entry reaches `t` is earlier than `t`. The index is saved next to the log
+// as `<path>.idx` and loaded from there while it matches the log.
+
+#define LOG_INDEX_STRIDE 1024
+#define LOG_INDEX_MAGIC "BNO08XIX"
+#define LOG_INDEX_VERSION 1
+
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t map_size;
+    recorder_header_t header; // The valid slot with the highest generation
+    uint64_t count;           // Committed records
+    const recorder_record_t *records;
+    uint64_t *index;
+    uint64_t index_len;
+    bool index_loaded; // From `<path>.idx` rather than built
+} log_reader_t;
+
+/// Map the log at `path` and load or build its index. Returns 0, an errno
+/// value, or EPROTO if the file isn't a log with a valid header.
+int log_open(const char *path, log_reader_t *log);
+
+void log_close(log_reader_t *log);
+
+/// Index of the first record at or after `timestamp_us`, log->count if none.
+uint64_t log_seek(const log_reader_t *log, uint64_t timestamp_us);
+
+/// Values of a record, decoded from the report for raw logs. Returns the
+/// number of values, 0 if the record can't be decoded.
+uint8_t log_record_values(const log_reader_t *log,
+                          const recorder_record_t *record,
+                          float out[DECODED_VALUES_MAX]);
+
+/// Values decoded from the report of a raw record, as log_record_values(..).
+uint8_t log_report_values(const recorder_record_t *record,
+                          float out[DECODED_VALUES_MAX]);
+
+/// Event view of a record of a raw log, for replay. Only valid while the log
+/// is open. Returns false if the record's length isn't that of its report,
+/// as in a corrupt log; the view mustn't be used then.
+bool log_record_view(const recorder_record_t *record,
+                     sh2_SensorEventView_t *view);
+
+#endif
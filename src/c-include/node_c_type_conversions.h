@@ -4,17 +4,51 @@
 
 #include <node/node_api.h>
 
+#include "clock_sync.h"
+#include "fanout_ring.h"
+#include "funcs.h"
+#include "latest_table.h"
+#include "log_reader.h"
+#include "recorder.h"
 #include "sh2/sh2.h"
+#include "sh2/sh2_SensorValue.h"
 
 // C->NAPI
 napi_value node_from_c_SensorConfig(napi_env env, sh2_SensorConfig_t *cfg);
 napi_value node_from_c_SensorEvent(napi_env env, sh2_SensorEvent_t *ev);
+// Same, for an event view already decoded into `sv`.
+napi_value node_from_c_SensorEventView(napi_env env,
+                                       const sh2_SensorEventView_t *ev,
+                                       const sh2_SensorValue_t *sv);
 napi_value node_from_c_AsyncEvent(napi_env env, sh2_AsyncEvent_t *ev);
 napi_value node_from_c_SensorConfigResp(napi_env env,
                                         sh2_SensorConfigResp_t *cfg);
+napi_value node_from_c_ServiceStats(napi_env env, service_stats_t *stats);
+napi_value node_from_c_LatestValue(napi_env env, latest_value_t *latest);
+napi_value node_from_c_SubscriberStats(napi_env env, fanout_stats_t *stats);
+napi_value node_from_c_Metrics(napi_env env, metrics_t *metrics);
+napi_value node_from_c_SensorCounts(napi_env env, sh2_SensorId_t sensor_id,
+                                    sh2_Counts_t *counts);
+napi_value node_from_c_ErrorRecord(napi_env env, sh2_ErrorRecord_t *err);
+napi_value node_from_c_ClockSyncStatus(napi_env env,
+                                       clock_sync_status_t *sync);
+napi_value node_from_c_RecordingStats(napi_env env, recorder_stats_t *stats);
+napi_value node_from_c_LogInfo(napi_env env, log_reader_t *log);
+napi_value node_from_c_ArrowExport(napi_env env, uint8_t sensor_id,
+                                   const char *path, uint64_t rows);
 
 // NAPI->C
 int8_t node_to_c_SensorConfig(napi_env env, napi_value value,
                               sh2_SensorConfig_t *result);
 
+// Read an optional uint32 property of an options object. `result` is left
+// untouched if the property is missing.
+int8_t node_to_c_optional_uint32(napi_env env, napi_value obj,
+                                 const char *name, uint32_t *result);
+int8_t node_to_c_optional_bool(napi_env env, napi_value obj, const char *name,
+                               bool *result);
+// Copies at most len - 1 bytes and NUL terminates. Fails if truncated.
+int8_t node_to_c_optional_string(napi_env env, napi_value obj,
+                                 const char *name, char *buf, size_t len);
+
 #endif
@@ -0,0 +1,45 @@
+#ifndef POLL_TIMER_H
+#define POLL_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <uv.h>
+
+// Polling engine for boards without an INT line. A worker thread blocks on a
+// timerfd in epoll and wakes the main thread with a uv_async on every tick.
+
+typedef void (*poll_main_cb_t)(void *user);
+
+// Shortest and longest poll period accepted, in microseconds.
+#define POLL_TIMER_MIN_PERIOD_US 100
+#define POLL_TIMER_MAX_PERIOD_US 1000000
+
+// Start the poll thread; on_main runs on Node’s main thread once per tick.
+// Returns 0 on success, -1 on error.
+int start_poll_timer(uv_loop_t *loop, poll_main_cb_t on_main, void *user,
+                     uint32_t period_us);
+
+// Change the period of a running poll timer (call on main thread).
+int set_poll_timer_period(uint32_t period_us);
+
+// Enable phase alignment: ticks are moved to land `offset_us` after the hub
+// makes a report available. Since there is no INT line to say when that is,
+// the timer first polls slightly faster than the period until a tick finds
+// nothing, which places the arrival just after that tick. Once locked, an
+// empty tick or a tick with two reports means the phase slipped, and the
+// schedule is moved again.
+void set_poll_timer_phase(bool align, uint32_t offset_us);
+
+// Tell the timer how many reports the pacing sensor produced on this tick.
+// Call from on_main after servicing the hub.
+void poll_timer_report(uint32_t reports);
+
+// Stop the poll thread and close the async handle (call on main thread).
+void stop_poll_timer(void);
+
+bool poll_timer_running(void);
+
+// Ticks the poll thread missed because the main thread didn't keep up.
+uint64_t poll_timer_overruns(void);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef Q_DECODE_H
+#define Q_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Conversion of runs of Q-format fixed-point values to float, e.g. the x/y/z
+// or i/j/k/real of many reports of one sensor. The values of each report are
+// `lanes` little-endian int16 in a row, and reports are `stride` bytes apart.
+//
+// With 3 or 4 lanes the conversion is vectorized with NEON on ARM and SSE2
+// (AVX2 if compiled for it) on x86, a report at a time. Other lane counts
+// and other architectures use the scalar loop.
+
+/// Convert `count` reports starting at `src` into `out`, which receives
+/// `count * lanes` floats. Each value is scaled by 2^-q.
+void q_decode(const uint8_t *src, size_t stride, uint8_t lanes, uint8_t q,
+              size_t count, float *out);
+
+/// Same as q_decode(..), one value at a time. The reference for q_decode(..).
+void q_decode_scalar(const uint8_t *src, size_t stride, uint8_t lanes,
+                     uint8_t q, size_t count, float *out);
+
+/// Name of the instruction set q_decode(..) was compiled for.
+const char *q_decode_impl(void);
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <uv.h>
+
+#include "sh2/sh2.h"
+#include "sh2/sh2_SensorValue.h"
+
+// Native binary recording of sensor events, written from the service path
+// without going through JS.
+//
+// The file is pre-allocated for `capacity` records and mapped into memory;
+// each event is one fixed size record appended to the mapping. A libuv
+// worker periodically msync()s the new records and then commits their count
+// to the header, so after a crash or power loss the header never claims
+// records that weren't on disk. The header is kept in two slots, written in
+// turn with a generation number and a CRC-32. A reader takes the valid slot
+// with the highest generation, and a slot torn by a crash is simply skipped.
+// Once stopped cleanly, the file is trimmed to the records written.
+//
+// Layout, all little-endian:
+//   [0, RECORDER_HEADER_SIZE)  header page, slots at offsets 0 and 512
+//   then `capacity` records of RECORDER_RECORD_SIZE bytes
+
+#define RECORDER_MAGIC "BNO08XRC"
+#define RECORDER_VERSION 1
+#define RECORDER_HEADER_SIZE 4096
+#define RECORDER_HEADER_SLOT_SIZE 512
+#define RECORDER_RECORD_SIZE 80
+#define RECORDER_PAYLOAD_SIZE 64
+
+// Records a recording has room for unless set otherwise, about 80 MB.
+#define RECORDER_DEFAULT_CAPACITY (1u << 20)
+#define RECORDER_DEFAULT_SYNC_INTERVAL_MS 1000
+
+typedef enum {
+    RECORDER_RAW = 0,     // Payload is the report as sent by the hub
+    RECORDER_DECODED = 1, // Payload is the floats of decode_sensor_values(..)
+} recorder_format_t;
+
+// Set in recorder_header_t.flags when the recording was stopped cleanly.
+#define RECORDER_FLAG_CLOSED 0x1
+
+typedef struct {
+    char magic[8];         // RECORDER_MAGIC, no terminator
+    uint32_t version;      // RECORDER_VERSION
+    uint32_t header_size;  // Bytes before the first record
+    uint32_t record_size;  // RECORDER_RECORD_SIZE
+    uint32_t format;       // recorder_format_t
+    uint64_t capacity;     // Records the file has room for
+    uint64_t committed;    // Records known to be on disk
+    uint64_t sensor_mask;  // Bit n set if sensor id n is recorded
+    uint64_t start_monotonic_us; // Timestamp of the first record, 0 if none
+    uint64_t start_realtime_us;  // Wall clock at that timestamp
+    uint32_t generation;   // Incremented on every header write
+    uint32_t flags;        // RECORDER_FLAG_*
+    uint32_t crc;          // CRC-32 of the bytes before it
+    uint32_t reserved;
+} recorder_header_t;
+
+typedef struct {
+    uint64_t timestamp_us; // Host microseconds, as in SensorEvent
+    int32_t delay_us;
+    uint8_t sensor_id;
+    uint8_t sequence;
+    uint8_t status;        // Accuracy, 0..3
+    uint8_t len;           // Bytes of report, or number of values
+    union {
+        uint8_t report[RECORDER_PAYLOAD_SIZE];
+        float values[RECORDER_PAYLOAD_SIZE / sizeof(float)];
+    } payload;
+} recorder_record_t;
+
+typedef struct {
+    recorder_format_t format;
+    uint64_t sensor_mask; // 0 records all sensors
+    uint64_t capacity;    // Records
+    uint32_t sync_interval_ms;
+} recorder_options_t;
+
+typedef struct {
+    uint64_t records;   // Appended
+    uint64_t committed; // Synced to disk
+    uint64_t dropped;   // Didn't fit in the file
+} recorder_stats_t;
+
+/// CRC-32 (IEEE) of `len` bytes, as in recorder_header_t.crc.
+uint32_t recorder_crc32(const void *data, size_t len);
+
+/// Create `path` and start recording into it. Returns 0 on success, or an
+/// errno value; -1 if a recording is already running.
+int recorder_start(uv_loop_t *loop, const char *path,
+                   const recorder_options_t *options);
+
+bool recorder_active(void);
+
+/// Append an event. `sv` is the decoded value, NULL if it couldn't be
+/// decoded. Cheap when not recording.
+void recorder_append(const sh2_SensorEventView_t *event,
+                     const sh2_SensorValue_t *sv);
+
+/// Stats of the running recording. Returns false if not recording.
+bool recorder_stats(recorder_stats_t *out);
+
+/// Sync, trim and close the file. Returns 0, or the errno of the first
+/// failed write or sync of the recording. Returns -1 if not recording.
+int recorder_stop(recorder_stats_t *out);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef REPORT_SLAB_H
+#define REPORT_SLAB_H
+
+#include <node/node_api.h>
+#include <stddef.h>
+
+// Storage of the `report` bytes of SensorEvent objects.
+typedef enum {
+    // A Buffer per event, backed by its own malloc and freed by a finalizer.
+    REPORT_STORAGE_BUFFER,
+    // Uint8Array views into a shared 16 KiB ArrayBuffer slab. A new slab is
+    // created only when the current one is full, so there's no malloc or
+    // finalizer per event. A slab lives as long as any view into it does.
+    REPORT_STORAGE_SLAB,
+} report_storage_t;
+
+#define REPORT_SLAB_SIZE (16 * 1024)
+
+void set_report_storage(report_storage_t storage);
+report_storage_t get_report_storage(void);
+
+/// Copy `len` bytes into the current slab and return a Uint8Array view of
+/// them. Throws and returns NULL on error.
+napi_value report_slab_copy(napi_env env, const void *data, size_t len);
+
+/// Let go of the current slab; the next copy starts a new one.
+void report_slab_reset(napi_env env);
+
+#endif
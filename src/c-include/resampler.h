@@ -0,0 +1,76 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "decoded_values.h"
+
+// Alignment of several sensors to one time grid, e.g. accelerometer, gyro,
+// magnetometer and rotation vector for fusion.
+//
+// Decoded values of the selected sensors are queued as they arrive. A frame
+// for grid time t holds every sensor's values at t: interpolated linearly
+// between the samples around t, and with SLERP for the i/j/k/real of
+// quaternions. It's made once every sensor has a sample at or after t, or
+// once the newest sample of any of them is `latency` past t, so a sensor
+// that stalls delays frames by at most that. The stalled sensor's last
+// value is then held.
+//
+// Frames start at the first grid time after every sensor has reported.
+
+#define RESAMPLER_MAX_SENSORS 8
+#define RESAMPLER_QUEUE 256 // Samples kept per sensor
+#define RESAMPLER_MAX_FRAMES 4096 // Frames held for delivery
+
+typedef struct {
+    uint64_t timestamp_us;
+    float values[DECODED_VALUES_MAX];
+} resampler_sample_t;
+
+typedef struct {
+    uint8_t sensor_id;
+    uint8_t lanes;
+    bool quaternion; // Values start with i, j, k, real
+    uint16_t offset; // Of its values in a frame
+    resampler_sample_t queue[RESAMPLER_QUEUE];
+    uint32_t head;   // Oldest sample
+    uint32_t count;
+} resampler_stream_t;
+
+typedef struct {
+    resampler_stream_t streams[RESAMPLER_MAX_SENSORS];
+    uint8_t stream_count;
+    uint64_t sensor_mask;
+    uint16_t stride; // Values per frame
+
+    uint64_t period_us;
+    uint64_t latency_us;
+    uint64_t next_us;   // Grid time of the next frame, 0 until started
+    uint64_t latest_us; // Newest sample of any sensor
+
+    // Frames made since the last delivery
+    double timestamps[RESAMPLER_MAX_FRAMES];
+    float *values; // `stride` per frame
+    uint32_t frames;
+    uint64_t dropped; // Frames that didn't fit or were skipped over a gap
+} resampler_t;
+
+/// Set up a resampler of `count` sensors. Returns false if a sensor is
+/// repeated or the values don't fit in memory.
+bool resampler_init(resampler_t *r, const uint8_t *sensor_ids, uint8_t count,
+                    uint64_t period_us, uint64_t latency_us);
+
+void resampler_free(resampler_t *r);
+
+/// Queue a sample of a sensor and make the frames it completes. Samples of
+/// other sensors are ignored.
+void resampler_push(resampler_t *r, uint8_t sensor_id, uint64_t timestamp_us,
+                    const float values[DECODED_VALUES_MAX]);
+
+/// Spherical linear interpolation from quaternion `a` to `b` (i, j, k, real)
+/// by `u`, along the shorter arc.
+void resampler_slerp(const float a[4], const float b[4], float u,
+                     float out[4]);
+
+#endif
@@ -10,9 +10,45 @@ typedef struct {
     int i2c_fd;
 } i2c_settings_t;
 
+// Outcome of the most recent read_from_i2c(..) call. The HAL needs two reads
+// per SHTP transfer (header, then the full transfer), so callers draining the
+// hub use this to tell "hub is idle" apart from "call me again".
+typedef enum {
+    HAL_READ_IDLE,     // Hub had no data ready
+    HAL_READ_HEADER,   // Header read; the transfer is read on the next call
+    HAL_READ_TRANSFER, // A full SHTP transfer was handed to the driver
+    HAL_READ_ERROR,    // Read failed
+    HAL_READ_NONE,     // No read since hal_set_read_state(HAL_READ_NONE)
+} hal_read_state_t;
+
+// Bus traffic of the HAL, counted since the I2C device was opened.
+typedef struct {
+    uint32_t transfers;   // Full SHTP transfers read
+    uint32_t idle_reads;  // Header reads that found no data ready
+    uint32_t read_errors; // Failed reads
+    uint64_t read_bytes;  // Bytes read, headers included
+    uint32_t writes;      // Successful writes
+    uint32_t write_errors;
+    uint64_t write_bytes;
+} hal_stats_t;
+
 void set_i2c_settings(i2c_settings_t *settings);
 i2c_settings_t get_i2c_settings(void);
 
 sh2_Hal_t make_hal(void);
 
+hal_read_state_t hal_last_read_state(void);
+
+// Reset the state to HAL_READ_NONE before servicing, to tell whether the
+// driver read at all. Other HALs, e.g. stubs in tests, report theirs here.
+void hal_set_read_state(hal_read_state_t state);
+
+hal_stats_t hal_stats(void);
+
+// Error the HAL ran into that the user should hear about, e.g. the clock
+// stretching bug of the Raspberry Pi. The HAL runs inside sh2_*() calls and
+// can't throw, so the caller of the driver takes the message and throws it.
+// Returns NULL if there's none; the message is cleared once taken.
+const char *hal_take_error(void);
+
 #endif
@@ -0,0 +1,78 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "decoded_values.h"
+
+// Windowed FFT of selected values of a sensor, e.g. the x, y and z of the
+// accelerometer for vibration monitoring, so spectra or band energies go
+// out instead of the samples.
+//
+// The last `size` samples of each axis are kept. Every `hop` samples once
+// that many have arrived, they're multiplied by the window and transformed
+// with an in-place radix-2 FFT, giving a frame of either:
+//  - the one-sided amplitude spectrum, size / 2 + 1 bins, scaled so that a
+//    sinusoid centered on a bin reads as its amplitude, or
+//  - the mean square of each band, summed over the bins in [low, high) Hz
+//    and normalized by the window's power. Bands covering every bin add up
+//    to the mean square of the samples, as by Parseval.
+// Bin spacing comes from the timestamps of the frame's samples.
+
+#define SPECTRUM_MIN_SIZE 16
+#define SPECTRUM_MAX_SIZE 8192
+#define SPECTRUM_MAX_AXES 3
+#define SPECTRUM_MAX_BANDS 32
+#define SPECTRUM_MAX_FRAMES 64 // Frames held for delivery
+
+typedef enum {
+    SPECTRUM_HANN,
+    SPECTRUM_HAMMING,
+    SPECTRUM_RECTANGULAR,
+} spectrum_window_t;
+
+typedef struct {
+    uint32_t size; // Power of two
+    uint32_t hop;  // Samples between frames, 1 to size
+    uint8_t axes;
+    uint8_t lanes[SPECTRUM_MAX_AXES]; // Index of each axis' value
+    uint8_t bands;                     // 0 for spectra
+    float band_edges[SPECTRUM_MAX_BANDS + 1];
+    uint32_t outputs; // Values per axis in a frame: bins or bands
+
+    float *window;
+    double s1, s2; // Sums of the window and its squares
+    float *cos_table, *sin_table; // size / 2 twiddles
+    float *re, *im;               // FFT scratch
+    double *timestamps;           // Ring of the last `size` samples
+    float *ring;                  // Likewise, `size` per axis
+    uint64_t samples;
+
+    // Frames made since the last delivery
+    double frame_timestamps[SPECTRUM_MAX_FRAMES]; // Last sample's
+    double bin_hz[SPECTRUM_MAX_FRAMES];
+    float *frames_out; // `axes * outputs` per frame
+    uint32_t frames;
+    uint64_t dropped;
+} spectrum_t;
+
+/// Set up a spectrum of the values at `lanes`. `band_edges` has `bands + 1`
+/// ascending frequencies, or is NULL with `bands` 0 for amplitude spectra.
+/// Returns false on invalid arguments or if out of memory.
+bool spectrum_init(spectrum_t *s, const uint8_t *lanes, uint8_t axes,
+                   uint32_t size, uint32_t hop, spectrum_window_t window,
+                   const float *band_edges, uint8_t bands);
+
+void spectrum_free(spectrum_t *s);
+
+/// Queue a sample and make the frame it completes, if any.
+void spectrum_push(spectrum_t *s, uint64_t timestamp_us,
+                   const float values[DECODED_VALUES_MAX]);
+
+/// In-place FFT of `n` points, a power of two, with the tables of
+/// cos/sin(2 pi k / n) for k < n / 2.
+void spectrum_fft(float *re, float *im, uint32_t n, const float *cos_table,
+                  const float *sin_table);
+
+#endif
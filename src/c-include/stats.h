@@ -0,0 +1,83 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "decoded_values.h"
+
+// Running statistics of each decoded value of a sensor: mean, variance,
+// min, max and RMS, accumulated with Welford's method as samples arrive.
+//
+// Windows are counted in samples:
+//  - cumulative: every sample since the statistics were set up
+//  - tumbling: consecutive windows of `size` samples; a snapshot is of the
+//    last complete window, or of the first one until it completes
+//  - sliding: the last `size` samples. Each sample is added, and removed
+//    again `size` samples later, so the retained samples are kept. Min and
+//    max come from monotonic queues of them, and the sums are recomputed
+//    from them once per window to keep rounding from building up.
+
+#define STATS_MAX_SLIDING 65536 // Samples of a sliding window
+
+typedef enum {
+    STATS_CUMULATIVE,
+    STATS_TUMBLING,
+    STATS_SLIDING,
+} stats_window_t;
+
+typedef struct {
+    uint64_t count;
+    double mean;
+    double m2; // Sum of squared differences from the mean
+    double min;
+    double max;
+} welford_t;
+
+// Queue of ring slots whose values decrease (max) or increase (min)
+typedef struct {
+    uint32_t *slots; // `size` of them
+    uint32_t head;
+    uint32_t length;
+} stats_queue_t;
+
+typedef struct {
+    stats_window_t window;
+    uint32_t size;
+    uint8_t lanes;
+    uint64_t samples;      // Pushed since set up
+    uint64_t timestamp_us; // Of the last sample
+    welford_t acc[DECODED_VALUES_MAX];
+    // Tumbling: the last complete window
+    welford_t done[DECODED_VALUES_MAX];
+    uint64_t windows; // Complete tumbling windows
+    // Sliding: the last `size` values of each lane, one lane after another
+    float *ring;
+    stats_queue_t min[DECODED_VALUES_MAX];
+    stats_queue_t max[DECODED_VALUES_MAX];
+} stats_t;
+
+typedef struct {
+    double mean;
+    double variance; // Of the sample, 0 for less than two
+    double min;
+    double max;
+    double rms;
+} stats_value_t;
+
+/// Set up statistics of `lanes` values. `size` is ignored for cumulative
+/// statistics and at least 1 otherwise. Returns false if out of memory.
+bool stats_init(stats_t *s, stats_window_t window, uint32_t size,
+                uint8_t lanes);
+
+void stats_free(stats_t *s);
+
+void stats_push(stats_t *s, uint64_t timestamp_us,
+                const float values[DECODED_VALUES_MAX]);
+
+/// Statistics of each value in the current window. Returns the number of
+/// samples they're of; the values are NaN when 0.
+uint64_t stats_snapshot(const stats_t *s,
+                        stats_value_t out[DECODED_VALUES_MAX]);
+
+#endif
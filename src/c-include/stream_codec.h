@@ -0,0 +1,86 @@
+#ifndef STREAM_CODEC_H
+#define STREAM_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "recorder.h"
+
+// Compact encoding of the raw reports of one sensor, for logs and network
+// payloads. Consecutive reports of a sensor differ little, so each record
+// is stored as its difference to the one before:
+//
+//   flags      1 byte, STREAM_* bits for the fields that follow
+//   [len]      if STREAM_LEN, the report length
+//   [seq]      if STREAM_SEQ, the sequence number, else previous + 1
+//   [status]   if STREAM_STATUS, byte 2 of the report, else unchanged
+//   [delay]    if STREAM_DELAY, byte 3 of the report, else unchanged
+//   [delay_us] if STREAM_DELAY_US, zigzag varint of the change in delay_us
+//   timestamp  zigzag varint of the change in the timestamp interval
+//   values     zigzag varint of the change in each int16 after the 4 byte
+//              report header, wrapping; a last odd byte as is
+//
+// A stream starts with STREAM_MAGIC and the sensor id, and the first record
+// is relative to all zeros. At a steady rate, the timestamp usually takes
+// one byte, and slowly changing values one or two each.
+
+#define STREAM_MAGIC "BNZ1"
+#define STREAM_HEADER_SIZE 5
+
+// Most bytes one record can take.
+#define STREAM_MAX_RECORD 128
+
+#define STREAM_LEN 0x01
+#define STREAM_SEQ 0x02
+#define STREAM_STATUS 0x04
+#define STREAM_DELAY 0x08
+#define STREAM_DELAY_US 0x10
+
+typedef struct {
+    uint8_t sensor_id;
+    uint64_t timestamp_us;
+    int64_t interval_us;
+    int32_t delay_us;
+    uint8_t len;
+    uint8_t report[RECORDER_PAYLOAD_SIZE];
+} stream_state_t;
+
+typedef struct {
+    stream_state_t prev;
+    bool started; // The stream header was written
+} stream_encoder_t;
+
+typedef struct {
+    stream_state_t prev;
+    bool started; // The stream header was read
+    // Bytes of a record cut off at the end of the last input
+    uint8_t pending[STREAM_MAX_RECORD + STREAM_HEADER_SIZE];
+    size_t pending_len;
+} stream_decoder_t;
+
+typedef enum {
+    STREAM_CORRUPT = -1,
+    STREAM_NEED_MORE = 0,
+    STREAM_RECORD = 1,
+} stream_result_t;
+
+void stream_encoder_init(stream_encoder_t *enc, uint8_t sensor_id);
+
+/// Encode a record of a raw log into `out`, which has room for
+/// STREAM_MAX_RECORD + STREAM_HEADER_SIZE bytes. Returns the bytes written,
+/// 0 if the record isn't a report of the encoder's sensor.
+size_t stream_encode(stream_encoder_t *enc, const recorder_record_t *record,
+                     uint8_t *out);
+
+void stream_decoder_init(stream_decoder_t *dec);
+
+/// Decode the next record from `len` bytes at `in`, setting `used` to the
+/// bytes taken. Input may be split anywhere; a record cut off at the end is
+/// kept by the decoder, all of `in` is used and STREAM_NEED_MORE returned.
+/// After STREAM_CORRUPT the decoder must be initialized again.
+stream_result_t stream_decode(stream_decoder_t *dec, const uint8_t *in,
+                              size_t len, size_t *used,
+                              recorder_record_t *out);
+
+#endif
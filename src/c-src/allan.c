@@ -0,0 +1,104 @@
+#include "allan.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint8_t allan_levels(uint32_t max_cluster) {
+    if (max_cluster == 0 || max_cluster > 1u << (ALLAN_MAX_LEVELS - 1)) {
+        return 0;
+    }
+    uint8_t levels = 0;
+    while (levels < ALLAN_MAX_LEVELS && (1u << levels) <= max_cluster) {
+        levels++;
+    }
+    return levels;
+}
+
+bool allan_init(allan_t *a, uint8_t levels) {
+    memset(a, 0, sizeof(*a));
+    a->levels = levels;
+    a->capacity = (1u << levels) + 1;
+    // Θ(0) is 0 in every lane
+    a->sums = calloc((size_t)a->capacity * ALLAN_LANES, sizeof(double));
+    return a->sums != NULL;
+}
+
+void allan_free(allan_t *a) {
+    free(a->sums);
+    a->sums = NULL;
+}
+
+void allan_push(allan_t *a, uint64_t timestamp_us,
+                const float values[DECODED_VALUES_MAX]) {
+    if (a->samples == 0) {
+        a->first_us = timestamp_us;
+        memcpy(a->offset, values, sizeof(a->offset));
+    }
+    a->last_us = timestamp_us;
+    uint64_t n = ++a->samples;
+
+    for (uint8_t l = 0; l < ALLAN_LANES; l++) {
+        double *sums = a->sums + (size_t)l * a->capacity;
+        a->sum[l] += values[l] - a->offset[l];
+        sums[n % a->capacity] = a->sum[l];
+    }
+    for (uint8_t level = 0; level < a->levels; level++) {
+        uint64_t m = 1ULL << level;
+        if (n < 2 * m) { break; }
+        size_t mid = (n - m) % a->capacity;
+        size_t start = (n - 2 * m) % a->capacity;
+        for (uint8_t l = 0; l < ALLAN_LANES; l++) {
+            const double *sums = a->sums + (size_t)l * a->capacity;
+            double d = a->sum[l] - 2 * sums[mid] + sums[start];
+            a->squares[level][l] += d * d;
+        }
+        a->terms[level]++;
+    }
+}
+
+double allan_interval(const allan_t *a) {
+    if (a->samples < 2) { return NAN; }
+    return (double)(a->last_us - a->first_us) / (a->samples - 1) / 1e6;
+}
+
+double allan_deviation(const allan_t *a, uint8_t level, uint8_t lane) {
+    if (level >= a->levels || a->terms[level] == 0) { return NAN; }
+    double m = (double)(1ULL << level);
+    return sqrt(a->squares[level][lane] / (2 * m * m * a->terms[level]));
+}
+
+void allan_noise(const allan_t *a, uint8_t lane, allan_noise_t *out) {
+    *out = (allan_noise_t){NAN, NAN, NAN};
+    double interval = allan_interval(a);
+
+    double tau[ALLAN_MAX_LEVELS], dev[ALLAN_MAX_LEVELS];
+    uint8_t count = 0;
+    for (uint8_t level = 0; level < a->levels; level++) {
+        if (a->samples < ALLAN_MIN_CLUSTERS * (1ULL << level)) { break; }
+        tau[count] = interval * (1ULL << level);
+        dev[count] = allan_deviation(a, level, lane);
+        count++;
+    }
+    if (count < 2 || !(interval > 0)) { return; }
+
+    // Points where the log-log slope to the next is closest to -1/2 and 1/2
+    double white_error = INFINITY, walk_error = INFINITY;
+    double min = INFINITY;
+    for (uint8_t n = 0; n < count; n++) {
+        if (dev[n] < min) { min = dev[n]; }
+        if (n + 1 == count) { break; }
+        double slope = log2(dev[n + 1] / dev[n]);
+        if (fabs(slope + 0.5) < white_error) {
+            white_error = fabs(slope + 0.5);
+            out->noise_density = dev[n] * sqrt(tau[n]);
+        }
+        if (slope > 0 && fabs(slope - 0.5) < walk_error) {
+            walk_error = fabs(slope - 0.5);
+            out->rate_random_walk = dev[n + 1] * sqrt(3 / tau[n + 1]);
+        }
+    }
+    out->bias_instability = min / sqrt(2 * log(2) / M_PI);
+}
@@ -0,0 +1,446 @@
+#include "arrow_writer.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decoded_values.h"
+
+#define ARROW_MAGIC "ARROW1"
+#define ARROW_CONTINUATION 0xFFFFFFFFu
+
+// Format.fbs and Schema.fbs of the Arrow repository
+#define METADATA_V5 4
+#define HEADER_SCHEMA 1
+#define HEADER_RECORD_BATCH 3
+#define TYPE_INT 2
+#define TYPE_FLOATING_POINT 3
+#define PRECISION_SINGLE 1
+
+typedef enum { COL_INT64, COL_INT32, COL_UINT8, COL_FLOAT32 } column_type_t;
+
+typedef struct {
+    const char *name;
+    column_type_t type;
+} column_t;
+
+static const column_t HEADER_COLUMNS[4] = {
+    {"timestamp_us", COL_INT64},
+    {"delay_us", COL_INT32},
+    {"sequence", COL_UINT8},
+    {"status", COL_UINT8},
+};
+
+static size_t column_width(column_type_t type) {
+    switch (type) {
+        case COL_INT64: return 8;
+        case COL_INT32:
+        case COL_FLOAT32: return 4;
+        default: return 1;
+    }
+}
+
+static column_t column_at(const arrow_writer_t *w, size_t n) {
+    if (n < 4) { return HEADER_COLUMNS[n]; }
+    return (column_t){w->names[n - 4], COL_FLOAT32};
+}
+
+static void put_le(uint8_t *p, uint64_t v, size_t size) {
+    for (size_t i = 0; i < size; i++) { p[i] = (uint8_t)(v >> (8 * i)); }
+}
+
+// Flatbuffers, built front to back: every offset points forward to an
+// object written after it, and is patched once that object is written.
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t capacity;
+    bool failed;
+} fb_t;
+
+typedef struct {
+    uint8_t data[64]; // The table, starting with the offset to its vtable
+    uint16_t len;
+    uint16_t slots[8]; // Offset of each field in the table, 0 if absent
+    uint8_t slot_count;
+} fb_table_t;
+
+static bool fb_init(fb_t *fb, size_t capacity) {
+    fb->data = calloc(1, capacity);
+    fb->len = 0;
+    fb->capacity = capacity;
+    fb->failed = fb->data == NULL;
+    return !fb->failed;
+}
+
+// Reserve zeroed bytes at a position where `pos + skew` is a multiple of
+// `align`. Capacities are worked out beforehand, so running out is a bug.
+static size_t fb_reserve(fb_t *fb, size_t size, size_t align, size_t skew) {
+    size_t pos = (fb->len + skew + align - 1) / align * align - skew;
+    if (fb->failed || pos + size > fb->capacity) {
+        fb->failed = true;
+        return 0;
+    }
+    fb->len = pos + size;
+    return pos;
+}
+
+static void fb_patch(fb_t *fb, size_t at, size_t target) {
+    if (!fb->failed) { put_le(fb->data + at, target - at, 4); }
+}
+
+static size_t fb_root(fb_t *fb) { return fb_reserve(fb, 4, 8, 0); }
+
+static size_t fb_string(fb_t *fb, const char *s) {
+    size_t len = strlen(s);
+    size_t pos = fb_reserve(fb, 4 + len + 1, 4, 0);
+    if (fb->failed) { return 0; }
+    put_le(fb->data + pos, len, 4);
+    memcpy(fb->data + pos + 4, s, len);
+    return pos;
+}
+
+// A vector's elements follow its length and are aligned to `align`.
+// Returns the position of the length.
+static size_t fb_vector(fb_t *fb, size_t count, size_t size, size_t align) {
+    size_t pos = fb_reserve(fb, 4 + count * size, align < 4 ? 4 : align, 4);
+    if (!fb->failed) { put_le(fb->data + pos, count, 4); }
+    return pos;
+}
+
+static uint16_t tb_field(fb_table_t *t, uint8_t slot, size_t size) {
+    uint16_t off = (t->len + size - 1) / size * size;
+    t->len = off + size;
+    t->slots[slot] = off;
+    if (slot >= t->slot_count) { t->slot_count = slot + 1; }
+    return off;
+}
+
+static void tb_scalar(fb_table_t *t, uint8_t slot, uint64_t v, size_t size) {
+    put_le(t->data + tb_field(t, slot, size), v, size);
+}
+
+// A field to fb_patch(..) with the object it refers to; returns its
+// position relative to the table.
+static uint16_t tb_offset(fb_table_t *t, uint8_t slot) {
+    return tb_field(t, slot, 4);
+}
+
+static void tb_init(fb_table_t *t) {
+    memset(t, 0, sizeof(*t));
+    t->len = 4;
+}
+
+// Write the vtable and then the table. Returns the table position.
+static size_t fb_table(fb_t *fb, const fb_table_t *t) {
+    size_t vtable_size = 4 + 2 * t->slot_count;
+    size_t vtable = fb_reserve(fb, vtable_size, 2, 0);
+    size_t table = fb_reserve(fb, t->len, 8, 0);
+    if (fb->failed) { return 0; }
+    put_le(fb->data + vtable, vtable_size, 2);
+    put_le(fb->data + vtable + 2, t->len, 2);
+    for (uint8_t n = 0; n < t->slot_count; n++) {
+        put_le(fb->data + vtable + 4 + 2 * n, t->slots[n], 2);
+    }
+    memcpy(fb->data + table, t->data, t->len);
+    put_le(fb->data + table, table - vtable, 4);
+    return table;
+}
+
+// Schema {endianness, fields: [Field {name, nullable, type, children}]}
+static size_t fb_schema(fb_t *fb, const arrow_writer_t *w) {
+    fb_table_t t;
+    tb_init(&t);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    tb_scalar(&t, 0, 1, 2);
+#endif
+    uint16_t fields_at = tb_offset(&t, 1);
+    size_t schema = fb_table(fb, &t);
+
+    size_t count = 4 + w->lanes;
+    size_t fields = fb_vector(fb, count, 4, 4);
+    fb_patch(fb, schema + fields_at, fields);
+    for (size_t n = 0; n < count; n++) {
+        column_t col = column_at(w, n);
+        tb_init(&t);
+        uint16_t name_at = tb_offset(&t, 0);
+        tb_scalar(&t, 1, 0, 1); // nullable: false
+        tb_scalar(&t, 2,
+                  col.type == COL_FLOAT32 ? TYPE_FLOATING_POINT : TYPE_INT,
+                  1);
+        uint16_t type_at = tb_offset(&t, 3);
+        uint16_t children_at = tb_offset(&t, 5);
+        size_t field = fb_table(fb, &t);
+        fb_patch(fb, fields + 4 + 4 * n, field);
+        fb_patch(fb, field + name_at, fb_string(fb, col.name));
+
+        tb_init(&t);
+        if (col.type == COL_FLOAT32) {
+            tb_scalar(&t, 0, PRECISION_SINGLE, 2);
+        } else {
+            tb_scalar(&t, 0, 8 * column_width(col.type), 4); // bitWidth
+            tb_scalar(&t, 1, col.type != COL_UINT8, 1);      // is_signed
+        }
+        fb_patch(fb, field + type_at, fb_table(fb, &t));
+        fb_patch(fb, field + children_at, fb_vector(fb, 0, 4, 4));
+    }
+    return schema;
+}
+
+// Bytes the schema takes, with room to spare for alignment.
+static size_t schema_capacity(const arrow_writer_t *w) {
+    return 256 + (4 + w->lanes) * 192;
+}
+
+static void write_bytes(arrow_writer_t *w, const void *data, size_t len) {
+    if (w->error != 0 || len == 0) { return; }
+    if (fwrite(data, 1, len, w->file) != len) {
+        w->error = errno ? errno : EIO;
+        return;
+    }
+    w->offset += len;
+}
+
+static void write_padding(arrow_writer_t *w) {
+    static const uint8_t zeros[8] = {0};
+    write_bytes(w, zeros, (8 - w->offset % 8) % 8);
+}
+
+// Frame a message: continuation marker, metadata length, the flatbuffer
+// padded to 8 bytes. Returns the metadata length with its prefix.
+static int32_t write_message(arrow_writer_t *w, fb_t *fb) {
+    fb_reserve(fb, 0, 8, 0);
+    if (fb->failed) {
+        if (w->error == 0) { w->error = ENOMEM; }
+        return 0;
+    }
+    uint8_t prefix[8];
+    put_le(prefix, ARROW_CONTINUATION, 4);
+    put_le(prefix + 4, fb->len, 4);
+    write_bytes(w, prefix, sizeof(prefix));
+    write_bytes(w, fb->data, fb->len);
+    return (int32_t)(sizeof(prefix) + fb->len);
+}
+
+// Message {version, header_type, header, bodyLength}. Returns the position
+// of the header field to patch.
+static size_t fb_message(fb_t *fb, uint8_t header_type, int64_t body_length) {
+    fb_table_t t;
+    tb_init(&t);
+    tb_scalar(&t, 0, METADATA_V5, 2);
+    tb_scalar(&t, 1, header_type, 1);
+    uint16_t header_at = tb_offset(&t, 2);
+    tb_scalar(&t, 3, (uint64_t)body_length, 8);
+    size_t root = fb_root(fb);
+    size_t message = fb_table(fb, &t);
+    fb_patch(fb, root, message);
+    return message + header_at;
+}
+
+static size_t column_bytes(const arrow_writer_t *w, column_type_t type) {
+    return w->rows * column_width(type);
+}
+
+static const void *column_data(const arrow_writer_t *w, size_t n) {
+    switch (n) {
+        case 0: return w->timestamps;
+        case 1: return w->delays;
+        case 2: return w->sequences;
+        case 3: return w->statuses;
+        default: return w->values + (n - 4) * w->batch_rows;
+    }
+}
+
+static void write_batch(arrow_writer_t *w) {
+    if (w->rows == 0 || w->error != 0) { return; }
+    if (w->block_count == w->block_capacity) {
+        size_t capacity = w->block_capacity ? 2 * w->block_capacity : 16;
+        arrow_block_t *blocks =
+            realloc(w->blocks, capacity * sizeof(arrow_block_t));
+        if (blocks == NULL) {
+            w->error = ENOMEM;
+            return;
+        }
+        w->blocks = blocks;
+        w->block_capacity = capacity;
+    }
+
+    // Each column has an empty validity buffer and its values, padded
+    size_t count = 4 + w->lanes;
+    int64_t body_length = 0;
+    for (size_t n = 0; n < count; n++) {
+        body_length += (column_bytes(w, column_at(w, n).type) + 7) / 8 * 8;
+    }
+
+    fb_t fb;
+    if (!fb_init(&fb, 256 + count * 48)) {
+        w->error = ENOMEM;
+        return;
+    }
+    size_t header_at = fb_message(&fb, HEADER_RECORD_BATCH, body_length);
+
+    // RecordBatch {length, nodes: [FieldNode], buffers: [Buffer]}
+    fb_table_t t;
+    tb_init(&t);
+    tb_scalar(&t, 0, w->rows, 8);
+    uint16_t nodes_at = tb_offset(&t, 1);
+    uint16_t buffers_at = tb_offset(&t, 2);
+    size_t batch = fb_table(&fb, &t);
+    fb_patch(&fb, header_at, batch);
+
+    size_t nodes = fb_vector(&fb, count, 16, 8);
+    fb_patch(&fb, batch + nodes_at, nodes);
+    size_t buffers = fb_vector(&fb, 2 * count, 16, 8);
+    fb_patch(&fb, batch + buffers_at, buffers);
+    uint64_t offset = 0;
+    for (size_t n = 0; n < count && !fb.failed; n++) {
+        uint8_t *node = fb.data + nodes + 4 + 16 * n;
+        put_le(node, w->rows, 8); // length, and null_count 0
+        uint8_t *buffer = fb.data + buffers + 4 + 32 * n;
+        put_le(buffer, offset, 8); // Validity, empty
+        size_t len = column_bytes(w, column_at(w, n).type);
+        put_le(buffer + 16, offset, 8);
+        put_le(buffer + 24, len, 8);
+        offset += (len + 7) / 8 * 8;
+    }
+
+    arrow_block_t *block = &w->blocks[w->block_count];
+    block->offset = w->offset;
+    block->metadata_length = write_message(w, &fb);
+    block->body_length = body_length;
+    free(fb.data);
+    for (size_t n = 0; n < count; n++) {
+        write_bytes(w, column_data(w, n),
+                    column_bytes(w, column_at(w, n).type));
+        write_padding(w);
+    }
+    if (w->error == 0) { w->block_count++; }
+    w->rows = 0;
+}
+
+static void free_buffers(arrow_writer_t *w) {
+    free(w->timestamps);
+    free(w->delays);
+    free(w->sequences);
+    free(w->statuses);
+    free(w->values);
+    free(w->blocks);
+    memset(w, 0, sizeof(*w));
+}
+
+int arrow_open(arrow_writer_t *w, const char *path, uint8_t sensor_id,
+               uint32_t batch_rows) {
+    memset(w, 0, sizeof(*w));
+    if (batch_rows == 0) { return EINVAL; }
+    w->sensor_id = sensor_id;
+    w->names = decoded_value_names(sensor_id, &w->lanes);
+    w->batch_rows = batch_rows;
+    w->timestamps = malloc(batch_rows * sizeof(int64_t));
+    w->delays = malloc(batch_rows * sizeof(int32_t));
+    w->sequences = malloc(batch_rows);
+    w->statuses = malloc(batch_rows);
+    w->values = malloc((w->lanes ? w->lanes : 1) * (size_t)batch_rows *
+                       sizeof(float));
+    if (w->timestamps == NULL || w->delays == NULL || w->sequences == NULL ||
+        w->statuses == NULL || w->values == NULL) {
+        w->error = ENOMEM;
+    }
+    if (w->error == 0) {
+        w->file = fopen(path, "wb");
+        if (w->file == NULL) { w->error = errno; }
+    }
+
+    fb_t fb = {0};
+    if (w->error == 0 && !fb_init(&fb, schema_capacity(w))) {
+        w->error = ENOMEM;
+    }
+    if (w->error == 0) {
+        static const uint8_t magic[8] = ARROW_MAGIC;
+        write_bytes(w, magic, sizeof(magic));
+        size_t header_at = fb_message(&fb, HEADER_SCHEMA, 0);
+        fb_patch(&fb, header_at, fb_schema(&fb, w));
+        write_message(w, &fb);
+    }
+    free(fb.data);
+
+    int error = w->error;
+    if (error != 0) {
+        if (w->file != NULL) {
+            fclose(w->file);
+            remove(path);
+        }
+        free_buffers(w);
+    }
+    return error;
+}
+
+int arrow_append(arrow_writer_t *w, const recorder_record_t *record,
+                 const float values[DECODED_VALUES_MAX]) {
+    if (w->error != 0) { return w->error; }
+    uint32_t row = w->rows;
+    w->timestamps[row] = (int64_t)record->timestamp_us;
+    w->delays[row] = record->delay_us;
+    w->sequences[row] = record->sequence;
+    w->statuses[row] = record->status;
+    for (uint8_t l = 0; l < w->lanes; l++) {
+        w->values[l * w->batch_rows + row] = values[l];
+    }
+    w->rows++;
+    w->total_rows++;
+    if (w->rows == w->batch_rows) { write_batch(w); }
+    return w->error;
+}
+
+// Footer {version, schema, dictionaries: [], recordBatches: [Block]}
+static void write_footer(arrow_writer_t *w) {
+    fb_t fb;
+    if (!fb_init(&fb, schema_capacity(w) + 256 + 24 * w->block_count)) {
+        w->error = ENOMEM;
+        return;
+    }
+    fb_table_t t;
+    tb_init(&t);
+    tb_scalar(&t, 0, METADATA_V5, 2);
+    uint16_t schema_at = tb_offset(&t, 1);
+    uint16_t dictionaries_at = tb_offset(&t, 2);
+    uint16_t batches_at = tb_offset(&t, 3);
+    size_t root = fb_root(&fb);
+    size_t footer = fb_table(&fb, &t);
+    fb_patch(&fb, root, footer);
+    fb_patch(&fb, footer + schema_at, fb_schema(&fb, w));
+    fb_patch(&fb, footer + dictionaries_at, fb_vector(&fb, 0, 24, 8));
+    size_t batches = fb_vector(&fb, w->block_count, 24, 8);
+    fb_patch(&fb, footer + batches_at, batches);
+    for (size_t n = 0; n < w->block_count && !fb.failed; n++) {
+        uint8_t *block = fb.data + batches + 4 + 24 * n;
+        put_le(block, w->blocks[n].offset, 8);
+        put_le(block + 8, w->blocks[n].metadata_length, 4);
+        put_le(block + 16, w->blocks[n].body_length, 8);
+    }
+    if (fb.failed) {
+        w->error = ENOMEM;
+    } else {
+        uint8_t tail[10];
+        put_le(tail, fb.len, 4);
+        memcpy(tail + 4, ARROW_MAGIC, 6);
+        write_bytes(w, fb.data, fb.len);
+        write_bytes(w, tail, sizeof(tail));
+    }
+    free(fb.data);
+}
+
+int arrow_close(arrow_writer_t *w) {
+    if (w->file != NULL) {
+        write_batch(w);
+        if (w->error == 0) { write_footer(w); }
+        if (fclose(w->file) != 0 && w->error == 0) { w->error = errno; }
+    }
+    int error = w->error;
+    free_buffers(w);
+    return error;
+}
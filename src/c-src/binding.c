@@ -19,13 +19,22 @@ static uint8_t register_fn(napi_env env, napi_value exports, const char* name,
     return 0;
 }
 
-napi_value init(napi_env env, napi_value exports) {
+// Context-aware, so the addon can be loaded by several environments, e.g.
+// to drive the hub from a worker_thread.
+NAPI_MODULE_INIT() {
+    if (!init_addon_state(env)) {
+        napi_throw_error(env, "init c extension error",
+                         "couldn't set up addon state");
+        return NULL;
+    }
+
     register_fn(env, exports, "setI2CConfig", cb_setI2CSettings, NULL);
     register_fn(env, exports, "service", cb_service, NULL);
     register_fn(env, exports, "setSensorCallback", cb_setSensorCallback, NULL);
     register_fn(env, exports, "getSensorConfig", cb_get_sensor_config, NULL);
     register_fn(env, exports, "setSensorConfig", cb_set_sensor_config, NULL);
     register_fn(env, exports, "open", cb_sh2_open, NULL);
+    register_fn(env, exports, "flush", cb_flush, NULL);
     register_fn(env, exports, "devOn", cb_devOn, NULL);
     register_fn(env, exports, "devReset", cb_devReset, NULL);
     register_fn(env, exports, "devSleep", cb_devSleep, NULL);
@@ -34,9 +43,64 @@ napi_value init(napi_env env, napi_value exports) {
     register_fn(env, exports, "getFrs", cb_getFrs, NULL);
     // Expose interrupts setup
     register_fn(env, exports, "useInterrupts", cb_use_interrupts, NULL);
+    // Timer driven polling for boards without an INT line
+    register_fn(env, exports, "usePolling", cb_use_polling, NULL);
+    register_fn(env, exports, "stopPolling", cb_stop_polling, NULL);
+    register_fn(env, exports, "getLatest", cb_get_latest, NULL);
+    register_fn(env, exports, "getTimestampEpoch", cb_get_timestamp_epoch,
+                NULL);
+    // Fan-out of sensor events to several consumers
+    register_fn(env, exports, "subscribe", cb_subscribe, NULL);
+    register_fn(env, exports, "unsubscribe", cb_unsubscribe, NULL);
+    register_fn(env, exports, "setSubscriberPaused", cb_set_subscriber_paused,
+                NULL);
+    register_fn(env, exports, "getSubscriberStats", cb_get_subscriber_stats,
+                NULL);
+    register_fn(env, exports, "getMetrics", cb_get_metrics, NULL);
+    // Smoothing of event timestamps against the hub's clock
+    register_fn(env, exports, "setClockSync", cb_set_clock_sync, NULL);
+    register_fn(env, exports, "getClockSync", cb_get_clock_sync, NULL);
+    register_fn(env, exports, "setGirvRing", cb_set_girv_ring, NULL);
+    register_fn(env, exports, "decodeFixedPoint", cb_decode_fixed_point,
+                NULL);
+    register_fn(env, exports, "setEulerMode", cb_set_euler_mode, NULL);
+    register_fn(env, exports, "quaternionsToEuler", cb_quaternions_to_euler,
+                NULL);
+    register_fn(env, exports, "startRecording", cb_start_recording, NULL);
+    register_fn(env, exports, "stopRecording", cb_stop_recording, NULL);
+    register_fn(env, exports, "getRecordingStats", cb_get_recording_stats,
+                NULL);
+    register_fn(env, exports, "openLog", cb_open_log, NULL);
+    register_fn(env, exports, "closeLog", cb_close_log, NULL);
+    register_fn(env, exports, "getLogInfo", cb_get_log_info, NULL);
+    register_fn(env, exports, "seekLog", cb_seek_log, NULL);
+    register_fn(env, exports, "readLog", cb_read_log, NULL);
+    register_fn(env, exports, "replayLog", cb_replay_log, NULL);
+    register_fn(env, exports, "stopReplay", cb_stop_replay, NULL);
+    register_fn(env, exports, "encodeLogStream", cb_encode_log_stream, NULL);
+    register_fn(env, exports, "createStreamDecoder", cb_create_stream_decoder,
+                NULL);
+    register_fn(env, exports, "decodeStream", cb_decode_stream, NULL);
+    register_fn(env, exports, "exportLogToArrow", cb_export_log_to_arrow,
+                NULL);
+    register_fn(env, exports, "setHistory", cb_set_history, NULL);
+    register_fn(env, exports, "historyWindow", cb_history_window, NULL);
+    register_fn(env, exports, "historyLast", cb_history_last, NULL);
+    register_fn(env, exports, "historySince", cb_history_since, NULL);
+    register_fn(env, exports, "startResampler", cb_start_resampler, NULL);
+    register_fn(env, exports, "stopResampler", cb_stop_resampler, NULL);
+    register_fn(env, exports, "setStats", cb_set_stats, NULL);
+    register_fn(env, exports, "getStats", cb_get_stats, NULL);
+    register_fn(env, exports, "setAllanVariance", cb_set_allan_variance,
+                NULL);
+    register_fn(env, exports, "getAllanVariance", cb_get_allan_variance,
+                NULL);
+    register_fn(env, exports, "startSpectrum", cb_start_spectrum, NULL);
+    register_fn(env, exports, "stopSpectrum", cb_stop_spectrum, NULL);
+    register_fn(env, exports, "startCapture", cb_start_capture, NULL);
+    register_fn(env, exports, "stopCapture", cb_stop_capture, NULL);
     register_fn(env, exports, "storeCurrentDynamicCalibration",
                 cb_store_current_dynamic_calibration, NULL);
     
     return exports;
 }
-NAPI_MODULE(bno08x_native, init)
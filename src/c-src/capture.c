@@ -0,0 +1,128 @@
+#include "capture.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sh2/sh2.h"
+
+bool capture_init(capture_t *c, const uint8_t *sensor_ids, uint8_t count,
+                  uint32_t capacity, uint64_t pre_us, uint64_t post_us) {
+    memset(c, 0, sizeof(*c));
+    c->pre_us = pre_us;
+    c->post_us = post_us;
+    if (count > CAPTURE_MAX_SENSORS || capacity == 0 ||
+        capacity > CAPTURE_MAX_CAPACITY) {
+        return false;
+    }
+    uint64_t mask = 0;
+    for (uint8_t n = 0; n < count; n++) {
+        capture_ring_t *r = &c->rings[n];
+        r->sensor_id = sensor_ids[n];
+        if (r->sensor_id <= SH2_MAX_SENSOR_ID) {
+            decoded_value_names(r->sensor_id, &r->lanes);
+        }
+        if (r->lanes == 0 || (mask & (1ULL << r->sensor_id))) {
+            capture_free(c);
+            return false;
+        }
+        mask |= 1ULL << r->sensor_id;
+
+        // The timestamps of the ring and of the window, then their values
+        r->capacity = capacity;
+        r->timestamps =
+            malloc(2 * (size_t)capacity *
+                   (sizeof(double) + r->lanes * sizeof(float)));
+        if (r->timestamps == NULL) {
+            capture_free(c);
+            return false;
+        }
+        r->window_timestamps = r->timestamps + capacity;
+        r->values = (float *)(r->window_timestamps + capacity);
+        r->window_values = r->values + (size_t)capacity * r->lanes;
+        c->ring_count++;
+    }
+    return true;
+}
+
+void capture_free(capture_t *c) {
+    for (uint8_t n = 0; n < CAPTURE_MAX_SENSORS; n++) {
+        free(c->rings[n].timestamps);
+        c->rings[n].timestamps = NULL;
+    }
+}
+
+static bool rule_triggers(const capture_rule_t *rule,
+                          const float values[DECODED_VALUES_MAX]) {
+    float x = rule->lane == CAPTURE_MAGNITUDE
+                  ? sqrtf(values[0] * values[0] + values[1] * values[1] +
+                          values[2] * values[2])
+                  : values[rule->lane];
+    return x > rule->above || x < rule->below;
+}
+
+// Copy each ring's samples from `pre` before the trigger to `post` after.
+static void take_window(capture_t *c) {
+    uint64_t from = c->trigger_us > c->pre_us ? c->trigger_us - c->pre_us
+                                              : 0;
+    uint64_t to = c->trigger_us + c->post_us;
+    c->truncated = false;
+    for (uint8_t n = 0; n < c->ring_count; n++) {
+        capture_ring_t *r = &c->rings[n];
+        uint64_t oldest =
+            r->written > r->capacity ? r->written - r->capacity : 0;
+        if (oldest > 0 && r->timestamps[oldest % r->capacity] > from) {
+            c->truncated = true;
+        }
+        r->count = 0;
+        for (uint64_t s = oldest; s < r->written; s++) {
+            size_t slot = s % r->capacity;
+            double t = r->timestamps[slot];
+            if (t < from || t > to) { continue; }
+            r->window_timestamps[r->count] = t;
+            memcpy(r->window_values + (size_t)r->count * r->lanes,
+                   r->values + slot * r->lanes, r->lanes * sizeof(float));
+            r->count++;
+        }
+    }
+    c->window_trigger_us = c->trigger_us;
+    c->window_trigger_sensor = c->trigger_sensor;
+    c->ready = true;
+}
+
+void capture_push(capture_t *c, uint8_t sensor_id, uint64_t timestamp_us,
+                  const float values[DECODED_VALUES_MAX]) {
+    for (uint8_t n = 0; n < c->ring_count; n++) {
+        capture_ring_t *r = &c->rings[n];
+        if (r->sensor_id != sensor_id) { continue; }
+        size_t slot = r->written % r->capacity;
+        r->timestamps[slot] = (double)timestamp_us;
+        memcpy(r->values + slot * r->lanes, values, r->lanes * sizeof(float));
+        r->written++;
+        break;
+    }
+
+    if (!c->capturing) {
+        bool triggered = sensor_id <= SH2_MAX_SENSOR_ID &&
+                         (c->trigger_mask & (1ULL << sensor_id));
+        for (uint8_t n = 0; n < c->rule_count && !triggered; n++) {
+            triggered = c->rules[n].sensor_id == sensor_id &&
+                        rule_triggers(&c->rules[n], values);
+        }
+        if (!triggered) { return; }
+        c->capturing = true;
+        c->trigger_us = timestamp_us;
+        c->trigger_sensor = sensor_id;
+    }
+
+    if (timestamp_us > c->trigger_us + c->post_us) {
+        c->capturing = false;
+        if (c->ready) {
+            c->missed++;
+        } else {
+            take_window(c);
+        }
+    }
+}
@@ -0,0 +1,223 @@
+#include "clock_sync.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sh2/sh2.h"
+
+// Consecutive reports off the fit by more than a period before the fit is
+// dropped, e.g. after the report interval changed or more than 255 reports
+// were lost and the sequence number can't tell how many.
+#define MAX_MISFITS 4
+
+// MAD to standard deviation of a normal distribution
+#define MAD_SCALE 1.4826
+
+// Reports between fits. In between, and while reports fit, the last line
+// keeps stamping them; a fit of the full window takes tens of microseconds.
+#define REFIT_INTERVAL 16
+
+typedef struct {
+    uint64_t base_us; // Timestamp of the first report; y is relative to it
+    uint64_t n;       // Unwrapped sequence number of the latest report
+    uint8_t last_seq;
+    uint64_t last_out_us;
+    uint32_t misfits;
+    uint32_t since_fit; // Reports since the last fit
+
+    // Window of reports, oldest at head once full
+    uint32_t count;
+    uint32_t head;
+    uint64_t x[CLOCK_SYNC_MAX_WINDOW]; // Unwrapped sequence numbers
+    double y[CLOCK_SYNC_MAX_WINDOW];   // Timestamps, relative to base_us
+
+    // Fitted line y = y0 + slope * (x - x0)
+    bool locked;
+    uint64_t x0;
+    double y0;
+    double slope;
+    double jitter_us;
+} sensor_sync_t;
+
+static bool enabled = false;
+static uint32_t window = CLOCK_SYNC_DEFAULT_WINDOW;
+static sensor_sync_t syncs[SH2_MAX_SENSOR_ID + 1];
+static uint32_t nominal_periods[SH2_MAX_SENSOR_ID + 1];
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// Least squares line through the points whose `use` is set. Returns false if
+// there are fewer than two distinct x.
+static bool least_squares(const double *x, const double *y, const bool *use,
+                          uint32_t n, double *intercept, double *slope) {
+    double sx = 0, sy = 0;
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (!use[i]) { continue; }
+        sx += x[i];
+        sy += y[i];
+        m++;
+    }
+    if (m < 2) { return false; }
+    double mx = sx / m, my = sy / m;
+    double sxx = 0, sxy = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (!use[i]) { continue; }
+        sxx += (x[i] - mx) * (x[i] - mx);
+        sxy += (x[i] - mx) * (y[i] - my);
+    }
+    if (sxx == 0) { return false; }
+    *slope = sxy / sxx;
+    *intercept = my - *slope * mx;
+    return true;
+}
+
+// Fit the window: least squares, drop the points further than 3 sigma (from
+// the MAD) off it, and fit the rest again. Latency only ever delays a
+// timestamp, so the line is then lowered to the 10th percentile of the
+// residuals, near the reports that were stamped with the least latency.
+static void fit(sensor_sync_t *s) {
+    double x[CLOCK_SYNC_MAX_WINDOW];
+    double r[CLOCK_SYNC_MAX_WINDOW];
+    double sorted[CLOCK_SYNC_MAX_WINDOW];
+    bool use[CLOCK_SYNC_MAX_WINDOW];
+    uint32_t n = s->count;
+
+    s->since_fit = 0;
+    s->locked = false;
+    s->x0 = s->x[s->count < window ? 0 : s->head];
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] = (double)(s->x[i] - s->x0);
+        use[i] = true;
+    }
+    double intercept, slope;
+    if (!least_squares(x, s->y, use, n, &intercept, &slope)) { return; }
+
+    for (uint32_t i = 0; i < n; i++) {
+        r[i] = s->y[i] - (intercept + slope * x[i]);
+        sorted[i] = r[i];
+    }
+    qsort(sorted, n, sizeof(double), compare_doubles);
+    double median = sorted[n / 2];
+    for (uint32_t i = 0; i < n; i++) { sorted[i] = fabs(r[i] - median); }
+    qsort(sorted, n, sizeof(double), compare_doubles);
+    double sigma = MAD_SCALE * sorted[n / 2];
+
+    uint32_t inliers = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        use[i] = fabs(r[i] - median) <= 3 * sigma + 1.0;
+        inliers += use[i];
+    }
+    if (!least_squares(x, s->y, use, n, &intercept, &slope)) { return; }
+
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (use[i]) { sorted[m++] = s->y[i] - (intercept + slope * x[i]); }
+    }
+    qsort(sorted, m, sizeof(double), compare_doubles);
+
+    s->y0 = intercept + sorted[m / 10];
+    s->slope = slope;
+    s->jitter_us = sigma;
+    s->locked = n >= CLOCK_SYNC_MIN_SAMPLES && inliers * 2 >= n &&
+                slope > 0 && sigma < slope / 4;
+}
+
+void clock_sync_enable(bool enable, uint32_t window_size) {
+    if (window_size < CLOCK_SYNC_MIN_SAMPLES) {
+        window_size = CLOCK_SYNC_MIN_SAMPLES;
+    }
+    if (window_size > CLOCK_SYNC_MAX_WINDOW) {
+        window_size = CLOCK_SYNC_MAX_WINDOW;
+    }
+    enabled = enable;
+    window = window_size;
+    clock_sync_reset_all();
+}
+
+bool clock_sync_enabled(void) { return enabled; }
+
+uint64_t clock_sync_update(uint8_t sensor_id, uint8_t sequence,
+                           uint64_t timestamp_us, uint32_t nominal_period_us) {
+    if (sensor_id > SH2_MAX_SENSOR_ID) { return timestamp_us; }
+    sensor_sync_t *s = &syncs[sensor_id];
+    nominal_periods[sensor_id] = nominal_period_us;
+
+    if (s->count > 0) {
+        uint8_t step = (uint8_t)(sequence - s->last_seq);
+        s->n += step;
+        if (step == 0) {
+            // Same sequence number again; can't place it.
+            s->misfits = MAX_MISFITS;
+        } else if (s->locked) {
+            double predicted = s->y0 + s->slope * (double)(s->n - s->x0);
+            double actual = (double)(int64_t)(timestamp_us - s->base_us);
+            s->misfits = fabs(actual - predicted) > s->slope ? s->misfits + 1
+                                                             : 0;
+        }
+        if (s->misfits >= MAX_MISFITS) {
+            uint64_t last_out_us = s->last_out_us;
+            clock_sync_reset(sensor_id);
+            s->last_out_us = last_out_us;
+        }
+    }
+    if (s->count == 0) {
+        s->base_us = timestamp_us;
+        s->n = 0;
+    }
+    s->last_seq = sequence;
+
+    // Append, overwriting the oldest once the window is full
+    uint32_t i = s->count < window ? s->count++ : s->head;
+    if (s->count == window) { s->head = (i + 1) % window; }
+    s->x[i] = s->n;
+    s->y[i] = (double)(int64_t)(timestamp_us - s->base_us);
+    // Fit as soon as there are enough reports to lock, then now and then,
+    // and on every report off the line
+    s->since_fit++;
+    if (s->count >= CLOCK_SYNC_MIN_SAMPLES &&
+        (s->count == CLOCK_SYNC_MIN_SAMPLES ||
+         s->since_fit >= REFIT_INTERVAL || s->misfits > 0)) {
+        fit(s);
+    }
+
+    uint64_t out_us = timestamp_us;
+    if (s->locked) {
+        double y = s->y0 + s->slope * (double)(s->n - s->x0);
+        out_us = s->base_us + (int64_t)llround(y);
+    }
+    if (s->last_out_us != 0 && out_us <= s->last_out_us) {
+        out_us = s->last_out_us + 1;
+    }
+    s->last_out_us = out_us;
+    return out_us;
+}
+
+bool clock_sync_status(uint8_t sensor_id, clock_sync_status_t *out) {
+    if (sensor_id > SH2_MAX_SENSOR_ID || syncs[sensor_id].count == 0) {
+        return false;
+    }
+    const sensor_sync_t *s = &syncs[sensor_id];
+    uint32_t nominal = nominal_periods[sensor_id];
+    out->locked = s->locked;
+    out->samples = s->count;
+    out->period_us = s->slope;
+    out->jitter_us = s->jitter_us;
+    out->drift_ppm =
+        nominal != 0 && s->locked ? (s->slope / nominal - 1.0) * 1e6 : 0;
+    return true;
+}
+
+void clock_sync_reset(uint8_t sensor_id) {
+    if (sensor_id > SH2_MAX_SENSOR_ID) { return; }
+    memset(&syncs[sensor_id], 0, sizeof(sensor_sync_t));
+}
+
+void clock_sync_reset_all(void) { memset(syncs, 0, sizeof(syncs)); }
@@ -0,0 +1,122 @@
+#include "decoded_values.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sh2/sh2.h"
+#include "sh2/sh2_SensorValue.h"
+
+static const char *const XYZ[] = {"x", "y", "z"};
+static const char *const XYZ_TEMPERATURE[] = {"x", "y", "z", "temperature"};
+static const char *const XYZ_BIAS[] = {"x",     "y",     "z",
+                                       "biasX", "biasY", "biasZ"};
+static const char *const QUATERNION[] = {"i", "j", "k", "real"};
+static const char *const QUATERNION_ACCURACY[] = {"i", "j", "k", "real",
+                                                  "accuracy"};
+static const char *const QUATERNION_ANGVEL[] = {
+    "i", "j", "k", "real", "angVelX", "angVelY", "angVelZ"};
+static const char *const VALUE[] = {"value"};
+static const char *const STEPS[] = {"steps", "latency"};
+static const char *const LATENCY[] = {"latency"};
+static const char *const CLASSIFICATION[] = {"classification"};
+static const char *const FLAGS[] = {"flags"};
+static const char *const HEART_RATE[] = {"heartRate"};
+static const char *const POSE[] = {"linPosX", "linPosY", "linPosZ", "i",
+                                   "j",       "k",       "real",    "linVelX",
+                                   "linVelY", "linVelZ", "angVelX", "angVelY",
+                                   "angVelZ"};
+
+#define LAYOUT(names) {names, sizeof(names) / sizeof(names[0])}
+
+static const struct {
+    const char *const *names;
+    uint8_t count;
+} LAYOUTS[SH2_MAX_SENSOR_ID + 1] = {
+    [SH2_RAW_ACCELEROMETER] = LAYOUT(XYZ),
+    [SH2_ACCELEROMETER] = LAYOUT(XYZ),
+    [SH2_LINEAR_ACCELERATION] = LAYOUT(XYZ),
+    [SH2_GRAVITY] = LAYOUT(XYZ),
+    [SH2_RAW_GYROSCOPE] = LAYOUT(XYZ_TEMPERATURE),
+    [SH2_GYROSCOPE_CALIBRATED] = LAYOUT(XYZ),
+    [SH2_GYROSCOPE_UNCALIBRATED] = LAYOUT(XYZ_BIAS),
+    [SH2_RAW_MAGNETOMETER] = LAYOUT(XYZ),
+    [SH2_MAGNETIC_FIELD_CALIBRATED] = LAYOUT(XYZ),
+    [SH2_MAGNETIC_FIELD_UNCALIBRATED] = LAYOUT(XYZ_BIAS),
+    [SH2_ROTATION_VECTOR] = LAYOUT(QUATERNION_ACCURACY),
+    [SH2_GAME_ROTATION_VECTOR] = LAYOUT(QUATERNION),
+    [SH2_GEOMAGNETIC_ROTATION_VECTOR] = LAYOUT(QUATERNION_ACCURACY),
+    [SH2_PRESSURE] = LAYOUT(VALUE),
+    [SH2_AMBIENT_LIGHT] = LAYOUT(VALUE),
+    [SH2_HUMIDITY] = LAYOUT(VALUE),
+    [SH2_PROXIMITY] = LAYOUT(VALUE),
+    [SH2_TEMPERATURE] = LAYOUT(VALUE),
+    [SH2_TAP_DETECTOR] = LAYOUT(FLAGS),
+    [SH2_STEP_DETECTOR] = LAYOUT(LATENCY),
+    [SH2_STEP_COUNTER] = LAYOUT(STEPS),
+    [SH2_STABILITY_CLASSIFIER] = LAYOUT(CLASSIFICATION),
+    [SH2_HEART_RATE_MONITOR] = LAYOUT(HEART_RATE),
+    [SH2_ARVR_STABILIZED_RV] = LAYOUT(QUATERNION_ACCURACY),
+    [SH2_ARVR_STABILIZED_GRV] = LAYOUT(QUATERNION),
+    [SH2_GYRO_INTEGRATED_RV] = LAYOUT(QUATERNION_ANGVEL),
+    [SH2_DEAD_RECKONING_POSE] = LAYOUT(POSE),
+};
+
+const char *const *decoded_value_names(uint8_t sensor_id, uint8_t *count) {
+    if (sensor_id > SH2_MAX_SENSOR_ID) {
+        *count = 0;
+        return NULL;
+    }
+    *count = LAYOUTS[sensor_id].count;
+    return LAYOUTS[sensor_id].names;
+}
+
+uint8_t decode_sensor_values(const sh2_SensorValue_t *sv,
+                             float out[DECODED_VALUES_MAX]) {
+    switch (sv->sensorId) {
+        case SH2_RAW_ACCELEROMETER:
+            out[0] = sv->un.rawAccelerometer.x;
+            out[1] = sv->un.rawAccelerometer.y;
+            out[2] = sv->un.rawAccelerometer.z;
+            return 3;
+        case SH2_RAW_GYROSCOPE:
+            out[0] = sv->un.rawGyroscope.x;
+            out[1] = sv->un.rawGyroscope.y;
+            out[2] = sv->un.rawGyroscope.z;
+            out[3] = sv->un.rawGyroscope.temperature;
+            return 4;
+        case SH2_RAW_MAGNETOMETER:
+            out[0] = sv->un.rawMagnetometer.x;
+            out[1] = sv->un.rawMagnetometer.y;
+            out[2] = sv->un.rawMagnetometer.z;
+            return 3;
+        case SH2_TAP_DETECTOR:
+            out[0] = sv->un.tapDetector.flags;
+            return 1;
+        case SH2_STEP_DETECTOR:
+            out[0] = sv->un.stepDetector.latency;
+            return 1;
+        case SH2_STEP_COUNTER:
+            out[0] = sv->un.stepCounter.steps;
+            out[1] = sv->un.stepCounter.latency;
+            return 2;
+        case SH2_STABILITY_CLASSIFIER:
+            out[0] = sv->un.stabilityClassifier.classification;
+            return 1;
+        case SH2_HEART_RATE_MONITOR:
+            out[0] = sv->un.heartRateMonitor.heartRate;
+            return 1;
+        case SH2_DEAD_RECKONING_POSE:
+            // Skip the leading timestamp; the rest are floats.
+            memcpy(out, &sv->un.deadReckoningPose.linPosX,
+                   13 * sizeof(float));
+            return 13;
+        default: break;
+    }
+
+    // Everything else in the layout table is a struct of plain floats.
+    uint8_t count = 0;
+    decoded_value_names(sv->sensorId, &count);
+    memcpy(out, &sv->un, count * sizeof(float));
+    return count;
+}
@@ -21,3 +21,4 @@ const char* ERROR_EXECUTING_TEST = "ERROR_EXECUTING_TEST";
 const char* ASSERT_ERROR = "ASSERT_ERROR";
 const char* THREADING_ERROR = "THREADING_ERROR";
 const char* I2C_ERROR = "I2C_ERROR";
+const char* RECORDING_ERROR = "RECORDING_ERROR";
@@ -0,0 +1,34 @@
+#include "event_timestamp.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+static timestamp_format_t format = TIMESTAMP_BIGINT;
+
+static struct {
+    bool set;
+    uint64_t epoch_us;
+} session = {.set = false, .epoch_us = 0};
+
+void set_timestamp_format(timestamp_format_t f) {
+    format = f;
+    session.set = false;
+    session.epoch_us = 0;
+}
+
+timestamp_format_t get_timestamp_format(void) { return format; }
+
+double timestamp_relative_us(uint64_t timestamp_us) {
+    if (!session.set) {
+        session.set = true;
+        session.epoch_us = timestamp_us;
+    }
+    // Signed, so that an event older than the epoch doesn't wrap around.
+    return (double)(int64_t)(timestamp_us - session.epoch_us);
+}
+
+bool timestamp_epoch(uint64_t *epoch_us) {
+    if (!session.set) { return false; }
+    *epoch_us = session.epoch_us;
+    return true;
+}
@@ -0,0 +1,170 @@
+#include "fanout_ring.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sh2/sh2.h"
+
+typedef struct {
+    bool used;
+    bool paused;
+    fanout_options_t opts;
+    uint64_t cursor;  // Next sequence number to read
+    uint32_t pending; // Events this subscriber wants in [cursor, head)
+    uint64_t wanted;  // Events it wanted since subscribing
+    bool skipped;     // Skipped to the latest, deliver it regardless of batch
+    uint64_t delivered;
+    uint64_t dropped;
+} subscriber_t;
+
+static sh2_SensorEvent_t ring[FANOUT_RING_CAP];
+// Each subscriber's `wanted` before the event in the same slot, so events
+// it wanted can be counted without the slots they were overwritten in.
+static uint64_t wanted_before[FANOUT_RING_CAP][FANOUT_MAX_SUBSCRIBERS];
+static uint64_t head = 0; // Sequence number of the next event written
+static subscriber_t subs[FANOUT_MAX_SUBSCRIBERS];
+static uint8_t n_subs = 0;
+
+static bool wants(const subscriber_t *s, uint8_t sensor_id) {
+    if (s->opts.sensor_mask == 0) return true;
+    return sensor_id < 64 && (s->opts.sensor_mask >> sensor_id) & 1;
+}
+
+// Account for the event just written at `head`.
+static void published(uint8_t report_id) {
+    uint64_t *before = wanted_before[head & (FANOUT_RING_CAP - 1)];
+    head++;
+    for (int id = 0; id < FANOUT_MAX_SUBSCRIBERS; id++) {
+        before[id] = subs[id].wanted;
+        if (subs[id].used && wants(&subs[id], report_id)) {
+            subs[id].pending++;
+            subs[id].wanted++;
+        }
+    }
+}
+
+void fanout_publish(const sh2_SensorEvent_t *ev) {
+    if (n_subs == 0) return;
+    memcpy(&ring[head & (FANOUT_RING_CAP - 1)], ev, sizeof(*ev));
+    published(ev->reportId);
+}
+
+void fanout_publish_view(const sh2_SensorEventView_t *view) {
+    if (n_subs == 0) return;
+    sh2_SensorEvent_t *slot = &ring[head & (FANOUT_RING_CAP - 1)];
+    slot->timestamp_uS = view->timestamp_uS;
+    slot->delay_uS = view->delay_uS;
+    slot->len = view->len;
+    slot->reportId = view->reportId;
+    memcpy(slot->report, view->report, view->len);
+    published(view->reportId);
+}
+
+int fanout_subscribe(const fanout_options_t *opts) {
+    for (int id = 0; id < FANOUT_MAX_SUBSCRIBERS; id++) {
+        if (subs[id].used) continue;
+        subscriber_t *s = &subs[id];
+        memset(s, 0, sizeof(*s));
+        s->used = true;
+        s->opts = *opts;
+        if (s->opts.batch_size == 0) { s->opts.batch_size = 1; }
+        if (s->opts.max_pending == 0 ||
+            s->opts.max_pending > FANOUT_RING_CAP) {
+            s->opts.max_pending = FANOUT_RING_CAP;
+        }
+        if (s->opts.batch_size > s->opts.max_pending) {
+            s->opts.batch_size = s->opts.max_pending;
+        }
+        s->cursor = head; // Only events published from now on
+        n_subs++;
+        return id;
+    }
+    return -1;
+}
+
+void fanout_unsubscribe(int id) {
+    if (!fanout_is_subscribed(id)) return;
+    subs[id].used = false;
+    n_subs--;
+}
+
+bool fanout_is_subscribed(int id) {
+    return id >= 0 && id < FANOUT_MAX_SUBSCRIBERS && subs[id].used;
+}
+
+void fanout_set_paused(int id, bool paused) {
+    if (!fanout_is_subscribed(id)) return;
+    subs[id].paused = paused;
+}
+
+// Drop what the subscriber can't keep up with: events about to be
+// overwritten, and anything beyond max_pending per the lag policy.
+static void apply_lag_policy(subscriber_t *s) {
+    uint32_t keep = s->opts.lag_policy == FANOUT_SKIP_TO_LATEST
+                        ? 1
+                        : s->opts.max_pending;
+    if (s->pending <= s->opts.max_pending) { keep = s->opts.max_pending; }
+
+    if (head - s->cursor > FANOUT_RING_CAP) {
+        // Skip what's been overwritten. The events still in the ring that
+        // the subscriber wants are the ones it wanted since the oldest.
+        uint64_t oldest = head - FANOUT_RING_CAP;
+        int id = (int)(s - subs);
+        uint32_t kept = (uint32_t)(s->wanted -
+                                   wanted_before[oldest & (FANOUT_RING_CAP - 1)]
+                                                [id]);
+        s->dropped += s->pending - kept;
+        s->pending = kept;
+        s->cursor = oldest;
+    }
+
+    while (s->cursor != head && s->pending > keep) {
+        const sh2_SensorEvent_t *ev = &ring[s->cursor & (FANOUT_RING_CAP - 1)];
+        s->cursor++;
+        if (wants(s, ev->reportId)) {
+            s->pending--;
+            s->dropped++;
+            s->skipped = s->opts.lag_policy == FANOUT_SKIP_TO_LATEST;
+        }
+    }
+}
+
+uint32_t fanout_take(int id, sh2_SensorEvent_t *out, uint32_t max) {
+    if (!fanout_is_subscribed(id)) return 0;
+    subscriber_t *s = &subs[id];
+
+    apply_lag_policy(s);
+    if (s->paused || (s->pending < s->opts.batch_size && !s->skipped)) {
+        return 0;
+    }
+    s->skipped = false;
+
+    uint32_t n = 0;
+    while (s->cursor != head && n < max) {
+        const sh2_SensorEvent_t *ev = &ring[s->cursor & (FANOUT_RING_CAP - 1)];
+        s->cursor++;
+        if (!wants(s, ev->reportId)) continue;
+        memcpy(&out[n++], ev, sizeof(*ev));
+        s->pending--;
+    }
+    s->delivered += n;
+    return n;
+}
+
+bool fanout_stats(int id, fanout_stats_t *out) {
+    if (!fanout_is_subscribed(id)) return false;
+    subscriber_t *s = &subs[id];
+    apply_lag_policy(s);
+    out->pending = s->pending;
+    out->delivered = s->delivered;
+    out->dropped = s->dropped;
+    out->paused = s->paused;
+    return true;
+}
+
+void fanout_reset(void) {
+    memset(subs, 0, sizeof(subs));
+    n_subs = 0;
+    head = 0;
+}
@@ -0,0 +1,78 @@
+#include "fast_euler.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#include "sh2/euler.h"
+
+#define PI_F 3.14159265358979323846f
+#define PI_2_F 1.57079632679489661923f
+
+static euler_mode_t mode = EULER_EXACT;
+
+void euler_set_mode(euler_mode_t new_mode) { mode = new_mode; }
+
+euler_mode_t euler_mode(void) { return mode; }
+
+// atan(z) for 0 <= z <= 1
+static inline float atan_unit(float z) {
+    float z2 = z * z;
+    return z * (0.99997726f +
+                z2 * (-0.33262347f +
+                      z2 * (0.19354346f +
+                            z2 * (-0.11643287f +
+                                  z2 * (0.05265332f + z2 * -0.01172120f)))));
+}
+
+float fast_atan2f(float y, float x) {
+    float ax = fabsf(x), ay = fabsf(y);
+    float hi = ax > ay ? ax : ay;
+    float lo = ax > ay ? ay : ax;
+    // Reduce to the first octant and fold back
+    float a = hi == 0 ? 0 : atan_unit(lo / hi);
+    if (ay > ax) { a = PI_2_F - a; }
+    if (x < 0) { a = PI_F - a; }
+    return copysignf(a, y);
+}
+
+float fast_asinf(float x) {
+    float ax = fabsf(x);
+    if (ax > 1) { ax = 1; }
+    float p =
+        1.5707963050f +
+        ax * (-0.2145988016f +
+              ax * (0.0889789874f +
+                    ax * (-0.0501743046f +
+                          ax * (0.0308918810f +
+                                ax * (-0.0170881256f +
+                                      ax * (0.0066700901f +
+                                            ax * -0.0012624911f))))));
+    return copysignf(PI_2_F - sqrtf(1 - ax) * p, x);
+}
+
+void fast_q_to_ypr(float r, float i, float j, float k, float *yaw,
+                   float *pitch, float *roll) {
+    *yaw = fast_atan2f(2.0f * i * j - 2.0f * r * k,
+                       2.0f * r * r + 2.0f * j * j - 1.0f);
+    *pitch = fast_asinf(2.0f * j * k + 2.0f * r * i);
+    *roll = fast_atan2f(-2.0f * i * k + 2.0f * r * j,
+                        2.0f * r * r + 2.0f * k * k - 1.0f);
+}
+
+void q_to_ypr_batch(const float *quats, size_t count, euler_mode_t batch_mode,
+                    float *ypr) {
+    // Separate loops so the fast one has no calls and can be vectorized
+    if (batch_mode == EULER_FAST) {
+        for (size_t n = 0; n < count; n++) {
+            const float *q = &quats[n * 4];
+            fast_q_to_ypr(q[3], q[0], q[1], q[2], &ypr[n * 3],
+                          &ypr[n * 3 + 1], &ypr[n * 3 + 2]);
+        }
+        return;
+    }
+    for (size_t n = 0; n < count; n++) {
+        const float *q = &quats[n * 4];
+        q_to_ypr(q[3], q[0], q[1], q[2], &ypr[n * 3], &ypr[n * 3 + 1],
+                 &ypr[n * 3 + 2]);
+    }
+}
@@ -1,5 +1,7 @@
 #include "funcs.h"
 
+#include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -8,16 +10,36 @@
 #include <string.h>
 #include <uv.h>
 
+#include "allan.h"
+#include "arrow_writer.h"
+#include "capture.h"
+#include "clock_sync.h"
 #include "error.h"
+#include "event_timestamp.h"
+#include "fanout_ring.h"
+#include "fast_euler.h"
+#include "girv_ring.h"
+#include "history.h"
 #include "interrupt.h"
 #include "js_native_api.h"
 #include "js_native_api_types.h"
 #include "node_api.h"
+#include "latest_table.h"
+#include "log_reader.h"
 #include "node_c_type_conversions.h"
+#include "poll_timer.h"
+#include "q_decode.h"
+#include "recorder.h"
+#include "report_slab.h"
+#include "resampler.h"
 #include "sh2/sh2.h"
 #include "sh2/sh2_err.h"
+#include "sh2/sh2_SensorValue.h"
 #include "sh2/sh2_hal.h"
 #include "sh2_hal_supplement.h"
+#include "spectrum.h"
+#include "stats.h"
+#include "stream_codec.h"
 #include "uv.h"
 #include "uv/unix.h"
 
@@ -151,10 +173,249 @@ typedef struct {
     uv_thread_t thread;
 } cb_cookie_t;
 
-static cb_cookie_t *_sensor_callback;
-static cb_cookie_t *_async_event_callback;
+// State of one environment (the main thread or a worker_thread) that loaded
+// the addon. Set as its instance data, so nothing here outlives the env.
+typedef struct {
+    napi_env env;
+    cb_cookie_t *sensor_callback;
+    cb_cookie_t *async_event_callback;
+    // JS callbacks of fan-out subscribers, indexed by subscriber id
+    napi_ref subscriber_fns[FANOUT_MAX_SUBSCRIBERS];
+    // Pending flush(..) of each sensor, settled on SH2_FLUSH_COMPLETED. The
+    // promise is kept so repeated calls before completion share it.
+    napi_deferred flush_deferred[SH2_MAX_SENSOR_ID + 1];
+    napi_ref flush_promise[SH2_MAX_SENSOR_ID + 1];
+    // Ring that gyro-integrated RV reports go to instead of the callbacks,
+    // see setGirvRing(..). NULL if not set.
+    napi_ref girv_ring_ref;
+    double *girv_ring;
+    // History of each sensor's decoded values, see setHistory(..). The
+    // reference keeps its memory alive; NULL if not kept.
+    napi_ref history_refs[SH2_MAX_SENSOR_ID + 1];
+    history_t histories[SH2_MAX_SENSOR_ID + 1];
+    // Resampler of startResampler(..) and the callback its frames go to.
+    // NULL if not started.
+    resampler_t *resampler;
+    napi_ref resampler_fn;
+    // Statistics of each sensor's decoded values, see setStats(..). NULL if
+    // not kept.
+    stats_t *stats[SH2_MAX_SENSOR_ID + 1];
+    // Allan variance of each sensor's x, y and z, see setAllanVariance(..).
+    // NULL if not computed.
+    allan_t *allan[SH2_MAX_SENSOR_ID + 1];
+    // Spectrum analyzer of each sensor and the callback its frames go to,
+    // see startSpectrum(..). NULL if not started.
+    spectrum_t *spectra[SH2_MAX_SENSOR_ID + 1];
+    napi_ref spectrum_fns[SH2_MAX_SENSOR_ID + 1];
+    // Trigger capture of startCapture(..) and the callback its windows go
+    // to. NULL if not started.
+    capture_t *capture;
+    napi_ref capture_fn;
+} addon_state_t;
+
+// The hub, the driver and the I2C bus are process-wide, so one environment
+// drives them at a time: the one that opened the hub, until it closes it or
+// is torn down.
+static addon_state_t *_hub_owner;
+
+// Last configuration set for each sensor with setSensorConfig(..)
+static sh2_SensorConfig_t _sensor_configs[SH2_MAX_SENSOR_ID + 1];
+
+static void deliver_to_subscribers(addon_state_t *state);
+static void deliver_resampled(addon_state_t *state);
+static void deliver_spectra(addon_state_t *state);
+static void deliver_capture(addon_state_t *state);
+static void end_replay(void);
+
+// State of the timer driven polling mode (usePolling(..))
+static struct {
+    bool auto_period;        // Period follows the fastest configured sensor
+    uint8_t pacing_sensor;   // Sensor whose reports the phase locks onto
+    uint32_t pacing_reports; // Reports from pacing_sensor on this tick
+} _polling;
+
+// State of replayLog(..). Replayed events go through the sensor event hub
+// like live ones, so only one replay runs at a time and the hub can't be
+// opened meanwhile.
+static struct {
+    addon_state_t *state; // NULL when not replaying
+    log_reader_t *log;
+    napi_ref log_ref; // Keeps the log handle from being collected
+    napi_deferred deferred;
+    // Timer callbacks run in a callback scope of this, so that the promise
+    // and callbacks see their microtasks run.
+    napi_ref resource_ref;
+    napi_async_context async_context;
+    bool in_tick;
+    uv_timer_t *timer; // Freed once closed
+    uint64_t next; // Next record
+    uint64_t end;
+    uint64_t sensor_mask;
+    double speed; // 0 for as fast as possible
+    uint64_t first_us; // Timestamp of the first record
+    uint64_t start_ns; // uv_hrtime() when the replay started
+    uint64_t replayed;
+} _replay;
+
+static void free_cookie(napi_env env, cb_cookie_t *cookie) {
+    if (cookie == NULL) { return; }
+    napi_delete_reference(env, cookie->jsFn_ref);
+    napi_delete_reference(env, cookie->cookie_ref);
+    free(cookie);
+}
+
+// State of the calling environment. Throws and returns NULL on failure.
+static addon_state_t *get_state(napi_env env) {
+    addon_state_t *state = NULL;
+    if (napi_get_instance_data(env, (void **)&state) != napi_ok ||
+        state == NULL) {
+        napi_throw_error(env, UNKNOWN_ERROR, "Addon state is missing.");
+        return NULL;
+    }
+    return state;
+}
+
+// Like get_state(..), for calls that use the hub. Throws and returns NULL if
+// another environment has it open.
+static addon_state_t *hub_state(napi_env env) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+    if (_hub_owner != NULL && _hub_owner != state) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "The sensor hub is open in another thread.");
+        return NULL;
+    }
+    return state;
+}
+
+// Throw the error the HAL recorded during the preceding driver calls, if
+// any. The HAL runs inside sh2_*() and has no env of its own to throw on.
+static void throw_hal_error(napi_env env) {
+    const char *msg = hal_take_error();
+    if (msg == NULL) { return; }
+    bool pending = false;
+    napi_is_exception_pending(env, &pending);
+    if (!pending) { napi_throw_error(env, I2C_ERROR, msg); }
+}
+
+// Settle the pending flush(..) of `sensor_id`, if any. Rejects with `reason`
+// unless it's NULL.
+static void settle_flush(addon_state_t *state, uint8_t sensor_id,
+                         const char *reason) {
+    napi_env env = state->env;
+    napi_deferred deferred = state->flush_deferred[sensor_id];
+    if (deferred == NULL) { return; }
+    state->flush_deferred[sensor_id] = NULL;
+    napi_delete_reference(env, state->flush_promise[sensor_id]);
+    state->flush_promise[sensor_id] = NULL;
+
+    napi_value value;
+    if (reason == NULL) {
+        napi_get_undefined(env, &value);
+        napi_resolve_deferred(env, deferred, value);
+        return;
+    }
+    napi_value code, msg;
+    napi_create_string_utf8(env, ERROR_INTERACTING_WITH_DRIVER,
+                            NAPI_AUTO_LENGTH, &code);
+    napi_create_string_utf8(env, reason, NAPI_AUTO_LENGTH, &msg);
+    napi_create_error(env, code, msg, &value);
+    napi_reject_deferred(env, deferred, value);
+}
+
+static void close_hub(addon_state_t *state) {
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        settle_flush(state, id, "The sensor hub was closed.");
+    }
+    sh2_close();
+    stop_irq_worker();
+    stop_poll_timer();
+    latest_table_reset();
+    clock_sync_reset_all();
+    if (recorder_active()) {
+        recorder_stats_t stats;
+        (void)recorder_stop(&stats);
+    }
+    // The slab is referenced from this env; the next owner starts a new one.
+    report_slab_reset(state->env);
+    (void)hal_take_error();
+    _hub_owner = NULL;
+}
+
+// Runs while `state`'s environment is torn down (e.g. a worker exits), while
+// its loop can still close the interrupt and timer handles.
+static void release_hub_on_teardown(void *arg) {
+    addon_state_t *state = arg;
+    if (_hub_owner == state) { close_hub(state); }
+    if (_replay.state == state) { end_replay(); }
+    for (int id = 0; id < FANOUT_MAX_SUBSCRIBERS; id++) {
+        if (state->subscriber_fns[id] != NULL) { fanout_unsubscribe(id); }
+    }
+}
+
+static void free_addon_state(napi_env env, void *data, void *hint) {
+    (void)hint;
+    addon_state_t *state = data;
+    free_cookie(env, state->sensor_callback);
+    free_cookie(env, state->async_event_callback);
+    for (int id = 0; id < FANOUT_MAX_SUBSCRIBERS; id++) {
+        if (state->subscriber_fns[id] != NULL) {
+            napi_delete_reference(env, state->subscriber_fns[id]);
+        }
+    }
+    for (int id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        if (state->flush_promise[id] != NULL) {
+            napi_delete_reference(env, state->flush_promise[id]);
+        }
+        if (state->history_refs[id] != NULL) {
+            napi_delete_reference(env, state->history_refs[id]);
+        }
+        if (state->stats[id] != NULL) {
+            stats_free(state->stats[id]);
+            free(state->stats[id]);
+        }
+        if (state->allan[id] != NULL) {
+            allan_free(state->allan[id]);
+            free(state->allan[id]);
+        }
+        if (state->spectra[id] != NULL) {
+            napi_delete_reference(env, state->spectrum_fns[id]);
+            spectrum_free(state->spectra[id]);
+            free(state->spectra[id]);
+        }
+    }
+    if (state->girv_ring_ref != NULL) {
+        napi_delete_reference(env, state->girv_ring_ref);
+    }
+    if (state->resampler != NULL) {
+        napi_delete_reference(env, state->resampler_fn);
+        resampler_free(state->resampler);
+        free(state->resampler);
+    }
+    if (state->capture != NULL) {
+        napi_delete_reference(env, state->capture_fn);
+        capture_free(state->capture);
+        free(state->capture);
+    }
+    free(state);
+}
+
+bool init_addon_state(napi_env env) {
+    addon_state_t *state = calloc(1, sizeof(addon_state_t));
+    if (state == NULL) { return false; }
+    state->env = env;
+    if (napi_set_instance_data(env, state, free_addon_state, NULL) !=
+        napi_ok) {
+        free(state);
+        return false;
+    }
+    return napi_add_env_cleanup_hook(env, release_hub_on_teardown, state) ==
+           napi_ok;
+}
 
 napi_value cb_setI2CSettings(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     napi_value argv[MAX_ARGUMENTS] = {NULL};
     napi_value this;
     size_t argc = MAX_ARGUMENTS;
@@ -183,15 +444,111 @@ napi_value cb_setI2CSettings(napi_env env, napi_callback_info info) {
     return NULL;
 }
 
+// Transfers service({..}) drains at most, if the caller doesn't say.
+#define SERVICE_DEFAULT_MAX_TRANSFERS 64
+
+// Poll period used when no sensor has been configured yet.
+#define POLL_DEFAULT_PERIOD_US 10000
+
+// The HAL needs two rounds per transfer, so a single sh2_service() call
+// isn't enough to keep up with the hub FIFO.
+service_stats_t service_until_idle(napi_env env, const void *owner,
+                                   uint32_t max_transfers, uint32_t max_us) {
+    service_stats_t stats = {0};
+    uint64_t start_ns = uv_hrtime();
+
+    for (;;) {
+        // Without a hub the driver doesn't read and the state would be stale
+        hal_set_read_state(HAL_READ_NONE);
+        sh2_service();
+        stats.serviceCalls++;
+
+        hal_read_state_t state = hal_last_read_state();
+        if (state == HAL_READ_TRANSFER) {
+            stats.transfers++;
+        } else if (state == HAL_READ_IDLE) {
+            stats.idle = true;
+            break;
+        } else if (state == HAL_READ_ERROR || state == HAL_READ_NONE) {
+            break;
+        }
+
+        // A callback closed the hub, or opened another
+        if (_hub_owner != owner) { break; }
+
+        // A callback threw; let it propagate instead of servicing further.
+        bool pending = false;
+        napi_is_exception_pending(env, &pending);
+        if (pending) { break; }
+
+        if (max_transfers && stats.transfers >= max_transfers) { break; }
+        if (max_us && (uv_hrtime() - start_ns) / 1000 >= max_us) { break; }
+    }
+
+    stats.elapsed_us = (uint32_t)((uv_hrtime() - start_ns) / 1000);
+    throw_hal_error(env);
+    return stats;
+}
+
+// Without arguments this services the hub once, as before. With an options
+// object `{maxTransfers, maxMicros}` it drains the hub until idle or until
+// the budget runs out, and returns the counts.
 napi_value cb_service(napi_env env, napi_callback_info info) {
-    sh2_service();
-    return NULL;
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 0, 1);
+    if (!success) { return NULL; }
+
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+
+    if (argc == 0) {
+        sh2_service();
+        throw_hal_error(env);
+        deliver_to_subscribers(state);
+        return NULL;
+    }
+
+    napi_valuetype argt;
+    napi_typeof(env, argv[0], &argt);
+    if (argt != napi_object) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "First argument must be an options object.");
+        return NULL;
+    }
+
+    uint32_t max_transfers = SERVICE_DEFAULT_MAX_TRANSFERS;
+    uint32_t max_us = 0;
+    if (node_to_c_optional_uint32(env, argv[0], "maxTransfers",
+                                  &max_transfers) != 0 ||
+        node_to_c_optional_uint32(env, argv[0], "maxMicros", &max_us) != 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "maxTransfers and maxMicros must be uint32 numbers.");
+        return NULL;
+    }
+    // A hub streaming faster than it's drained would never let go
+    if (max_transfers == 0 && max_us == 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "maxTransfers 0 needs a maxMicros budget.");
+        return NULL;
+    }
+
+    service_stats_t stats =
+        service_until_idle(env, state, max_transfers, max_us);
+    deliver_to_subscribers(state);
+
+    bool pending = false;
+    napi_is_exception_pending(env, &pending);
+    if (pending) { return NULL; }
+
+    return node_from_c_ServiceStats(env, &stats);
 }
 
-// This function is the common C callback the driver calls on a sensor event.
-// It then calls the JS callback that is passed in the cookie structure
-// `cb_cookie_t`.
-static void sensor_callback(void *cookie, sh2_SensorEvent_t *event) {
+// Calls the JS callback that is passed in the cookie structure `cb_cookie_t`
+// with a sensor event and its decoded values.
+static void sensor_callback(void *cookie, const sh2_SensorEventView_t *event,
+                            const sh2_SensorValue_t *sv) {
     napi_env env = ((cb_cookie_t *)(cookie))->env;
     napi_status status;
 
@@ -203,7 +560,7 @@ static void sensor_callback(void *cookie, sh2_SensorEvent_t *event) {
     }
 
     // Translate sensor event to napi_value
-    napi_value sensor_event = node_from_c_SensorEvent(env, event);
+    napi_value sensor_event = node_from_c_SensorEventView(env, event, sv);
     if (sensor_event == NULL) {
         napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
                          "Error translating SensorEvent to JS object.");
@@ -255,6 +612,170 @@ static void sensor_callback(void *cookie, sh2_SensorEvent_t *event) {
     }
 }
 
+// Every sensor event from the driver comes through here, as a view into the
+// SHTP receive buffer. It keeps the latest value table up to date whether or
+// not a JS callback is set, and then hands the event to the JS callback. The
+// report is decoded once for both, and only copied where it's stored.
+static void sensor_event_hub(void *cookie, const sh2_SensorEventView_t *event) {
+    addon_state_t *state = cookie;
+
+    if (event->reportId == _polling.pacing_sensor) {
+        _polling.pacing_reports++;
+    }
+
+    sh2_SensorValue_t sv;
+    int decoded = sh2_decodeSensorEventView(&sv, event);
+
+    // Restamp the event with the timestamp smoothed by the clock sync.
+    // Gyro-integrated RV reports have no sequence number to fit against, and
+    // replayed ones were recorded after the clock sync.
+    sh2_SensorEventView_t synced;
+    if (decoded == SH2_OK && clock_sync_enabled() &&
+        sv.sensorId != SH2_GYRO_INTEGRATED_RV && _replay.state == NULL) {
+        synced = *event;
+        synced.timestamp_uS = clock_sync_update(
+            sv.sensorId, sv.sequence, event->timestamp_uS,
+            _sensor_configs[sv.sensorId].reportInterval_us);
+        sv.timestamp = synced.timestamp_uS;
+        event = &synced;
+    }
+
+    recorder_append(event, decoded == SH2_OK ? &sv : NULL);
+
+    if (decoded == SH2_OK && (state->history_refs[sv.sensorId] != NULL ||
+                              state->resampler != NULL ||
+                              state->stats[sv.sensorId] != NULL ||
+                              state->allan[sv.sensorId] != NULL ||
+                              state->spectra[sv.sensorId] != NULL ||
+                              state->capture != NULL)) {
+        float values[DECODED_VALUES_MAX];
+        decode_sensor_values(&sv, values);
+        if (state->stats[sv.sensorId] != NULL) {
+            stats_push(state->stats[sv.sensorId], event->timestamp_uS, values);
+        }
+        if (state->allan[sv.sensorId] != NULL) {
+            allan_push(state->allan[sv.sensorId], event->timestamp_uS, values);
+        }
+        if (state->spectra[sv.sensorId] != NULL) {
+            spectrum_push(state->spectra[sv.sensorId], event->timestamp_uS,
+                          values);
+        }
+        if (state->capture != NULL) {
+            capture_push(state->capture, sv.sensorId, event->timestamp_uS,
+                         values);
+        }
+        if (state->history_refs[sv.sensorId] != NULL) {
+            history_push(&state->histories[sv.sensorId], event->timestamp_uS,
+                         values);
+        }
+        if (state->resampler != NULL) {
+            resampler_push(state->resampler, sv.sensorId,
+                           event->timestamp_uS, values);
+        }
+    }
+
+    // Gyro-integrated RV reports come at up to 1 kHz; with a ring set they
+    // skip the event objects.
+    if (decoded == SH2_OK && sv.sensorId == SH2_GYRO_INTEGRATED_RV &&
+        state->girv_ring != NULL) {
+        girv_ring_push(state->girv_ring, &sv, event->timestamp_uS);
+        latest_table_store(&sv, event->delay_uS);
+        return;
+    }
+
+    if (decoded == SH2_OK) { latest_table_store(&sv, event->delay_uS); }
+
+    fanout_publish_view(event);
+
+    if (state->sensor_callback != NULL) {
+        sensor_callback(state->sensor_callback, event, &sv);
+    }
+}
+
+// Hand each fan-out subscriber its pending events as one array. Runs after
+// the hub has been serviced, so a subscriber that can't keep up only loses
+// its own events and others aren't held back by its backlog.
+static void deliver_to_subscribers(addon_state_t *state) {
+    static sh2_SensorEvent_t batch[FANOUT_RING_CAP];
+    napi_env env = state->env;
+
+    for (int id = 0; id < FANOUT_MAX_SUBSCRIBERS; id++) {
+        // Subscribed from an environment that doesn't own the hub.
+        if (state->subscriber_fns[id] == NULL) { continue; }
+
+        // A subscriber threw; let it propagate.
+        bool pending = false;
+        napi_is_exception_pending(env, &pending);
+        if (pending) { return; }
+
+        uint32_t n = fanout_take(id, batch, FANOUT_RING_CAP);
+        if (n == 0) { continue; }
+
+        napi_handle_scope scope;
+        if (napi_open_handle_scope(env, &scope) != napi_ok) {
+            napi_throw_error(env, ERROR_OPENING_SCOPE,
+                             "Couldn't open napi scope.");
+            return;
+        }
+        napi_value events, fn, global, ret;
+        napi_status status = napi_create_array_with_length(env, n, &events);
+        for (uint32_t i = 0; i < n && status == napi_ok; i++) {
+            napi_value event = node_from_c_SensorEvent(env, &batch[i]);
+            if (event == NULL) {
+                napi_close_handle_scope(env, scope);
+                return; // node_from_c_SensorEvent threw
+            }
+            status = napi_set_element(env, events, i, event);
+        }
+        status |= napi_get_reference_value(env, state->subscriber_fns[id], &fn);
+        status |= napi_get_global(env, &global);
+        if (status != napi_ok) {
+            napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                             "Couldn't build a batch for a subscriber.");
+            napi_close_handle_scope(env, scope);
+            return;
+        }
+        napi_call_function(env, global, fn, 1, &events, &ret);
+        napi_close_handle_scope(env, scope);
+    }
+    deliver_resampled(state);
+    deliver_spectra(state);
+    deliver_capture(state);
+}
+
+// Parse the options object of setSensorCallback(..).
+static bool parse_sensor_callback_options(napi_env env, napi_value obj,
+                                          report_storage_t *storage,
+                                          timestamp_format_t *timestamp) {
+    char report[16] = "buffer";
+    char format[16] = "bigint";
+    if (node_to_c_optional_string(env, obj, "report", report,
+                                  sizeof(report)) != 0 ||
+        node_to_c_optional_string(env, obj, "timestamp", format,
+                                  sizeof(format)) != 0) {
+        return false;
+    }
+
+    if (strcmp(report, "buffer") == 0) {
+        *storage = REPORT_STORAGE_BUFFER;
+    } else if (strcmp(report, "slab") == 0) {
+        *storage = REPORT_STORAGE_SLAB;
+    } else {
+        return false;
+    }
+
+    if (strcmp(format, "bigint") == 0) {
+        *timestamp = TIMESTAMP_BIGINT;
+    } else if (strcmp(format, "float64") == 0) {
+        *timestamp = TIMESTAMP_FLOAT64;
+    } else if (strcmp(format, "hilo") == 0) {
+        *timestamp = TIMESTAMP_HILO;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 // This function prepares the `cb_cookie_t` struct and calls the
 // sh2_setSensorCallback function.
 // It sets the callback function to be called when a sensor event occurs by
@@ -263,14 +784,16 @@ static void sensor_callback(void *cookie, sh2_SensorEvent_t *event) {
 // args:
 //  - jsFn: function to be called when a sensor event occurs
 //  - cookie: a value that will be passed to the sensor callback function
+//  - options (optional): {report: 'buffer' | 'slab',
+//                          timestamp: 'bigint' | 'float64' | 'hilo'}
 napi_value cb_setSensorCallback(napi_env env, napi_callback_info info) {
     // napi_status status;
 
-    napi_value argv[2] = {0};
-    size_t argc = 2;
+    napi_value argv[3] = {0};
+    size_t argc = 3;
 
     napi_valuetype argt;
-    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 3);
     if (!success) {
         napi_throw_error(env, ARGUMENT_ERROR,
                          "Couldn't parse arguments in cb_setSensorCallback");
@@ -283,6 +806,27 @@ napi_value cb_setSensorCallback(napi_env env, napi_callback_info info) {
         return NULL;
     }
 
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+
+    report_storage_t storage = REPORT_STORAGE_BUFFER;
+    timestamp_format_t timestamp = TIMESTAMP_BIGINT;
+    if (argc == 3) {
+        napi_typeof(env, argv[2], &argt);
+        if (argt != napi_object ||
+            !parse_sensor_callback_options(env, argv[2], &storage,
+                                           &timestamp)) {
+            napi_throw_error(env, ARGUMENT_ERROR,
+                             "Invalid sensor callback options. report must be "
+                             "'buffer' or 'slab' and timestamp 'bigint', "
+                             "'float64' or 'hilo'.");
+            return NULL;
+        }
+    }
+    set_timestamp_format(timestamp);
+    set_report_storage(storage);
+    if (storage == REPORT_STORAGE_BUFFER) { report_slab_reset(env); }
+
     // Prepare the cookie struct
     cb_cookie_t *cookie = malloc(sizeof(cb_cookie_t));
     if (cookie == NULL) {
@@ -293,12 +837,8 @@ napi_value cb_setSensorCallback(napi_env env, napi_callback_info info) {
     }
 
     // Delete ref to allow GC to take it, and make note of the new ref
-    if (_sensor_callback != NULL) {
-        napi_delete_reference(env, _sensor_callback->jsFn_ref);
-        napi_delete_reference(env, _sensor_callback->cookie_ref);
-        free(_sensor_callback);
-        _sensor_callback = NULL;
-    }
+    free_cookie(env, state->sensor_callback);
+    state->sensor_callback = NULL;
 
     cookie->env = env;
     cookie->thread = uv_thread_self();
@@ -315,9 +855,9 @@ napi_value cb_setSensorCallback(napi_env env, napi_callback_info info) {
                          "Couldn't create a napi ref for cookie value in "
                          "setSensorCallback.");
     }
-    _sensor_callback = cookie;
+    state->sensor_callback = cookie;
 
-    int8_t code = sh2_setSensorCallback(sensor_callback, _sensor_callback);
+    int8_t code = sh2_setSensorViewCallback(sensor_event_hub, state);
     if (code != SH2_OK) {
         char msg[200];
         snprintf(msg, 200, "Setting a new callback failed with code: %hhd\n",
@@ -404,16 +944,22 @@ static void async_event_callback_broker(void *cookie, sh2_AsyncEvent_t *event) {
     napi_close_handle_scope(cookie_with_type->env, scope);
 }
 
-// Ha. Ha. Second source of truth exclusively for HAL read_i2c(..).
-// Raspberry Pi 4B and older have a i2c clock stretching bug which bugs
-// the connection to the sensor. This is for being able to throw node.js error
-// to let user know what is wrong and make them use sw i2c or keep re-opening
-// sensor hub connection.
-napi_env _global_env_dont_touch;
-napi_value cb_sh2_open(napi_env env, napi_callback_info info) {
-    // Assign the ugly _globa_env
-    _global_env_dont_touch = env;
+// Receives the driver's async events. Completes flushes before handing the
+// event to the callback registered with open(..).
+static void async_event_hub(void *cookie, sh2_AsyncEvent_t *event) {
+    addon_state_t *state = cookie;
+    if (event->eventId == SH2_FLUSH_COMPLETED &&
+        event->flushCompleted <= SH2_MAX_SENSOR_ID) {
+        settle_flush(state, event->flushCompleted, NULL);
+    }
+    if (state->async_event_callback != NULL) {
+        async_event_callback_broker(state->async_event_callback, event);
+    }
+}
 
+// Opens the hub for the calling environment, which may be a worker_thread.
+// Only one environment can have it open at a time.
+napi_value cb_sh2_open(napi_env env, napi_callback_info info) {
     napi_status status;
     size_t argc = 2;
     napi_value argv[2] = {0};
@@ -432,64 +978,100 @@ napi_value cb_sh2_open(napi_env env, napi_callback_info info) {
         return NULL;
     }
 
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+    if (_replay.state != NULL) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "A log is being replayed.");
+        return NULL;
+    }
+
     // Get napi values of the arguments
     napi_value jsFn = argv[0];
     napi_value jsCookie = argv[1];
 
     // Get the bus number and address from the I2C settings
     // i2c_settings_t     settings = get_i2c_settings();
-    if (_async_event_callback != NULL) {
-        napi_delete_reference(env, _async_event_callback->jsFn_ref);
-        napi_delete_reference(env, _async_event_callback->cookie_ref);
-        free(_async_event_callback);
-        _async_event_callback = NULL;
-    }
+    free_cookie(env, state->async_event_callback);
+    state->async_event_callback = NULL;
     cb_cookie_t *cookie = malloc(sizeof(cb_cookie_t));
-    _async_event_callback = cookie;
-    _async_event_callback->env = env;
-    _async_event_callback->thread = uv_thread_self();
+    if (cookie == NULL) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't allocate memory for cookie to use for "
+                         "async event callback");
+        return NULL;
+    }
+    cookie->env = env;
+    cookie->thread = uv_thread_self();
 
     // Prevents jsFn and cookie from being garbage collected in case
     // there are no references left in the node side of things.
-    status =
-        napi_create_reference(env, jsFn, 1, &_async_event_callback->jsFn_ref);
+    status = napi_create_reference(env, jsFn, 1, &cookie->jsFn_ref);
     if (status != napi_ok) {
+        free(cookie);
         napi_throw_error(env, REF_ERROR,
                          "Couldn't create reference. Was JavaScript function "
                          "provided as a callback?\n");
         return NULL;
     }
-    status = napi_create_reference(env, jsCookie, 1,
-                                   &_async_event_callback->cookie_ref);
+    status = napi_create_reference(env, jsCookie, 1, &cookie->cookie_ref);
     if (status != napi_ok) {
+        napi_delete_reference(env, cookie->jsFn_ref);
+        free(cookie);
         napi_throw_error(env, REF_ERROR,
                          "Couldn't create reference. Was JavaScript Object "
                          "provided as a cookie?\n");
         return NULL;
     }
 
+    state->async_event_callback = cookie;
+
     // Prepare the HAL struct
     static sh2_Hal_t hal;
     hal = make_hal();
 
     // Open connection
-    int status_ =
-        sh2_open(&hal, async_event_callback_broker, _async_event_callback);
+    int status_ = sh2_open(&hal, async_event_hub, state);
+    throw_hal_error(env);
     if (status_ != SH2_OK) {
         napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
                          "Couldn't open the sh2 device.");
+        return NULL;
     }
+    _hub_owner = state;
+
+    // Route sensor events through the hub even before a JS callback is set,
+    // so getLatest(..) works without one.
+    sh2_setSensorViewCallback(sensor_event_hub, state);
 
     return NULL;
 }
 
 napi_value cb_sh2_close(napi_env env, napi_callback_info _) {
-    sh2_close();
-    stop_irq_worker();
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+    close_hub(state);
     return NULL;
 }
 
+// Shortest reportInterval_us of the enabled sensors, and which sensor has it.
+// Returns POLL_DEFAULT_PERIOD_US if no sensor is enabled.
+static uint32_t fastest_report_interval(uint8_t *sensor_id) {
+    uint32_t fastest = 0;
+    *sensor_id = 0;
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        uint32_t interval = _sensor_configs[id].reportInterval_us;
+        if (interval != 0 && (fastest == 0 || interval < fastest)) {
+            fastest = interval;
+            *sensor_id = id;
+        }
+    }
+    return fastest ? fastest : POLL_DEFAULT_PERIOD_US;
+}
+
 napi_value cb_get_sensor_config(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     size_t argc = 1;
     napi_value argv[1] = {0};
 
@@ -533,6 +1115,8 @@ napi_value cb_get_sensor_config(napi_env env, napi_callback_info info) {
 }
 
 napi_value cb_set_sensor_config(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     size_t argc = 2;
     napi_value argv[2] = {0};
 
@@ -546,7 +1130,6 @@ napi_value cb_set_sensor_config(napi_env env, napi_callback_info info) {
     // Convert sensor config to C struct
     // The first argument in argv is the sensor id, the second is the sensor
     // config
-    static sh2_SensorConfig_t configs[SH2_MAX_SENSOR_ID + 1];
     sh2_SensorConfig_t config;
     if (node_to_c_SensorConfig(env, argv[1], &config) != 0) {
         napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
@@ -557,18 +1140,24 @@ napi_value cb_set_sensor_config(napi_env env, napi_callback_info info) {
     // Read the sensor id from the first argument
     uint32_t sensor_id;
     napi_status status = napi_get_value_uint32(env, argv[0], &sensor_id);
-    if (status != napi_ok) {
+    if (status != napi_ok || sensor_id > SH2_MAX_SENSOR_ID) {
         napi_throw_error(env, ARGUMENT_ERROR,
                          "Failed to get sensor id from napi_value");
         return NULL;
     }
 
+    // A new interval invalidates the clock sync of the sensor.
+    if (config.reportInterval_us !=
+        _sensor_configs[sensor_id].reportInterval_us) {
+        clock_sync_reset(sensor_id);
+    }
+
     // Move config to static memory
-    memcpy(&configs[sensor_id], &config, sizeof(sh2_SensorConfig_t));
+    memcpy(&_sensor_configs[sensor_id], &config, sizeof(sh2_SensorConfig_t));
 
     // Set sensor config
     int code;
-    if ((code = sh2_setSensorConfig(sensor_id, &configs[sensor_id])) !=
+    if ((code = sh2_setSensorConfig(sensor_id, &_sensor_configs[sensor_id])) !=
         SH2_OK) {
         printf("Failed to set sensor config with code: %d\n", code);
         napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
@@ -576,10 +1165,77 @@ napi_value cb_set_sensor_config(napi_env env, napi_callback_info info) {
         return NULL;
     }
 
+    // Keep the poll period in step with the fastest sensor.
+    if (poll_timer_running() && _polling.auto_period) {
+        set_poll_timer_period(
+            fastest_report_interval(&_polling.pacing_sensor));
+    }
+
     return NULL;
 }
 
+// Asks the hub to send the reports it has batched for a sensor. Returns a
+// Promise that resolves once they have all been delivered, which happens as
+// the hub is serviced.
+napi_value cb_flush(napi_env env, napi_callback_info info) {
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+    if (!parse_args(env, info, &argc, argv, NULL, NULL, 1, 1)) { return NULL; }
+
+    uint32_t sensor_id;
+    napi_status status = napi_get_value_uint32(env, argv[0], &sensor_id);
+    if (status != napi_ok || sensor_id > SH2_MAX_SENSOR_ID) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid SensorId");
+        return NULL;
+    }
+
+    napi_value promise;
+    if (state->flush_deferred[sensor_id] != NULL) {
+        // Already flushing; the completion covers this call too.
+        status = napi_get_reference_value(env, state->flush_promise[sensor_id],
+                                          &promise);
+        if (status != napi_ok) {
+            napi_throw_error(env, REF_ERROR,
+                             "Couldn't get the pending flush promise.");
+            return NULL;
+        }
+        return promise;
+    }
+
+    int code = sh2_requestFlush(sensor_id);
+    throw_hal_error(env);
+    if (code != SH2_OK) {
+        char msg[80];
+        snprintf(msg, sizeof(msg), "Couldn't flush sensor %u. code %d",
+                 sensor_id, code);
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER, msg);
+        return NULL;
+    }
+
+    napi_deferred deferred;
+    status = napi_create_promise(env, &deferred, &promise);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create a promise for flush(..)");
+        return NULL;
+    }
+    status = napi_create_reference(env, promise, 1,
+                                   &state->flush_promise[sensor_id]);
+    if (status != napi_ok) {
+        napi_throw_error(env, REF_ERROR,
+                         "Couldn't create reference to the flush promise.");
+        return NULL;
+    }
+    state->flush_deferred[sensor_id] = deferred;
+    return promise;
+}
+
 napi_value cb_devOn(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     int code;
     if ((code = sh2_devOn()) != SH2_OK) {
         char msg[200];
@@ -590,6 +1246,8 @@ napi_value cb_devOn(napi_env env, napi_callback_info info) {
 }
 
 napi_value cb_devReset(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     if (sh2_devReset() != SH2_OK) {
         napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
                          "Could not reset the sensor hub.");
@@ -598,6 +1256,8 @@ napi_value cb_devReset(napi_env env, napi_callback_info info) {
 }
 
 napi_value cb_devSleep(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     int code = sh2_devSleep();
     if (code != SH2_OK) {
         napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
@@ -607,6 +1267,8 @@ napi_value cb_devSleep(napi_env env, napi_callback_info info) {
 }
 
 napi_value cb_setFrs(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     size_t argc = 2;
     napi_value argv[2]; // [0] recordId, [1] Buffer
 
@@ -671,6 +1333,8 @@ napi_value cb_setFrs(napi_env env, napi_callback_info info) {
 }
 
 napi_value cb_getFrs(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     size_t argc = 1;
     napi_value argv[1];
 
@@ -719,6 +1383,8 @@ napi_value cb_getFrs(napi_env env, napi_callback_info info) {
 
 napi_value cb_store_current_dynamic_calibration(napi_env env,
                                                 napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
     size_t argc = 0;
     napi_status status = napi_get_cb_info(env, info, &argc, NULL, NULL, NULL);
     if (status != napi_ok) {
@@ -740,34 +1406,46 @@ napi_value cb_store_current_dynamic_calibration(napi_env env,
 }
 
 static void call_sh2_service_on_irq(void *context) {
+    addon_state_t *state = context;
+    napi_env env = state->env;
     napi_handle_scope scope;
-    napi_status status = napi_open_handle_scope(context, &scope);
+    napi_status status = napi_open_handle_scope(env, &scope);
     if (status != napi_ok) {
-        napi_throw_error(context, ERROR_OPENING_SCOPE,
+        napi_throw_error(env, ERROR_OPENING_SCOPE,
                          "Couldn't open napi scope.");
         return;
     }
     sh2_service(); // one service per interrupt
-    status = napi_close_handle_scope(context, scope);
+    throw_hal_error(env);
+    deliver_to_subscribers(state);
+    status = napi_close_handle_scope(env, scope);
     if (status != napi_ok) {
-        napi_throw_error(context, ERROR_CLOSING_SCOPE,
+        napi_throw_error(env, ERROR_CLOSING_SCOPE,
                          "Couldn't close napi scope.");
         return;
     }
 }
 napi_value cb_use_interrupts(napi_env env, napi_callback_info info) {
-    size_t argc = 2;
-    napi_value argv[2];
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+    if (poll_timer_running()) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "Polling is in use. Call stopPolling() first.");
+        return NULL;
+    }
+
+    size_t argc = 3;
+    napi_value argv[3];
 
     napi_status status = napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
     if (status != napi_ok) {
         napi_throw_error(env, UNKNOWN_ERROR, "Couldn't parse arguments.");
         return NULL;
     }
-    if (argc != 2) {
+    if (argc != 2 && argc != 3) {
         napi_throw_error(env, ARGUMENT_ERROR,
-                         "Expected exactly two arguments: chipname: string,"
-                         "gpio pin: number.");
+                         "Expected two or three arguments: chipname: string,"
+                         "gpio pin: number, options?: object.");
         return NULL;
     }
     napi_valuetype argt;
@@ -784,6 +1462,26 @@ napi_value cb_use_interrupts(napi_env env, napi_callback_info info) {
         return NULL;
     }
 
+    irq_mode_t mode = IRQ_MODE_WORKER;
+    if (argc == 3) {
+        napi_typeof(env, argv[2], &argt);
+        char mode_str[16] = "worker";
+        if (argt != napi_object ||
+            node_to_c_optional_string(env, argv[2], "mode", mode_str,
+                                      sizeof(mode_str)) != 0) {
+            napi_throw_error(env, ARGUMENT_ERROR,
+                             "Third argument must be an options object.");
+            return NULL;
+        }
+        if (strcmp(mode_str, "uvPoll") == 0) {
+            mode = IRQ_MODE_UV_POLL;
+        } else if (strcmp(mode_str, "worker") != 0) {
+            napi_throw_error(env, ARGUMENT_ERROR,
+                             "mode must be either 'worker' or 'uvPoll'.");
+            return NULL;
+        }
+    }
+
     char chipname[50];
     unsigned int line_no;
     uint32_t line_no_uint32;
@@ -816,7 +1514,7 @@ napi_value cb_use_interrupts(napi_env env, napi_callback_info info) {
         return NULL;
     }
 
-    stat = start_irq_worker(loop, call_sh2_service_on_irq, env);
+    stat = start_irq_worker(loop, mode, call_sh2_service_on_irq, state);
     if (stat < 0) {
         napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
                          "Couldn't start IRQ worker.");
@@ -825,3 +1523,2789 @@ napi_value cb_use_interrupts(napi_env env, napi_callback_info info) {
 
     return NULL;
 }
+
+// Runs on the main thread on every poll timer tick. Drains the hub like
+// service({..}) would, and lets the timer know how many reports the pacing
+// sensor produced so it can keep its phase.
+static void call_sh2_service_on_tick(void *context) {
+    addon_state_t *state = context;
+    napi_env env = state->env;
+    napi_handle_scope scope;
+    napi_status status = napi_open_handle_scope(env, &scope);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_OPENING_SCOPE,
+                         "Couldn't open napi scope.");
+        return;
+    }
+    _polling.pacing_reports = 0;
+    service_until_idle(env, state, SERVICE_DEFAULT_MAX_TRANSFERS, 0);
+    deliver_to_subscribers(state);
+    poll_timer_report(_polling.pacing_reports);
+    status = napi_close_handle_scope(env, scope);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CLOSING_SCOPE,
+                         "Couldn't close napi scope.");
+        return;
+    }
+}
+
+// Service the hub from a timer thread instead of GPIO interrupts.
+//
+// args:
+//  - options (optional): {periodMicros, phaseAlign, phaseOffsetMicros}
+//
+// Without periodMicros the period follows the shortest reportInterval_us
+// configured with setSensorConfig(..). Calling this again while polling
+// updates the settings of the running timer.
+napi_value cb_use_polling(napi_env env, napi_callback_info info) {
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+    if (irq_worker_running()) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "Interrupts are in use until close().");
+        return NULL;
+    }
+
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 0, 1);
+    if (!success) { return NULL; }
+
+    uint32_t period_us = 0;
+    uint32_t offset_us = UINT32_MAX;
+    bool phase_align = false;
+    if (argc == 1) {
+        napi_valuetype argt;
+        napi_typeof(env, argv[0], &argt);
+        if (argt != napi_object) {
+            napi_throw_error(env, ARGUMENT_ERROR,
+                             "First argument must be an options object.");
+            return NULL;
+        }
+        if (node_to_c_optional_uint32(env, argv[0], "periodMicros",
+                                      &period_us) != 0 ||
+            node_to_c_optional_uint32(env, argv[0], "phaseOffsetMicros",
+                                      &offset_us) != 0 ||
+            node_to_c_optional_bool(env, argv[0], "phaseAlign",
+                                    &phase_align) != 0) {
+            napi_throw_error(env, ARGUMENT_ERROR,
+                             "Invalid polling options. periodMicros and "
+                             "phaseOffsetMicros must be uint32 numbers, "
+                             "phaseAlign a boolean.");
+            return NULL;
+        }
+    }
+
+    _polling.auto_period = period_us == 0;
+    uint32_t fastest = fastest_report_interval(&_polling.pacing_sensor);
+    if (_polling.auto_period) { period_us = fastest; }
+    if (offset_us == UINT32_MAX) { offset_us = period_us / 8; }
+
+    set_poll_timer_phase(phase_align, offset_us);
+    if (poll_timer_running()) {
+        set_poll_timer_period(period_us);
+        return NULL;
+    }
+
+    uv_loop_t *loop = NULL;
+    napi_status s = napi_get_uv_event_loop(env, &loop);
+    if (s != napi_ok || !loop) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "Couldn't start poll timer.");
+        return NULL;
+    }
+
+    if (start_poll_timer(loop, call_sh2_service_on_tick, state, period_us) <
+        0) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "Couldn't start poll timer.");
+        return NULL;
+    }
+
+    return NULL;
+}
+
+napi_value cb_stop_polling(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
+    stop_poll_timer();
+    return NULL;
+}
+
+// args:
+//  - sensorId: which sensor's latest value to return
+//
+// Returns null if the sensor hasn't reported during this session.
+napi_value cb_get_latest(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    uint32_t sensor_id;
+    napi_status status = napi_get_value_uint32(env, argv[0], &sensor_id);
+    if (status != napi_ok || sensor_id > SH2_MAX_SENSOR_ID) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid SensorId");
+        return NULL;
+    }
+
+    latest_value_t latest;
+    if (!latest_table_load(sensor_id, &latest)) {
+        napi_value null;
+        napi_get_null(env, &null);
+        return null;
+    }
+
+    return node_from_c_LatestValue(env, &latest);
+}
+
+// Host timestamp, in microseconds, that float64 event timestamps are relative
+// to. Returns null until the first event after setSensorCallback(..).
+napi_value cb_get_timestamp_epoch(napi_env env, napi_callback_info info) {
+    napi_value result;
+    uint64_t epoch_us;
+    if (!timestamp_epoch(&epoch_us)) {
+        napi_get_null(env, &result);
+        return result;
+    }
+    if (napi_create_bigint_uint64(env, epoch_us, &result) != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the timestamp epoch.");
+        return NULL;
+    }
+    return result;
+}
+
+// Read the optional array of sensor ids `name` of an options object into a
+// bit mask. `mask` is left untouched if the property is missing.
+static bool parse_sensor_array(napi_env env, napi_value obj, const char *name,
+                               uint64_t *mask) {
+    bool has_sensors;
+    if (napi_has_named_property(env, obj, name, &has_sensors) != napi_ok) {
+        return false;
+    }
+    if (!has_sensors) { return true; }
+
+    napi_value sensors;
+    bool is_array;
+    uint32_t len;
+    if (napi_get_named_property(env, obj, name, &sensors) != napi_ok ||
+        napi_is_array(env, sensors, &is_array) != napi_ok || !is_array ||
+        napi_get_array_length(env, sensors, &len) != napi_ok) {
+        return false;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        napi_value elem;
+        uint32_t sensor_id;
+        if (napi_get_element(env, sensors, i, &elem) != napi_ok ||
+            napi_get_value_uint32(env, elem, &sensor_id) != napi_ok ||
+            sensor_id > SH2_MAX_SENSOR_ID) {
+            return false;
+        }
+        *mask |= 1ULL << sensor_id;
+    }
+    return true;
+}
+
+// Read the optional `sensors` array of an options object into a bit mask of
+// sensor ids. `mask` is left untouched if the property is missing.
+static bool parse_sensor_list(napi_env env, napi_value obj, uint64_t *mask) {
+    return parse_sensor_array(env, obj, "sensors", mask);
+}
+
+// Parse the options object of subscribe(..).
+static bool parse_subscribe_options(napi_env env, napi_value obj,
+                                    fanout_options_t *opts) {
+    char lag_policy[16] = "dropOldest";
+    if (node_to_c_optional_uint32(env, obj, "batchSize", &opts->batch_size) !=
+            0 ||
+        node_to_c_optional_uint32(env, obj, "maxPending",
+                                  &opts->max_pending) != 0 ||
+        node_to_c_optional_string(env, obj, "lagPolicy", lag_policy,
+                                  sizeof(lag_policy)) != 0) {
+        return false;
+    }
+    if (strcmp(lag_policy, "dropOldest") == 0) {
+        opts->lag_policy = FANOUT_DROP_OLDEST;
+    } else if (strcmp(lag_policy, "skipToLatest") == 0) {
+        opts->lag_policy = FANOUT_SKIP_TO_LATEST;
+    } else {
+        return false;
+    }
+    return parse_sensor_list(env, obj, &opts->sensor_mask);
+}
+
+// args:
+//  - callback: called with an array of SensorEvents
+//  - options (optional): {batchSize, maxPending, lagPolicy, sensors}
+//
+// Returns the subscriber id.
+napi_value cb_subscribe(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 2);
+    if (!success) { return NULL; }
+
+    napi_valuetype argt;
+    napi_typeof(env, argv[0], &argt);
+    if (argt != napi_function) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "First argument must be a function.");
+        return NULL;
+    }
+
+    fanout_options_t opts = {0};
+    if (argc == 2) {
+        napi_typeof(env, argv[1], &argt);
+        if (argt != napi_object ||
+            !parse_subscribe_options(env, argv[1], &opts)) {
+            napi_throw_error(env, ARGUMENT_ERROR,
+                             "Invalid subscriber options. batchSize and "
+                             "maxPending must be uint32 numbers, lagPolicy "
+                             "'dropOldest' or 'skipToLatest' and sensors an "
+                             "array of SensorIds.");
+            return NULL;
+        }
+    }
+
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+
+    int id = fanout_subscribe(&opts);
+    if (id < 0) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Too many subscribers.");
+        return NULL;
+    }
+    napi_status status =
+        napi_create_reference(env, argv[0], 1, &state->subscriber_fns[id]);
+    if (status != napi_ok) {
+        fanout_unsubscribe(id);
+        napi_throw_error(env, REF_ERROR,
+                         "Couldn't create a napi ref for subscriber.");
+        return NULL;
+    }
+
+    napi_value result;
+    napi_create_int32(env, id, &result);
+    return result;
+}
+
+// Parse the id argument of a subscriber of this environment; throws and
+// returns -1 if invalid.
+static int subscriber_id_arg(napi_env env, napi_value arg) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return -1; }
+    int32_t id;
+    if (napi_get_value_int32(env, arg, &id) != napi_ok ||
+        !fanout_is_subscribed(id) || state->subscriber_fns[id] == NULL) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Unknown subscriber id.");
+        return -1;
+    }
+    return id;
+}
+
+napi_value cb_unsubscribe(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    int id = subscriber_id_arg(env, argv[0]);
+    if (id < 0) { return NULL; }
+
+    addon_state_t *state = get_state(env);
+    fanout_unsubscribe(id);
+    napi_delete_reference(env, state->subscriber_fns[id]);
+    state->subscriber_fns[id] = NULL;
+    return NULL;
+}
+
+// args:
+//  - id: subscriber id
+//  - paused: boolean
+napi_value cb_set_subscriber_paused(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    int id = subscriber_id_arg(env, argv[0]);
+    if (id < 0) { return NULL; }
+
+    bool paused;
+    if (napi_get_value_bool(env, argv[1], &paused) != napi_ok) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Second argument must be a boolean.");
+        return NULL;
+    }
+    fanout_set_paused(id, paused);
+    return NULL;
+}
+
+napi_value cb_get_subscriber_stats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    int id = subscriber_id_arg(env, argv[0]);
+    if (id < 0) { return NULL; }
+
+    fanout_stats_t stats;
+    fanout_stats(id, &stats);
+    return node_from_c_SubscriberStats(env, &stats);
+}
+
+// Most error records getMetrics(..) reads from the hub
+#define METRICS_MAX_ERRORS 32
+
+// Adds the hub's per-sensor counters of the sensors in `mask` to `obj` as
+// `counts`. Throws and returns false on error.
+static bool add_sensor_counts(napi_env env, napi_value obj, uint64_t mask) {
+    napi_value counts;
+    if (napi_create_array(env, &counts) != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create an array for counts.");
+        return false;
+    }
+    uint32_t n = 0;
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        if (!(mask & (1ULL << id))) { continue; }
+        sh2_Counts_t c;
+        int code = sh2_getCounts(id, &c);
+        throw_hal_error(env);
+        if (code != SH2_OK) {
+            char msg[80];
+            snprintf(msg, sizeof(msg),
+                     "Couldn't read counts of sensor %u. code %d", id, code);
+            napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER, msg);
+            return false;
+        }
+        napi_value elem = node_from_c_SensorCounts(env, id, &c);
+        if (elem == NULL || napi_set_element(env, counts, n++, elem) != napi_ok) {
+            return false;
+        }
+    }
+    return napi_set_named_property(env, obj, "counts", counts) == napi_ok;
+}
+
+// Adds the hub's error log, errors of `severity` or more severe, to `obj` as
+// `errors`. Throws and returns false on error.
+static bool add_hub_errors(napi_env env, napi_value obj, uint8_t severity) {
+    sh2_ErrorRecord_t records[METRICS_MAX_ERRORS];
+    uint16_t num = METRICS_MAX_ERRORS;
+    int code = sh2_getErrors(severity, records, &num);
+    throw_hal_error(env);
+    if (code != SH2_OK) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "Couldn't read the error log of the hub.");
+        return false;
+    }
+    napi_value errors;
+    if (napi_create_array_with_length(env, num, &errors) != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create an array for errors.");
+        return false;
+    }
+    for (uint16_t i = 0; i < num; i++) {
+        napi_value elem = node_from_c_ErrorRecord(env, &records[i]);
+        if (elem == NULL || napi_set_element(env, errors, i, elem) != napi_ok) {
+            return false;
+        }
+    }
+    return napi_set_named_property(env, obj, "errors", errors) == napi_ok;
+}
+
+// args:
+//  - options (optional): {sensors, errorSeverity}
+//
+// Returns the counters of the transport, driver and I2C bus, which don't
+// involve the hub. The hub's per-sensor counts and error log are read, with
+// a round trip each, only if asked for in the options.
+napi_value cb_get_metrics(napi_env env, napi_callback_info info) {
+    if (hub_state(env) == NULL) { return NULL; }
+
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 0, 1);
+    if (!success) { return NULL; }
+
+    uint64_t sensor_mask = 0;
+    uint32_t severity = UINT32_MAX;
+    if (argc == 1 &&
+        (!parse_sensor_list(env, argv[0], &sensor_mask) ||
+         node_to_c_optional_uint32(env, argv[0], "errorSeverity",
+                                   &severity) != 0 ||
+         (severity != UINT32_MAX && severity > UINT8_MAX))) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid metrics options.");
+        return NULL;
+    }
+
+    metrics_t metrics = {0};
+    if (sh2_getDriverStats(&metrics.driver) != SH2_OK) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "The sensor hub isn't open.");
+        return NULL;
+    }
+    metrics.bus = hal_stats();
+    metrics.poll_overruns = poll_timer_overruns();
+
+    napi_value obj = node_from_c_Metrics(env, &metrics);
+    if (obj == NULL) { return NULL; }
+
+    if (sensor_mask != 0 && !add_sensor_counts(env, obj, sensor_mask)) {
+        return NULL;
+    }
+    if (severity != UINT32_MAX && !add_hub_errors(env, obj, severity)) {
+        return NULL;
+    }
+    return obj;
+}
+
+// args:
+//  - enabled: boolean
+//  - options (optional): {window}
+napi_value cb_set_clock_sync(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 2);
+    if (!success) { return NULL; }
+
+    bool enabled;
+    if (napi_get_value_bool(env, argv[0], &enabled) != napi_ok) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Expected a boolean.");
+        return NULL;
+    }
+    uint32_t window = CLOCK_SYNC_DEFAULT_WINDOW;
+    if (argc == 2 &&
+        (node_to_c_optional_uint32(env, argv[1], "window", &window) != 0 ||
+         window < CLOCK_SYNC_MIN_SAMPLES || window > CLOCK_SYNC_MAX_WINDOW)) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid clock sync options.");
+        return NULL;
+    }
+
+    clock_sync_enable(enabled, window);
+    return NULL;
+}
+
+// Returns the ClockSyncStatus of a sensor, or null if it has no reports in
+// the window.
+napi_value cb_get_clock_sync(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    uint32_t sensor_id;
+    napi_status status = napi_get_value_uint32(env, argv[0], &sensor_id);
+    if (status != napi_ok || sensor_id > SH2_MAX_SENSOR_ID) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid SensorId");
+        return NULL;
+    }
+
+    clock_sync_status_t sync;
+    if (!clock_sync_status(sensor_id, &sync)) {
+        napi_value null;
+        napi_get_null(env, &null);
+        return null;
+    }
+    return node_from_c_ClockSyncStatus(env, &sync);
+}
+
+// args:
+//  - capacity: records in the ring, 0 to remove it
+//
+// Returns the Float64Array of the new ring, or null.
+napi_value cb_set_girv_ring(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    uint32_t capacity;
+    if (napi_get_value_uint32(env, argv[0], &capacity) != napi_ok ||
+        capacity > GIRV_RING_MAX_CAPACITY) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid ring capacity.");
+        return NULL;
+    }
+
+    // JS may keep using the old ring; it just stops being written.
+    if (state->girv_ring_ref != NULL) {
+        napi_delete_reference(env, state->girv_ring_ref);
+        state->girv_ring_ref = NULL;
+        state->girv_ring = NULL;
+    }
+    if (capacity == 0) {
+        napi_value null;
+        napi_get_null(env, &null);
+        return null;
+    }
+
+    size_t length = girv_ring_length(capacity);
+    void *data;
+    napi_value buffer, ring;
+    napi_status status = napi_create_arraybuffer(env, length * sizeof(double),
+                                                 &data, &buffer);
+    status |= napi_create_typedarray(env, napi_float64_array, length, buffer,
+                                     0, &ring);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the ring.");
+        return NULL;
+    }
+    // The reference keeps the memory alive while the ring is written.
+    if (napi_create_reference(env, buffer, 1, &state->girv_ring_ref) !=
+        napi_ok) {
+        napi_throw_error(env, REF_ERROR,
+                         "Couldn't create reference to the ring.");
+        return NULL;
+    }
+    state->girv_ring = data;
+    girv_ring_init(state->girv_ring, capacity);
+    return ring;
+}
+
+// args:
+//  - bytes: Uint8Array (or Buffer) of reports
+//  - options: {stride, offset, lanes, qPoint}
+//
+// Returns a Float32Array of `lanes` values per report.
+napi_value cb_decode_fixed_point(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    bool is_typedarray = false;
+    napi_typedarray_type type;
+    size_t len = 0;
+    void *data = NULL;
+    if (napi_is_typedarray(env, argv[0], &is_typedarray) != napi_ok ||
+        !is_typedarray ||
+        napi_get_typedarray_info(env, argv[0], &type, &len, &data, NULL,
+                                 NULL) != napi_ok ||
+        type != napi_uint8_array) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Expected a Uint8Array.");
+        return NULL;
+    }
+
+    uint32_t stride = 0, offset = 0, lanes = 0, q = 0;
+    if (node_to_c_optional_uint32(env, argv[1], "stride", &stride) != 0 ||
+        node_to_c_optional_uint32(env, argv[1], "offset", &offset) != 0 ||
+        node_to_c_optional_uint32(env, argv[1], "lanes", &lanes) != 0 ||
+        node_to_c_optional_uint32(env, argv[1], "qPoint", &q) != 0 ||
+        lanes == 0 || lanes > 16 || q > 15 || stride < lanes * 2) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Invalid stride, offset, lanes or qPoint.");
+        return NULL;
+    }
+
+    // Reports whose values are all inside the bytes
+    size_t count = 0;
+    if (len >= offset + lanes * 2) {
+        count = (len - offset - lanes * 2) / stride + 1;
+    }
+
+    void *out;
+    napi_value buffer, result;
+    napi_status status = napi_create_arraybuffer(
+        env, count * lanes * sizeof(float), &out, &buffer);
+    status |= napi_create_typedarray(env, napi_float32_array, count * lanes,
+                                     buffer, 0, &result);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the Float32Array.");
+        return NULL;
+    }
+    q_decode((const uint8_t *)data + offset, stride, lanes, q, count, out);
+    return result;
+}
+
+// Euler mode from 'exact', 'fast' or 'off'. Returns false on anything else.
+static bool parse_euler_mode(napi_env env, napi_value value,
+                             euler_mode_t *mode) {
+    char str[8];
+    size_t len;
+    if (napi_get_value_string_utf8(env, value, str, sizeof(str), &len) !=
+        napi_ok) {
+        return false;
+    }
+    if (strcmp(str, "exact") == 0) {
+        *mode = EULER_EXACT;
+    } else if (strcmp(str, "fast") == 0) {
+        *mode = EULER_FAST;
+    } else if (strcmp(str, "off") == 0) {
+        *mode = EULER_OFF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// args:
+//  - mode: 'exact' | 'fast' | 'off'
+napi_value cb_set_euler_mode(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    euler_mode_t mode;
+    if (!parse_euler_mode(env, argv[0], &mode)) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "mode must be 'exact', 'fast' or 'off'.");
+        return NULL;
+    }
+    euler_set_mode(mode);
+    return NULL;
+}
+
+// args:
+//  - quaternions: Float32Array of i, j, k, real
+//  - mode: optional 'exact' | 'fast', defaults to 'exact'
+//
+// Returns a Float32Array of yaw, pitch, roll per quaternion.
+napi_value cb_quaternions_to_euler(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 2);
+    if (!success) { return NULL; }
+
+    bool is_typedarray = false;
+    napi_typedarray_type type;
+    size_t len = 0;
+    void *data = NULL;
+    if (napi_is_typedarray(env, argv[0], &is_typedarray) != napi_ok ||
+        !is_typedarray ||
+        napi_get_typedarray_info(env, argv[0], &type, &len, &data, NULL,
+                                 NULL) != napi_ok ||
+        type != napi_float32_array || len % 4 != 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Expected a Float32Array of i, j, k, real "
+                         "quaternions.");
+        return NULL;
+    }
+
+    euler_mode_t mode = EULER_EXACT;
+    if (argc == 2 && (!parse_euler_mode(env, argv[1], &mode) ||
+                      mode == EULER_OFF)) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "mode must be 'exact' or 'fast'.");
+        return NULL;
+    }
+
+    size_t count = len / 4;
+    void *out;
+    napi_value buffer, result;
+    napi_status status = napi_create_arraybuffer(
+        env, count * 3 * sizeof(float), &out, &buffer);
+    status |= napi_create_typedarray(env, napi_float32_array, count * 3,
+                                     buffer, 0, &result);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the Float32Array.");
+        return NULL;
+    }
+    q_to_ypr_batch(data, count, mode, out);
+    return result;
+}
+
+// args:
+//  - path: string
+//  - options (optional): {sensors, format, capacity, syncIntervalMs}
+napi_value cb_start_recording(napi_env env, napi_callback_info info) {
+    addon_state_t *state = hub_state(env);
+    if (state == NULL) { return NULL; }
+    if (_hub_owner != state) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "The sensor hub isn't open.");
+        return NULL;
+    }
+
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 2);
+    if (!success) { return NULL; }
+
+    char path[PATH_MAX];
+    size_t len;
+    if (napi_get_value_string_utf8(env, argv[0], path, sizeof(path), &len) !=
+            napi_ok ||
+        len == 0 || len == sizeof(path) - 1) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Expected a file path.");
+        return NULL;
+    }
+
+    recorder_options_t options = {
+        .format = RECORDER_RAW,
+        .sensor_mask = 0,
+        .capacity = RECORDER_DEFAULT_CAPACITY,
+        .sync_interval_ms = RECORDER_DEFAULT_SYNC_INTERVAL_MS,
+    };
+    char format[16] = "raw";
+    uint32_t capacity = options.capacity;
+    if (argc == 2 &&
+        (!parse_sensor_list(env, argv[1], &options.sensor_mask) ||
+         node_to_c_optional_string(env, argv[1], "format", format,
+                                   sizeof(format)) != 0 ||
+         node_to_c_optional_uint32(env, argv[1], "capacity", &capacity) !=
+             0 ||
+         node_to_c_optional_uint32(env, argv[1], "syncIntervalMs",
+                                   &options.sync_interval_ms) != 0 ||
+         capacity == 0)) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid recording options.");
+        return NULL;
+    }
+    options.capacity = capacity;
+    if (strcmp(format, "decoded") == 0) {
+        options.format = RECORDER_DECODED;
+    } else if (strcmp(format, "raw") != 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "format must be either 'raw' or 'decoded'.");
+        return NULL;
+    }
+
+    uv_loop_t *loop;
+    if (napi_get_uv_event_loop(env, &loop) != napi_ok) {
+        napi_throw_error(env, UNKNOWN_ERROR, "Couldn't get the event loop.");
+        return NULL;
+    }
+    int error = recorder_start(loop, path, &options);
+    if (error == -1) {
+        napi_throw_error(env, RECORDING_ERROR, "Already recording.");
+        return NULL;
+    }
+    if (error != 0) {
+        char msg[PATH_MAX + 64];
+        snprintf(msg, sizeof(msg), "Couldn't create %s: %s", path,
+                 strerror(error));
+        napi_throw_error(env, RECORDING_ERROR, msg);
+        return NULL;
+    }
+    return NULL;
+}
+
+// Stops the recording and returns its RecordingStats, or null if there was
+// none.
+napi_value cb_stop_recording(napi_env env, napi_callback_info info) {
+    (void)info;
+    if (hub_state(env) == NULL) { return NULL; }
+
+    recorder_stats_t stats;
+    int error = recorder_stop(&stats);
+    if (error == -1) {
+        napi_value result;
+        napi_get_null(env, &result);
+        return result;
+    }
+    if (error != 0) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Writing the recording failed: %s",
+                 strerror(error));
+        napi_throw_error(env, RECORDING_ERROR, msg);
+        return NULL;
+    }
+    return node_from_c_RecordingStats(env, &stats);
+}
+
+// Returns the RecordingStats of the running recording, or null.
+napi_value cb_get_recording_stats(napi_env env, napi_callback_info info) {
+    (void)info;
+    recorder_stats_t stats;
+    if (!recorder_stats(&stats)) {
+        napi_value result;
+        napi_get_null(env, &result);
+        return result;
+    }
+    return node_from_c_RecordingStats(env, &stats);
+}
+
+// Tell the handles of openLog(..) and createStreamDecoder() apart
+static const napi_type_tag LOG_TAG = {0x4f7b1e2a9c3d4e10, 0x8a6f5b4c3d2e1f01};
+static const napi_type_tag DECODER_TAG = {0x4f7b1e2a9c3d4e10,
+                                          0x8a6f5b4c3d2e1f02};
+
+static void free_log(napi_env env, void *data, void *hint) {
+    (void)env;
+    (void)hint;
+    log_reader_t *log = data;
+    log_close(log);
+    free(log);
+}
+
+// The log of a handle from openLog(..). Throws and returns NULL if it isn't
+// one or was closed.
+static log_reader_t *get_log(napi_env env, napi_value handle) {
+    napi_valuetype type;
+    log_reader_t *log = NULL;
+    bool tagged = false;
+    if (napi_typeof(env, handle, &type) != napi_ok || type != napi_external ||
+        napi_check_object_type_tag(env, handle, &LOG_TAG, &tagged) !=
+            napi_ok ||
+        !tagged ||
+        napi_get_value_external(env, handle, (void **)&log) != napi_ok ||
+        log == NULL) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Expected a log from openLog.");
+        return NULL;
+    }
+    if (log->map == NULL) {
+        napi_throw_error(env, ARGUMENT_ERROR, "The log is closed.");
+        return NULL;
+    }
+    return log;
+}
+
+// args:
+//  - path: string
+napi_value cb_open_log(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    char path[PATH_MAX];
+    size_t len;
+    if (napi_get_value_string_utf8(env, argv[0], path, sizeof(path), &len) !=
+            napi_ok ||
+        len == 0 || len == sizeof(path) - 1) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Expected a file path.");
+        return NULL;
+    }
+
+    log_reader_t *log = malloc(sizeof(log_reader_t));
+    if (log == NULL) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE, "Out of memory.");
+        return NULL;
+    }
+    int error = log_open(path, log);
+    if (error != 0) {
+        free(log);
+        char msg[PATH_MAX + 64];
+        snprintf(msg, sizeof(msg), "Couldn't open %s: %s", path,
+                 error == EPROTO ? "Not a recording" : strerror(error));
+        napi_throw_error(env, RECORDING_ERROR, msg);
+        return NULL;
+    }
+
+    napi_value handle;
+    if (napi_create_external(env, log, free_log, NULL, &handle) != napi_ok) {
+        free_log(env, log, NULL);
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the log handle.");
+        return NULL;
+    }
+    if (napi_type_tag_object(env, handle, &LOG_TAG) != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the log handle.");
+        return NULL;
+    }
+    return handle;
+}
+
+// args:
+//  - log: handle from openLog(..)
+napi_value cb_close_log(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    log_reader_t *log = get_log(env, argv[0]);
+    if (log == NULL) { return NULL; }
+    if (_replay.log == log) {
+        napi_throw_error(env, RECORDING_ERROR, "The log is being replayed.");
+        return NULL;
+    }
+    log_close(log);
+    return NULL;
+}
+
+// args:
+//  - log: handle from openLog(..)
+napi_value cb_get_log_info(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    log_reader_t *log = get_log(env, argv[0]);
+    if (log == NULL) { return NULL; }
+    return node_from_c_LogInfo(env, log);
+}
+
+// args:
+//  - log: handle from openLog(..)
+//  - timestamp: number of microseconds
+//
+// Returns the index of the first record at or after the timestamp.
+napi_value cb_seek_log(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    log_reader_t *log = get_log(env, argv[0]);
+    if (log == NULL) { return NULL; }
+    int64_t timestamp;
+    if (napi_get_value_int64(env, argv[1], &timestamp) != napi_ok) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Expected a timestamp.");
+        return NULL;
+    }
+
+    napi_value result;
+    uint64_t n = log_seek(log, timestamp < 0 ? 0 : (uint64_t)timestamp);
+    if (napi_create_int64(env, (int64_t)n, &result) != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the record index.");
+        return NULL;
+    }
+    return result;
+}
+
+// Read the optional `from` and `to` timestamps of an options object into a
+// range of record indices.
+static bool parse_log_range(napi_env env, napi_value obj,
+                            const log_reader_t *log, uint64_t *begin,
+                            uint64_t *end) {
+    const char *names[2] = {"from", "to"};
+    uint64_t *out[2] = {begin, end};
+    *begin = 0;
+    *end = log->count;
+    for (int n = 0; n < 2; n++) {
+        bool has;
+        if (napi_has_named_property(env, obj, names[n], &has) != napi_ok) {
+            return false;
+        }
+        if (!has) { continue; }
+        napi_value value;
+        int64_t timestamp;
+        if (napi_get_named_property(env, obj, names[n], &value) != napi_ok ||
+            napi_get_value_int64(env, value, &timestamp) != napi_ok) {
+            return false;
+        }
+        // `to` is inclusive
+        if (n == 1 && timestamp < INT64_MAX) { timestamp++; }
+        *out[n] = log_seek(log, timestamp < 0 ? 0 : (uint64_t)timestamp);
+    }
+    return true;
+}
+
+// args:
+//  - log: handle from openLog(..)
+//  - options: {sensorId, from, to}
+//
+// Returns {timestamps: Float64Array, values: Float32Array, lanes} of the
+// records of one sensor.
+napi_value cb_read_log(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    log_reader_t *log = get_log(env, argv[0]);
+    if (log == NULL) { return NULL; }
+
+    uint32_t sensor_id = UINT32_MAX;
+    uint64_t begin, end;
+    if (node_to_c_optional_uint32(env, argv[1], "sensorId", &sensor_id) !=
+            0 ||
+        sensor_id > SH2_MAX_SENSOR_ID ||
+        !parse_log_range(env, argv[1], log, &begin, &end)) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid read options.");
+        return NULL;
+    }
+
+    uint64_t count = 0;
+    for (uint64_t n = begin; n < end; n++) {
+        count += log->records[n].sensor_id == sensor_id;
+    }
+    uint8_t lanes;
+    decoded_value_names(sensor_id, &lanes);
+
+    double *timestamps;
+    float *values;
+    napi_value ts_buffer, values_buffer, ts_array, values_array;
+    napi_status status = napi_create_arraybuffer(
+        env, count * sizeof(double), (void **)&timestamps, &ts_buffer);
+    status |= napi_create_typedarray(env, napi_float64_array, count,
+                                     ts_buffer, 0, &ts_array);
+    status |= napi_create_arraybuffer(env, count * lanes * sizeof(float),
+                                      (void **)&values, &values_buffer);
+    status |= napi_create_typedarray(env, napi_float32_array, count * lanes,
+                                     values_buffer, 0, &values_array);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the arrays.");
+        return NULL;
+    }
+
+    uint64_t i = 0;
+    for (uint64_t n = begin; n < end && i < count; n++) {
+        const recorder_record_t *record = &log->records[n];
+        if (record->sensor_id != sensor_id) { continue; }
+        float decoded[DECODED_VALUES_MAX] = {0};
+        log_record_values(log, record, decoded);
+        timestamps[i] = (double)record->timestamp_us;
+        memcpy(&values[i * lanes], decoded, lanes * sizeof(float));
+        i++;
+    }
+
+    napi_value result, v;
+    status = napi_create_object(env, &result);
+    status |= napi_set_named_property(env, result, "timestamps", ts_array);
+    status |= napi_set_named_property(env, result, "values", values_array);
+    status |= napi_create_uint32(env, lanes, &v);
+    status |= napi_set_named_property(env, result, "lanes", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the result.");
+        return NULL;
+    }
+    return result;
+}
+
+static void replay_timer_closed(uv_handle_t *handle) { free(handle); }
+
+static void destroy_replay_context(napi_env env, napi_ref resource_ref,
+                                   napi_async_context async_context) {
+    napi_delete_reference(env, resource_ref);
+    napi_async_destroy(env, async_context);
+}
+
+// Stop the timer and let go of the log, without settling the promise. The
+// async context is left to replay_tick(..) if it's running.
+static void end_replay(void) {
+    if (_replay.state == NULL) { return; }
+    uv_timer_stop(_replay.timer);
+    uv_close((uv_handle_t *)_replay.timer, replay_timer_closed);
+    _replay.timer = NULL;
+    napi_env env = _replay.state->env;
+    napi_delete_reference(env, _replay.log_ref);
+    if (!_replay.in_tick) {
+        destroy_replay_context(env, _replay.resource_ref,
+                               _replay.async_context);
+    }
+    _replay.state = NULL;
+    _replay.log = NULL;
+    _replay.log_ref = NULL;
+    _replay.deferred = NULL;
+}
+
+// End the replay and resolve its promise with the number of events
+// replayed, or reject it with `rejection` unless that is NULL.
+static void finish_replay(napi_value rejection) {
+    napi_env env = _replay.state->env;
+    napi_deferred deferred = _replay.deferred;
+    uint64_t replayed = _replay.replayed;
+    end_replay();
+
+    if (rejection != NULL) {
+        napi_reject_deferred(env, deferred, rejection);
+        return;
+    }
+    napi_value value;
+    napi_create_int64(env, (int64_t)replayed, &value);
+    napi_resolve_deferred(env, deferred, value);
+}
+
+// Most records replayed per timer callback, so that the loop gets to run
+// other work while replaying as fast as possible.
+#define REPLAY_MAX_BATCH 4096
+
+static void replay_records(void);
+
+static void replay_tick(uv_timer_t *timer) {
+    (void)timer;
+    napi_env env = _replay.state->env;
+    napi_handle_scope scope;
+    napi_callback_scope callback_scope;
+    napi_value resource;
+    if (napi_open_handle_scope(env, &scope) != napi_ok) {
+        napi_throw_error(env, ERROR_OPENING_SCOPE,
+                         "Couldn't open napi scope.");
+        return;
+    }
+    if (napi_get_reference_value(env, _replay.resource_ref, &resource) !=
+            napi_ok ||
+        napi_open_callback_scope(env, resource, _replay.async_context,
+                                 &callback_scope) != napi_ok) {
+        napi_close_handle_scope(env, scope);
+        napi_throw_error(env, ERROR_OPENING_SCOPE,
+                         "Couldn't open napi callback scope.");
+        return;
+    }
+    napi_ref resource_ref = _replay.resource_ref;
+    napi_async_context async_context = _replay.async_context;
+    _replay.in_tick = true;
+    replay_records();
+    _replay.in_tick = false;
+    napi_close_callback_scope(env, callback_scope);
+    if (_replay.state == NULL) {
+        destroy_replay_context(env, resource_ref, async_context);
+    }
+    napi_close_handle_scope(env, scope);
+}
+
+// Replay the records that are due, and schedule the next ones.
+static void replay_records(void) {
+    addon_state_t *state = _replay.state;
+    napi_env env = state->env;
+
+    // Timestamp the replay has reached
+    double elapsed_us = (double)(uv_hrtime() - _replay.start_ns) / 1000.0;
+    uint64_t due_us = _replay.speed == 0
+                          ? UINT64_MAX
+                          : _replay.first_us +
+                                (uint64_t)(elapsed_us * _replay.speed);
+    const log_reader_t *log = _replay.log;
+    uint32_t batch = 0;
+    bool pending = false;
+    while (_replay.state != NULL && _replay.next < _replay.end &&
+           batch < REPLAY_MAX_BATCH) {
+        const recorder_record_t *record = &log->records[_replay.next];
+        if (record->timestamp_us > due_us) { break; }
+        _replay.next++;
+        batch++;
+        if (_replay.sensor_mask != 0 &&
+            (record->sensor_id > SH2_MAX_SENSOR_ID ||
+             !(_replay.sensor_mask & (1ULL << record->sensor_id)))) {
+            continue;
+        }
+        sh2_SensorEventView_t view;
+        if (!log_record_view(record, &view)) { continue; }
+        sensor_event_hub(state, &view);
+        _replay.replayed++;
+        napi_is_exception_pending(env, &pending);
+        if (pending) { break; }
+    }
+    if (!pending) {
+        deliver_to_subscribers(state);
+        napi_is_exception_pending(env, &pending);
+    }
+
+    // stopReplay(..) was called from a callback
+    if (_replay.state == NULL) { return; }
+    if (pending) {
+        // A callback threw; reject the replay with it.
+        napi_value error;
+        napi_get_and_clear_last_exception(env, &error);
+        finish_replay(error);
+    } else if (_replay.next >= _replay.end) {
+        finish_replay(NULL);
+    } else {
+        uint64_t delay_ms = 0;
+        if (_replay.speed != 0) {
+            uint64_t next_us = log->records[_replay.next].timestamp_us;
+            double offset_us = next_us > _replay.first_us
+                                   ? (double)(next_us - _replay.first_us)
+                                   : 0;
+            double wait_us = offset_us / _replay.speed - elapsed_us;
+            delay_ms = wait_us > 0 ? (uint64_t)(wait_us / 1000.0) : 0;
+        }
+        uv_timer_start(_replay.timer, replay_tick, delay_ms, 0);
+    }
+}
+
+// args:
+//  - log: handle from openLog(..) of a raw recording
+//  - options (optional): {speed, from, to, sensors}
+//
+// Returns a promise of the number of events replayed.
+napi_value cb_replay_log(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 2);
+    if (!success) { return NULL; }
+
+    log_reader_t *log = get_log(env, argv[0]);
+    if (log == NULL) { return NULL; }
+    if (log->header.format != RECORDER_RAW) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Only raw recordings can be replayed.");
+        return NULL;
+    }
+    if (_hub_owner != NULL || _replay.state != NULL) {
+        napi_throw_error(env, ERROR_INTERACTING_WITH_DRIVER,
+                         "Close the sensor hub and stop other replays first.");
+        return NULL;
+    }
+
+    double speed = 1.0;
+    uint64_t sensor_mask = 0;
+    uint64_t begin = 0, end = log->count;
+    if (argc == 2) {
+        bool has_speed;
+        napi_value value;
+        if (napi_has_named_property(env, argv[1], "speed", &has_speed) !=
+                napi_ok ||
+            (has_speed &&
+             (napi_get_named_property(env, argv[1], "speed", &value) !=
+                  napi_ok ||
+              napi_get_value_double(env, value, &speed) != napi_ok ||
+              !(speed >= 0))) ||
+            !parse_sensor_list(env, argv[1], &sensor_mask) ||
+            !parse_log_range(env, argv[1], log, &begin, &end)) {
+            napi_throw_error(env, ARGUMENT_ERROR, "Invalid replay options.");
+            return NULL;
+        }
+    }
+
+    uv_loop_t *loop;
+    napi_value promise, resource, name;
+    uv_timer_t *timer = malloc(sizeof(uv_timer_t));
+    if (timer == NULL || napi_get_uv_event_loop(env, &loop) != napi_ok ||
+        uv_timer_init(loop, timer) != 0) {
+        free(timer);
+        napi_throw_error(env, UNKNOWN_ERROR, "Couldn't start a timer.");
+        return NULL;
+    }
+    napi_status status = napi_create_object(env, &resource);
+    status |= napi_create_string_utf8(env, "replayLog", NAPI_AUTO_LENGTH,
+                                      &name);
+    status |= napi_async_init(env, resource, name, &_replay.async_context);
+    status |= napi_create_reference(env, resource, 1, &_replay.resource_ref);
+    status |= napi_create_reference(env, argv[0], 1, &_replay.log_ref);
+    status |= napi_create_promise(env, &_replay.deferred, &promise);
+    if (status != napi_ok) {
+        uv_close((uv_handle_t *)timer, replay_timer_closed);
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the replay promise.");
+        return NULL;
+    }
+    _replay.state = state;
+    _replay.timer = timer;
+    _replay.log = log;
+    _replay.next = begin;
+    _replay.end = end;
+    _replay.sensor_mask = sensor_mask;
+    _replay.speed = isinf(speed) ? 0 : speed;
+    _replay.first_us = begin < end ? log->records[begin].timestamp_us : 0;
+    _replay.start_ns = uv_hrtime();
+    _replay.replayed = 0;
+
+    uv_timer_start(timer, replay_tick, 0, 0);
+    return promise;
+}
+
+// Stops the replay; its promise resolves with the events replayed so far.
+napi_value cb_stop_replay(napi_env env, napi_callback_info info) {
+    (void)info;
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+    if (_replay.state == state) { finish_replay(NULL); }
+    return NULL;
+}
+
+// args:
+//  - log: handle from openLog(..)
+//  - options: {sensorId, from, to}
+//
+// Returns a Uint8Array of the records of one sensor, see stream_codec.h.
+napi_value cb_encode_log_stream(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    log_reader_t *log = get_log(env, argv[0]);
+    if (log == NULL) { return NULL; }
+    if (log->header.format != RECORDER_RAW) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Only raw recordings can be encoded.");
+        return NULL;
+    }
+
+    uint32_t sensor_id = UINT32_MAX;
+    uint64_t begin, end;
+    if (node_to_c_optional_uint32(env, argv[1], "sensorId", &sensor_id) !=
+            0 ||
+        sensor_id > SH2_MAX_SENSOR_ID ||
+        !parse_log_range(env, argv[1], log, &begin, &end)) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid encode options.");
+        return NULL;
+    }
+
+    // Size the array with a first pass; encoding is cheap next to the
+    // reads from the mapping.
+    uint8_t scratch[STREAM_MAX_RECORD + STREAM_HEADER_SIZE];
+    stream_encoder_t enc;
+    stream_encoder_init(&enc, sensor_id);
+    size_t size = 0;
+    for (uint64_t n = begin; n < end; n++) {
+        if (log->records[n].sensor_id != sensor_id) { continue; }
+        size += stream_encode(&enc, &log->records[n], scratch);
+    }
+
+    uint8_t *out;
+    napi_value buffer, result;
+    napi_status status =
+        napi_create_arraybuffer(env, size, (void **)&out, &buffer);
+    status |= napi_create_typedarray(env, napi_uint8_array, size, buffer, 0,
+                                     &result);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the Uint8Array.");
+        return NULL;
+    }
+    stream_encoder_init(&enc, sensor_id);
+    size_t written = 0;
+    for (uint64_t n = begin; n < end; n++) {
+        if (log->records[n].sensor_id != sensor_id) { continue; }
+        size_t len = stream_encode(&enc, &log->records[n], scratch);
+        memcpy(out + written, scratch, len);
+        written += len;
+    }
+    return result;
+}
+
+static void free_stream_decoder(napi_env env, void *data, void *hint) {
+    (void)env;
+    (void)hint;
+    free(data);
+}
+
+// Returns a handle for decodeStream(..).
+napi_value cb_create_stream_decoder(napi_env env, napi_callback_info info) {
+    (void)info;
+    stream_decoder_t *dec = malloc(sizeof(stream_decoder_t));
+    if (dec == NULL) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE, "Out of memory.");
+        return NULL;
+    }
+    stream_decoder_init(dec);
+
+    napi_value handle;
+    if (napi_create_external(env, dec, free_stream_decoder, NULL, &handle) !=
+        napi_ok) {
+        free(dec);
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the decoder handle.");
+        return NULL;
+    }
+    if (napi_type_tag_object(env, handle, &DECODER_TAG) != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the decoder handle.");
+        return NULL;
+    }
+    return handle;
+}
+
+// Decode the records completed by `len` bytes. With `timestamps` NULL, only
+// counts them. Returns false if the stream is corrupt.
+static bool decode_stream_bytes(stream_decoder_t *dec, const uint8_t *in,
+                                size_t len, uint8_t lanes, size_t *count,
+                                double *timestamps, float *values) {
+    *count = 0;
+    while (len > 0) {
+        size_t used;
+        recorder_record_t record;
+        stream_result_t result = stream_decode(dec, in, len, &used, &record);
+        if (result == STREAM_CORRUPT) { return false; }
+        in += used;
+        len -= used;
+        if (result != STREAM_RECORD) { continue; }
+        if (timestamps != NULL) {
+            float decoded[DECODED_VALUES_MAX] = {0};
+            log_report_values(&record, decoded);
+            timestamps[*count] = (double)record.timestamp_us;
+            memcpy(&values[*count * lanes], decoded, lanes * sizeof(float));
+        }
+        (*count)++;
+    }
+    return true;
+}
+
+// args:
+//  - decoder: handle from createStreamDecoder()
+//  - bytes: Uint8Array, any part of a stream
+//
+// Returns {sensorId, timestamps: Float64Array, values: Float32Array, lanes}
+// of the records completed by `bytes`. A record cut off at the end is
+// completed by the next call.
+napi_value cb_decode_stream(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    napi_valuetype type;
+    bool tagged = false;
+    stream_decoder_t *dec = NULL;
+    if (napi_typeof(env, argv[0], &type) != napi_ok ||
+        type != napi_external ||
+        napi_check_object_type_tag(env, argv[0], &DECODER_TAG, &tagged) !=
+            napi_ok ||
+        !tagged ||
+        napi_get_value_external(env, argv[0], (void **)&dec) != napi_ok) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Expected a decoder from createStreamDecoder.");
+        return NULL;
+    }
+
+    bool is_typedarray = false;
+    napi_typedarray_type array_type;
+    size_t len = 0;
+    void *data = NULL;
+    if (napi_is_typedarray(env, argv[1], &is_typedarray) != napi_ok ||
+        !is_typedarray ||
+        napi_get_typedarray_info(env, argv[1], &array_type, &len, &data,
+                                 NULL, NULL) != napi_ok ||
+        array_type != napi_uint8_array) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Expected a Uint8Array.");
+        return NULL;
+    }
+
+    // Count on a copy of the decoder, then decode for real
+    stream_decoder_t counter = *dec;
+    size_t count;
+    if (!decode_stream_bytes(&counter, data, len, 0, &count, NULL, NULL)) {
+        stream_decoder_init(dec);
+        napi_throw_error(env, RECORDING_ERROR,
+                         "Corrupt stream; the decoder was reset.");
+        return NULL;
+    }
+    uint8_t lanes = 0;
+    if (counter.started) {
+        decoded_value_names(counter.prev.sensor_id, &lanes);
+    }
+
+    double *timestamps;
+    float *values;
+    napi_value ts_buffer, values_buffer, ts_array, values_array;
+    napi_status status = napi_create_arraybuffer(
+        env, count * sizeof(double), (void **)&timestamps, &ts_buffer);
+    status |= napi_create_typedarray(env, napi_float64_array, count,
+                                     ts_buffer, 0, &ts_array);
+    status |= napi_create_arraybuffer(env, count * lanes * sizeof(float),
+                                      (void **)&values, &values_buffer);
+    status |= napi_create_typedarray(env, napi_float32_array, count * lanes,
+                                     values_buffer, 0, &values_array);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the arrays.");
+        return NULL;
+    }
+    decode_stream_bytes(dec, data, len, lanes, &count, timestamps, values);
+
+    napi_value result, v;
+    status = napi_create_object(env, &result);
+    if (dec->started) {
+        status |= napi_create_uint32(env, dec->prev.sensor_id, &v);
+    } else {
+        status |= napi_get_null(env, &v);
+    }
+    status |= napi_set_named_property(env, result, "sensorId", v);
+    status |= napi_set_named_property(env, result, "timestamps", ts_array);
+    status |= napi_set_named_property(env, result, "values", values_array);
+    status |= napi_create_uint32(env, lanes, &v);
+    status |= napi_set_named_property(env, result, "lanes", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the result.");
+        return NULL;
+    }
+    return result;
+}
+
+// args:
+//  - log: handle from openLog(..)
+//  - directory: string
+//  - options: {sensors, from, to, batchRows}
+//
+// Writes `<directory>/sensor_<id>.arrow` for each sensor in the range.
+// Returns [{sensorId, path, rows}].
+napi_value cb_export_log_to_arrow(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 3);
+    if (!success) { return NULL; }
+
+    log_reader_t *log = get_log(env, argv[0]);
+    if (log == NULL) { return NULL; }
+
+    char dir[PATH_MAX - 32];
+    size_t len;
+    if (napi_get_value_string_utf8(env, argv[1], dir, sizeof(dir), &len) !=
+            napi_ok ||
+        len == 0 || len == sizeof(dir) - 1) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Expected a directory.");
+        return NULL;
+    }
+
+    uint64_t sensor_mask = 0;
+    uint64_t begin = 0, end = log->count;
+    uint32_t batch_rows = ARROW_DEFAULT_BATCH_ROWS;
+    if (argc == 3 &&
+        (!parse_sensor_list(env, argv[2], &sensor_mask) ||
+         !parse_log_range(env, argv[2], log, &begin, &end) ||
+         node_to_c_optional_uint32(env, argv[2], "batchRows", &batch_rows) !=
+             0 ||
+         batch_rows == 0 || batch_rows > (1u << 24))) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid export options.");
+        return NULL;
+    }
+
+    arrow_writer_t *writers =
+        calloc(SH2_MAX_SENSOR_ID + 1, sizeof(arrow_writer_t));
+    if (writers == NULL) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE, "Out of memory.");
+        return NULL;
+    }
+    uint64_t open_mask = 0;
+    char path[PATH_MAX];
+    int error = 0;
+    for (uint64_t n = begin; n < end && error == 0; n++) {
+        const recorder_record_t *record = &log->records[n];
+        uint8_t id = record->sensor_id;
+        if (id > SH2_MAX_SENSOR_ID ||
+            (sensor_mask != 0 && !(sensor_mask & (1ULL << id)))) {
+            continue;
+        }
+        if (!(open_mask & (1ULL << id))) {
+            snprintf(path, sizeof(path), "%s/sensor_%u.arrow", dir, id);
+            error = arrow_open(&writers[id], path, id, batch_rows);
+            if (error != 0) { break; }
+            open_mask |= 1ULL << id;
+        }
+        float values[DECODED_VALUES_MAX] = {0};
+        log_record_values(log, record, values);
+        error = arrow_append(&writers[id], record, values);
+    }
+
+    napi_value result;
+    napi_status status = napi_create_array(env, &result);
+    uint32_t i = 0;
+    napi_value entry = result;
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID && entry != NULL; id++) {
+        if (!(open_mask & (1ULL << id))) { continue; }
+        uint64_t rows = writers[id].total_rows;
+        int closed = arrow_close(&writers[id]);
+        open_mask &= ~(1ULL << id);
+        if (error == 0) { error = closed; }
+
+        snprintf(path, sizeof(path), "%s/sensor_%u.arrow", dir, id);
+        entry = node_from_c_ArrowExport(env, id, path, rows);
+        if (entry != NULL) {
+            status |= napi_set_element(env, result, i++, entry);
+        }
+    }
+    // Left open if creating an entry threw
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        if (open_mask & (1ULL << id)) { arrow_close(&writers[id]); }
+    }
+    free(writers);
+    if (entry == NULL) { return NULL; }
+    if (error != 0) {
+        char msg[PATH_MAX + 64];
+        snprintf(msg, sizeof(msg), "Couldn't export to %s: %s", dir,
+                 strerror(error));
+        napi_throw_error(env, RECORDING_ERROR, msg);
+        return NULL;
+    }
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the result.");
+        return NULL;
+    }
+    return result;
+}
+
+// Most samples a history keeps, and most memory it takes. The ring is
+// mirrored, so a sample of n values takes 2 * (8 + 4 n) bytes.
+#define HISTORY_MAX_CAPACITY (1u << 24)
+#define HISTORY_MAX_BYTES ((size_t)1 << 30)
+
+// args:
+//  - sensorId: number
+//  - capacity: number, 0 to stop keeping a history
+napi_value cb_set_history(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    uint32_t sensor_id, capacity;
+    if (napi_get_value_uint32(env, argv[0], &sensor_id) != napi_ok ||
+        sensor_id > SH2_MAX_SENSOR_ID ||
+        napi_get_value_uint32(env, argv[1], &capacity) != napi_ok ||
+        capacity > HISTORY_MAX_CAPACITY) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Invalid sensor id or history capacity.");
+        return NULL;
+    }
+    uint8_t lanes;
+    decoded_value_names(sensor_id, &lanes);
+    if (history_bytes(capacity, lanes) > HISTORY_MAX_BYTES) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "History would take more than 1 GB.");
+        return NULL;
+    }
+
+    // Views from the old history keep its memory; it just stops being
+    // written.
+    if (state->history_refs[sensor_id] != NULL) {
+        napi_delete_reference(env, state->history_refs[sensor_id]);
+        state->history_refs[sensor_id] = NULL;
+    }
+    if (capacity == 0) { return NULL; }
+
+    void *data;
+    napi_value buffer;
+    if (napi_create_arraybuffer(env, history_bytes(capacity, lanes), &data,
+                                &buffer) != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the history.");
+        return NULL;
+    }
+    if (napi_create_reference(env, buffer, 1,
+                              &state->history_refs[sensor_id]) != napi_ok) {
+        napi_throw_error(env, REF_ERROR,
+                         "Couldn't create reference to the history.");
+        return NULL;
+    }
+    history_init(&state->histories[sensor_id], data, capacity, lanes);
+    return NULL;
+}
+
+// The history of the sensor id in `value`. Returns NULL without throwing if
+// the sensor has none, and throws on an invalid id.
+static history_t *get_history(napi_env env, addon_state_t *state,
+                              napi_value value, uint32_t *sensor_id,
+                              napi_value *buffer) {
+    if (napi_get_value_uint32(env, value, sensor_id) != napi_ok ||
+        *sensor_id > SH2_MAX_SENSOR_ID) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid sensor id.");
+        return NULL;
+    }
+    if (state->history_refs[*sensor_id] == NULL ||
+        napi_get_reference_value(env, state->history_refs[*sensor_id],
+                                 buffer) != napi_ok) {
+        return NULL;
+    }
+    return &state->histories[*sensor_id];
+}
+
+// {first, next, timestamps, values: {name: Float32Array}} of the samples
+// [first, end), as views into the history's memory.
+static napi_value history_range(napi_env env, const history_t *h,
+                                napi_value buffer, uint8_t sensor_id,
+                                uint64_t first, uint64_t end) {
+    size_t slot = history_slot(h, first);
+    size_t count = end - first;
+    size_t column = 2 * (size_t)h->capacity;
+    uint8_t lanes;
+    const char *const *names = decoded_value_names(sensor_id, &lanes);
+
+    napi_value result, values, array, v;
+    napi_status status = napi_create_object(env, &result);
+    status |= napi_create_int64(env, (int64_t)first, &v);
+    status |= napi_set_named_property(env, result, "first", v);
+    status |= napi_create_int64(env, (int64_t)end, &v);
+    status |= napi_set_named_property(env, result, "next", v);
+    status |= napi_create_typedarray(env, napi_float64_array, count, buffer,
+                                     slot * sizeof(double), &array);
+    status |= napi_set_named_property(env, result, "timestamps", array);
+    status |= napi_create_object(env, &values);
+    for (uint8_t l = 0; l < h->lanes && l < lanes; l++) {
+        size_t offset = column * sizeof(double) +
+                        (l * column + slot) * sizeof(float);
+        status |= napi_create_typedarray(env, napi_float32_array, count,
+                                         buffer, offset, &array);
+        status |= napi_set_named_property(env, values, names[l], array);
+    }
+    status |= napi_set_named_property(env, result, "values", values);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the history views.");
+        return NULL;
+    }
+    return result;
+}
+
+// A timestamp, count or cursor argument of a history query.
+static bool get_history_arg(napi_env env, napi_value value, uint64_t *out) {
+    int64_t n;
+    if (napi_get_value_int64(env, value, &n) != napi_ok || n < 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Expected a non-negative integer.");
+        return false;
+    }
+    *out = (uint64_t)n;
+    return true;
+}
+
+typedef enum { HISTORY_WINDOW, HISTORY_LAST, HISTORY_SINCE } history_query_t;
+
+static napi_value query_history(napi_env env, napi_callback_info info,
+                                history_query_t query) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 3;
+    napi_value argv[3] = {0};
+    size_t args = query == HISTORY_WINDOW ? 3 : 2;
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, args, args);
+    if (!success) { return NULL; }
+
+    uint64_t a = 0, b = 0;
+    if (!get_history_arg(env, argv[1], &a) ||
+        (query == HISTORY_WINDOW && !get_history_arg(env, argv[2], &b))) {
+        return NULL;
+    }
+    uint32_t sensor_id;
+    napi_value buffer;
+    history_t *h = get_history(env, state, argv[0], &sensor_id, &buffer);
+    if (h == NULL) {
+        bool pending;
+        napi_value null;
+        napi_is_exception_pending(env, &pending);
+        if (pending) { return NULL; }
+        napi_get_null(env, &null);
+        return null;
+    }
+
+    uint64_t first, end;
+    switch (query) {
+        case HISTORY_WINDOW: history_window(h, a, b, &first, &end); break;
+        case HISTORY_LAST: history_last(h, a, &first, &end); break;
+        default: history_since(h, a, &first, &end); break;
+    }
+    return history_range(env, h, buffer, sensor_id, first, end);
+}
+
+// args:
+//  - sensorId: number
+//  - fromUs, toUs: number, inclusive
+napi_value cb_history_window(napi_env env, napi_callback_info info) {
+    return query_history(env, info, HISTORY_WINDOW);
+}
+
+// args:
+//  - sensorId: number
+//  - n: number
+napi_value cb_history_last(napi_env env, napi_callback_info info) {
+    return query_history(env, info, HISTORY_LAST);
+}
+
+// args:
+//  - sensorId: number
+//  - cursor: number, `next` of an earlier query
+napi_value cb_history_since(napi_env env, napi_callback_info info) {
+    return query_history(env, info, HISTORY_SINCE);
+}
+
+// Hand the frames the resampler made since the last delivery to its callback
+// as {timestamps, values, dropped}. The arrays are copies, as the resampler
+// reuses its buffers.
+static void deliver_resampled(addon_state_t *state) {
+    resampler_t *r = state->resampler;
+    if (r == NULL || (r->frames == 0 && r->dropped == 0)) { return; }
+    napi_env env = state->env;
+
+    bool pending = false;
+    napi_is_exception_pending(env, &pending);
+    if (pending) { return; }
+
+    napi_handle_scope scope;
+    if (napi_open_handle_scope(env, &scope) != napi_ok) {
+        napi_throw_error(env, ERROR_OPENING_SCOPE, "Couldn't open napi scope.");
+        return;
+    }
+    size_t count = (size_t)r->frames * r->stride;
+    void *timestamps_data, *values_data;
+    napi_value frames, buffer, array, v, fn, global, ret;
+    napi_status status = napi_create_object(env, &frames);
+    status |= napi_create_arraybuffer(env, r->frames * sizeof(double),
+                                      &timestamps_data, &buffer);
+    status |= napi_create_typedarray(env, napi_float64_array, r->frames,
+                                     buffer, 0, &array);
+    status |= napi_set_named_property(env, frames, "timestamps", array);
+    status |= napi_create_arraybuffer(env, count * sizeof(float),
+                                      &values_data, &buffer);
+    status |= napi_create_typedarray(env, napi_float32_array, count, buffer, 0,
+                                     &array);
+    status |= napi_set_named_property(env, frames, "values", array);
+    status |= napi_create_int64(env, (int64_t)r->dropped, &v);
+    status |= napi_set_named_property(env, frames, "dropped", v);
+    status |= napi_get_reference_value(env, state->resampler_fn, &fn);
+    status |= napi_get_global(env, &global);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't build the resampled frames.");
+        napi_close_handle_scope(env, scope);
+        return;
+    }
+    memcpy(timestamps_data, r->timestamps, r->frames * sizeof(double));
+    memcpy(values_data, r->values, count * sizeof(float));
+    r->frames = 0;
+    r->dropped = 0;
+    napi_call_function(env, global, fn, 1, &frames, &ret);
+    napi_close_handle_scope(env, scope);
+}
+
+static void stop_resampler(napi_env env, addon_state_t *state) {
+    if (state->resampler == NULL) { return; }
+    napi_delete_reference(env, state->resampler_fn);
+    resampler_free(state->resampler);
+    free(state->resampler);
+    state->resampler = NULL;
+}
+
+// {stride, sensors: [{sensorId, offset, names}]} of the frames of `r`.
+static napi_value resampler_layout(napi_env env, const resampler_t *r) {
+    napi_value layout, sensors, sensor, names, v;
+    napi_status status = napi_create_object(env, &layout);
+    status |= napi_create_uint32(env, r->stride, &v);
+    status |= napi_set_named_property(env, layout, "stride", v);
+    status |= napi_create_array_with_length(env, r->stream_count, &sensors);
+    for (uint8_t n = 0; n < r->stream_count; n++) {
+        const resampler_stream_t *s = &r->streams[n];
+        uint8_t lanes;
+        const char *const *value_names =
+            decoded_value_names(s->sensor_id, &lanes);
+        status |= napi_create_object(env, &sensor);
+        status |= napi_create_uint32(env, s->sensor_id, &v);
+        status |= napi_set_named_property(env, sensor, "sensorId", v);
+        status |= napi_create_uint32(env, s->offset, &v);
+        status |= napi_set_named_property(env, sensor, "offset", v);
+        status |= napi_create_array_with_length(env, lanes, &names);
+        for (uint8_t l = 0; l < lanes; l++) {
+            status |= napi_create_string_utf8(env, value_names[l],
+                                              NAPI_AUTO_LENGTH, &v);
+            status |= napi_set_element(env, names, l, v);
+        }
+        status |= napi_set_named_property(env, sensor, "names", names);
+        status |= napi_set_element(env, sensors, n, sensor);
+    }
+    status |= napi_set_named_property(env, layout, "sensors", sensors);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the resampler layout.");
+        return NULL;
+    }
+    return layout;
+}
+
+// args:
+//  - options: {sensors, intervalUs, latencyUs}
+//  - callback: called with {timestamps, values, dropped} after each service
+//
+// Replaces a running resampler. Returns the layout of the frames.
+napi_value cb_start_resampler(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    napi_valuetype argt;
+    napi_typeof(env, argv[1], &argt);
+    if (argt != napi_function) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Second argument must be a function.");
+        return NULL;
+    }
+
+    uint64_t sensor_mask = 0;
+    uint32_t interval_us = 0, latency_us = UINT32_MAX;
+    napi_typeof(env, argv[0], &argt);
+    if (argt != napi_object ||
+        !parse_sensor_list(env, argv[0], &sensor_mask) ||
+        node_to_c_optional_uint32(env, argv[0], "intervalUs", &interval_us) !=
+            0 ||
+        node_to_c_optional_uint32(env, argv[0], "latencyUs", &latency_us) !=
+            0 ||
+        interval_us == 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Invalid resampler options. sensors must be an "
+                         "array of SensorIds and intervalUs a positive "
+                         "uint32 number.");
+        return NULL;
+    }
+    // By default a stalled sensor holds frames back by four intervals
+    uint64_t latency = latency_us == UINT32_MAX ? 4 * (uint64_t)interval_us
+                                                : latency_us;
+
+    uint8_t sensor_ids[RESAMPLER_MAX_SENSORS];
+    uint8_t count = 0;
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        if (!(sensor_mask & (1ULL << id))) { continue; }
+        uint8_t lanes;
+        decoded_value_names(id, &lanes);
+        if (lanes == 0 || count == RESAMPLER_MAX_SENSORS) {
+            count = 0;
+            break;
+        }
+        sensor_ids[count++] = id;
+    }
+    if (count == 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Resample 1 to 8 sensors with decoded values.");
+        return NULL;
+    }
+
+    resampler_t *r = malloc(sizeof(resampler_t));
+    if (r == NULL ||
+        !resampler_init(r, sensor_ids, count, interval_us, latency)) {
+        free(r);
+        napi_throw_error(env, UNKNOWN_ERROR, "Couldn't start the resampler.");
+        return NULL;
+    }
+    napi_value layout = resampler_layout(env, r);
+    napi_ref fn_ref;
+    if (layout == NULL ||
+        napi_create_reference(env, argv[1], 1, &fn_ref) != napi_ok) {
+        resampler_free(r);
+        free(r);
+        if (layout != NULL) {
+            napi_throw_error(env, REF_ERROR,
+                             "Couldn't create a napi ref for the callback.");
+        }
+        return NULL;
+    }
+    stop_resampler(env, state);
+    state->resampler = r;
+    state->resampler_fn = fn_ref;
+    return layout;
+}
+
+// Frames not delivered yet are discarded.
+napi_value cb_stop_resampler(napi_env env, napi_callback_info info) {
+    (void)info;
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+    stop_resampler(env, state);
+    return NULL;
+}
+
+// args:
+//  - sensorId: number
+//  - options: {window, samples}, or null to stop keeping statistics
+napi_value cb_set_stats(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    uint32_t sensor_id;
+    uint8_t lanes = 0;
+    if (napi_get_value_uint32(env, argv[0], &sensor_id) == napi_ok &&
+        sensor_id <= SH2_MAX_SENSOR_ID) {
+        decoded_value_names(sensor_id, &lanes);
+    }
+    if (lanes == 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Invalid sensor id or sensor without decoded "
+                         "values.");
+        return NULL;
+    }
+
+    napi_valuetype argt;
+    napi_typeof(env, argv[1], &argt);
+    stats_window_t window = STATS_CUMULATIVE;
+    uint32_t samples = 0;
+    if (argt != napi_null) {
+        char name[16] = "cumulative";
+        if (argt != napi_object ||
+            node_to_c_optional_string(env, argv[1], "window", name,
+                                      sizeof(name)) != 0 ||
+            node_to_c_optional_uint32(env, argv[1], "samples", &samples) !=
+                0) {
+            name[0] = '\0';
+        }
+        if (strcmp(name, "cumulative") == 0) {
+            window = STATS_CUMULATIVE;
+        } else if (strcmp(name, "tumbling") == 0 && samples > 0) {
+            window = STATS_TUMBLING;
+        } else if (strcmp(name, "sliding") == 0 && samples > 0 &&
+                   samples <= STATS_MAX_SLIDING) {
+            window = STATS_SLIDING;
+        } else {
+            napi_throw_error(env, ARGUMENT_ERROR,
+                             "Invalid statistics options. window must be "
+                             "'cumulative', 'tumbling' or 'sliding', and "
+                             "samples 1 to 65536 for a sliding window.");
+            return NULL;
+        }
+    }
+
+    if (state->stats[sensor_id] != NULL) {
+        stats_free(state->stats[sensor_id]);
+        free(state->stats[sensor_id]);
+        state->stats[sensor_id] = NULL;
+    }
+    if (argt == napi_null) { return NULL; }
+
+    stats_t *s = malloc(sizeof(stats_t));
+    if (s == NULL || !stats_init(s, window, samples, lanes)) {
+        free(s);
+        napi_throw_error(env, UNKNOWN_ERROR,
+                         "Couldn't allocate the statistics.");
+        return NULL;
+    }
+    state->stats[sensor_id] = s;
+    return NULL;
+}
+
+// args:
+//  - sensorId: number
+//
+// Returns {count, timestamp, values: {name: {mean, variance, min, max,
+// rms}}}, or null if the sensor has no statistics.
+napi_value cb_get_stats(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    uint32_t sensor_id;
+    if (napi_get_value_uint32(env, argv[0], &sensor_id) != napi_ok ||
+        sensor_id > SH2_MAX_SENSOR_ID) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid sensor id.");
+        return NULL;
+    }
+    const stats_t *s = state->stats[sensor_id];
+    napi_value result, values, value, v;
+    if (s == NULL) {
+        napi_get_null(env, &result);
+        return result;
+    }
+
+    stats_value_t stats[DECODED_VALUES_MAX];
+    uint64_t count = stats_snapshot(s, stats);
+    uint8_t lanes;
+    const char *const *names = decoded_value_names(sensor_id, &lanes);
+
+    napi_status status = napi_create_object(env, &result);
+    status |= napi_create_int64(env, (int64_t)count, &v);
+    status |= napi_set_named_property(env, result, "count", v);
+    status |= napi_create_double(env, (double)s->timestamp_us, &v);
+    status |= napi_set_named_property(env, result, "timestamp", v);
+    status |= napi_create_object(env, &values);
+    for (uint8_t l = 0; l < s->lanes && l < lanes; l++) {
+        status |= napi_create_object(env, &value);
+        status |= napi_create_double(env, stats[l].mean, &v);
+        status |= napi_set_named_property(env, value, "mean", v);
+        status |= napi_create_double(env, stats[l].variance, &v);
+        status |= napi_set_named_property(env, value, "variance", v);
+        status |= napi_create_double(env, stats[l].min, &v);
+        status |= napi_set_named_property(env, value, "min", v);
+        status |= napi_create_double(env, stats[l].max, &v);
+        status |= napi_set_named_property(env, value, "max", v);
+        status |= napi_create_double(env, stats[l].rms, &v);
+        status |= napi_set_named_property(env, value, "rms", v);
+        status |= napi_set_named_property(env, values, names[l], value);
+    }
+    status |= napi_set_named_property(env, result, "values", values);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the statistics.");
+        return NULL;
+    }
+    return result;
+}
+
+// args:
+//  - sensorId: number, of a sensor reporting x, y and z
+//  - options: {maxClusterSamples}, or null to stop
+napi_value cb_set_allan_variance(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    uint32_t sensor_id;
+    uint8_t lanes = 0;
+    const char *const *names = NULL;
+    if (napi_get_value_uint32(env, argv[0], &sensor_id) == napi_ok &&
+        sensor_id <= SH2_MAX_SENSOR_ID) {
+        names = decoded_value_names(sensor_id, &lanes);
+    }
+    if (lanes < ALLAN_LANES || strcmp(names[0], "x") != 0) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Invalid sensor id or sensor without x, y and z.");
+        return NULL;
+    }
+
+    napi_valuetype argt;
+    napi_typeof(env, argv[1], &argt);
+    uint32_t max_cluster = 1u << 16;
+    if (argt != napi_null &&
+        (argt != napi_object ||
+         node_to_c_optional_uint32(env, argv[1], "maxClusterSamples",
+                                   &max_cluster) != 0 ||
+         allan_levels(max_cluster) == 0)) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Invalid Allan variance options. maxClusterSamples "
+                         "must be 1 to 2^20.");
+        return NULL;
+    }
+
+    if (state->allan[sensor_id] != NULL) {
+        allan_free(state->allan[sensor_id]);
+        free(state->allan[sensor_id]);
+        state->allan[sensor_id] = NULL;
+    }
+    if (argt == napi_null) { return NULL; }
+
+    allan_t *a = malloc(sizeof(allan_t));
+    if (a == NULL || !allan_init(a, allan_levels(max_cluster))) {
+        free(a);
+        napi_throw_error(env, UNKNOWN_ERROR,
+                         "Couldn't allocate the Allan variance.");
+        return NULL;
+    }
+    state->allan[sensor_id] = a;
+    return NULL;
+}
+
+static const char *const ALLAN_AXES[ALLAN_LANES] = {"x", "y", "z"};
+
+// args:
+//  - sensorId: number
+//
+// Returns {samples, interval, curve: [{tau, terms, x, y, z}], noise: {x,
+// y, z: {noiseDensity, biasInstability, rateRandomWalk}}}, or null if not
+// computed for the sensor.
+napi_value cb_get_allan_variance(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    uint32_t sensor_id;
+    if (napi_get_value_uint32(env, argv[0], &sensor_id) != napi_ok ||
+        sensor_id > SH2_MAX_SENSOR_ID) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid sensor id.");
+        return NULL;
+    }
+    const allan_t *a = state->allan[sensor_id];
+    napi_value result, curve, point, noise, axis, v;
+    if (a == NULL) {
+        napi_get_null(env, &result);
+        return result;
+    }
+
+    double interval = allan_interval(a);
+    napi_status status = napi_create_object(env, &result);
+    status |= napi_create_int64(env, (int64_t)a->samples, &v);
+    status |= napi_set_named_property(env, result, "samples", v);
+    status |= napi_create_double(env, interval, &v);
+    status |= napi_set_named_property(env, result, "interval", v);
+
+    // Cluster sizes with terms so far
+    status |= napi_create_array(env, &curve);
+    for (uint8_t level = 0; level < a->levels && a->terms[level] > 0;
+         level++) {
+        status |= napi_create_object(env, &point);
+        status |= napi_create_double(env, interval * (1ULL << level), &v);
+        status |= napi_set_named_property(env, point, "tau", v);
+        status |= napi_create_int64(env, (int64_t)a->terms[level], &v);
+        status |= napi_set_named_property(env, point, "terms", v);
+        for (uint8_t l = 0; l < ALLAN_LANES; l++) {
+            status |= napi_create_double(env, allan_deviation(a, level, l), &v);
+            status |= napi_set_named_property(env, point, ALLAN_AXES[l], v);
+        }
+        status |= napi_set_element(env, curve, level, point);
+    }
+    status |= napi_set_named_property(env, result, "curve", curve);
+
+    status |= napi_create_object(env, &noise);
+    for (uint8_t l = 0; l < ALLAN_LANES; l++) {
+        allan_noise_t coefficients;
+        allan_noise(a, l, &coefficients);
+        status |= napi_create_object(env, &axis);
+        status |= napi_create_double(env, coefficients.noise_density, &v);
+        status |= napi_set_named_property(env, axis, "noiseDensity", v);
+        status |= napi_create_double(env, coefficients.bias_instability, &v);
+        status |= napi_set_named_property(env, axis, "biasInstability", v);
+        status |= napi_create_double(env, coefficients.rate_random_walk, &v);
+        status |= napi_set_named_property(env, axis, "rateRandomWalk", v);
+        status |= napi_set_named_property(env, noise, ALLAN_AXES[l], axis);
+    }
+    status |= napi_set_named_property(env, result, "noise", noise);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the Allan variance.");
+        return NULL;
+    }
+    return result;
+}
+
+// Hand each spectrum analyzer's frames since the last delivery to its
+// callback as {sensorId, timestamps, binHz, values, dropped}.
+static void deliver_spectra(addon_state_t *state) {
+    napi_env env = state->env;
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        spectrum_t *s = state->spectra[id];
+        if (s == NULL || (s->frames == 0 && s->dropped == 0)) { continue; }
+
+        bool pending = false;
+        napi_is_exception_pending(env, &pending);
+        if (pending) { return; }
+
+        napi_handle_scope scope;
+        if (napi_open_handle_scope(env, &scope) != napi_ok) {
+            napi_throw_error(env, ERROR_OPENING_SCOPE,
+                             "Couldn't open napi scope.");
+            return;
+        }
+        size_t count = (size_t)s->frames * s->axes * s->outputs;
+        void *timestamps_data, *bin_hz_data, *values_data;
+        napi_value frames, buffer, array, v, fn, global, ret;
+        napi_status status = napi_create_object(env, &frames);
+        status |= napi_create_uint32(env, id, &v);
+        status |= napi_set_named_property(env, frames, "sensorId", v);
+        status |= napi_create_arraybuffer(env, s->frames * sizeof(double),
+                                          &timestamps_data, &buffer);
+        status |= napi_create_typedarray(env, napi_float64_array, s->frames,
+                                         buffer, 0, &array);
+        status |= napi_set_named_property(env, frames, "timestamps", array);
+        status |= napi_create_arraybuffer(env, s->frames * sizeof(double),
+                                          &bin_hz_data, &buffer);
+        status |= napi_create_typedarray(env, napi_float64_array, s->frames,
+                                         buffer, 0, &array);
+        status |= napi_set_named_property(env, frames, "binHz", array);
+        status |= napi_create_arraybuffer(env, count * sizeof(float),
+                                          &values_data, &buffer);
+        status |= napi_create_typedarray(env, napi_float32_array, count,
+                                         buffer, 0, &array);
+        status |= napi_set_named_property(env, frames, "values", array);
+        status |= napi_create_int64(env, (int64_t)s->dropped, &v);
+        status |= napi_set_named_property(env, frames, "dropped", v);
+        status |= napi_get_reference_value(env, state->spectrum_fns[id], &fn);
+        status |= napi_get_global(env, &global);
+        if (status != napi_ok) {
+            napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                             "Couldn't build the spectrum frames.");
+            napi_close_handle_scope(env, scope);
+            return;
+        }
+        memcpy(timestamps_data, s->frame_timestamps,
+               s->frames * sizeof(double));
+        memcpy(bin_hz_data, s->bin_hz, s->frames * sizeof(double));
+        memcpy(values_data, s->frames_out, count * sizeof(float));
+        s->frames = 0;
+        s->dropped = 0;
+        napi_call_function(env, global, fn, 1, &frames, &ret);
+        napi_close_handle_scope(env, scope);
+    }
+}
+
+static void stop_spectrum(napi_env env, addon_state_t *state, uint8_t id) {
+    if (state->spectra[id] == NULL) { return; }
+    napi_delete_reference(env, state->spectrum_fns[id]);
+    spectrum_free(state->spectra[id]);
+    free(state->spectra[id]);
+    state->spectra[id] = NULL;
+}
+
+// Read the optional `axes` array of names of the sensor's values into the
+// indexes of the values. Defaults to x, y and z.
+static bool parse_spectrum_axes(napi_env env, napi_value obj,
+                                uint8_t sensor_id, uint8_t *lanes,
+                                uint8_t *axes) {
+    uint8_t count;
+    const char *const *names = decoded_value_names(sensor_id, &count);
+    bool has_axes;
+    if (napi_has_named_property(env, obj, "axes", &has_axes) != napi_ok) {
+        return false;
+    }
+    if (!has_axes) {
+        if (count < 3 || strcmp(names[0], "x") != 0) { return false; }
+        *axes = 3;
+        for (uint8_t a = 0; a < 3; a++) { lanes[a] = a; }
+        return true;
+    }
+
+    napi_value array;
+    bool is_array;
+    uint32_t len;
+    if (napi_get_named_property(env, obj, "axes", &array) != napi_ok ||
+        napi_is_array(env, array, &is_array) != napi_ok || !is_array ||
+        napi_get_array_length(env, array, &len) != napi_ok || len == 0 ||
+        len > SPECTRUM_MAX_AXES) {
+        return false;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        napi_value elem;
+        char name[32];
+        if (napi_get_element(env, array, i, &elem) != napi_ok ||
+            napi_get_value_string_utf8(env, elem, name, sizeof(name), NULL) !=
+                napi_ok) {
+            return false;
+        }
+        uint8_t l = 0;
+        while (l < count && strcmp(names[l], name) != 0) { l++; }
+        if (l == count) { return false; }
+        lanes[i] = l;
+    }
+    *axes = len;
+    return true;
+}
+
+// Read the optional `bands` array of edges in Hz.
+static bool parse_spectrum_bands(napi_env env, napi_value obj, float *edges,
+                                 uint8_t *bands) {
+    bool has_bands;
+    if (napi_has_named_property(env, obj, "bands", &has_bands) != napi_ok) {
+        return false;
+    }
+    *bands = 0;
+    if (!has_bands) { return true; }
+
+    napi_value array;
+    bool is_array;
+    uint32_t len;
+    if (napi_get_named_property(env, obj, "bands", &array) != napi_ok ||
+        napi_is_array(env, array, &is_array) != napi_ok || !is_array ||
+        napi_get_array_length(env, array, &len) != napi_ok || len < 2 ||
+        len > SPECTRUM_MAX_BANDS + 1) {
+        return false;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        napi_value elem;
+        double edge;
+        if (napi_get_element(env, array, i, &elem) != napi_ok ||
+            napi_get_value_double(env, elem, &edge) != napi_ok) {
+            return false;
+        }
+        edges[i] = (float)edge;
+    }
+    *bands = len - 1;
+    return true;
+}
+
+// args:
+//  - sensorId: number
+//  - options: {axes, frameSize, overlap, window, bands}
+//  - callback: called with {sensorId, timestamps, binHz, values, dropped}
+//    after each service
+//
+// Replaces a running analyzer of the sensor. Returns {axes, valuesPerAxis}.
+napi_value cb_start_spectrum(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 3;
+    napi_value argv[3] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 3, 3);
+    if (!success) { return NULL; }
+
+    napi_valuetype argt;
+    napi_typeof(env, argv[2], &argt);
+    if (argt != napi_function) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Third argument must be a function.");
+        return NULL;
+    }
+    uint32_t sensor_id;
+    if (napi_get_value_uint32(env, argv[0], &sensor_id) != napi_ok ||
+        sensor_id > SH2_MAX_SENSOR_ID) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid sensor id.");
+        return NULL;
+    }
+
+    uint8_t lanes[SPECTRUM_MAX_AXES], axes = 0, bands = 0;
+    float edges[SPECTRUM_MAX_BANDS + 1];
+    uint32_t frame_size = 256, overlap = UINT32_MAX;
+    char window_name[16] = "hann";
+    spectrum_window_t window = SPECTRUM_HANN;
+    napi_typeof(env, argv[1], &argt);
+    bool valid =
+        argt == napi_object &&
+        parse_spectrum_axes(env, argv[1], sensor_id, lanes, &axes) &&
+        parse_spectrum_bands(env, argv[1], edges, &bands) &&
+        node_to_c_optional_uint32(env, argv[1], "frameSize", &frame_size) ==
+            0 &&
+        node_to_c_optional_uint32(env, argv[1], "overlap", &overlap) == 0 &&
+        node_to_c_optional_string(env, argv[1], "window", window_name,
+                                  sizeof(window_name)) == 0;
+    if (strcmp(window_name, "hamming") == 0) {
+        window = SPECTRUM_HAMMING;
+    } else if (strcmp(window_name, "rectangular") == 0) {
+        window = SPECTRUM_RECTANGULAR;
+    } else if (strcmp(window_name, "hann") != 0) {
+        valid = false;
+    }
+    if (overlap == UINT32_MAX) { overlap = frame_size / 2; }
+
+    spectrum_t *s = NULL;
+    if (valid && overlap < frame_size) {
+        s = malloc(sizeof(spectrum_t));
+        if (s != NULL &&
+            !spectrum_init(s, lanes, axes, frame_size, frame_size - overlap,
+                           window, edges, bands)) {
+            free(s);
+            s = NULL;
+        }
+    }
+    if (s == NULL) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Invalid spectrum options. axes must name 1 to 3 "
+                         "values of the sensor, frameSize be a power of two "
+                         "from 16 to 8192, overlap less than frameSize, "
+                         "window 'hann', 'hamming' or 'rectangular' and "
+                         "bands 2 to 33 ascending frequencies.");
+        return NULL;
+    }
+
+    uint8_t count;
+    const char *const *names = decoded_value_names(sensor_id, &count);
+    napi_value layout, axis_names, v;
+    napi_ref fn_ref = NULL;
+    napi_status status = napi_create_object(env, &layout);
+    status |= napi_create_array_with_length(env, axes, &axis_names);
+    for (uint8_t a = 0; a < axes; a++) {
+        status |= napi_create_string_utf8(env, names[lanes[a]],
+                                          NAPI_AUTO_LENGTH, &v);
+        status |= napi_set_element(env, axis_names, a, v);
+    }
+    status |= napi_set_named_property(env, layout, "axes", axis_names);
+    status |= napi_create_uint32(env, s->outputs, &v);
+    status |= napi_set_named_property(env, layout, "valuesPerAxis", v);
+    status |= napi_create_reference(env, argv[2], 1, &fn_ref);
+    if (status != napi_ok) {
+        if (fn_ref != NULL) { napi_delete_reference(env, fn_ref); }
+        spectrum_free(s);
+        free(s);
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't start the spectrum analyzer.");
+        return NULL;
+    }
+    stop_spectrum(env, state, sensor_id);
+    state->spectra[sensor_id] = s;
+    state->spectrum_fns[sensor_id] = fn_ref;
+    return layout;
+}
+
+// args:
+//  - sensorId: number
+//
+// Frames not delivered yet are discarded.
+napi_value cb_stop_spectrum(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 1;
+    napi_value argv[1] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 1, 1);
+    if (!success) { return NULL; }
+
+    uint32_t sensor_id;
+    if (napi_get_value_uint32(env, argv[0], &sensor_id) != napi_ok ||
+        sensor_id > SH2_MAX_SENSOR_ID) {
+        napi_throw_error(env, ARGUMENT_ERROR, "Invalid sensor id.");
+        return NULL;
+    }
+    stop_spectrum(env, state, sensor_id);
+    return NULL;
+}
+
+// Hand the captured window to the capture's callback as {triggerTimestamp,
+// triggerSensorId, truncated, missed, sensors: [{sensorId, timestamps,
+// values}]}.
+static void deliver_capture(addon_state_t *state) {
+    capture_t *c = state->capture;
+    if (c == NULL || !c->ready) { return; }
+    napi_env env = state->env;
+
+    bool pending = false;
+    napi_is_exception_pending(env, &pending);
+    if (pending) { return; }
+
+    napi_handle_scope scope;
+    if (napi_open_handle_scope(env, &scope) != napi_ok) {
+        napi_throw_error(env, ERROR_OPENING_SCOPE, "Couldn't open napi scope.");
+        return;
+    }
+    napi_value window, sensors, sensor, buffer, array, v, fn, global, ret;
+    napi_status status = napi_create_object(env, &window);
+    status |= napi_create_double(env, (double)c->window_trigger_us, &v);
+    status |= napi_set_named_property(env, window, "triggerTimestamp", v);
+    status |= napi_create_uint32(env, c->window_trigger_sensor, &v);
+    status |= napi_set_named_property(env, window, "triggerSensorId", v);
+    status |= napi_get_boolean(env, c->truncated, &v);
+    status |= napi_set_named_property(env, window, "truncated", v);
+    status |= napi_create_int64(env, (int64_t)c->missed, &v);
+    status |= napi_set_named_property(env, window, "missed", v);
+    status |= napi_create_array_with_length(env, c->ring_count, &sensors);
+    for (uint8_t n = 0; n < c->ring_count && status == napi_ok; n++) {
+        const capture_ring_t *r = &c->rings[n];
+        size_t count = (size_t)r->count * r->lanes;
+        void *data;
+        status |= napi_create_object(env, &sensor);
+        status |= napi_create_uint32(env, r->sensor_id, &v);
+        status |= napi_set_named_property(env, sensor, "sensorId", v);
+        status |= napi_create_arraybuffer(env, r->count * sizeof(double),
+                                          &data, &buffer);
+        if (status == napi_ok) {
+            memcpy(data, r->window_timestamps, r->count * sizeof(double));
+        }
+        status |= napi_create_typedarray(env, napi_float64_array, r->count,
+                                         buffer, 0, &array);
+        status |= napi_set_named_property(env, sensor, "timestamps", array);
+        status |= napi_create_arraybuffer(env, count * sizeof(float), &data,
+                                          &buffer);
+        if (status == napi_ok) {
+            memcpy(data, r->window_values, count * sizeof(float));
+        }
+        status |= napi_create_typedarray(env, napi_float32_array, count,
+                                         buffer, 0, &array);
+        status |= napi_set_named_property(env, sensor, "values", array);
+        status |= napi_set_element(env, sensors, n, sensor);
+    }
+    status |= napi_set_named_property(env, window, "sensors", sensors);
+    status |= napi_get_reference_value(env, state->capture_fn, &fn);
+    status |= napi_get_global(env, &global);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't build the captured window.");
+        napi_close_handle_scope(env, scope);
+        return;
+    }
+    c->ready = false;
+    c->missed = 0;
+    napi_call_function(env, global, fn, 1, &window, &ret);
+    napi_close_handle_scope(env, scope);
+}
+
+static void stop_capture(napi_env env, addon_state_t *state) {
+    if (state->capture == NULL) { return; }
+    napi_delete_reference(env, state->capture_fn);
+    capture_free(state->capture);
+    free(state->capture);
+    state->capture = NULL;
+}
+
+// Read an optional number property of an options object. `result` is left
+// untouched if the property is missing.
+static bool get_optional_double(napi_env env, napi_value obj,
+                                const char *name, double *result) {
+    bool has;
+    napi_value value;
+    return napi_has_named_property(env, obj, name, &has) == napi_ok &&
+           (!has ||
+            (napi_get_named_property(env, obj, name, &value) == napi_ok &&
+             napi_get_value_double(env, value, result) == napi_ok));
+}
+
+// Read the optional `rules` array of startCapture(..): {sensorId, value,
+// above, below}, `value` naming one of the sensor's values or 'magnitude'.
+static bool parse_capture_rules(napi_env env, napi_value obj, capture_t *c) {
+    bool has_rules;
+    if (napi_has_named_property(env, obj, "rules", &has_rules) != napi_ok) {
+        return false;
+    }
+    if (!has_rules) { return true; }
+
+    napi_value rules;
+    bool is_array;
+    uint32_t len;
+    if (napi_get_named_property(env, obj, "rules", &rules) != napi_ok ||
+        napi_is_array(env, rules, &is_array) != napi_ok || !is_array ||
+        napi_get_array_length(env, rules, &len) != napi_ok ||
+        len > CAPTURE_MAX_RULES) {
+        return false;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        napi_value elem;
+        uint32_t sensor_id = UINT32_MAX;
+        char name[32] = "magnitude";
+        double above = NAN, below = NAN;
+        if (napi_get_element(env, rules, i, &elem) != napi_ok ||
+            node_to_c_optional_uint32(env, elem, "sensorId", &sensor_id) !=
+                0 ||
+            sensor_id > SH2_MAX_SENSOR_ID ||
+            node_to_c_optional_string(env, elem, "value", name,
+                                      sizeof(name)) != 0 ||
+            !get_optional_double(env, elem, "above", &above) ||
+            !get_optional_double(env, elem, "below", &below) ||
+            (isnan(above) && isnan(below))) {
+            return false;
+        }
+
+        uint8_t count;
+        const char *const *names = decoded_value_names(sensor_id, &count);
+        int8_t lane = 0;
+        if (strcmp(name, "magnitude") == 0) {
+            if (count < 3 || strcmp(names[0], "x") != 0) { return false; }
+            lane = CAPTURE_MAGNITUDE;
+        } else {
+            while (lane < count && strcmp(names[lane], name) != 0) { lane++; }
+            if (lane == count) { return false; }
+        }
+        c->rules[i] = (capture_rule_t){sensor_id, lane, above, below};
+    }
+    c->rule_count = len;
+    return true;
+}
+
+// args:
+//  - options: {sensors, preUs, postUs, capacity, triggers, rules}
+//  - callback: called with each captured window after the service it
+//    completes in
+//
+// Replaces a running capture. Returns {sensors: [{sensorId, names}]}.
+napi_value cb_start_capture(napi_env env, napi_callback_info info) {
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+
+    size_t argc = 2;
+    napi_value argv[2] = {0};
+
+    bool success = parse_args(env, info, &argc, argv, NULL, NULL, 2, 2);
+    if (!success) { return NULL; }
+
+    napi_valuetype argt;
+    napi_typeof(env, argv[1], &argt);
+    if (argt != napi_function) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Second argument must be a function.");
+        return NULL;
+    }
+
+    uint64_t sensor_mask = 0, trigger_mask = 0;
+    uint32_t pre_us = 0, post_us = 0, capacity = 4096;
+    napi_typeof(env, argv[0], &argt);
+    bool valid =
+        argt == napi_object &&
+        parse_sensor_list(env, argv[0], &sensor_mask) &&
+        parse_sensor_array(env, argv[0], "triggers", &trigger_mask) &&
+        node_to_c_optional_uint32(env, argv[0], "preUs", &pre_us) == 0 &&
+        node_to_c_optional_uint32(env, argv[0], "postUs", &post_us) == 0 &&
+        node_to_c_optional_uint32(env, argv[0], "capacity", &capacity) == 0;
+
+    uint8_t sensor_ids[CAPTURE_MAX_SENSORS];
+    uint8_t count = 0;
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID && valid; id++) {
+        if (!(sensor_mask & (1ULL << id))) { continue; }
+        if (count == CAPTURE_MAX_SENSORS) {
+            valid = false;
+            break;
+        }
+        sensor_ids[count++] = id;
+    }
+
+    capture_t *c = NULL;
+    if (valid && count > 0) {
+        c = malloc(sizeof(capture_t));
+        if (c != NULL && (!capture_init(c, sensor_ids, count, capacity,
+                                        pre_us, post_us) ||
+                          !parse_capture_rules(env, argv[0], c) ||
+                          (trigger_mask == 0 && c->rule_count == 0))) {
+            capture_free(c);
+            free(c);
+            c = NULL;
+        }
+    }
+    if (c == NULL) {
+        napi_throw_error(env, ARGUMENT_ERROR,
+                         "Invalid capture options. sensors must be 1 to 8 "
+                         "SensorIds with decoded values, capacity 1 to "
+                         "65536, and triggers or rules given. A rule needs "
+                         "a sensorId, a value of it or 'magnitude', and "
+                         "above or below.");
+        return NULL;
+    }
+    c->trigger_mask = trigger_mask;
+
+    napi_value layout, sensors, sensor, names, v;
+    napi_ref fn_ref = NULL;
+    napi_status status = napi_create_object(env, &layout);
+    status |= napi_create_array_with_length(env, count, &sensors);
+    for (uint8_t n = 0; n < count; n++) {
+        uint8_t lanes;
+        const char *const *value_names =
+            decoded_value_names(sensor_ids[n], &lanes);
+        status |= napi_create_object(env, &sensor);
+        status |= napi_create_uint32(env, sensor_ids[n], &v);
+        status |= napi_set_named_property(env, sensor, "sensorId", v);
+        status |= napi_create_array_with_length(env, lanes, &names);
+        for (uint8_t l = 0; l < lanes; l++) {
+            status |= napi_create_string_utf8(env, value_names[l],
+                                              NAPI_AUTO_LENGTH, &v);
+            status |= napi_set_element(env, names, l, v);
+        }
+        status |= napi_set_named_property(env, sensor, "names", names);
+        status |= napi_set_element(env, sensors, n, sensor);
+    }
+    status |= napi_set_named_property(env, layout, "sensors", sensors);
+    status |= napi_create_reference(env, argv[1], 1, &fn_ref);
+    if (status != napi_ok) {
+        if (fn_ref != NULL) { napi_delete_reference(env, fn_ref); }
+        capture_free(c);
+        free(c);
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't start the capture.");
+        return NULL;
+    }
+    stop_capture(env, state);
+    state->capture = c;
+    state->capture_fn = fn_ref;
+    return layout;
+}
+
+// A window captured but not delivered yet is discarded.
+napi_value cb_stop_capture(napi_env env, napi_callback_info info) {
+    (void)info;
+    addon_state_t *state = get_state(env);
+    if (state == NULL) { return NULL; }
+    stop_capture(env, state);
+    return NULL;
+}
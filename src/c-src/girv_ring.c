@@ -0,0 +1,33 @@
+#include "girv_ring.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+size_t girv_ring_length(uint32_t capacity) {
+    return GIRV_RING_HEADER + (size_t)capacity * GIRV_RING_RECORD;
+}
+
+void girv_ring_init(double *ring, uint32_t capacity) {
+    ring[0] = 0;
+    ring[1] = capacity;
+}
+
+void girv_ring_push(double *ring, const sh2_SensorValue_t *sv,
+                    uint64_t timestamp_us) {
+    // Doubles hold integers exactly up to 2^53, so the count can't wrap.
+    uint64_t written = (uint64_t)ring[0];
+    uint64_t capacity = (uint64_t)ring[1];
+    double *rec =
+        ring + GIRV_RING_HEADER + (written % capacity) * GIRV_RING_RECORD;
+
+    const sh2_GyroIntegratedRV_t *rv = &sv->un.gyroIntegratedRV;
+    rec[0] = (double)timestamp_us;
+    rec[1] = rv->i;
+    rec[2] = rv->j;
+    rec[3] = rv->k;
+    rec[4] = rv->real;
+    rec[5] = rv->angVelX;
+    rec[6] = rv->angVelY;
+    rec[7] = rv->angVelZ;
+    ring[0] = (double)(written + 1);
+}
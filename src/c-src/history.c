@@ -0,0 +1,71 @@
+#include "history.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+size_t history_bytes(uint32_t capacity, uint8_t lanes) {
+    return 2 * (size_t)capacity * (sizeof(double) + lanes * sizeof(float));
+}
+
+void history_init(history_t *h, void *memory, uint32_t capacity,
+                  uint8_t lanes) {
+    h->capacity = capacity;
+    h->lanes = lanes;
+    h->written = 0;
+    h->timestamps = memory;
+    h->values = (float *)(h->timestamps + 2 * (size_t)capacity);
+}
+
+void history_push(history_t *h, uint64_t timestamp_us,
+                  const float values[DECODED_VALUES_MAX]) {
+    size_t slot = history_slot(h, h->written);
+    size_t mirror = slot + h->capacity;
+    h->timestamps[slot] = h->timestamps[mirror] = (double)timestamp_us;
+    float *column = h->values;
+    for (uint8_t l = 0; l < h->lanes; l++) {
+        column[slot] = column[mirror] = values[l];
+        column += 2 * (size_t)h->capacity;
+    }
+    h->written++;
+}
+
+uint64_t history_oldest(const history_t *h) {
+    return h->written > h->capacity ? h->written - h->capacity : 0;
+}
+
+// First retained sample stamped at or after `timestamp_us`.
+static uint64_t lower_bound(const history_t *h, uint64_t timestamp_us) {
+    uint64_t oldest = history_oldest(h);
+    uint64_t lo = oldest, hi = h->written;
+    const double *ts = h->timestamps + history_slot(h, oldest);
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (ts[mid - oldest] < (double)timestamp_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void history_window(const history_t *h, uint64_t from_us, uint64_t to_us,
+                    uint64_t *first, uint64_t *end) {
+    *first = lower_bound(h, from_us);
+    *end = to_us == UINT64_MAX ? h->written : lower_bound(h, to_us + 1);
+    if (*end < *first) { *end = *first; }
+}
+
+void history_last(const history_t *h, uint64_t n, uint64_t *first,
+                  uint64_t *end) {
+    uint64_t oldest = history_oldest(h);
+    *end = h->written;
+    *first = h->written - oldest > n ? h->written - n : oldest;
+}
+
+void history_since(const history_t *h, uint64_t cursor, uint64_t *first,
+                   uint64_t *end) {
+    uint64_t oldest = history_oldest(h);
+    *end = h->written;
+    *first = cursor < oldest ? oldest : cursor > *end ? *end : cursor;
+}
@@ -45,6 +45,8 @@ static struct openi2c_bno08x_ints_s ints_s = {
 static uv_async_t irq_async;
 static atomic_int pending = 0;
 static pthread_t irq_thread;
+static uv_poll_t irq_poll;
+static irq_mode_t irq_mode = IRQ_MODE_NONE;
 static irq_main_cb_t on_main_cb = NULL;
 static void *on_main_context = NULL;
 
@@ -233,7 +235,8 @@ int setup_interrupts(const char *chipname, unsigned int line_num) {
 }
 
 // Consume queued edge events only when the kernel reports readiness.
-// Never block here; this runs from the worker thread after poll() says POLLIN.
+// Never block here; this runs after poll() or uv_poll says the fd is
+// readable.
 static void drain_edge_events(void) {
     // Loop while there are events ready (non-blocking)
     for (;;) {
@@ -310,11 +313,8 @@ static void *irq_wait_thread(void *arg) {
     return NULL;
 }
 
-// Runs on Node's main thread
-static void irq_async_cb(uv_async_t *h) {
-    (void)h;
-    if (atomic_exchange(&pending, 0) == 0) return;
-
+// Service the hub once per queued edge timestamp. Runs on Node's main thread.
+static void dispatch_bursts(void) {
     uint32_t ts;
     while (tsq_pop(&ts)) {
         atomic_store(&current_burst_us, ts);
@@ -330,9 +330,31 @@ static void irq_async_cb(uv_async_t *h) {
     }
 }
 
-int start_irq_worker(uv_loop_t *loop, irq_main_cb_t on_main, void *context) {
+// Runs on Node's main thread
+static void irq_async_cb(uv_async_t *h) {
+    (void)h;
+    if (atomic_exchange(&pending, 0) == 0) return;
+    dispatch_bursts();
+}
+
+// IRQ_MODE_UV_POLL: the loop reports the GPIO fd readable. Read the edges
+// and drain the hub right here, without a thread hop.
+static void irq_poll_cb(uv_poll_t *h, int status, int events) {
+    if (status < 0) {
+        fprintf(stderr, "irq: uv_poll error: %s\n", uv_strerror(status));
+        uv_poll_stop(h);
+        return;
+    }
+    if (events & UV_READABLE) {
+        drain_edge_events();
+        dispatch_bursts();
+    }
+}
+
+int start_irq_worker(uv_loop_t *loop, irq_mode_t mode, irq_main_cb_t on_main,
+                     void *context) {
     if (!ints_s.req || ints_s.fd < 0 || ints_s.stop_efd < 0 || !loop ||
-        !on_main) {
+        !on_main || irq_mode != IRQ_MODE_NONE) {
         fprintf(stderr, "start_irq_worker: invalid state/args\n");
         return -1;
     }
@@ -344,28 +366,59 @@ int start_irq_worker(uv_loop_t *loop, irq_main_cb_t on_main, void *context) {
         fprintf(stderr, "uv_async_init failed\n");
         return -1;
     }
-    if (pthread_create(&irq_thread, NULL, irq_wait_thread, NULL) != 0) {
-        fprintf(stderr, "pthread_create failed\n");
-        uv_close((uv_handle_t *)&irq_async, NULL);
-        return -1;
+
+    if (mode == IRQ_MODE_UV_POLL) {
+        if (uv_poll_init(loop, &irq_poll, ints_s.fd) != 0) {
+            fprintf(stderr, "uv_poll_init failed\n");
+            uv_close((uv_handle_t *)&irq_async, NULL);
+            return -1;
+        }
+        if (uv_poll_start(&irq_poll, UV_READABLE, irq_poll_cb) != 0) {
+            fprintf(stderr, "uv_poll_start failed\n");
+            uv_close((uv_handle_t *)&irq_poll, NULL);
+            uv_close((uv_handle_t *)&irq_async, NULL);
+            return -1;
+        }
+        // No edge will come if the line is already asserted. Kick a drain
+        // through the async handle so it runs after this call returns.
+        if (irq_line_active()) {
+            tsq_push(monotonic_now_us32());
+            atomic_store(&pending, 1);
+            uv_async_send(&irq_async);
+        }
+    } else {
+        if (pthread_create(&irq_thread, NULL, irq_wait_thread, NULL) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            uv_close((uv_handle_t *)&irq_async, NULL);
+            return -1;
+        }
     }
 
+    irq_mode = mode;
     return 0;
 }
 
+bool irq_worker_running(void) { return irq_mode != IRQ_MODE_NONE; }
+
 void stop_irq_worker(void) {
-    if (irq_thread == 0) return;
-    // Wake the blocking poll by writing to eventfd
-    if (ints_s.stop_efd >= 0) {
-        uint64_t one = 1;
-        (void)write(ints_s.stop_efd, &one, sizeof(one));
-    }
-    int code = pthread_join(irq_thread, NULL);
-    if (code) {
-        fprintf(stderr, "stop_irq_worker: pthread_join failed: %s\n",
-                strerror(code));
+    if (irq_mode == IRQ_MODE_NONE) return;
+    if (irq_mode == IRQ_MODE_WORKER) {
+        // Wake the blocking poll by writing to eventfd
+        if (ints_s.stop_efd >= 0) {
+            uint64_t one = 1;
+            (void)write(ints_s.stop_efd, &one, sizeof(one));
+        }
+        int code = pthread_join(irq_thread, NULL);
+        if (code) {
+            fprintf(stderr, "stop_irq_worker: pthread_join failed: %s\n",
+                    strerror(code));
+        }
+    } else {
+        uv_poll_stop(&irq_poll);
+        uv_close((uv_handle_t *)&irq_poll, NULL);
     }
     uv_close((uv_handle_t *)&irq_async, NULL);
+    irq_mode = IRQ_MODE_NONE;
 }
 
 void teardown_interrupts(void) {
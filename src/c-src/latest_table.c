@@ -0,0 +1,60 @@
+#include "latest_table.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "decoded_values.h"
+#include "sh2/sh2.h"
+
+typedef struct {
+    // Even: stable. Odd: a write is in progress. 0: never written.
+    atomic_uint seq;
+    latest_value_t value;
+} latest_slot_t;
+
+static latest_slot_t slots[SH2_MAX_SENSOR_ID + 1];
+
+void latest_table_store(const sh2_SensorValue_t *sv, int64_t delay_us) {
+    if (sv->sensorId > SH2_MAX_SENSOR_ID) return;
+    latest_slot_t *slot = &slots[sv->sensorId];
+
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    latest_value_t *v = &slot->value;
+    v->sensorId = sv->sensorId;
+    v->sequence = sv->sequence;
+    v->accuracy = sv->status & 0x03;
+    v->timestamp_us = sv->timestamp;
+    v->delay_us = delay_us;
+    v->count = decode_sensor_values(sv, v->values);
+
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+bool latest_table_load(uint8_t sensor_id, latest_value_t *out) {
+    if (sensor_id > SH2_MAX_SENSOR_ID) return false;
+    latest_slot_t *slot = &slots[sensor_id];
+
+    for (;;) {
+        unsigned before =
+            atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (before == 0) return false;
+        if (before & 1) continue; // Writer is mid-update
+
+        memcpy(out, &slot->value, sizeof(*out));
+
+        atomic_thread_fence(memory_order_acquire);
+        unsigned after = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+        if (before == after) return true;
+    }
+}
+
+void latest_table_reset(void) {
+    for (int i = 0; i <= SH2_MAX_SENSOR_ID; i++) {
+        atomic_store_explicit(&slots[i].seq, 0, memory_order_release);
+    }
+}
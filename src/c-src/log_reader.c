@@ -0,0 +1,222 @@
+#define _GNU_SOURCE
+#include "log_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "decoded_values.h"
+#include "recorder.h"
+#include "sh2/sh2_SensorValue.h"
+#include "sh2/sh2_err.h"
+
+typedef struct {
+    char magic[8];       // LOG_INDEX_MAGIC
+    uint32_t version;    // LOG_INDEX_VERSION
+    uint32_t stride;     // LOG_INDEX_STRIDE
+    uint64_t records;    // Records of the log indexed
+    uint32_t log_crc;    // crc of the log header the index was built for
+    uint32_t reserved;
+} log_index_header_t;
+
+// The header slot with a valid crc and the highest generation.
+static bool read_header(const uint8_t *map, recorder_header_t *out) {
+    bool found = false;
+    for (int n = 0; n < 2; n++) {
+        recorder_header_t slot;
+        memcpy(&slot, map + n * RECORDER_HEADER_SLOT_SIZE, sizeof(slot));
+        if (memcmp(slot.magic, RECORDER_MAGIC, sizeof(slot.magic)) != 0 ||
+            slot.version != RECORDER_VERSION ||
+            recorder_crc32(&slot, offsetof(recorder_header_t, crc)) !=
+                slot.crc) {
+            continue;
+        }
+        if (!found || slot.generation > out->generation) { *out = slot; }
+        found = true;
+    }
+    return found;
+}
+
+static void index_path(const char *path, char *out, size_t size) {
+    snprintf(out, size, "%s.idx", path);
+}
+
+static bool load_index(log_reader_t *log, const char *path) {
+    char idx_path[PATH_MAX];
+    index_path(path, idx_path, sizeof(idx_path));
+    FILE *f = fopen(idx_path, "rb");
+    if (f == NULL) { return false; }
+
+    log_index_header_t h;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 &&
+              memcmp(h.magic, LOG_INDEX_MAGIC, sizeof(h.magic)) == 0 &&
+              h.version == LOG_INDEX_VERSION &&
+              h.stride == LOG_INDEX_STRIDE && h.records == log->count &&
+              h.log_crc == log->header.crc &&
+              fread(log->index, sizeof(uint64_t), log->index_len, f) ==
+                  log->index_len;
+    fclose(f);
+    return ok;
+}
+
+// Write to a temporary file and rename, so a reader never sees half an
+// index. Failing is fine, e.g. in a read-only directory; it's rebuilt.
+static void save_index(const log_reader_t *log, const char *path) {
+    char idx_path[PATH_MAX], tmp_path[PATH_MAX];
+    index_path(path, idx_path, sizeof(idx_path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", idx_path);
+    FILE *f = fopen(tmp_path, "wb");
+    if (f == NULL) { return; }
+
+    log_index_header_t h = {
+        .version = LOG_INDEX_VERSION,
+        .stride = LOG_INDEX_STRIDE,
+        .records = log->count,
+        .log_crc = log->header.crc,
+    };
+    memcpy(h.magic, LOG_INDEX_MAGIC, sizeof(h.magic));
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(log->index, sizeof(uint64_t), log->index_len, f) ==
+                  log->index_len;
+    ok &= fclose(f) == 0;
+    if (!ok || rename(tmp_path, idx_path) != 0) { unlink(tmp_path); }
+}
+
+static void build_index(log_reader_t *log) {
+    uint64_t latest = 0;
+    for (uint64_t n = 0; n < log->count; n++) {
+        uint64_t ts = log->records[n].timestamp_us;
+        if (ts > latest) { latest = ts; }
+        if (n % LOG_INDEX_STRIDE == LOG_INDEX_STRIDE - 1 ||
+            n == log->count - 1) {
+            log->index[n / LOG_INDEX_STRIDE] = latest;
+        }
+    }
+}
+
+int log_open(const char *path, log_reader_t *log) {
+    memset(log, 0, sizeof(*log));
+    log->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (log->fd < 0) { return errno; }
+
+    int error = 0;
+    struct stat st;
+    if (fstat(log->fd, &st) != 0) {
+        error = errno;
+    } else if ((uint64_t)st.st_size < RECORDER_HEADER_SIZE) {
+        error = EPROTO;
+    }
+    if (error == 0) {
+        log->map_size = st.st_size;
+        log->map = mmap(NULL, log->map_size, PROT_READ, MAP_SHARED, log->fd, 0);
+        if (log->map == MAP_FAILED) {
+            log->map = NULL;
+            error = errno;
+        }
+    }
+    // Records past the end of the file, e.g. of a log that is still being
+    // written to a full disk, aren't counted.
+    if (error == 0 && (!read_header(log->map, &log->header) ||
+                       log->header.record_size != RECORDER_RECORD_SIZE ||
+                       log->header.header_size != RECORDER_HEADER_SIZE)) {
+        error = EPROTO;
+    }
+    if (error != 0) {
+        log_close(log);
+        return error;
+    }
+    uint64_t fits = (log->map_size - RECORDER_HEADER_SIZE) /
+                    RECORDER_RECORD_SIZE;
+    log->count = log->header.committed < fits ? log->header.committed : fits;
+    log->records =
+        (const recorder_record_t *)(log->map + RECORDER_HEADER_SIZE);
+
+    log->index_len = (log->count + LOG_INDEX_STRIDE - 1) / LOG_INDEX_STRIDE;
+    log->index = malloc((log->index_len ? log->index_len : 1) *
+                        sizeof(uint64_t));
+    if (log->index == NULL) {
+        log_close(log);
+        return ENOMEM;
+    }
+    log->index_loaded = load_index(log, path);
+    if (!log->index_loaded) {
+        madvise((void *)log->map, log->map_size, MADV_SEQUENTIAL);
+        build_index(log);
+        save_index(log, path);
+    }
+    madvise((void *)log->map, log->map_size, MADV_NORMAL);
+    return 0;
+}
+
+void log_close(log_reader_t *log) {
+    if (log->map != NULL) { munmap((void *)log->map, log->map_size); }
+    if (log->fd >= 0) { close(log->fd); }
+    free(log->index);
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+}
+
+uint64_t log_seek(const log_reader_t *log, uint64_t timestamp_us) {
+    // First block whose running maximum reaches the timestamp
+    uint64_t lo = 0, hi = log->index_len;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (log->index[mid] < timestamp_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (uint64_t n = lo * LOG_INDEX_STRIDE; n < log->count; n++) {
+        if (log->records[n].timestamp_us >= timestamp_us) { return n; }
+    }
+    return log->count;
+}
+
+uint8_t log_record_values(const log_reader_t *log,
+                          const recorder_record_t *record,
+                          float out[DECODED_VALUES_MAX]) {
+    if (log->header.format == RECORDER_DECODED) {
+        uint8_t count = record->len < DECODED_VALUES_MAX ? record->len
+                                                         : DECODED_VALUES_MAX;
+        memcpy(out, record->payload.values, count * sizeof(float));
+        return count;
+    }
+    return log_report_values(record, out);
+}
+
+uint8_t log_report_values(const recorder_record_t *record,
+                          float out[DECODED_VALUES_MAX]) {
+    sh2_SensorEventView_t view;
+    sh2_SensorValue_t sv;
+    if (!log_record_view(record, &view) ||
+        sh2_decodeSensorEventView(&sv, &view) != SH2_OK) {
+        return 0;
+    }
+    return decode_sensor_values(&sv, out);
+}
+
+bool log_record_view(const recorder_record_t *record,
+                     sh2_SensorEventView_t *view) {
+    // The header's CRC doesn't cover the records, so don't trust the length
+    // to bound the report
+    if (record->len == 0 || record->len > SH2_MAX_SENSOR_EVENT_LEN ||
+        record->len != sh2_getReportLen(record->sensor_id)) {
+        return false;
+    }
+    view->timestamp_uS = record->timestamp_us;
+    view->delay_uS = record->delay_us;
+    view->len = record->len;
+    view->reportId = record->sensor_id;
+    view->report = record->payload.report;
+    return true;
+}
@@ -7,7 +7,11 @@
 #include <string.h>
 #include <endian.h>
 
+#include "decoded_values.h"
 #include "error.h"
+#include "event_timestamp.h"
+#include "node_c_type_conversions.h"
+#include "report_slab.h"
 #include "sensor_report_auxialiry_fns.h"
 #include "sh2/sh2.h"
 #include "sh2/sh2_SensorValue.h"
@@ -16,7 +20,51 @@ void free_event(napi_env env, void* finalize_data, void* finalize_hint) {
     (void)finalize_hint; // unused
     if (finalize_data != NULL) { free(finalize_data); }
 }
+// Set the timestamp of a SensorEvent in the format chosen with
+// set_timestamp_format(..).
+static napi_status set_event_timestamp(napi_env env, napi_value obj,
+                                       uint64_t timestamp_us) {
+    napi_status status;
+    napi_value value;
+    switch (get_timestamp_format()) {
+        case TIMESTAMP_FLOAT64:
+            status = napi_create_double(
+                env, timestamp_relative_us(timestamp_us), &value);
+            status |= napi_set_named_property(env, obj,
+                                              "timestampMicroseconds", value);
+            return status;
+        case TIMESTAMP_HILO:
+            status = napi_create_uint32(env, (uint32_t)(timestamp_us >> 32),
+                                        &value);
+            status |= napi_set_named_property(
+                env, obj, "timestampMicrosecondsHi", value);
+            status |= napi_create_uint32(env, (uint32_t)timestamp_us, &value);
+            status |= napi_set_named_property(
+                env, obj, "timestampMicrosecondsLo", value);
+            return status;
+        case TIMESTAMP_BIGINT:
+        default:
+            status = napi_create_bigint_uint64(env, timestamp_us, &value);
+            status |= napi_set_named_property(env, obj,
+                                              "timestampMicroseconds", value);
+            return status;
+    }
+}
+
 napi_value node_from_c_SensorEvent(napi_env env, sh2_SensorEvent_t* ev) {
+    sh2_SensorEventView_t view = {.timestamp_uS = ev->timestamp_uS,
+                                  .delay_uS = ev->delay_uS,
+                                  .len = ev->len,
+                                  .reportId = ev->reportId,
+                                  .report = ev->report};
+    sh2_SensorValue_t sv;
+    sh2_decodeSensorEventView(&sv, &view);
+    return node_from_c_SensorEventView(env, &view, &sv);
+}
+
+napi_value node_from_c_SensorEventView(napi_env env,
+                                       const sh2_SensorEventView_t* ev,
+                                       const sh2_SensorValue_t* sv) {
     napi_status status;
     napi_value ret_val;
     status = napi_create_object(env, &ret_val);
@@ -25,9 +73,7 @@ napi_value node_from_c_SensorEvent(napi_env env, sh2_SensorEvent_t* ev) {
                          "Couldn't create SensorEvent object.");
         return NULL;
     }
-    sh2_SensorValue_t sv;
-    sh2_decodeSensorEvent(&sv, ev);
-    uint32_t calibration_status = sv.status & 0x03;
+    uint32_t calibration_status = sv->status & 0x03;
     napi_value calibrationStatus;
     status = napi_create_uint32(env, calibration_status, &calibrationStatus);
     if (status != napi_ok) {
@@ -43,25 +89,10 @@ napi_value node_from_c_SensorEvent(napi_env env, sh2_SensorEvent_t* ev) {
         return NULL;
     }
 
-    uint8_t* buf = malloc(ev->len);
-    if (buf == NULL) {
-        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
-                         "Failed to allocate memory for event");
-        return NULL;
-    }
-    memcpy((void*)buf, (const void*)&ev->report, ev->len);
-
-    napi_value timestamp_uS; // uint64_t -> number
-    napi_value delay_uS;     // int64_t -> number
-    napi_value len;          // uint8_t -> number
-    napi_value reportId;     // uint8_t -> number
-    napi_value report;       // uint8_t -> ArrayBuffer
-    status = napi_create_bigint_uint64(env, ev->timestamp_uS, &timestamp_uS);
-    if (status != napi_ok) {
-        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
-                         "Couldn't creating napi bigint in c_to_SensorEvent.");
-        return NULL;
-    }
+    napi_value delay_uS; // int64_t -> number
+    napi_value len;      // uint8_t -> number
+    napi_value reportId; // uint8_t -> number
+    napi_value report;   // uint8_t -> Buffer or Uint8Array
     status = napi_create_int64(env, ev->delay_uS, &delay_uS);
     if (status != napi_ok) {
         napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
@@ -80,21 +111,35 @@ napi_value node_from_c_SensorEvent(napi_env env, sh2_SensorEvent_t* ev) {
                          "Couldn't create napi uint32 in c_to_SensorEvent.");
         return NULL;
     }
-    status = napi_create_external_buffer(env, ev->len, buf, free_event, NULL,
-                                         &report);
-    if (status != napi_ok) {
-        napi_throw_error(
-            env, ERROR_TRANSLATING_STRUCT_TO_NODE,
-            "Failed to create SensorEvent object in c_to_SensorEvent.");
-        return NULL;
+    if (get_report_storage() == REPORT_STORAGE_SLAB) {
+        report = report_slab_copy(env, ev->report, ev->len);
+        if (report == NULL) {
+            // report_slab_copy(..) already threw
+            return NULL;
+        }
+    } else {
+        uint8_t* buf = malloc(ev->len);
+        if (buf == NULL) {
+            napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                             "Failed to allocate memory for event");
+            return NULL;
+        }
+        memcpy((void*)buf, (const void*)ev->report, ev->len);
+        status = napi_create_external_buffer(env, ev->len, buf, free_event,
+                                             NULL, &report);
+        if (status != napi_ok) {
+            free(buf);
+            napi_throw_error(
+                env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                "Failed to create SensorEvent object in c_to_SensorEvent.");
+            return NULL;
+        }
     }
 
-    status = napi_set_named_property(env, ret_val, "timestampMicroseconds",
-                                     timestamp_uS);
+    status = set_event_timestamp(env, ret_val, ev->timestamp_uS);
     if (status != napi_ok) {
-        napi_throw_error(
-            env, ERROR_TRANSLATING_STRUCT_TO_NODE,
-            "Couldn't set property timestampMicroseconds for SensorEvent.");
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't set the timestamp of SensorEvent.");
         return NULL;
     }
     status =
@@ -255,6 +300,343 @@ napi_value node_from_c_SensorConfigResp(napi_env env,
     return result;
 }
 
+napi_value node_from_c_ServiceStats(napi_env env, service_stats_t* stats) {
+    napi_status status;
+    napi_value obj;
+    status = napi_create_object(env, &obj);
+
+    napi_value transfers;
+    napi_value serviceCalls;
+    napi_value idle;
+    napi_value elapsedMicros;
+
+    status |= napi_create_uint32(env, stats->transfers, &transfers);
+    status |= napi_create_uint32(env, stats->serviceCalls, &serviceCalls);
+    status |= napi_get_boolean(env, stats->idle, &idle);
+    status |= napi_create_uint32(env, stats->elapsed_us, &elapsedMicros);
+
+    status |= napi_set_named_property(env, obj, "transfers", transfers);
+    status |= napi_set_named_property(env, obj, "serviceCalls", serviceCalls);
+    status |= napi_set_named_property(env, obj, "idle", idle);
+    status |= napi_set_named_property(env, obj, "elapsedMicros", elapsedMicros);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct a ServiceResult.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+napi_value node_from_c_LatestValue(napi_env env, latest_value_t* latest) {
+    napi_status status;
+    napi_value obj;
+    status = napi_create_object(env, &obj);
+
+    napi_value sensorId;
+    napi_value sequence;
+    napi_value calibrationStatus;
+    napi_value timestampMicroseconds;
+    napi_value delayMicroseconds;
+
+    status |= napi_create_uint32(env, latest->sensorId, &sensorId);
+    status |= napi_create_uint32(env, latest->sequence, &sequence);
+    status |= napi_create_uint32(env, latest->accuracy, &calibrationStatus);
+    status |= napi_create_bigint_uint64(env, latest->timestamp_us,
+                                        &timestampMicroseconds);
+    status |= napi_create_int64(env, latest->delay_us, &delayMicroseconds);
+
+    status |= napi_set_named_property(env, obj, "sensorId", sensorId);
+    status |= napi_set_named_property(env, obj, "sequence", sequence);
+    status |= napi_set_named_property(env, obj, "calibrationStatus",
+                                      calibrationStatus);
+    status |= napi_set_named_property(env, obj, "timestampMicroseconds",
+                                      timestampMicroseconds);
+    status |= napi_set_named_property(env, obj, "delayMicroseconds",
+                                      delayMicroseconds);
+
+    // Decoded values go on the object by name, like on SensorEvent.
+    uint8_t count = 0;
+    const char* const* names = decoded_value_names(latest->sensorId, &count);
+    if (latest->count < count) { count = latest->count; }
+    for (uint8_t i = 0; i < count; i++) {
+        napi_value value;
+        status |= napi_create_double(env, latest->values[i], &value);
+        status |= napi_set_named_property(env, obj, names[i], value);
+    }
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct a LatestValue.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+napi_value node_from_c_SubscriberStats(napi_env env, fanout_stats_t* stats) {
+    napi_status status;
+    napi_value obj;
+    status = napi_create_object(env, &obj);
+
+    napi_value pending;
+    napi_value delivered;
+    napi_value dropped;
+    napi_value paused;
+
+    status |= napi_create_uint32(env, stats->pending, &pending);
+    status |= napi_create_int64(env, (int64_t)stats->delivered, &delivered);
+    status |= napi_create_int64(env, (int64_t)stats->dropped, &dropped);
+    status |= napi_get_boolean(env, stats->paused, &paused);
+
+    status |= napi_set_named_property(env, obj, "pending", pending);
+    status |= napi_set_named_property(env, obj, "delivered", delivered);
+    status |= napi_set_named_property(env, obj, "dropped", dropped);
+    status |= napi_set_named_property(env, obj, "paused", paused);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct a SubscriberStats.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+static napi_status set_uint32_prop(napi_env env, napi_value obj,
+                                   const char* name, uint32_t value) {
+    napi_value v;
+    napi_status status = napi_create_uint32(env, value, &v);
+    if (status != napi_ok) { return status; }
+    return napi_set_named_property(env, obj, name, v);
+}
+
+static napi_status set_int64_prop(napi_env env, napi_value obj,
+                                  const char* name, uint64_t value) {
+    napi_value v;
+    napi_status status = napi_create_int64(env, (int64_t)value, &v);
+    if (status != napi_ok) { return status; }
+    return napi_set_named_property(env, obj, name, v);
+}
+
+napi_value node_from_c_Metrics(napi_env env, metrics_t* metrics) {
+    napi_status status;
+    napi_value obj;
+    napi_value transport;
+    napi_value driver;
+    napi_value bus;
+    napi_value host;
+    status = napi_create_object(env, &obj);
+    status |= napi_create_object(env, &transport);
+    status |= napi_create_object(env, &driver);
+    status |= napi_create_object(env, &bus);
+    status |= napi_create_object(env, &host);
+
+    sh2_DriverStats_t* d = &metrics->driver;
+    status |= set_uint32_prop(env, transport, "rxBadChannel", d->rxBadChan);
+    status |= set_uint32_prop(env, transport, "rxShortFragments",
+                              d->rxShortFragments);
+    status |= set_uint32_prop(env, transport, "rxTooLargePayloads",
+                              d->rxTooLargePayloads);
+    status |= set_uint32_prop(env, transport, "rxInterruptedPayloads",
+                              d->rxInterruptedPayloads);
+    status |= set_uint32_prop(env, transport, "txBadChannel", d->badTxChan);
+    status |= set_uint32_prop(env, transport, "txDiscards", d->txDiscards);
+    status |= set_uint32_prop(env, transport, "txTooLargePayloads",
+                              d->txTooLargePayloads);
+
+    status |= set_uint32_prop(env, driver, "unknownReportIds",
+                              d->unknownReportIds);
+    status |= set_uint32_prop(env, driver, "emptyPayloads", d->emptyPayloads);
+    status |= set_uint32_prop(env, driver, "execBadPayloads",
+                              d->execBadPayload);
+
+    hal_stats_t* b = &metrics->bus;
+    status |= set_uint32_prop(env, bus, "transfers", b->transfers);
+    status |= set_uint32_prop(env, bus, "idleReads", b->idle_reads);
+    status |= set_uint32_prop(env, bus, "readErrors", b->read_errors);
+    status |= set_int64_prop(env, bus, "readBytes", b->read_bytes);
+    status |= set_uint32_prop(env, bus, "writes", b->writes);
+    status |= set_uint32_prop(env, bus, "writeErrors", b->write_errors);
+    status |= set_int64_prop(env, bus, "writeBytes", b->write_bytes);
+
+    status |= set_int64_prop(env, host, "pollOverruns", metrics->poll_overruns);
+
+    status |= napi_set_named_property(env, obj, "transport", transport);
+    status |= napi_set_named_property(env, obj, "driver", driver);
+    status |= napi_set_named_property(env, obj, "bus", bus);
+    status |= napi_set_named_property(env, obj, "host", host);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct Metrics.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+napi_value node_from_c_SensorCounts(napi_env env, sh2_SensorId_t sensor_id,
+                                    sh2_Counts_t* counts) {
+    napi_status status;
+    napi_value obj;
+    status = napi_create_object(env, &obj);
+
+    status |= set_uint32_prop(env, obj, "sensorId", sensor_id);
+    status |= set_uint32_prop(env, obj, "offered", counts->offered);
+    status |= set_uint32_prop(env, obj, "accepted", counts->accepted);
+    status |= set_uint32_prop(env, obj, "on", counts->on);
+    status |= set_uint32_prop(env, obj, "attempted", counts->attempted);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct SensorCounts.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+napi_value node_from_c_ErrorRecord(napi_env env, sh2_ErrorRecord_t* err) {
+    napi_status status;
+    napi_value obj;
+    status = napi_create_object(env, &obj);
+
+    status |= set_uint32_prop(env, obj, "severity", err->severity);
+    status |= set_uint32_prop(env, obj, "sequence", err->sequence);
+    status |= set_uint32_prop(env, obj, "source", err->source);
+    status |= set_uint32_prop(env, obj, "error", err->error);
+    status |= set_uint32_prop(env, obj, "module", err->module);
+    status |= set_uint32_prop(env, obj, "code", err->code);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct ErrorRecord.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+napi_value node_from_c_ClockSyncStatus(napi_env env,
+                                       clock_sync_status_t* sync) {
+    napi_status status;
+    napi_value obj;
+    status = napi_create_object(env, &obj);
+
+    napi_value locked;
+    napi_value periodMicros;
+    napi_value jitterMicros;
+    napi_value driftPpm;
+
+    status |= napi_get_boolean(env, sync->locked, &locked);
+    status |= napi_create_double(env, sync->period_us, &periodMicros);
+    status |= napi_create_double(env, sync->jitter_us, &jitterMicros);
+    status |= napi_create_double(env, sync->drift_ppm, &driftPpm);
+
+    status |= napi_set_named_property(env, obj, "locked", locked);
+    status |= set_uint32_prop(env, obj, "samples", sync->samples);
+    status |= napi_set_named_property(env, obj, "periodMicros", periodMicros);
+    status |= napi_set_named_property(env, obj, "jitterMicros", jitterMicros);
+    status |= napi_set_named_property(env, obj, "driftPpm", driftPpm);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct a ClockSyncStatus.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+napi_value node_from_c_RecordingStats(napi_env env, recorder_stats_t* stats) {
+    napi_status status;
+    napi_value obj;
+    status = napi_create_object(env, &obj);
+
+    status |= set_int64_prop(env, obj, "records", stats->records);
+    status |= set_int64_prop(env, obj, "committed", stats->committed);
+    status |= set_int64_prop(env, obj, "dropped", stats->dropped);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct a RecordingStats.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+napi_value node_from_c_LogInfo(napi_env env, log_reader_t* log) {
+    napi_status status;
+    napi_value obj;
+    status = napi_create_object(env, &obj);
+
+    napi_value format;
+    napi_value sensors;
+    napi_value closed;
+    napi_value indexLoaded;
+
+    const recorder_header_t* h = &log->header;
+    status |= napi_create_string_utf8(
+        env, h->format == RECORDER_DECODED ? "decoded" : "raw",
+        NAPI_AUTO_LENGTH, &format);
+    status |= napi_create_array(env, &sensors);
+    uint32_t n = 0;
+    for (uint32_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        if (!(h->sensor_mask & (1ULL << id))) { continue; }
+        napi_value sensor;
+        status |= napi_create_uint32(env, id, &sensor);
+        status |= napi_set_element(env, sensors, n++, sensor);
+    }
+    status |= napi_get_boolean(env, h->flags & RECORDER_FLAG_CLOSED, &closed);
+    status |= napi_get_boolean(env, log->index_loaded, &indexLoaded);
+
+    uint64_t start = log->count ? log->records[0].timestamp_us : 0;
+    uint64_t end = log->count ? log->index[log->index_len - 1] : 0;
+
+    status |= napi_set_named_property(env, obj, "format", format);
+    status |= set_int64_prop(env, obj, "records", log->count);
+    status |= set_int64_prop(env, obj, "startMicros", start);
+    status |= set_int64_prop(env, obj, "endMicros", end);
+    status |= set_int64_prop(env, obj, "startMonotonicMicros",
+                             h->start_monotonic_us);
+    status |= set_int64_prop(env, obj, "startRealtimeMicros",
+                             h->start_realtime_us);
+    status |= napi_set_named_property(env, obj, "sensors", sensors);
+    status |= napi_set_named_property(env, obj, "closed", closed);
+    status |= napi_set_named_property(env, obj, "indexLoaded", indexLoaded);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct a LogInfo.");
+        return NULL;
+    }
+
+    return obj;
+}
+
+napi_value node_from_c_ArrowExport(napi_env env, uint8_t sensor_id,
+                                   const char *path, uint64_t rows) {
+    napi_status status;
+    napi_value obj, value;
+    status = napi_create_object(env, &obj);
+
+    status |= set_uint32_prop(env, obj, "sensorId", sensor_id);
+    status |= napi_create_string_utf8(env, path, NAPI_AUTO_LENGTH, &value);
+    status |= napi_set_named_property(env, obj, "path", value);
+    status |= set_int64_prop(env, obj, "rows", rows);
+
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                         "Couldn't construct an ArrowExport.");
+        return NULL;
+    }
+
+    return obj;
+}
+
 napi_value node_from_c_AsyncEvent(napi_env env, sh2_AsyncEvent_t* evt) {
     napi_value obj;
     napi_status status;
@@ -296,7 +678,8 @@ napi_value node_from_c_AsyncEvent(napi_env env, sh2_AsyncEvent_t* evt) {
             return NULL;
         }
 
-    } else { // It's SH2_RESET, neither of shtpEvent or sensorConfig is set
+    } else { // SH2_RESET or SH2_FLUSH_COMPLETED, neither of shtpEvent or
+             // sensorConfig is set
         status = napi_get_null(env, &shtpEvent);
         status |= napi_get_null(env, &sh2SensorConfigResp);
         if (status != napi_ok) {
@@ -333,6 +716,16 @@ napi_value node_from_c_AsyncEvent(napi_env env, sh2_AsyncEvent_t* evt) {
             "Couldn't set property sh2SensorConfigResp for AsyncEvent");
         return NULL;
     }
+    if (evt->eventId == SH2_FLUSH_COMPLETED) {
+        napi_value sensorId;
+        status = napi_create_uint32(env, evt->flushCompleted, &sensorId);
+        status |= napi_set_named_property(env, obj, "sensorId", sensorId);
+        if (status != napi_ok) {
+            napi_throw_error(env, ERROR_TRANSLATING_STRUCT_TO_NODE,
+                             "Couldn't set property sensorId for AsyncEvent");
+            return NULL;
+        }
+    }
     return obj;
 }
 
@@ -490,3 +883,50 @@ int8_t node_to_c_SensorConfig(napi_env env, napi_value value,
     }
     return EXIT_SUCCESS;
 }
+
+int8_t node_to_c_optional_uint32(napi_env env, napi_value obj,
+                                 const char* name, uint32_t* result) {
+    bool has_prop;
+    napi_status status = napi_has_named_property(env, obj, name, &has_prop);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    if (!has_prop) { return EXIT_SUCCESS; }
+
+    napi_value value;
+    status = napi_get_named_property(env, obj, name, &value);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    status = napi_get_value_uint32(env, value, result);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    return EXIT_SUCCESS;
+}
+
+int8_t node_to_c_optional_bool(napi_env env, napi_value obj, const char* name,
+                               bool* result) {
+    bool has_prop;
+    napi_status status = napi_has_named_property(env, obj, name, &has_prop);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    if (!has_prop) { return EXIT_SUCCESS; }
+
+    napi_value value;
+    status = napi_get_named_property(env, obj, name, &value);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    status = napi_get_value_bool(env, value, result);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    return EXIT_SUCCESS;
+}
+
+int8_t node_to_c_optional_string(napi_env env, napi_value obj,
+                                 const char* name, char* buf, size_t len) {
+    bool has_prop;
+    napi_status status = napi_has_named_property(env, obj, name, &has_prop);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    if (!has_prop) { return EXIT_SUCCESS; }
+
+    napi_value value;
+    status = napi_get_named_property(env, obj, name, &value);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    size_t copied;
+    status = napi_get_value_string_utf8(env, value, buf, len, &copied);
+    if (status != napi_ok) { return EXIT_FAILURE; }
+    if (copied + 1 >= len) { return EXIT_FAILURE; } // Truncated
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,301 @@
+#define _GNU_SOURCE
+#include "poll_timer.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <uv.h>
+
+static uint64_t monotonic_now_ns(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) { return 0; }
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+typedef enum {
+    PHASE_OFF,     // Free-running ticks
+    PHASE_ACQUIRE, // Polling a bit faster than the period to find the phase
+    PHASE_LOCKED,  // Ticks follow report arrival
+} poll_phase_t;
+
+static struct {
+    int timer_fd;
+    int stop_efd; // eventfd to wake epoll_wait on shutdown
+    int epoll_fd;
+    pthread_t thread;
+    bool running;
+    uint64_t period_ns;
+    uint64_t offset_ns;
+    poll_phase_t phase;
+} pt = {
+    .timer_fd = -1,
+    .stop_efd = -1,
+    .epoll_fd = -1,
+    .running = false,
+    .period_ns = 0,
+    .offset_ns = 0,
+    .phase = PHASE_OFF,
+};
+
+// libuv dispatch to main thread
+static uv_async_t poll_async;
+static bool poll_async_closing = false;
+static atomic_int pending = 0;
+static atomic_uint_fast64_t overruns = 0;
+static poll_main_cb_t on_main_cb = NULL;
+static void *on_main_context = NULL;
+
+// Expiry time of the latest tick (set by worker) and the ticks being
+// handled on the main thread.
+static atomic_uint_fast64_t last_tick_ns = 0;
+static uint64_t tick_ns = 0;
+static uint64_t prev_tick_ns = 0;
+
+static void close_fds(void) {
+    if (pt.epoll_fd >= 0) {
+        close(pt.epoll_fd);
+        pt.epoll_fd = -1;
+    }
+    if (pt.stop_efd >= 0) {
+        close(pt.stop_efd);
+        pt.stop_efd = -1;
+    }
+    if (pt.timer_fd >= 0) {
+        close(pt.timer_fd);
+        pt.timer_fd = -1;
+    }
+}
+
+// While acquiring the phase, tick 1/8 faster than the period so that a tick
+// eventually falls just before a report arrives and comes back empty.
+static uint64_t tick_period(void) {
+    if (pt.phase == PHASE_ACQUIRE) { return pt.period_ns - pt.period_ns / 8; }
+    return pt.period_ns;
+}
+
+// Arm the timer to first expire at absolute time `first_ns` and every
+// `period_ns` after that.
+static int arm(uint64_t first_ns, uint64_t period_ns) {
+    struct itimerspec its = {
+        .it_interval = {.tv_sec = period_ns / 1000000000ULL,
+                        .tv_nsec = period_ns % 1000000000ULL},
+        .it_value = {.tv_sec = first_ns / 1000000000ULL,
+                     .tv_nsec = first_ns % 1000000000ULL},
+    };
+    if (timerfd_settime(pt.timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+        perror("timerfd_settime");
+        return -1;
+    }
+    tick_ns = 0;
+    prev_tick_ns = 0;
+    return 0;
+}
+
+static uint32_t clamp_period(uint32_t period_us) {
+    if (period_us < POLL_TIMER_MIN_PERIOD_US) {
+        return POLL_TIMER_MIN_PERIOD_US;
+    }
+    if (period_us > POLL_TIMER_MAX_PERIOD_US) {
+        return POLL_TIMER_MAX_PERIOD_US;
+    }
+    return period_us;
+}
+
+// Worker thread: block until the timer expires or stop is signalled
+static void *poll_wait_thread(void *arg) {
+    (void)arg;
+    struct epoll_event evs[2];
+
+    for (;;) {
+        int n = epoll_wait(pt.epoll_fd, evs, 2, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        bool stop = false;
+        for (int i = 0; i < n; i++) {
+            if (evs[i].data.fd == pt.stop_efd) {
+                uint64_t v;
+                (void)read(pt.stop_efd, &v, sizeof(v));
+                stop = true;
+            } else if (evs[i].data.fd == pt.timer_fd) {
+                uint64_t expirations = 0;
+                if (read(pt.timer_fd, &expirations, sizeof(expirations)) !=
+                    sizeof(expirations)) {
+                    // EAGAIN after a re-arm from the main thread; no tick.
+                    continue;
+                }
+                if (expirations > 1) {
+                    atomic_fetch_add(&overruns, expirations - 1);
+                }
+                atomic_store(&last_tick_ns, monotonic_now_ns());
+                if (atomic_exchange(&pending, 1) == 0) {
+                    uv_async_send(&poll_async);
+                } else {
+                    // Main thread is still busy with the previous tick.
+                    atomic_fetch_add(&overruns, 1);
+                }
+            }
+        }
+        if (stop) break;
+    }
+    return NULL;
+}
+
+// Runs on Node's main thread
+static void poll_async_cb(uv_async_t *h) {
+    (void)h;
+    if (atomic_exchange(&pending, 0) == 0) return;
+    prev_tick_ns = tick_ns;
+    tick_ns = atomic_load(&last_tick_ns);
+    if (on_main_cb) { on_main_cb(on_main_context); }
+}
+
+static void poll_async_close_cb(uv_handle_t *h) {
+    (void)h;
+    poll_async_closing = false;
+}
+
+int start_poll_timer(uv_loop_t *loop, poll_main_cb_t on_main, void *context,
+                     uint32_t period_us) {
+    if (pt.running || poll_async_closing || !loop || !on_main) {
+        fprintf(stderr, "start_poll_timer: invalid state/args\n");
+        return -1;
+    }
+
+    pt.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (pt.timer_fd < 0) {
+        perror("timerfd_create");
+        return -1;
+    }
+    pt.stop_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pt.stop_efd < 0) {
+        perror("eventfd");
+        close_fds();
+        return -1;
+    }
+    pt.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (pt.epoll_fd < 0) {
+        perror("epoll_create1");
+        close_fds();
+        return -1;
+    }
+    struct epoll_event ev = {.events = EPOLLIN};
+    ev.data.fd = pt.timer_fd;
+    if (epoll_ctl(pt.epoll_fd, EPOLL_CTL_ADD, pt.timer_fd, &ev) < 0) {
+        perror("epoll_ctl(timerfd)");
+        close_fds();
+        return -1;
+    }
+    ev.data.fd = pt.stop_efd;
+    if (epoll_ctl(pt.epoll_fd, EPOLL_CTL_ADD, pt.stop_efd, &ev) < 0) {
+        perror("epoll_ctl(eventfd)");
+        close_fds();
+        return -1;
+    }
+
+    pt.period_ns = (uint64_t)clamp_period(period_us) * 1000ULL;
+    if (arm(monotonic_now_ns() + pt.period_ns, tick_period()) < 0) {
+        close_fds();
+        return -1;
+    }
+
+    on_main_cb = on_main;
+    on_main_context = context;
+    atomic_store(&pending, 0);
+    atomic_store(&overruns, 0);
+
+    if (uv_async_init(loop, &poll_async, poll_async_cb) != 0) {
+        fprintf(stderr, "uv_async_init failed\n");
+        close_fds();
+        return -1;
+    }
+    if (pthread_create(&pt.thread, NULL, poll_wait_thread, NULL) != 0) {
+        fprintf(stderr, "pthread_create failed\n");
+        poll_async_closing = true;
+        uv_close((uv_handle_t *)&poll_async, poll_async_close_cb);
+        close_fds();
+        return -1;
+    }
+    pt.running = true;
+    return 0;
+}
+
+int set_poll_timer_period(uint32_t period_us) {
+    if (!pt.running) return -1;
+    uint64_t period_ns = (uint64_t)clamp_period(period_us) * 1000ULL;
+    if (period_ns == pt.period_ns) return 0;
+    pt.period_ns = period_ns;
+    if (pt.phase != PHASE_OFF) { pt.phase = PHASE_ACQUIRE; }
+    return arm(monotonic_now_ns() + period_ns, tick_period());
+}
+
+void set_poll_timer_phase(bool align, uint32_t offset_us) {
+    pt.offset_ns = (uint64_t)offset_us * 1000ULL;
+    pt.phase = align ? PHASE_ACQUIRE : PHASE_OFF;
+    if (pt.running) {
+        (void)arm(monotonic_now_ns() + pt.period_ns, tick_period());
+    }
+}
+
+// Move the schedule so ticks land offset_ns after `arrival_ns`.
+static void lock_on(uint64_t arrival_ns) {
+    uint64_t now_ns = monotonic_now_ns();
+    uint64_t next_ns = arrival_ns + pt.offset_ns;
+    if (next_ns <= now_ns) {
+        next_ns += ((now_ns - next_ns) / pt.period_ns + 1) * pt.period_ns;
+    }
+    pt.phase = PHASE_LOCKED;
+    (void)arm(next_ns, pt.period_ns);
+}
+
+void poll_timer_report(uint32_t reports) {
+    if (!pt.running || pt.phase == PHASE_OFF || tick_ns == 0) return;
+
+    if (reports == 0) {
+        // Nothing arrived since the previous tick, so the next report
+        // arrives after this one, within the step the acquiring schedule
+        // gains per tick. Lock onto the late end of that window so ticks
+        // don't come early. Once locked, the window is only the drift
+        // between the hub and host clocks.
+        uint64_t window_ns = pt.phase == PHASE_ACQUIRE ? pt.period_ns / 8 : 0;
+        lock_on(tick_ns + window_ns);
+    } else if (reports >= 2 && pt.phase == PHASE_LOCKED && prev_tick_ns) {
+        // The hub runs faster than the schedule; the older of the two
+        // reports arrived just after the previous tick.
+        lock_on(prev_tick_ns);
+    }
+}
+
+void stop_poll_timer(void) {
+    if (!pt.running) return;
+    // Wake the blocking epoll_wait by writing to eventfd
+    uint64_t one = 1;
+    (void)write(pt.stop_efd, &one, sizeof(one));
+    int code = pthread_join(pt.thread, NULL);
+    if (code) {
+        fprintf(stderr, "stop_poll_timer: pthread_join failed: %s\n",
+                strerror(code));
+    }
+    poll_async_closing = true;
+    uv_close((uv_handle_t *)&poll_async, poll_async_close_cb);
+    close_fds();
+    pt.running = false;
+    on_main_cb = NULL;
+    on_main_context = NULL;
+}
+
+bool poll_timer_running(void) { return pt.running; }
+
+uint64_t poll_timer_overruns(void) { return atomic_load(&overruns); }
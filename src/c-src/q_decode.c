@@ -0,0 +1,120 @@
+#include "q_decode.h"
+
+#include <endian.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// The vector loops reinterpret the bytes in place, so little-endian only.
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && defined(__ARM_NEON)
+#define Q_DECODE_NEON
+#include <arm_neon.h>
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && defined(__SSE2__)
+#define Q_DECODE_SSE2
+#include <immintrin.h>
+#endif
+
+static inline float scale_q(uint8_t q) { return 1.0f / (float)(1u << q); }
+
+void q_decode_scalar(const uint8_t *src, size_t stride, uint8_t lanes,
+                     uint8_t q, size_t count, float *out) {
+    const float scale = scale_q(q);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = src + i * stride;
+        for (uint8_t l = 0; l < lanes; l++) {
+            uint16_t raw;
+            memcpy(&raw, p + 2 * l, sizeof(raw));
+            *out++ = (int16_t)le16toh(raw) * scale;
+        }
+    }
+}
+
+// The vector loops load four int16 of every report. For 3 lanes that reads
+// two bytes past the values and writes a float past them, which the next
+// report's values then overwrite. So with 3 lanes the last report goes
+// through the scalar loop, and the bytes past its values are never touched.
+static inline size_t vector_count(uint8_t lanes, size_t count) {
+    return lanes == 4 ? count : count - 1;
+}
+
+#if defined(Q_DECODE_NEON)
+
+const char *q_decode_impl(void) { return "neon"; }
+
+void q_decode(const uint8_t *src, size_t stride, uint8_t lanes, uint8_t q,
+              size_t count, float *out) {
+    if ((lanes != 3 && lanes != 4) || count == 0) {
+        q_decode_scalar(src, stride, lanes, q, count, out);
+        return;
+    }
+    const float32x4_t scale = vdupq_n_f32(scale_q(q));
+    const size_t n = vector_count(lanes, count);
+    size_t i = 0;
+    for (; i < n; i++) {
+        int16x4_t raw = vreinterpret_s16_u8(vld1_u8(src + i * stride));
+        float32x4_t v = vcvtq_f32_s32(vmovl_s16(raw));
+        vst1q_f32(out + i * lanes, vmulq_f32(v, scale));
+    }
+    q_decode_scalar(src + i * stride, stride, lanes, q, count - i,
+                    out + i * lanes);
+}
+
+#elif defined(Q_DECODE_SSE2)
+
+const char *q_decode_impl(void) {
+#if defined(__AVX2__)
+    return "avx2";
+#else
+    return "sse2";
+#endif
+}
+
+// Four int16 at `p` to four floats
+static inline __m128 load4(const uint8_t *p) {
+    __m128i raw = _mm_loadl_epi64((const __m128i *)p);
+    // Sign extend by putting each int16 in the top half and shifting down
+    __m128i wide = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+    return _mm_cvtepi32_ps(wide);
+}
+
+void q_decode(const uint8_t *src, size_t stride, uint8_t lanes, uint8_t q,
+              size_t count, float *out) {
+    if ((lanes != 3 && lanes != 4) || count == 0) {
+        q_decode_scalar(src, stride, lanes, q, count, out);
+        return;
+    }
+    const size_t n = vector_count(lanes, count);
+    size_t i = 0;
+#if defined(__AVX2__)
+    if (lanes == 4) {
+        // Two reports per iteration
+        const __m256 scale8 = _mm256_set1_ps(scale_q(q));
+        for (; i + 2 <= n; i += 2) {
+            __m128i a = _mm_loadl_epi64((const __m128i *)(src + i * stride));
+            __m128i b =
+                _mm_loadl_epi64((const __m128i *)(src + (i + 1) * stride));
+            __m256i wide = _mm256_cvtepi16_epi32(_mm_unpacklo_epi64(a, b));
+            __m256 v = _mm256_mul_ps(_mm256_cvtepi32_ps(wide), scale8);
+            _mm256_storeu_ps(out + i * 4, v);
+        }
+    }
+#endif
+    const __m128 scale = _mm_set1_ps(scale_q(q));
+    for (; i < n; i++) {
+        __m128 v = _mm_mul_ps(load4(src + i * stride), scale);
+        _mm_storeu_ps(out + i * lanes, v);
+    }
+    q_decode_scalar(src + i * stride, stride, lanes, q, count - i,
+                    out + i * lanes);
+}
+
+#else
+
+const char *q_decode_impl(void) { return "scalar"; }
+
+void q_decode(const uint8_t *src, size_t stride, uint8_t lanes, uint8_t q,
+              size_t count, float *out) {
+    q_decode_scalar(src, stride, lanes, q, count, out);
+}
+
+#endif
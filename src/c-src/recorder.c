@@ -0,0 +1,284 @@
+#define _GNU_SOURCE
+#include "recorder.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <uv.h>
+
+#include "decoded_values.h"
+
+_Static_assert(sizeof(recorder_record_t) == RECORDER_RECORD_SIZE,
+               "recorder_record_t must match RECORDER_RECORD_SIZE");
+_Static_assert(sizeof(recorder_header_t) <= RECORDER_HEADER_SLOT_SIZE,
+               "recorder_header_t must fit in a header slot");
+
+typedef struct {
+    int fd;
+    uint8_t *map; // Header page and records
+    size_t map_size;
+    recorder_header_t header; // Last header written, without crc
+
+    uint64_t written; // Records appended
+    uint64_t dropped;
+    uint64_t sync_interval_us;
+    uint64_t last_sync_us; // uv_hrtime(), in microseconds
+    int error; // errno of the first failure
+
+    // Background sync. While `in_worker`, only the worker touches the
+    // header, `committed` and `error`; the main thread keeps appending past
+    // `sync_target`.
+    uv_work_t work;
+    bool syncing;    // Queued, until sync_done(..) has run
+    atomic_bool in_worker;
+    bool closed;     // Stopped while syncing; sync_done(..) frees it
+    uint64_t sync_target;
+    atomic_uint_fast64_t committed;
+} recording_t;
+
+static recording_t *active = NULL;
+
+uint32_t recorder_crc32(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= p[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint64_t clock_us(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) { return 0; }
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static recorder_record_t *record_at(recording_t *r, uint64_t n) {
+    return (recorder_record_t *)(r->map + RECORDER_HEADER_SIZE +
+                                 n * RECORDER_RECORD_SIZE);
+}
+
+// Flush records [from, to) to disk.
+static int sync_records(recording_t *r, uint64_t from, uint64_t to) {
+    if (to <= from) { return 0; }
+    long page = sysconf(_SC_PAGESIZE);
+    size_t start = RECORDER_HEADER_SIZE + from * RECORDER_RECORD_SIZE;
+    size_t end = RECORDER_HEADER_SIZE + to * RECORDER_RECORD_SIZE;
+    start -= start % page;
+    return msync(r->map + start, end - start, MS_SYNC) == 0 ? 0 : errno;
+}
+
+// Write the header to the slot after the last one and flush it.
+static int commit_header(recording_t *r, uint64_t committed, uint32_t flags) {
+    recorder_header_t *h = &r->header;
+    h->committed = committed;
+    h->flags = flags;
+    h->generation++;
+    h->crc = recorder_crc32(h, offsetof(recorder_header_t, crc));
+    uint8_t *slot = r->map + (h->generation % 2) * RECORDER_HEADER_SLOT_SIZE;
+    memcpy(slot, h, sizeof(*h));
+    return msync(r->map, RECORDER_HEADER_SIZE, MS_SYNC) == 0 ? 0 : errno;
+}
+
+static void close_recording(recording_t *r) {
+    int error = sync_records(r, r->committed, r->written);
+    if (error == 0) {
+        r->header.capacity = r->written;
+        error = commit_header(r, r->written, RECORDER_FLAG_CLOSED);
+    }
+    if (error == 0) { r->committed = r->written; }
+    if (r->error == 0) { r->error = error; }
+    munmap(r->map, r->map_size);
+    if (error == 0 &&
+        ftruncate(r->fd, RECORDER_HEADER_SIZE +
+                             r->written * RECORDER_RECORD_SIZE) != 0 &&
+        r->error == 0) {
+        r->error = errno;
+    }
+    if (close(r->fd) != 0 && r->error == 0) { r->error = errno; }
+}
+
+// Runs on a libuv worker thread.
+static void sync_work(uv_work_t *work) {
+    recording_t *r = work->data;
+    int error = sync_records(r, r->committed, r->sync_target);
+    if (error == 0) { error = commit_header(r, r->sync_target, 0); }
+    if (error == 0) {
+        r->committed = r->sync_target;
+    } else if (r->error == 0) {
+        r->error = error;
+    }
+    r->in_worker = false;
+}
+
+static void sync_done(uv_work_t *work, int status) {
+    (void)status;
+    recording_t *r = work->data;
+    r->syncing = false;
+    if (r->closed) { free(r); }
+}
+
+int recorder_start(uv_loop_t *loop, const char *path,
+                   const recorder_options_t *options) {
+    if (active != NULL) { return -1; }
+    if (options->capacity == 0) { return EINVAL; }
+    if (options->capacity > (SIZE_MAX - RECORDER_HEADER_SIZE) /
+                                RECORDER_RECORD_SIZE) {
+        return EFBIG;
+    }
+
+    recording_t *r = calloc(1, sizeof(recording_t));
+    if (r == NULL) { return ENOMEM; }
+    r->map_size = RECORDER_HEADER_SIZE +
+                  options->capacity * RECORDER_RECORD_SIZE;
+    r->sync_interval_us = (uint64_t)options->sync_interval_ms * 1000;
+    r->work.data = r;
+    r->work.loop = loop;
+
+    r->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (r->fd < 0) {
+        int error = errno;
+        free(r);
+        return error;
+    }
+    // Allocate the blocks now, so a full disk fails here and not with a
+    // SIGBUS on a write to the mapping. Fall back to a sparse file where
+    // the filesystem can't.
+    int error = posix_fallocate(r->fd, 0, r->map_size);
+    if (error == EINVAL || error == EOPNOTSUPP) {
+        error = ftruncate(r->fd, r->map_size) == 0 ? 0 : errno;
+    }
+    if (error == 0) {
+        r->map = mmap(NULL, r->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      r->fd, 0);
+        if (r->map == MAP_FAILED) { error = errno; }
+    }
+    if (error != 0) {
+        close(r->fd);
+        unlink(path);
+        free(r);
+        return error;
+    }
+    madvise(r->map, r->map_size, MADV_SEQUENTIAL);
+
+    recorder_header_t *h = &r->header;
+    memcpy(h->magic, RECORDER_MAGIC, sizeof(h->magic));
+    h->version = RECORDER_VERSION;
+    h->header_size = RECORDER_HEADER_SIZE;
+    h->record_size = RECORDER_RECORD_SIZE;
+    h->format = options->format;
+    h->capacity = options->capacity;
+    h->sensor_mask = options->sensor_mask;
+    error = commit_header(r, 0, 0);
+    if (error != 0) {
+        munmap(r->map, r->map_size);
+        close(r->fd);
+        unlink(path);
+        free(r);
+        return error;
+    }
+    r->last_sync_us = uv_hrtime() / 1000;
+    active = r;
+    return 0;
+}
+
+bool recorder_active(void) { return active != NULL; }
+
+void recorder_append(const sh2_SensorEventView_t *event,
+                     const sh2_SensorValue_t *sv) {
+    recording_t *r = active;
+    if (r == NULL) { return; }
+    uint64_t mask = r->header.sensor_mask;
+    if (mask != 0 && (event->reportId > SH2_MAX_SENSOR_ID ||
+                      !(mask & (1ULL << event->reportId)))) {
+        return;
+    }
+    bool decoded = r->header.format == RECORDER_DECODED;
+    if (decoded && sv == NULL) { return; }
+
+    if (r->written == r->header.capacity) {
+        r->dropped++;
+        return;
+    }
+    if (r->written == 0) {
+        // Pair the first timestamp with the wall clock. Timestamps carry the
+        // low 32 bits of the monotonic clock, which gives the event's age.
+        uint32_t age_us = (uint32_t)clock_us(CLOCK_MONOTONIC) -
+                          (uint32_t)event->timestamp_uS;
+        r->header.start_monotonic_us = event->timestamp_uS;
+        r->header.start_realtime_us = clock_us(CLOCK_REALTIME) - age_us;
+    }
+    recorder_record_t *rec = record_at(r, r->written);
+    rec->timestamp_us = event->timestamp_uS;
+    rec->delay_us = (int32_t)event->delay_uS;
+    rec->sensor_id = event->reportId;
+    if (decoded) {
+        rec->sequence = sv->sequence;
+        rec->status = sv->status & 0x03;
+        rec->len = decode_sensor_values(sv, rec->payload.values);
+    } else {
+        uint8_t len = event->len < RECORDER_PAYLOAD_SIZE
+                          ? event->len
+                          : RECORDER_PAYLOAD_SIZE;
+        rec->sequence = len > 1 ? event->report[1] : 0;
+        rec->status = len > 2 ? event->report[2] & 0x03 : 0;
+        rec->len = len;
+        memcpy(rec->payload.report, event->report, len);
+    }
+    r->written++;
+
+    // Hand the records since the last sync to a worker now and then
+    uint64_t now_us = uv_hrtime() / 1000;
+    if (!r->syncing && r->written > r->committed &&
+        now_us - r->last_sync_us >= r->sync_interval_us) {
+        r->last_sync_us = now_us;
+        r->sync_target = r->written;
+        r->syncing = true;
+        r->in_worker = true;
+        if (uv_queue_work(r->work.loop, &r->work, sync_work, sync_done) != 0) {
+            r->syncing = false;
+            r->in_worker = false;
+        }
+    }
+}
+
+bool recorder_stats(recorder_stats_t *out) {
+    if (active == NULL) { return false; }
+    out->records = active->written;
+    out->committed = active->committed;
+    out->dropped = active->dropped;
+    return true;
+}
+
+int recorder_stop(recorder_stats_t *out) {
+    recording_t *r = active;
+    if (r == NULL) { return -1; }
+    active = NULL;
+
+    // Wait for a running sync to let go of the mapping. It only covers the
+    // records since the previous one.
+    while (r->in_worker) { uv_sleep(1); }
+    close_recording(r);
+
+    out->records = r->written;
+    out->committed = r->committed;
+    out->dropped = r->dropped;
+    int error = r->error;
+    if (r->syncing) {
+        r->closed = true; // sync_done(..) is still to run
+    } else {
+        free(r);
+    }
+    return error;
+}
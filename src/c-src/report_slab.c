@@ -0,0 +1,76 @@
+#include "report_slab.h"
+
+#include <node/node_api.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "error.h"
+
+static report_storage_t storage = REPORT_STORAGE_BUFFER;
+
+static struct {
+    napi_ref ref; // Keeps the slab alive while it's being filled
+    uint8_t *data;
+    size_t used;
+} slab = {.ref = NULL, .data = NULL, .used = 0};
+
+void set_report_storage(report_storage_t s) { storage = s; }
+
+report_storage_t get_report_storage(void) { return storage; }
+
+void report_slab_reset(napi_env env) {
+    if (slab.ref != NULL) {
+        napi_delete_reference(env, slab.ref);
+        slab.ref = NULL;
+    }
+    slab.data = NULL;
+    slab.used = 0;
+}
+
+napi_value report_slab_copy(napi_env env, const void *data, size_t len) {
+    if (len > REPORT_SLAB_SIZE) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Report doesn't fit in a slab.");
+        return NULL;
+    }
+
+    napi_status status;
+    napi_value arraybuffer;
+    if (slab.ref == NULL || slab.used + len > REPORT_SLAB_SIZE) {
+        report_slab_reset(env);
+        void *mem;
+        status = napi_create_arraybuffer(env, REPORT_SLAB_SIZE, &mem,
+                                         &arraybuffer);
+        status |= napi_create_reference(env, arraybuffer, 1, &slab.ref);
+        if (status != napi_ok) {
+            report_slab_reset(env);
+            napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                             "Couldn't allocate a report slab.");
+            return NULL;
+        }
+        slab.data = mem;
+    } else {
+        status = napi_get_reference_value(env, slab.ref, &arraybuffer);
+        if (status != napi_ok) {
+            napi_throw_error(env, REF_ERROR,
+                             "Couldn't fetch the report slab by reference.");
+            return NULL;
+        }
+    }
+
+    size_t offset = slab.used;
+    memcpy(slab.data + offset, data, len);
+    // Keep views 4-byte aligned so they can be reinterpreted cheaply.
+    slab.used += (len + 3) & ~(size_t)3;
+
+    napi_value view;
+    status = napi_create_typedarray(env, napi_uint8_array, len, arraybuffer,
+                                    offset, &view);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create a view into the report slab.");
+        return NULL;
+    }
+    return view;
+}
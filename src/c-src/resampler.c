@@ -0,0 +1,176 @@
+#include "resampler.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decoded_values.h"
+#include "sh2/sh2.h"
+
+static bool is_quaternion(uint8_t sensor_id, uint8_t lanes) {
+    const char *const *names = decoded_value_names(sensor_id, &lanes);
+    return lanes >= 4 && strcmp(names[0], "i") == 0 &&
+           strcmp(names[3], "real") == 0;
+}
+
+bool resampler_init(resampler_t *r, const uint8_t *sensor_ids, uint8_t count,
+                    uint64_t period_us, uint64_t latency_us) {
+    memset(r, 0, sizeof(*r));
+    if (count == 0 || count > RESAMPLER_MAX_SENSORS || period_us == 0) {
+        return false;
+    }
+    for (uint8_t n = 0; n < count; n++) {
+        uint8_t id = sensor_ids[n];
+        if (id > SH2_MAX_SENSOR_ID || (r->sensor_mask & (1ULL << id))) {
+            return false;
+        }
+        resampler_stream_t *s = &r->streams[n];
+        s->sensor_id = id;
+        decoded_value_names(id, &s->lanes);
+        s->quaternion = is_quaternion(id, s->lanes);
+        s->offset = r->stride;
+        r->stride += s->lanes;
+        r->sensor_mask |= 1ULL << id;
+    }
+    r->stream_count = count;
+    r->period_us = period_us;
+    r->latency_us = latency_us;
+    r->values = malloc(RESAMPLER_MAX_FRAMES * (r->stride ? r->stride : 1) *
+                       sizeof(float));
+    return r->values != NULL;
+}
+
+void resampler_free(resampler_t *r) {
+    free(r->values);
+    r->values = NULL;
+}
+
+static resampler_sample_t *sample(resampler_stream_t *s, uint32_t n) {
+    return &s->queue[(s->head + n) % RESAMPLER_QUEUE];
+}
+
+void resampler_slerp(const float a[4], const float b[4], float u,
+                     float out[4]) {
+    float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    float sign = dot < 0 ? -1.0f : 1.0f;
+    dot *= sign;
+    float wa, wb;
+    if (dot > 0.9995f) {
+        // Nearly the same; lerp and normalize below
+        wa = 1.0f - u;
+        wb = u;
+    } else {
+        float theta = acosf(dot);
+        float s = sinf(theta);
+        wa = sinf((1.0f - u) * theta) / s;
+        wb = sinf(u * theta) / s;
+    }
+    float norm = 0;
+    for (int n = 0; n < 4; n++) {
+        out[n] = wa * a[n] + sign * wb * b[n];
+        norm += out[n] * out[n];
+    }
+    norm = sqrtf(norm);
+    if (norm > 0) {
+        for (int n = 0; n < 4; n++) { out[n] /= norm; }
+    }
+}
+
+// Values of a stream at `t`. Samples before the last one at or before `t`
+// are dropped, as later frames won't need them.
+static void values_at(resampler_stream_t *s, uint64_t t, float *out) {
+    while (s->count >= 2 && sample(s, 1)->timestamp_us <= t) {
+        s->head = (s->head + 1) % RESAMPLER_QUEUE;
+        s->count--;
+    }
+    const resampler_sample_t *a = sample(s, 0);
+    if (s->count == 1 || t <= a->timestamp_us) {
+        memcpy(out, a->values, s->lanes * sizeof(float));
+        return;
+    }
+    const resampler_sample_t *b = sample(s, 1);
+    float u = (float)((double)(t - a->timestamp_us) /
+                      (double)(b->timestamp_us - a->timestamp_us));
+    uint8_t l = 0;
+    if (s->quaternion) {
+        resampler_slerp(a->values, b->values, u, out);
+        l = 4;
+    }
+    for (; l < s->lanes; l++) {
+        out[l] = a->values[l] + u * (b->values[l] - a->values[l]);
+    }
+}
+
+static bool frame_ready(const resampler_t *r, uint64_t t) {
+    if (r->latest_us >= t + r->latency_us) { return true; }
+    for (uint8_t n = 0; n < r->stream_count; n++) {
+        const resampler_stream_t *s = &r->streams[n];
+        const resampler_sample_t *newest =
+            &s->queue[(s->head + s->count - 1) % RESAMPLER_QUEUE];
+        if (newest->timestamp_us < t) { return false; }
+    }
+    return true;
+}
+
+static void make_frames(resampler_t *r) {
+    while (frame_ready(r, r->next_us)) {
+        // After a gap, e.g. a paused replay, skip to the frames still due
+        uint64_t due = r->latest_us > r->latency_us
+                           ? r->latest_us - r->latency_us
+                           : 0;
+        uint64_t behind =
+            due > r->next_us ? (due - r->next_us) / r->period_us : 0;
+        if (behind > RESAMPLER_MAX_FRAMES) {
+            r->next_us += behind * r->period_us;
+            r->dropped += behind;
+        }
+
+        uint64_t t = r->next_us;
+        r->next_us += r->period_us;
+        if (r->frames == RESAMPLER_MAX_FRAMES) {
+            r->dropped++;
+            continue;
+        }
+        r->timestamps[r->frames] = (double)t;
+        float *frame = r->values + (size_t)r->frames * r->stride;
+        for (uint8_t n = 0; n < r->stream_count; n++) {
+            resampler_stream_t *s = &r->streams[n];
+            values_at(s, t, frame + s->offset);
+        }
+        r->frames++;
+    }
+}
+
+void resampler_push(resampler_t *r, uint8_t sensor_id, uint64_t timestamp_us,
+                    const float values[DECODED_VALUES_MAX]) {
+    if (sensor_id > SH2_MAX_SENSOR_ID ||
+        !(r->sensor_mask & (1ULL << sensor_id))) {
+        return;
+    }
+    resampler_stream_t *s = r->streams;
+    while (s->sensor_id != sensor_id) { s++; }
+
+    // A sensor far ahead of a stalled one loses its oldest samples
+    if (s->count == RESAMPLER_QUEUE) {
+        s->head = (s->head + 1) % RESAMPLER_QUEUE;
+        s->count--;
+    }
+    resampler_sample_t *new_sample = sample(s, s->count);
+    new_sample->timestamp_us = timestamp_us;
+    memcpy(new_sample->values, values, s->lanes * sizeof(float));
+    s->count++;
+    if (timestamp_us > r->latest_us) { r->latest_us = timestamp_us; }
+
+    if (r->next_us == 0) {
+        uint64_t start = 0;
+        for (uint8_t n = 0; n < r->stream_count; n++) {
+            if (r->streams[n].count == 0) { return; }
+            uint64_t first = sample(&r->streams[n], 0)->timestamp_us;
+            if (first > start) { start = first; }
+        }
+        r->next_us = (start / r->period_us + 1) * r->period_us;
+    }
+    make_frames(r);
+}
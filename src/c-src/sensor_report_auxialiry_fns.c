@@ -3,6 +3,7 @@
 #include <stdint.h>
 
 #include "error.h"
+#include "fast_euler.h"
 #include "sh2/euler.h"
 
 uint8_t add_xyz_to_sensor_report(napi_env env, napi_value report) {
@@ -149,29 +150,6 @@ uint8_t add_ypr_to_rotation_vector(napi_env env, napi_value report) {
         return 1;
     }
 
-    // Create prop values for yaw, pitch and roll.
-    napi_value yaw, pitch, roll;
-    float _yaw, _pitch, _roll;
-    q_to_ypr(real, i, j, k, &_roll, &_pitch, &_yaw);
-    status = napi_create_double(env, _yaw, &yaw);
-    if (status != napi_ok) {
-        napi_throw_error(env, SENSOR_REPORT_ERROR,
-                         "Couldn't create napi_value for yaw.");
-        return 1;
-    }
-    status = napi_create_double(env, _pitch, &pitch);
-    if (status != napi_ok) {
-        napi_throw_error(env, SENSOR_REPORT_ERROR,
-                         "Couldn't create napi_value for pitch.");
-        return 1;
-    }
-    status = napi_create_double(env, _roll, &roll);
-    if (status != napi_ok) {
-        napi_throw_error(env, SENSOR_REPORT_ERROR,
-                         "Couldn't create napi_value for roll.");
-        return 1;
-    }
-
     // Attach quaternion props to the report.
     status = napi_set_named_property(env, report, "i", I);
     if (status != napi_ok) {
@@ -199,6 +177,37 @@ uint8_t add_ypr_to_rotation_vector(napi_env env, napi_value report) {
         return 1;
     }
 
+    // Create prop values for yaw, pitch and roll, unless turned off.
+    napi_value yaw, pitch, roll;
+    float _yaw, _pitch, _roll;
+    switch (euler_mode()) {
+        case EULER_OFF:
+            return 0; // OK
+        case EULER_FAST:
+            fast_q_to_ypr(real, i, j, k, &_yaw, &_pitch, &_roll);
+            break;
+        default:
+            q_to_ypr(real, i, j, k, &_yaw, &_pitch, &_roll);
+    }
+    status = napi_create_double(env, _yaw, &yaw);
+    if (status != napi_ok) {
+        napi_throw_error(env, SENSOR_REPORT_ERROR,
+                         "Couldn't create napi_value for yaw.");
+        return 1;
+    }
+    status = napi_create_double(env, _pitch, &pitch);
+    if (status != napi_ok) {
+        napi_throw_error(env, SENSOR_REPORT_ERROR,
+                         "Couldn't create napi_value for pitch.");
+        return 1;
+    }
+    status = napi_create_double(env, _roll, &roll);
+    if (status != napi_ok) {
+        napi_throw_error(env, SENSOR_REPORT_ERROR,
+                         "Couldn't create napi_value for roll.");
+        return 1;
+    }
+
     // Attach euler angle props to the report.
     status = napi_set_named_property(env, report, "yaw", yaw);
     if (status != napi_ok) {
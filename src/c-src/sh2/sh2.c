@@ -299,6 +299,15 @@ struct sh2_s {
     sh2_SensorCallback_t *sensorCallback;
     void * sensorCookie;
 
+    // Zero-copy sensor callback and it's cookie
+    sh2_SensorViewCallback_t *sensorViewCallback;
+    void * sensorViewCookie;
+
+    // Gyro-integrated RV transfers: host time of the previous one, and
+    // the estimated spacing of its reports.
+    uint64_t lastGirv_uS;
+    uint32_t girvSpacing_uS;
+
     // Storage space for reading sensor metadata
     uint32_t frsData[MAX_FRS_WORDS];
     uint16_t frsDataLen;
@@ -543,13 +552,19 @@ static void opOnReset(sh2_t *pSh2)
 
 static uint8_t getReportLen(uint8_t reportId)
 {
-    for (unsigned n = 0; n < ARRAY_LEN(sh2ReportLens); n++) {
-        if (sh2ReportLens[n].id == reportId) {
-            return sh2ReportLens[n].len;
+    // Indexed by report id, built from sh2ReportLens on first use. Batched
+    // payloads hold many reports, so avoid searching the list for each.
+    static uint8_t lens[256];
+    static bool lensReady = false;
+
+    if (!lensReady) {
+        for (unsigned n = 0; n < ARRAY_LEN(sh2ReportLens); n++) {
+            lens[sh2ReportLens[n].id] = sh2ReportLens[n].len;
         }
+        lensReady = true;
     }
 
-    return 0;
+    return lens[reportId];
 }
 
 static void sensorhubControlHdlr(void *cookie, uint8_t *payload, uint16_t len, uint32_t timestamp)
@@ -680,7 +695,9 @@ static uint64_t touSTimestamp(uint32_t hostInt, int32_t referenceDelta, uint16_t
     lastHostInt = hostInt;
     
     timestamp = ((uint64_t)rollovers << 32);
-    timestamp += hostInt + (referenceDelta + delay) * 100;
+    // Signed and 64-bit: batched reports can be older than hostInt is large,
+    // and a 32-bit sum would wrap instead of reaching back past a rollover.
+    timestamp += (int64_t)hostInt + ((int64_t)referenceDelta + delay) * 100;
 
     return timestamp;
 }
@@ -718,17 +735,36 @@ static void sensorhubInputHdlr(sh2_t *pSh2, uint8_t *payload, uint16_t len, uint
             else if (reportId == SENSORHUB_FLUSH_COMPLETED) {
                 // Route this as if it arrived on command channel.
                 opRx(pSh2, payload+cursor, reportLen);
+
+                // Also let the application know, for flushes requested
+                // without waiting on them (sh2_requestFlush.)
+                if (pSh2->eventCallback) {
+                    const ForceFlushResp_t *rpt = (const ForceFlushResp_t *)(payload+cursor);
+                    sh2AsyncEvent.eventId = SH2_FLUSH_COMPLETED;
+                    sh2AsyncEvent.flushCompleted = rpt->sensorId;
+                    pSh2->eventCallback(pSh2->eventCookie, &sh2AsyncEvent);
+                }
             }
             else {
                 // Sensor event.  Call callback
                 uint8_t *pReport = payload+cursor;
                 uint16_t delay = ((pReport[2] & 0xFC) << 6) + pReport[3];
-                event.timestamp_uS = touSTimestamp(timestamp, referenceDelta, delay);
-                event.delay_uS = (referenceDelta + delay) * 100;
-                event.reportId = reportId;
-                memcpy(event.report, pReport, reportLen);
-                event.len = reportLen;
-                if (pSh2->sensorCallback != 0) {
+                if (pSh2->sensorViewCallback != 0) {
+                    // Hand over the report where it is, no copy.
+                    sh2_SensorEventView_t view;
+                    view.timestamp_uS = touSTimestamp(timestamp, referenceDelta, delay);
+                    view.delay_uS = ((int64_t)referenceDelta + delay) * 100;
+                    view.reportId = reportId;
+                    view.report = pReport;
+                    view.len = reportLen;
+                    pSh2->sensorViewCallback(pSh2->sensorViewCookie, &view);
+                }
+                else if (pSh2->sensorCallback != 0) {
+                    event.timestamp_uS = touSTimestamp(timestamp, referenceDelta, delay);
+                    event.delay_uS = ((int64_t)referenceDelta + delay) * 100;
+                    event.reportId = reportId;
+                    memcpy(event.report, pReport, reportLen);
+                    event.len = reportLen;
                     pSh2->sensorCallback(pSh2->sensorCookie, &event);
                 }
             }
@@ -753,6 +789,10 @@ static void sensorhubInputWakeHdlr(void *cookie, uint8_t *payload, uint16_t len,
     sensorhubInputHdlr(pSh2, payload, len, timestamp);
 }
 
+// Longest spacing of gyro-integrated RV reports taken as a running stream.
+// Longer gaps are pauses, not the report rate.
+#define GIRV_MAX_SPACING_US (100000)
+
 static void sensorhubInputGyroRvHdlr(void *cookie, uint8_t *payload, uint16_t len, uint32_t timestamp)
 {
     sh2_t *pSh2 = (sh2_t *)cookie;
@@ -761,14 +801,51 @@ static void sensorhubInputGyroRvHdlr(void *cookie, uint8_t *payload, uint16_t le
 
     uint8_t reportId = SH2_GYRO_INTEGRATED_RV;
     uint8_t reportLen = getReportLen(reportId);
+    if (reportLen == 0) {
+        return;
+    }
 
-    while (cursor < len) {
-        event.timestamp_uS = timestamp;
-        event.reportId = reportId;
-        memcpy(event.report, payload+cursor, reportLen);
-        event.len = reportLen;
+    // These reports carry no delay.  The newest was taken just before the
+    // interrupt, the others one report period apart before it.  Estimate
+    // the period from the spacing of the transfers.
+    uint64_t hostInt = touSTimestamp(timestamp, 0, 0);
+    uint16_t reports = len / reportLen;
+    if (reports == 0) {
+        // Shorter than one report; nothing to deliver or space out.
+        return;
+    }
+    if ((pSh2->lastGirv_uS != 0) && (hostInt > pSh2->lastGirv_uS)) {
+        uint64_t spacing = (hostInt - pSh2->lastGirv_uS) / reports;
+        if (spacing <= GIRV_MAX_SPACING_US) {
+            if (pSh2->girvSpacing_uS == 0) {
+                pSh2->girvSpacing_uS = spacing;
+            }
+            else {
+                // Smooth out the interrupt latency
+                pSh2->girvSpacing_uS += ((int64_t)spacing - pSh2->girvSpacing_uS) / 8;
+            }
+        }
+    }
+    pSh2->lastGirv_uS = hostInt;
 
-        if (pSh2->sensorCallback != 0) {
+    for (uint16_t n = 0; cursor + reportLen <= len; n++) {
+        int64_t delay_uS = -(int64_t)(reports - 1 - n) * pSh2->girvSpacing_uS;
+
+        if (pSh2->sensorViewCallback != 0) {
+            sh2_SensorEventView_t view;
+            view.timestamp_uS = hostInt + delay_uS;
+            view.delay_uS = delay_uS;
+            view.reportId = reportId;
+            view.report = payload+cursor;
+            view.len = reportLen;
+            pSh2->sensorViewCallback(pSh2->sensorViewCookie, &view);
+        }
+        else if (pSh2->sensorCallback != 0) {
+            event.timestamp_uS = hostInt + delay_uS;
+            event.delay_uS = delay_uS;
+            event.reportId = reportId;
+            memcpy(event.report, payload+cursor, reportLen);
+            event.len = reportLen;
             pSh2->sensorCallback(pSh2->sensorCookie, &event);
         }
 
@@ -1867,6 +1944,8 @@ int sh2_open(sh2_Hal_t *pHal,
     pSh2->eventCookie = eventCookie;
     pSh2->sensorCallback = 0;
     pSh2->sensorCookie = 0;
+    pSh2->sensorViewCallback = 0;
+    pSh2->sensorViewCookie = 0;
 
     // Open SHTP layer
     pSh2->pShtp = shtp_open(pSh2->pHal);
@@ -1952,6 +2031,23 @@ int sh2_setSensorCallback(sh2_SensorCallback_t *callback, void *cookie)
     return SH2_OK;
 }
 
+/**
+ * @brief Register a function to receive sensor events without copying them.
+ *
+ * @param  callback A function that will be called each time a sensor event is received.
+ * @param  cookie  A value that will be passed to the sensor callback function.
+ * @return SH2_OK (0), on success.  Negative value from sh2_err.h on error.
+ */
+int sh2_setSensorViewCallback(sh2_SensorViewCallback_t *callback, void *cookie)
+{
+    sh2_t *pSh2 = &_sh2;
+    
+    pSh2->sensorViewCallback = callback;
+    pSh2->sensorViewCookie = cookie;
+
+    return SH2_OK;
+}
+
 /**
  * @brief Reset the sensor hub device by sending RESET (1) command on "device" channel.
  *
@@ -2260,6 +2356,36 @@ int sh2_clearCounts(sh2_SensorId_t sensorId)
     return opProcess(pSh2, &sendCmdOp);
 }
 
+/**
+ * @brief Read the host side counters of the driver.
+ *
+ * @param  pStats Pointer to DriverStats structure that will receive data.
+ * @return SH2_OK (0), on success.  Negative value from sh2_err.h on error.
+ */
+int sh2_getDriverStats(sh2_DriverStats_t *pStats)
+{
+    sh2_t *pSh2 = &_sh2;
+    shtp_Stats_t shtpStats;
+
+    if (pSh2->pShtp == 0) {
+        return SH2_ERR;  // sh2 API isn't open
+    }
+
+    shtp_getStats(pSh2->pShtp, &shtpStats);
+    pStats->rxBadChan = shtpStats.rxBadChan;
+    pStats->rxShortFragments = shtpStats.rxShortFragments;
+    pStats->rxTooLargePayloads = shtpStats.rxTooLargePayloads;
+    pStats->rxInterruptedPayloads = shtpStats.rxInterruptedPayloads;
+    pStats->badTxChan = shtpStats.badTxChan;
+    pStats->txDiscards = shtpStats.txDiscards;
+    pStats->txTooLargePayloads = shtpStats.txTooLargePayloads;
+    pStats->execBadPayload = pSh2->execBadPayload;
+    pStats->emptyPayloads = pSh2->emptyPayloads;
+    pStats->unknownReportIds = pSh2->unknownReportIds;
+
+    return SH2_OK;
+}
+
 /**
  * @brief Perform a tare operation on one or more axes.
  *
@@ -2501,6 +2627,39 @@ int sh2_flush(sh2_SensorId_t sensorId)
     return opProcess(pSh2, &forceFlushOp);
 }
 
+/**
+ * @brief Request buffered sensor reports from a given sensor without waiting.
+ *
+ * @param  sensorId Which sensor reports to flush.
+ * @return SH2_OK (0), on success.  Negative value from sh2_err.h on error.
+ */
+int sh2_requestFlush(sh2_SensorId_t sensorId)
+{
+    sh2_t *pSh2 = &_sh2;
+    ForceFlushReq_t req;
+
+    if (pSh2->pShtp == 0) {
+        return SH2_ERR;  // sh2 API isn't open
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.reportId = SENSORHUB_FORCE_SENSOR_FLUSH;
+    req.sensorId = sensorId;
+
+    return sendCtrl(pSh2, (uint8_t *)&req, sizeof(req));
+}
+
+/**
+ * @brief Length of a report as sent by the hub.
+ *
+ * @param  reportId Report id, e.g. a sensor id.
+ * @return Length in bytes, 0 for an unknown report id.
+ */
+uint8_t sh2_getReportLen(uint8_t reportId)
+{
+    return getReportLen(reportId);
+}
+
 /**
  * @brief Command clear DCD in RAM, then reset sensor hub.
  *
@@ -52,6 +52,22 @@ typedef struct sh2_SensorEvent {
 
 typedef void (sh2_SensorCallback_t)(void * cookie, sh2_SensorEvent_t *pEvent);
 
+/**
+ * @brief Sensor Event, without a copy of the report
+ *
+ * Same as sh2_SensorEvent_t, but report points into the receive buffer of the
+ * SHTP layer. It is only valid during the callback.
+ */
+typedef struct sh2_SensorEventView {
+    uint64_t timestamp_uS;
+    int64_t delay_uS;
+    uint8_t len;
+    uint8_t reportId;
+    const uint8_t *report;
+} sh2_SensorEventView_t;
+
+typedef void (sh2_SensorViewCallback_t)(void * cookie, const sh2_SensorEventView_t *pView);
+
 /**
  * @brief Product Id value
  *
@@ -219,6 +235,25 @@ typedef struct sh2_Counts {
     uint32_t attempted; /**< @brief [events] */
 } sh2_Counts_t;
 
+/**
+ * @brief Host side counters of the driver and its SHTP transport
+ *
+ * Counted since sh2_open().  These are dropped or malformed traffic
+ * detected by the host, unlike sh2_Counts_t which the hub keeps.
+ */
+typedef struct sh2_DriverStats {
+    uint32_t rxBadChan;             /**< @brief Transfers on unknown channels */
+    uint32_t rxShortFragments;      /**< @brief Transfers shorter than a header */
+    uint32_t rxTooLargePayloads;    /**< @brief Payloads too large to assemble */
+    uint32_t rxInterruptedPayloads; /**< @brief Payloads cut off by a new one */
+    uint32_t badTxChan;             /**< @brief Sends to unknown channels */
+    uint32_t txDiscards;            /**< @brief Sends the HAL didn't accept */
+    uint32_t txTooLargePayloads;    /**< @brief Sends too large to transmit */
+    uint32_t execBadPayload;        /**< @brief Malformed executable channel payloads */
+    uint32_t emptyPayloads;         /**< @brief Sensorhub payloads without reports */
+    uint32_t unknownReportIds;      /**< @brief Reports of unknown type, dropped */
+} sh2_DriverStats_t;
+
 /**
  * @brief Values for specifying tare basis
  *
@@ -410,6 +445,7 @@ enum sh2_AsyncEventId_e {
     SH2_RESET,
     SH2_SHTP_EVENT,
     SH2_GET_FEATURE_RESP,
+    SH2_FLUSH_COMPLETED,
 };
 typedef enum sh2_AsyncEventId_e sh2_AsyncEventId_t;
 
@@ -435,6 +471,7 @@ typedef struct sh2_AsyncEvent {
     union {
         sh2_ShtpEvent_t shtpEvent;
         sh2_SensorConfigResp_t sh2SensorConfigResp;
+        sh2_SensorId_t flushCompleted;  // Sensor whose reports were flushed
     };
 } sh2_AsyncEvent_t;
 
@@ -489,6 +526,18 @@ void sh2_service(void);
  */
 int sh2_setSensorCallback(sh2_SensorCallback_t *callback, void *cookie);
 
+/**
+ * @brief Register a function to receive sensor events without copying them.
+ *
+ * While set, it is called instead of the sh2_setSensorCallback() callback.
+ * Pass a null callback to go back to copied events.
+ *
+ * @param  callback A function that will be called each time a sensor event is received.
+ * @param  cookie  A value that will be passed to the sensor callback function.
+ * @return SH2_OK (0), on success.  Negative value from sh2_err.h on error.
+ */
+int sh2_setSensorViewCallback(sh2_SensorViewCallback_t *callback, void *cookie);
+
 /**
  * @brief Reset the sensor hub device by sending RESET (1) command on "device" channel.
  *
@@ -593,6 +642,16 @@ int sh2_getCounts(sh2_SensorId_t sensorId, sh2_Counts_t *pCounts);
  */
 int sh2_clearCounts(sh2_SensorId_t sensorId);
 
+/**
+ * @brief Read the host side counters of the driver.
+ *
+ * Doesn't communicate with the hub.
+ *
+ * @param  pStats Pointer to DriverStats structure that will receive data.
+ * @return SH2_OK (0), on success.  Negative value from sh2_err.h on error.
+ */
+int sh2_getDriverStats(sh2_DriverStats_t *pStats);
+
 /**
  * @brief Perform a tare operation on one or more axes.
  *
@@ -693,6 +752,25 @@ int sh2_setDcdAutoSave(bool enabled);
  */
 int sh2_flush(sh2_SensorId_t sensorId);
 
+/**
+ * @brief Request buffered sensor reports from a given sensor without waiting.
+ *
+ * The reports arrive as the hub is serviced, followed by an SH2_FLUSH_COMPLETED
+ * event to the sh2_open() event callback.
+ *
+ * @param  sensorId Which sensor reports to flush.
+ * @return SH2_OK (0), on success.  Negative value from sh2_err.h on error.
+ */
+int sh2_requestFlush(sh2_SensorId_t sensorId);
+
+/**
+ * @brief Length of a report as sent by the hub.
+ *
+ * @param  reportId Report id, e.g. a sensor id.
+ * @return Length in bytes, 0 for an unknown report id.
+ */
+uint8_t sh2_getReportLen(uint8_t reportId);
+
 /**
  * @brief Command clear DCD in RAM, then reset sensor hub.
  *
@@ -541,5 +541,6 @@ typedef struct sh2_SensorValue {
 } sh2_SensorValue_t;
 
 int sh2_decodeSensorEvent(sh2_SensorValue_t *value, const sh2_SensorEvent_t *event);
+int sh2_decodeSensorEventView(sh2_SensorValue_t *value, const sh2_SensorEventView_t *view);
 
 #endif
@@ -29,8 +29,15 @@
 #define SH2_HAL_MAX_TRANSFER_OUT (128)
 #define SH2_HAL_MAX_PAYLOAD_OUT  (128)
 
+// Can be raised at build time for hubs batching into large transfers. A
+// payload is assembled from transfers, so it can be larger than one; the
+// payloads of batched reports flushed from the hub's FIFO run to several KB.
+#ifndef SH2_HAL_MAX_TRANSFER_IN
 #define SH2_HAL_MAX_TRANSFER_IN  (1024)
-#define SH2_HAL_MAX_PAYLOAD_IN   (1024)
+#endif
+#ifndef SH2_HAL_MAX_PAYLOAD_IN
+#define SH2_HAL_MAX_PAYLOAD_IN   (8192)
+#endif
 
 typedef struct sh2_Hal_s sh2_Hal_t;
 
@@ -250,6 +250,12 @@ static void rxAssemble(shtp_t *pShtp, uint8_t *in, uint16_t len, uint32_t t_us)
     pShtp->chan[chan].nextInSeq = seq + 1;
 
     if (pShtp->inRemaining == 0) {
+        // A continuation of a payload that was dropped, as too large or
+        // interrupted. Skip it rather than parse its middle as a payload.
+        if (continuation) {
+            return;
+        }
+
         if (payloadLen > sizeof(pShtp->inPayload)) {
             // Error: This payload won't fit! Discard it.
             pShtp->rxTooLargePayloads++;
@@ -263,6 +269,19 @@ static void rxAssemble(shtp_t *pShtp, uint8_t *in, uint16_t len, uint32_t t_us)
 
         // This represents a new payload
 
+        // A complete payload in a single fragment, the common case for
+        // sensor reports. Hand the listener a view into the transfer instead
+        // of copying it into inPayload first.
+        if (!continuation && len >= payloadLen) {
+            pShtp->inCursor = 0;
+            if (pShtp->chan[chan].callback != 0) {
+                pShtp->chan[chan].callback(pShtp->chan[chan].cookie,
+                                           in+SHTP_HDR_LEN, payloadLen-SHTP_HDR_LEN,
+                                           t_us);
+            }
+            return;
+        }
+
         // Store timestamp
         pShtp->inTimestamp = t_us;
 
@@ -392,6 +411,20 @@ int shtp_send(void *pInstance,
     return txProcess(pShtp, channel, payload, len);
 }
 
+// Read the transport error counters.
+void shtp_getStats(void *pInstance, shtp_Stats_t *pStats)
+{
+    shtp_t *pShtp = (shtp_t *)pInstance;
+
+    pStats->rxBadChan = pShtp->rxBadChan;
+    pStats->rxShortFragments = pShtp->rxShortFragments;
+    pStats->rxTooLargePayloads = pShtp->rxTooLargePayloads;
+    pStats->rxInterruptedPayloads = pShtp->rxInterruptedPayloads;
+    pStats->badTxChan = pShtp->badTxChan;
+    pStats->txDiscards = pShtp->txDiscards;
+    pStats->txTooLargePayloads = pShtp->txTooLargePayloads;
+}
+
 // Check for received data and process it.
 void shtp_service(void *pInstance)
 {
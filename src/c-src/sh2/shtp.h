@@ -37,6 +37,17 @@ typedef enum shtp_Event_e {
     SHTP_INTERRUPTED_PAYLOAD = 7,
 } shtp_Event_t;
 
+// Transport error counters, since shtp_open
+typedef struct shtp_Stats_s {
+    uint32_t rxBadChan;
+    uint32_t rxShortFragments;
+    uint32_t rxTooLargePayloads;
+    uint32_t rxInterruptedPayloads;
+    uint32_t badTxChan;
+    uint32_t txDiscards;
+    uint32_t txTooLargePayloads;
+} shtp_Stats_t;
+
 typedef void shtp_Callback_t(void * cookie, uint8_t *payload, uint16_t len, uint32_t timestamp);
 typedef void shtp_EventCallback_t(void *cookie, shtp_Event_t shtpEvent);
 
@@ -66,5 +77,8 @@ int shtp_send(void *pShtp,
 // Check for received data and process it.
 void shtp_service(void *pShtp);
 
+// Read the transport error counters.
+void shtp_getStats(void *pShtp, shtp_Stats_t *pStats);
+
 // #ifdef SHTP_H
 #endif
@@ -6,7 +6,6 @@
 #include <limits.h>
 #include <linux/i2c-dev.h>
 #include <linux/i2c.h>
-#include <node/node_api.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -18,14 +17,16 @@
 #include <time.h>
 #include <unistd.h>
 
-#include "error.h"
-#include "funcs.h"
 #include "interrupt.h"
 #include "sh2/sh2.h"
 #include "sh2/sh2_err.h"
 #include "sh2_hal_supplement.h"
 
 static i2c_settings_t CURRENT_I2C_SETTINGS;
+static hal_read_state_t LAST_READ_STATE = HAL_READ_IDLE;
+// Message for the caller of the driver to throw, see hal_take_error().
+static const char* LAST_ERROR = NULL;
+static hal_stats_t STATS;
 
 // This function completes communications with the sensor hub.
 // It should put the device in reset then de-initialize any
@@ -67,6 +68,7 @@ int open_i2c(sh2_Hal_t* self) {
         return 1;
     }
     fprintf(stdout, "Opened I2C device: %s\n", dev);
+    memset(&STATS, 0, sizeof(STATS));
     // Set the I2C slave address.
     if (ioctl(CURRENT_I2C_SETTINGS.i2c_fd, I2C_SLAVE,
               CURRENT_I2C_SETTINGS.addr) < 0) {
@@ -116,7 +118,6 @@ int open_i2c(sh2_Hal_t* self) {
 
 int read_from_i2c(sh2_Hal_t* self, uint8_t* pBuffer, unsigned len,
                   uint32_t* t_us) {
-    (void)len;
     i2c_settings_t* settings = &CURRENT_I2C_SETTINGS;
     static bool is_retry;
     static u_int16_t length;
@@ -125,6 +126,7 @@ int read_from_i2c(sh2_Hal_t* self, uint8_t* pBuffer, unsigned len,
 
     if (!is_retry) {
         const ssize_t n = read(settings->i2c_fd, pBuffer, 4); // header
+        if (n > 0) { STATS.read_bytes += n; }
         seq = pBuffer[3]; // Sequence number
         length = *(u_int16_t*)pBuffer;
         length &= 0x7fff;
@@ -136,11 +138,12 @@ int read_from_i2c(sh2_Hal_t* self, uint8_t* pBuffer, unsigned len,
                         seq);
             }
             perror("read_from_i2c(..)");
-            napi_throw_error(
-                _global_env_dont_touch, I2C_ERROR,
+            LAST_READ_STATE = HAL_READ_ERROR;
+            STATS.read_errors++;
+            LAST_ERROR =
                 "Are you perhaps on Raspberry Pi 4B or older and are using "
                 "hardware I2C? See OpenI2C root repository's README.md "
-                "about clock stretching on this platform.");
+                "about clock stretching on this platform.";
             return 0;
         } else if (n < 0) {
             if (debug && strcmp(debug, "true") == 0) {
@@ -149,6 +152,8 @@ int read_from_i2c(sh2_Hal_t* self, uint8_t* pBuffer, unsigned len,
                         seq);
             }
             perror("read_from_i2c(..)");
+            LAST_READ_STATE = HAL_READ_ERROR;
+            STATS.read_errors++;
             return 0;
         }
         if (length == 0) {
@@ -158,9 +163,12 @@ int read_from_i2c(sh2_Hal_t* self, uint8_t* pBuffer, unsigned len,
                     "\x1b[31mSeq: %hhd, dropped due to no data ready\x1b[0m\n",
                     seq);
             }
+            LAST_READ_STATE = HAL_READ_IDLE;
+            STATS.idle_reads++;
             return 0;
         }
         is_retry = true;
+        LAST_READ_STATE = HAL_READ_HEADER;
         if (debug && strcmp(debug, "true") == 0) {
             fprintf(stderr,
                     "\x1b[33mSeq: %hhd, Read payload length; retrying with "
@@ -169,13 +177,22 @@ int read_from_i2c(sh2_Hal_t* self, uint8_t* pBuffer, unsigned len,
         }
         return 0;
     }
-    const ssize_t n = read(settings->i2c_fd, pBuffer, length + 4);
+    // The length includes the header. Batched reports flushed from the hub's
+    // FIFO can make a cargo larger than our buffer; read what fits and the
+    // hub sends the rest as a continuation.
+    const size_t want = length < len ? length : len;
+    const ssize_t n = read(settings->i2c_fd, pBuffer, want);
     if (n < 0) {
         perror("read_from_i2c");
+        LAST_READ_STATE = HAL_READ_ERROR;
+        STATS.read_errors++;
         return 0;
     }
+    STATS.transfers++;
+    STATS.read_bytes += n;
     seq = pBuffer[3]; // Sequence number
     is_retry = false;
+    LAST_READ_STATE = HAL_READ_TRANSFER;
     uint32_t burst_t_us;
     bool success = irq_current_burst(&burst_t_us); // get burst timestamp
     if (success) {
@@ -210,10 +227,13 @@ int write_to_i2c(sh2_Hal_t* self, uint8_t* pBuffer, unsigned int len) {
     // fprintf(stderr, "write_to_i2c, len=%d\n", len);
     i2c_settings_t* settings = &CURRENT_I2C_SETTINGS;
     ssize_t n = write(settings->i2c_fd, pBuffer, len);
-    if (n <= 0)
+    if (n <= 0) {
+        STATS.write_errors++;
         return 0;
-    else
-        return n;
+    }
+    STATS.writes++;
+    STATS.write_bytes += n;
+    return n;
 }
 
 /**
@@ -234,6 +254,18 @@ void set_i2c_settings(i2c_settings_t* settings) {
 
 i2c_settings_t get_i2c_settings(void) { return CURRENT_I2C_SETTINGS; }
 
+hal_read_state_t hal_last_read_state(void) { return LAST_READ_STATE; }
+
+void hal_set_read_state(hal_read_state_t state) { LAST_READ_STATE = state; }
+
+hal_stats_t hal_stats(void) { return STATS; }
+
+const char* hal_take_error(void) {
+    const char* msg = LAST_ERROR;
+    LAST_ERROR = NULL;
+    return msg;
+}
+
 sh2_Hal_t make_hal(void) {
     sh2_Hal_t hal = {.open = open_i2c,
                      .close = close_i2c,
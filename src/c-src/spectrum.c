@@ -0,0 +1,161 @@
+#include "spectrum.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool spectrum_init(spectrum_t *s, const uint8_t *lanes, uint8_t axes,
+                   uint32_t size, uint32_t hop, spectrum_window_t window,
+                   const float *band_edges, uint8_t bands) {
+    memset(s, 0, sizeof(*s));
+    if (axes == 0 || axes > SPECTRUM_MAX_AXES || size < SPECTRUM_MIN_SIZE ||
+        size > SPECTRUM_MAX_SIZE || (size & (size - 1)) != 0 || hop == 0 ||
+        hop > size || bands > SPECTRUM_MAX_BANDS) {
+        return false;
+    }
+    for (uint8_t b = 0; b < bands; b++) {
+        if (!(band_edges[b] >= 0 && band_edges[b] < band_edges[b + 1])) {
+            return false;
+        }
+    }
+    s->size = size;
+    s->hop = hop;
+    s->axes = axes;
+    memcpy(s->lanes, lanes, axes);
+    s->bands = bands;
+    if (bands > 0) {
+        memcpy(s->band_edges, band_edges, (bands + 1) * sizeof(float));
+    }
+    s->outputs = bands > 0 ? bands : size / 2 + 1;
+
+    // The timestamps, then the float arrays
+    size_t floats = size + size + 2 * size + (size_t)axes * size +
+                    (size_t)SPECTRUM_MAX_FRAMES * axes * s->outputs;
+    s->timestamps = malloc(size * sizeof(double) + floats * sizeof(float));
+    if (s->timestamps == NULL) { return false; }
+    s->window = (float *)(s->timestamps + size);
+    s->cos_table = s->window + size;
+    s->sin_table = s->cos_table + size / 2;
+    s->re = s->sin_table + size / 2;
+    s->im = s->re + size;
+    s->ring = s->im + size;
+    s->frames_out = s->ring + (size_t)axes * size;
+
+    for (uint32_t n = 0; n < size; n++) {
+        double phase = 2 * M_PI * n / size;
+        double w = window == SPECTRUM_HANN      ? 0.5 - 0.5 * cos(phase)
+                   : window == SPECTRUM_HAMMING ? 0.54 - 0.46 * cos(phase)
+                                                : 1.0;
+        s->window[n] = (float)w;
+        s->s1 += w;
+        s->s2 += w * w;
+        if (n < size / 2) {
+            s->cos_table[n] = (float)cos(phase);
+            s->sin_table[n] = (float)sin(phase);
+        }
+    }
+    return true;
+}
+
+void spectrum_free(spectrum_t *s) {
+    free(s->timestamps);
+    s->timestamps = NULL;
+}
+
+void spectrum_fft(float *re, float *im, uint32_t n, const float *cos_table,
+                  const float *sin_table) {
+    // Bit-reversed order
+    for (uint32_t i = 1, j = 0; i < n; i++) {
+        uint32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) { j ^= bit; }
+        j ^= bit;
+        if (i < j) {
+            float t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+    for (uint32_t len = 2; len <= n; len <<= 1) {
+        uint32_t half = len / 2, step = n / len;
+        for (uint32_t i = 0; i < n; i += len) {
+            for (uint32_t k = 0; k < half; k++) {
+                // e^(-2 pi i k / len)
+                float wr = cos_table[k * step], wi = -sin_table[k * step];
+                uint32_t a = i + k, b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+// Transform the last `size` samples into the next frame.
+static void make_frame(spectrum_t *s) {
+    uint32_t oldest = s->samples % s->size;
+    double first_us = s->timestamps[oldest];
+    double last_us = s->timestamps[(s->samples - 1) % s->size];
+    double bin_hz = last_us > first_us
+                        ? (s->size - 1) / ((last_us - first_us) / 1e6) /
+                              s->size
+                        : 0;
+
+    if (s->frames == SPECTRUM_MAX_FRAMES) {
+        s->dropped++;
+        return;
+    }
+    s->frame_timestamps[s->frames] = last_us;
+    s->bin_hz[s->frames] = bin_hz;
+    float *out = s->frames_out + (size_t)s->frames * s->axes * s->outputs;
+    s->frames++;
+
+    uint32_t bins = s->size / 2 + 1;
+    for (uint8_t a = 0; a < s->axes; a++, out += s->outputs) {
+        const float *ring = s->ring + (size_t)a * s->size;
+        for (uint32_t n = 0; n < s->size; n++) {
+            s->re[n] = ring[(oldest + n) % s->size] * s->window[n];
+            s->im[n] = 0;
+        }
+        spectrum_fft(s->re, s->im, s->size, s->cos_table, s->sin_table);
+
+        if (s->bands == 0) {
+            for (uint32_t k = 0; k < bins; k++) {
+                double scale = k == 0 || k == s->size / 2 ? 1 : 2;
+                out[k] = (float)(scale * hypot(s->re[k], s->im[k]) / s->s1);
+            }
+            continue;
+        }
+        memset(out, 0, s->bands * sizeof(float));
+        for (uint32_t k = 0, b = 0; k < bins; k++) {
+            double hz = k * bin_hz;
+            while (b < s->bands && hz >= s->band_edges[b + 1]) { b++; }
+            if (b == s->bands) { break; }
+            if (hz < s->band_edges[b]) { continue; }
+            double scale = k == 0 || k == s->size / 2 ? 1 : 2;
+            double power = (double)s->re[k] * s->re[k] +
+                           (double)s->im[k] * s->im[k];
+            out[b] += (float)(scale * power / (s->size * s->s2));
+        }
+    }
+}
+
+void spectrum_push(spectrum_t *s, uint64_t timestamp_us,
+                   const float values[DECODED_VALUES_MAX]) {
+    uint32_t slot = s->samples % s->size;
+    s->timestamps[slot] = (double)timestamp_us;
+    for (uint8_t a = 0; a < s->axes; a++) {
+        s->ring[(size_t)a * s->size + slot] = values[s->lanes[a]];
+    }
+    s->samples++;
+    if (s->samples >= s->size && (s->samples - s->size) % s->hop == 0) {
+        make_frame(s);
+    }
+}
@@ -0,0 +1,155 @@
+#include "stats.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool stats_init(stats_t *s, stats_window_t window, uint32_t size,
+                uint8_t lanes) {
+    memset(s, 0, sizeof(*s));
+    s->window = window;
+    s->size = window == STATS_CUMULATIVE ? 0 : size;
+    s->lanes = lanes;
+    if (window != STATS_SLIDING) { return true; }
+
+    // The ring of each lane, then the slots of its min and max queues
+    s->ring = malloc((size_t)size * lanes *
+                     (sizeof(float) + 2 * sizeof(uint32_t)));
+    if (s->ring == NULL) { return false; }
+    uint32_t *slots = (uint32_t *)(s->ring + (size_t)size * lanes);
+    for (uint8_t l = 0; l < lanes; l++) {
+        s->min[l].slots = slots + (size_t)2 * l * size;
+        s->max[l].slots = s->min[l].slots + size;
+    }
+    return true;
+}
+
+void stats_free(stats_t *s) {
+    free(s->ring);
+    s->ring = NULL;
+}
+
+static void welford_add(welford_t *w, double x) {
+    w->count++;
+    double delta = x - w->mean;
+    w->mean += delta / w->count;
+    w->m2 += delta * (x - w->mean);
+    if (w->count == 1 || x < w->min) { w->min = x; }
+    if (w->count == 1 || x > w->max) { w->max = x; }
+}
+
+// Undo welford_add(.., x). Min and max aren't kept.
+static void welford_remove(welford_t *w, double x) {
+    if (w->count <= 1) {
+        memset(w, 0, sizeof(*w));
+        return;
+    }
+    double delta = x - w->mean;
+    w->count--;
+    w->mean -= delta / w->count;
+    w->m2 -= delta * (x - w->mean);
+    if (w->m2 < 0) { w->m2 = 0; }
+}
+
+static uint32_t queue_slot(const stats_queue_t *q, uint32_t n, uint32_t size) {
+    return q->slots[(q->head + n) % size];
+}
+
+// Drop `slot` from the front as it leaves the window.
+static void queue_expire(stats_queue_t *q, uint32_t slot, uint32_t size) {
+    if (q->length > 0 && q->slots[q->head] == slot) {
+        q->head = (q->head + 1) % size;
+        q->length--;
+    }
+}
+
+// Append `slot`, first dropping the slots it outlasts: those not above its
+// value for the max queue, and not below it for the min queue.
+static void queue_push(stats_queue_t *q, const float *ring, uint32_t slot,
+                       uint32_t size, bool max) {
+    float x = ring[slot];
+    while (q->length > 0) {
+        float back = ring[queue_slot(q, q->length - 1, size)];
+        if (max ? back > x : back < x) { break; }
+        q->length--;
+    }
+    q->slots[(q->head + q->length) % size] = slot;
+    q->length++;
+}
+
+// Exact sums of a full sliding window
+static void recompute(stats_t *s) {
+    for (uint8_t l = 0; l < s->lanes; l++) {
+        const float *ring = s->ring + (size_t)l * s->size;
+        double sum = 0, m2 = 0;
+        for (uint32_t n = 0; n < s->size; n++) { sum += ring[n]; }
+        double mean = sum / s->size;
+        for (uint32_t n = 0; n < s->size; n++) {
+            m2 += (ring[n] - mean) * (ring[n] - mean);
+        }
+        s->acc[l].mean = mean;
+        s->acc[l].m2 = m2;
+    }
+}
+
+void stats_push(stats_t *s, uint64_t timestamp_us,
+                const float values[DECODED_VALUES_MAX]) {
+    s->timestamp_us = timestamp_us;
+
+    if (s->window != STATS_SLIDING) {
+        for (uint8_t l = 0; l < s->lanes; l++) {
+            welford_add(&s->acc[l], values[l]);
+        }
+        s->samples++;
+        if (s->window == STATS_TUMBLING && s->acc[0].count == s->size) {
+            memcpy(s->done, s->acc, sizeof(s->done));
+            memset(s->acc, 0, sizeof(s->acc));
+            s->windows++;
+        }
+        return;
+    }
+
+    uint32_t slot = s->samples % s->size;
+    bool full = s->samples >= s->size;
+    for (uint8_t l = 0; l < s->lanes; l++) {
+        float *ring = s->ring + (size_t)l * s->size;
+        if (full) {
+            welford_remove(&s->acc[l], ring[slot]);
+            queue_expire(&s->min[l], slot, s->size);
+            queue_expire(&s->max[l], slot, s->size);
+        }
+        ring[slot] = values[l];
+        welford_add(&s->acc[l], values[l]);
+        queue_push(&s->min[l], ring, slot, s->size, false);
+        queue_push(&s->max[l], ring, slot, s->size, true);
+    }
+    s->samples++;
+    if (slot == s->size - 1) { recompute(s); }
+}
+
+uint64_t stats_snapshot(const stats_t *s,
+                        stats_value_t out[DECODED_VALUES_MAX]) {
+    const welford_t *w =
+        s->window == STATS_TUMBLING && s->windows > 0 ? s->done : s->acc;
+    uint64_t count = w[0].count;
+    for (uint8_t l = 0; l < s->lanes; l++) {
+        if (count == 0) {
+            out[l] = (stats_value_t){NAN, NAN, NAN, NAN, NAN};
+            continue;
+        }
+        out[l].mean = w[l].mean;
+        out[l].variance = count > 1 ? w[l].m2 / (count - 1) : 0;
+        out[l].rms = sqrt(w[l].mean * w[l].mean + w[l].m2 / count);
+        if (s->window == STATS_SLIDING) {
+            const float *ring = s->ring + (size_t)l * s->size;
+            out[l].min = ring[s->min[l].slots[s->min[l].head]];
+            out[l].max = ring[s->max[l].slots[s->max[l].head]];
+        } else {
+            out[l].min = w[l].min;
+            out[l].max = w[l].max;
+        }
+    }
+    return count;
+}
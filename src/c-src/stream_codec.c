@@ -0,0 +1,236 @@
+#include "stream_codec.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define REPORT_HEADER 4
+#define STREAM_FLAGS                                                     \
+    (STREAM_LEN | STREAM_SEQ | STREAM_STATUS | STREAM_DELAY | STREAM_DELAY_US)
+
+static inline uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static size_t put_varint(uint8_t *out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+// Returns 1 with `*pos` past the varint, 0 if the input ends first, -1 if
+// it's longer than any uint64.
+static int get_varint(const uint8_t *in, size_t len, size_t *pos,
+                      uint64_t *v) {
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*pos >= len) { return 0; }
+        uint8_t b = in[(*pos)++];
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) { return 1; }
+    }
+    return -1;
+}
+
+static inline int16_t lane(const uint8_t *report, uint8_t n) {
+    const uint8_t *p = report + REPORT_HEADER + 2 * n;
+    return (int16_t)(p[0] | p[1] << 8);
+}
+
+void stream_encoder_init(stream_encoder_t *enc, uint8_t sensor_id) {
+    memset(enc, 0, sizeof(*enc));
+    enc->prev.sensor_id = sensor_id;
+}
+
+size_t stream_encode(stream_encoder_t *enc, const recorder_record_t *record,
+                     uint8_t *out) {
+    stream_state_t *prev = &enc->prev;
+    const uint8_t *report = record->payload.report;
+    if (record->len < REPORT_HEADER || record->len > RECORDER_PAYLOAD_SIZE ||
+        report[0] != prev->sensor_id) {
+        return 0;
+    }
+
+    size_t n = 0;
+    if (!enc->started) {
+        memcpy(out, STREAM_MAGIC, 4);
+        out[4] = prev->sensor_id;
+        n = STREAM_HEADER_SIZE;
+        enc->started = true;
+    }
+    uint8_t *flags = &out[n++];
+    *flags = 0;
+    if (record->len != prev->len) {
+        *flags |= STREAM_LEN;
+        out[n++] = record->len;
+    }
+    if (report[1] != (uint8_t)(prev->report[1] + 1)) {
+        *flags |= STREAM_SEQ;
+        out[n++] = report[1];
+    }
+    if (report[2] != prev->report[2]) {
+        *flags |= STREAM_STATUS;
+        out[n++] = report[2];
+    }
+    if (report[3] != prev->report[3]) {
+        *flags |= STREAM_DELAY;
+        out[n++] = report[3];
+    }
+    if (record->delay_us != prev->delay_us) {
+        *flags |= STREAM_DELAY_US;
+        int32_t change =
+            (int32_t)((uint32_t)record->delay_us - (uint32_t)prev->delay_us);
+        n += put_varint(&out[n], zigzag(change));
+    }
+    int64_t interval = (int64_t)(record->timestamp_us - prev->timestamp_us);
+    int64_t change =
+        (int64_t)((uint64_t)interval - (uint64_t)prev->interval_us);
+    n += put_varint(&out[n], zigzag(change));
+
+    // Lanes the previous report doesn't have are relative to 0
+    uint8_t lanes = (record->len - REPORT_HEADER) / 2;
+    for (uint8_t l = 0; l < lanes; l++) {
+        int16_t before = 2 * l + REPORT_HEADER + 1 < prev->len
+                             ? lane(prev->report, l)
+                             : 0;
+        int16_t delta = (int16_t)(uint16_t)(lane(report, l) - before);
+        n += put_varint(&out[n], zigzag(delta));
+    }
+    if ((record->len - REPORT_HEADER) % 2) {
+        out[n++] = report[record->len - 1];
+    }
+
+    prev->timestamp_us = record->timestamp_us;
+    prev->interval_us = interval;
+    prev->delay_us = record->delay_us;
+    prev->len = record->len;
+    memcpy(prev->report, report, record->len);
+    return n;
+}
+
+void stream_decoder_init(stream_decoder_t *dec) {
+    memset(dec, 0, sizeof(*dec));
+}
+
+// Parse one record, and the stream header before the first. Returns the
+// bytes it took, 0 if `in` ends first, or -1 if it's not a valid record.
+// The decoder is only updated on success.
+static int parse(stream_decoder_t *dec, const uint8_t *in, size_t len,
+                 recorder_record_t *out) {
+    stream_state_t s = dec->prev;
+    size_t pos = 0;
+    if (!dec->started) {
+        if (len < STREAM_HEADER_SIZE) { return 0; }
+        if (memcmp(in, STREAM_MAGIC, 4) != 0) { return -1; }
+        s.sensor_id = in[4];
+        pos = STREAM_HEADER_SIZE;
+    }
+    if (pos >= len) { return 0; }
+    uint8_t flags = in[pos++];
+    if (flags & ~STREAM_FLAGS) { return -1; }
+
+    // The fixed size fields, in order
+    uint8_t header[4] = {0, (uint8_t)(s.report[1] + 1), s.report[2],
+                         s.report[3]};
+    uint8_t new_len = s.len;
+    const uint8_t bits[4] = {STREAM_LEN, STREAM_SEQ, STREAM_STATUS,
+                             STREAM_DELAY};
+    for (int f = 0; f < 4; f++) {
+        if (!(flags & bits[f])) { continue; }
+        if (pos >= len) { return 0; }
+        if (f == 0) {
+            new_len = in[pos++];
+        } else {
+            header[f] = in[pos++];
+        }
+    }
+    if (new_len < REPORT_HEADER || new_len > RECORDER_PAYLOAD_SIZE) {
+        return -1;
+    }
+    // Sums wrap as in the encoder, whatever the input
+    uint64_t v;
+    int got;
+    if (flags & STREAM_DELAY_US) {
+        if ((got = get_varint(in, len, &pos, &v)) != 1) { return got; }
+        s.delay_us = (int32_t)(uint32_t)(s.delay_us + (uint32_t)unzigzag(v));
+    }
+    if ((got = get_varint(in, len, &pos, &v)) != 1) { return got; }
+    s.interval_us =
+        (int64_t)((uint64_t)s.interval_us + (uint64_t)unzigzag(v));
+    s.timestamp_us += (uint64_t)s.interval_us;
+
+    uint8_t report[RECORDER_PAYLOAD_SIZE] = {0};
+    report[0] = s.sensor_id;
+    memcpy(&report[1], &header[1], 3);
+    uint8_t lanes = (new_len - REPORT_HEADER) / 2;
+    for (uint8_t l = 0; l < lanes; l++) {
+        if ((got = get_varint(in, len, &pos, &v)) != 1) { return got; }
+        int16_t before =
+            2 * l + REPORT_HEADER + 1 < s.len ? lane(s.report, l) : 0;
+        uint16_t value = (uint16_t)(before + (int16_t)unzigzag(v));
+        report[REPORT_HEADER + 2 * l] = value & 0xFF;
+        report[REPORT_HEADER + 2 * l + 1] = value >> 8;
+    }
+    if ((new_len - REPORT_HEADER) % 2) {
+        if (pos >= len) { return 0; }
+        report[new_len - 1] = in[pos++];
+    }
+    s.len = new_len;
+    memcpy(s.report, report, sizeof(report));
+
+    memset(out, 0, sizeof(*out));
+    out->timestamp_us = s.timestamp_us;
+    out->delay_us = s.delay_us;
+    out->sensor_id = s.sensor_id;
+    out->sequence = report[1];
+    out->status = report[2] & 0x03;
+    out->len = new_len;
+    memcpy(out->payload.report, report, new_len);
+
+    dec->prev = s;
+    dec->started = true;
+    return (int)pos;
+}
+
+stream_result_t stream_decode(stream_decoder_t *dec, const uint8_t *in,
+                              size_t len, size_t *used,
+                              recorder_record_t *out) {
+    *used = 0;
+    if (dec->pending_len == 0) {
+        int n = parse(dec, in, len, out);
+        if (n > 0) {
+            *used = n;
+            return STREAM_RECORD;
+        }
+        if (n < 0 || len > sizeof(dec->pending)) { return STREAM_CORRUPT; }
+        memcpy(dec->pending, in, len);
+        dec->pending_len = len;
+        *used = len;
+        return STREAM_NEED_MORE;
+    }
+
+    // Complete the cut off record with the start of `in`
+    size_t had = dec->pending_len;
+    size_t take = sizeof(dec->pending) - had;
+    if (take > len) { take = len; }
+    memcpy(&dec->pending[had], in, take);
+    int n = parse(dec, dec->pending, had + take, out);
+    if (n > 0) {
+        dec->pending_len = 0;
+        *used = n - had;
+        return STREAM_RECORD;
+    }
+    if (n < 0 || had + take == sizeof(dec->pending)) { return STREAM_CORRUPT; }
+    dec->pending_len = had + take;
+    *used = take;
+    return STREAM_NEED_MORE;
+}
@@ -0,0 +1,86 @@
+// Benchmark and accuracy check of fast_q_to_ypr(..) against the driver's
+// q_to_ypr(..), on random unit quaternions and on ones near gimbal lock.
+//
+// Build and run: node-gyp build && ./build/Release/bench_euler
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fast_euler.h"
+
+#define QUATS 4096
+#define ROUNDS 500
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Nanoseconds per quaternion
+static double run(const float *quats, euler_mode_t mode, float *ypr) {
+    double start = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        q_to_ypr_batch(quats, QUATS, mode, ypr);
+        // Keep the compiler from dropping rounds
+        __asm__ volatile("" : : "r"(ypr) : "memory");
+    }
+    return (now_ns() - start) / ((double)ROUNDS * QUATS);
+}
+
+static float uniform(void) { return 2.0f * rand() / RAND_MAX - 1.0f; }
+
+static void random_quats(float *quats, int near_gimbal_lock) {
+    for (int n = 0; n < QUATS; n++) {
+        float *q = &quats[n * 4];
+        if (near_gimbal_lock) {
+            // Pitch close to +-90 degrees: 2jk + 2ri close to +-1
+            float yaw = uniform() * 3.1416f;
+            float pitch = copysignf(1.5708f - fabsf(uniform()) * 1e-3f,
+                                    uniform());
+            q[0] = sinf(pitch / 2) * cosf(yaw / 2);
+            q[1] = sinf(pitch / 2) * sinf(yaw / 2);
+            q[2] = cosf(pitch / 2) * sinf(yaw / 2);
+            q[3] = cosf(pitch / 2) * cosf(yaw / 2);
+        } else {
+            float norm;
+            do {
+                for (int c = 0; c < 4; c++) { q[c] = uniform(); }
+                norm = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] +
+                             q[3] * q[3]);
+            } while (norm < 0.1f || norm > 1.0f);
+            for (int c = 0; c < 4; c++) { q[c] /= norm; }
+        }
+    }
+}
+
+static int bench(const char *name, int near_gimbal_lock) {
+    static float quats[QUATS * 4], exact[QUATS * 3], fast[QUATS * 3];
+    srand(1);
+    random_quats(quats, near_gimbal_lock);
+
+    double exact_ns = run(quats, EULER_EXACT, exact);
+    double fast_ns = run(quats, EULER_FAST, fast);
+    double max_error = 0;
+    for (int n = 0; n < QUATS * 3; n++) {
+        double error = fabs(remainder(fast[n] - exact[n], 2 * M_PI));
+        if (error > max_error) { max_error = error; }
+    }
+    int ok = max_error <= FAST_EULER_MAX_ERROR;
+
+    printf("%-18s exact %6.2f ns  fast %6.2f ns  %.1fx  max error %.2e rad"
+           "  %s\n",
+           name, exact_ns, fast_ns, exact_ns / fast_ns, max_error,
+           ok ? "ok" : "OVER BOUND");
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    int failed = 0;
+    failed |= bench("random", 0);
+    failed |= bench("near gimbal lock", 1);
+    return failed;
+}
@@ -0,0 +1,74 @@
+// Benchmark of q_decode(..) against the scalar loop, on batches shaped like
+// accelerometer (3 lanes, 10 byte reports) and rotation vector (4 lanes, 14
+// byte reports) payloads, and on packed triples. Checks that both give the
+// same floats.
+//
+// Build and run: node-gyp build && ./build/Release/bench_q_decode
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "q_decode.h"
+
+#define REPORTS 4096
+#define ROUNDS 2000
+
+typedef void (*decode_fn_t)(const uint8_t *, size_t, uint8_t, uint8_t, size_t,
+                            float *);
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Nanoseconds per report
+static double run(decode_fn_t fn, const uint8_t *src, size_t stride,
+                  uint8_t lanes, uint8_t q, float *out) {
+    double start = now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        fn(src, stride, lanes, q, REPORTS, out);
+        // Keep the compiler from dropping rounds
+        __asm__ volatile("" : : "r"(out) : "memory");
+    }
+    return (now_ns() - start) / ((double)ROUNDS * REPORTS);
+}
+
+// `offset` is where the values start in a report, after its header.
+static int bench(const char *name, size_t stride, size_t offset,
+                 uint8_t lanes, uint8_t q) {
+    uint8_t *payload = malloc(REPORTS * stride);
+    float *scalar = malloc(REPORTS * lanes * sizeof(float));
+    float *vector = malloc(REPORTS * lanes * sizeof(float));
+    if (!payload || !scalar || !vector) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    srand(1);
+    for (size_t i = 0; i < REPORTS * stride; i++) { payload[i] = rand(); }
+
+    const uint8_t *src = payload + offset;
+    double scalar_ns = run(q_decode_scalar, src, stride, lanes, q, scalar);
+    double vector_ns = run(q_decode, src, stride, lanes, q, vector);
+    int same = memcmp(scalar, vector, REPORTS * lanes * sizeof(float)) == 0;
+
+    printf("%-18s scalar %6.2f ns/report  %-6s %6.2f ns/report  %.1fx  %s\n",
+           name, scalar_ns, q_decode_impl(), vector_ns, scalar_ns / vector_ns,
+           same ? "match" : "MISMATCH");
+
+    free(payload);
+    free(scalar);
+    free(vector);
+    return same ? 0 : 1;
+}
+
+int main(void) {
+    int failed = 0;
+    failed |= bench("accelerometer", 10, 4, 3, 8);
+    failed |= bench("rotation vector", 14, 4, 4, 14);
+    failed |= bench("packed triples", 6, 0, 3, 10);
+    return failed;
+}
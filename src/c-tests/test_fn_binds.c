@@ -34,6 +34,36 @@ napi_value init(napi_env env, napi_value exports) {
                 test_node_from_c_AsyncEvent, NULL);
     register_fn(env, exports, "test_node_from_c_SensorEvent",
                 test_node_from_c_SensorEvent, NULL);
+    register_fn(env, exports, "test_node_from_c_SensorEvent_slab",
+                test_node_from_c_SensorEvent_slab, NULL);
+    register_fn(env, exports, "test_node_from_c_SensorEvent_timestamps",
+                test_node_from_c_SensorEvent_timestamps, NULL);
+    register_fn(env, exports, "test_node_from_c_ServiceStats",
+                test_node_from_c_ServiceStats, NULL);
+    register_fn(env, exports, "test_node_from_c_LatestValue",
+                test_node_from_c_LatestValue, NULL);
+    register_fn(env, exports, "test_node_from_c_SubscriberStats",
+                test_node_from_c_SubscriberStats, NULL);
+    register_fn(env, exports, "test_node_from_c_Metrics",
+                test_node_from_c_Metrics, NULL);
+    register_fn(env, exports, "test_clock_sync", test_clock_sync, NULL);
+    register_fn(env, exports, "test_girv_ring", test_girv_ring, NULL);
+    register_fn(env, exports, "test_q_decode", test_q_decode, NULL);
+    register_fn(env, exports, "test_fast_euler", test_fast_euler, NULL);
+    register_fn(env, exports, "test_recorder", test_recorder, NULL);
+    register_fn(env, exports, "test_log_reader", test_log_reader, NULL);
+    register_fn(env, exports, "test_log_replay_corrupt",
+                test_log_replay_corrupt, NULL);
+    register_fn(env, exports, "test_stream_codec", test_stream_codec, NULL);
+    register_fn(env, exports, "test_arrow_writer", test_arrow_writer, NULL);
+    register_fn(env, exports, "test_history", test_history, NULL);
+    register_fn(env, exports, "test_resampler", test_resampler, NULL);
+    register_fn(env, exports, "test_stats", test_stats, NULL);
+    register_fn(env, exports, "test_allan", test_allan, NULL);
+    register_fn(env, exports, "test_spectrum", test_spectrum, NULL);
+    register_fn(env, exports, "test_capture", test_capture, NULL);
+    register_fn(env, exports, "test_service_until_idle",
+                test_service_until_idle, NULL);
     register_fn(env, exports, "test_add_xyz_to_sensor_report",
                 test_add_xyz_to_sensor_report, NULL);
     register_fn(env, exports, "test_add_ypr_to_rotation_vector",
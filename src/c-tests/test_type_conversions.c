@@ -1,10 +1,34 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
 #include <node/node_api.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "allan.h"
+#include "arrow_writer.h"
+#include "capture.h"
+#include "clock_sync.h"
 #include "error.h"
+#include "event_timestamp.h"
+#include "fast_euler.h"
+#include "funcs.h"
+#include "girv_ring.h"
+#include "history.h"
+#include "log_reader.h"
 #include "node_c_type_conversions.h"
+#include "q_decode.h"
+#include "recorder.h"
+#include "report_slab.h"
+#include "resampler.h"
+#include "sh2/sh2_err.h"
+#include "spectrum.h"
+#include "stats.h"
+#include "stream_codec.h"
 
 napi_value test_node_to_c_SensorConfig(napi_env env, napi_callback_info info) {
     size_t argc = 1;
@@ -155,9 +179,15 @@ napi_value test_node_from_c_AsyncEvent(napi_env env, napi_callback_info info) {
         .sh2SensorConfigResp = r,
     };
 
-    // Out object and the two resulting test objects inside with keys
-    // 'withShtpEv' and 'withSensorConfigResp'
-    napi_value out, with_shtp_ev, with_sensor_config_resp;
+    // AsyncEvent of a completed flush
+    sh2_AsyncEvent_t test_s_flush_completed = {
+        .eventId = SH2_FLUSH_COMPLETED,
+        .flushCompleted = SH2_GYROSCOPE_CALIBRATED,
+    };
+
+    // Out object and the resulting test objects inside with keys
+    // 'withShtpEv', 'withSensorConfigResp' and 'flushCompleted'
+    napi_value out, with_shtp_ev, with_sensor_config_resp, flush_completed;
 
     napi_status status = napi_create_object(env, &out);
     if (status != napi_ok) {
@@ -168,8 +198,10 @@ napi_value test_node_from_c_AsyncEvent(napi_env env, napi_callback_info info) {
     with_shtp_ev = node_from_c_AsyncEvent(env, &test_s_with_shtp_event);
     with_sensor_config_resp =
         node_from_c_AsyncEvent(env, &test_s_with_sensor_config_resp);
+    flush_completed = node_from_c_AsyncEvent(env, &test_s_flush_completed);
 
-    if (with_shtp_ev == NULL || with_sensor_config_resp == NULL) {
+    if (with_shtp_ev == NULL || with_sensor_config_resp == NULL ||
+        flush_completed == NULL) {
         napi_throw_error(env, ERROR_EXECUTING_TEST,
                          "Couldn't convert value because of an error in test");
         return NULL;
@@ -183,6 +215,8 @@ napi_value test_node_from_c_AsyncEvent(napi_env env, napi_callback_info info) {
     }
     status = napi_set_named_property(env, out, "withSensorConfigResp",
                                      with_sensor_config_resp);
+    status |= napi_set_named_property(env, out, "flushCompleted",
+                                      flush_completed);
     if (status != napi_ok) {
         napi_throw_error(env, ERROR_EXECUTING_TEST,
                          "Couldn't set prop for out var");
@@ -191,3 +225,1206 @@ napi_value test_node_from_c_AsyncEvent(napi_env env, napi_callback_info info) {
 
     return out;
 }
+
+napi_value test_node_from_c_ServiceStats(napi_env env,
+                                         napi_callback_info info) {
+    service_stats_t stats = {
+        .transfers = 12,
+        .serviceCalls = 25,
+        .idle = true,
+        .elapsed_us = 12345,
+    };
+    napi_value result = node_from_c_ServiceStats(env, &stats);
+    return result; // Assert in TypeScript.
+}
+
+napi_value test_node_from_c_LatestValue(napi_env env,
+                                        napi_callback_info info) {
+    sh2_SensorValue_t sv = {
+        .sensorId = SH2_ACCELEROMETER,
+        .sequence = 7,
+        .status = 0x02,
+        .timestamp = 12345,
+        .un.accelerometer = {.x = 1.5f, .y = -2.25f, .z = 9.75f},
+    };
+    latest_table_store(&sv, 300);
+
+    latest_value_t latest;
+    if (!latest_table_load(SH2_ACCELEROMETER, &latest)) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Stored value wasn't found in the table.");
+        return NULL;
+    }
+    latest_table_reset();
+
+    napi_value result = node_from_c_LatestValue(env, &latest);
+    return result; // Assert in TypeScript.
+}
+
+napi_value test_node_from_c_SubscriberStats(napi_env env,
+                                            napi_callback_info info) {
+    fanout_options_t opts = {
+        .batch_size = 1,
+        .max_pending = 100,
+        .lag_policy = FANOUT_DROP_OLDEST,
+        .sensor_mask = 1ULL << SH2_ACCELEROMETER,
+    };
+    int id = fanout_subscribe(&opts);
+    if (id < 0) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't subscribe.");
+        return NULL;
+    }
+
+    // 150 accelerometer events and 150 filtered out gyro events.
+    sh2_SensorEvent_t ev = {0};
+    for (int i = 0; i < 300; i++) {
+        ev.reportId = i % 2 ? SH2_GYROSCOPE_CALIBRATED : SH2_ACCELEROMETER;
+        fanout_publish(&ev);
+    }
+    sh2_SensorEvent_t out[10];
+    fanout_take(id, out, 10);
+    fanout_set_paused(id, true);
+
+    fanout_stats_t stats;
+    fanout_stats(id, &stats);
+    fanout_reset();
+
+    // Filtered subscribers overrun by the ring: 100 accelerometer events,
+    // then 1100 gyro events, overwriting the first 176.
+    opts.max_pending = 0;
+    int accel_id = fanout_subscribe(&opts);
+    opts.sensor_mask = 1ULL << SH2_GYROSCOPE_CALIBRATED;
+    int gyro_id = fanout_subscribe(&opts);
+    for (int i = 0; i < 1200; i++) {
+        ev.reportId = i < 100 ? SH2_ACCELEROMETER : SH2_GYROSCOPE_CALIBRATED;
+        fanout_publish(&ev);
+    }
+    static sh2_SensorEvent_t overrun_out[FANOUT_RING_CAP + 1];
+    fanout_take(gyro_id, overrun_out, FANOUT_RING_CAP + 1);
+    fanout_stats_t accel_stats, gyro_stats;
+    fanout_stats(accel_id, &accel_stats);
+    fanout_stats(gyro_id, &gyro_stats);
+    fanout_reset();
+
+    napi_value result = node_from_c_SubscriberStats(env, &stats);
+    napi_value overrun;
+    napi_status status = napi_create_array_with_length(env, 2, &overrun);
+    status |= napi_set_element(
+        env, overrun, 0, node_from_c_SubscriberStats(env, &accel_stats));
+    status |= napi_set_element(
+        env, overrun, 1, node_from_c_SubscriberStats(env, &gyro_stats));
+    status |= napi_set_named_property(env, result, "overrun", overrun);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_CREATING_NAPI_VALUE,
+                         "Couldn't create the overrun stats.");
+        return NULL;
+    }
+    return result; // Assert in TypeScript.
+}
+
+napi_value test_node_from_c_SensorEvent_slab(napi_env env,
+                                             napi_callback_info info) {
+    sh2_SensorEvent_t ev1 = {.timestamp_uS = 1,
+                             .len = 3,
+                             .report = {1u, 2u, 3u},
+                             .reportId = SH2_GAME_ROTATION_VECTOR};
+    sh2_SensorEvent_t ev2 = {.timestamp_uS = 2,
+                             .len = 2,
+                             .report = {4u, 5u},
+                             .reportId = SH2_GAME_ROTATION_VECTOR};
+
+    set_report_storage(REPORT_STORAGE_SLAB);
+    napi_value node_ev1 = node_from_c_SensorEvent(env, &ev1);
+    napi_value node_ev2 = node_from_c_SensorEvent(env, &ev2);
+    set_report_storage(REPORT_STORAGE_BUFFER);
+    report_slab_reset(env);
+    if (node_ev1 == NULL || node_ev2 == NULL) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't convert events in slab mode.");
+        return NULL;
+    }
+
+    napi_value result;
+    napi_status status = napi_create_array_with_length(env, 2, &result);
+    status |= napi_set_element(env, result, 0, node_ev1);
+    status |= napi_set_element(env, result, 1, node_ev2);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't create result array.");
+        return NULL;
+    }
+    return result; // Assert in TypeScript.
+}
+
+napi_value test_node_from_c_SensorEvent_timestamps(napi_env env,
+                                                   napi_callback_info info) {
+    sh2_SensorEvent_t evs[3] = {
+        {.timestamp_uS = 1000000,
+         .len = 2,
+         .report = {1u, 2u},
+         .reportId = SH2_GAME_ROTATION_VECTOR},
+        {.timestamp_uS = 1002500,
+         .len = 2,
+         .report = {1u, 2u},
+         .reportId = SH2_GAME_ROTATION_VECTOR},
+        {.timestamp_uS = 0x0000000500000007ULL,
+         .len = 2,
+         .report = {1u, 2u},
+         .reportId = SH2_GAME_ROTATION_VECTOR},
+    };
+
+    napi_value node_evs[3];
+    set_timestamp_format(TIMESTAMP_FLOAT64);
+    node_evs[0] = node_from_c_SensorEvent(env, &evs[0]);
+    node_evs[1] = node_from_c_SensorEvent(env, &evs[1]);
+    set_timestamp_format(TIMESTAMP_HILO);
+    node_evs[2] = node_from_c_SensorEvent(env, &evs[2]);
+    set_timestamp_format(TIMESTAMP_BIGINT);
+
+    napi_value result;
+    napi_status status = napi_create_array_with_length(env, 3, &result);
+    for (uint32_t i = 0; i < 3; i++) {
+        if (node_evs[i] == NULL) {
+            napi_throw_error(env, ERROR_EXECUTING_TEST,
+                             "Couldn't convert events with timestamp formats.");
+            return NULL;
+        }
+        status |= napi_set_element(env, result, i, node_evs[i]);
+    }
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't create result array.");
+        return NULL;
+    }
+    return result; // Assert in TypeScript.
+}
+
+napi_value test_node_from_c_Metrics(napi_env env, napi_callback_info info) {
+    metrics_t metrics = {
+        .driver = {.rxInterruptedPayloads = 3, .txDiscards = 1,
+                   .unknownReportIds = 4},
+        .bus = {.transfers = 100, .idle_reads = 20, .read_errors = 2,
+                .read_bytes = 5000000000ULL},
+        .poll_overruns = 6,
+    };
+    napi_value result = node_from_c_Metrics(env, &metrics);
+    return result; // Assert in TypeScript.
+}
+
+napi_value test_clock_sync(napi_env env, napi_callback_info info) {
+    clock_sync_enable(true, CLOCK_SYNC_MAX_WINDOW);
+
+    // A 100 Hz sensor whose clock runs 50 ppm slow against the host, stamped
+    // with 100..200 us of interrupt latency and an occasional 5 ms stall.
+    uint32_t lcg = 12345;
+    double max_error = 0, raw_max_error = 0;
+    uint64_t prev = 0;
+    bool monotonic = true;
+    for (int n = 0; n < 400; n++) {
+        double t = 1e9 + n * 10000.5;
+        lcg = lcg * 1103515245u + 12345u;
+        double latency = 100 + (lcg >> 16) % 100;
+        if (n % 17 == 5) { latency += 5000; }
+        uint64_t raw = (uint64_t)(t + latency);
+
+        uint64_t out =
+            clock_sync_update(SH2_ACCELEROMETER, (uint8_t)n, raw, 10000);
+        monotonic = monotonic && out > prev;
+        prev = out;
+        if (n >= 300) {
+            // Against the least latency
+            max_error = fmax(max_error, fabs((double)out - (t + 100)));
+            raw_max_error = fmax(raw_max_error, fabs((double)raw - (t + 100)));
+        }
+    }
+
+    clock_sync_status_t sync;
+    bool found = clock_sync_status(SH2_ACCELEROMETER, &sync);
+    clock_sync_enable(false, CLOCK_SYNC_DEFAULT_WINDOW);
+    if (!found) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "No clock sync status.");
+        return NULL;
+    }
+
+    napi_value out = node_from_c_ClockSyncStatus(env, &sync);
+    if (out == NULL) { return NULL; }
+    napi_value v;
+    napi_status status = napi_create_double(env, max_error, &v);
+    status |= napi_set_named_property(env, out, "maxErrorMicros", v);
+    status |= napi_create_double(env, raw_max_error, &v);
+    status |= napi_set_named_property(env, out, "rawMaxErrorMicros", v);
+    status |= napi_get_boolean(env, monotonic, &v);
+    status |= napi_set_named_property(env, out, "monotonic", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_girv_ring(napi_env env, napi_callback_info info) {
+    size_t length = girv_ring_length(2);
+    void *data;
+    napi_value buffer, ring;
+    napi_status status = napi_create_arraybuffer(env, length * sizeof(double),
+                                                 &data, &buffer);
+    status |= napi_create_typedarray(env, napi_float64_array, length, buffer,
+                                     0, &ring);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't create ring.");
+        return NULL;
+    }
+    girv_ring_init(data, 2);
+
+    // Three reports into room for two; the third overwrites the first.
+    for (int n = 1; n <= 3; n++) {
+        sh2_SensorValue_t sv = {
+            .sensorId = SH2_GYRO_INTEGRATED_RV,
+            .un.gyroIntegratedRV = {.i = 0.5f * n, .real = 1.0f,
+                                    .angVelZ = -0.25f * n},
+        };
+        girv_ring_push(data, &sv, 1000 * n);
+    }
+    return ring; // Assert in TypeScript.
+}
+
+napi_value test_q_decode(napi_env env, napi_callback_info info) {
+    enum { STRIDE = 14, COUNT = 33 };
+    uint8_t src[STRIDE * COUNT];
+    float vector[4 * COUNT], scalar[4 * COUNT];
+
+    uint32_t seed = 1;
+    for (size_t i = 0; i < sizeof(src); i++) {
+        seed = seed * 1103515245 + 12345;
+        src[i] = seed >> 16;
+    }
+    // Known values in the first report: 1.0, -1.0, smallest and largest.
+    const uint8_t known[8] = {0x00, 0x40, 0x00, 0xC0, 0x00, 0x80, 0xFF, 0x7F};
+    memcpy(src, known, sizeof(known));
+
+    bool match = true;
+    for (uint8_t lanes = 1; lanes <= 5; lanes++) {
+        q_decode(src, STRIDE, lanes, 14, COUNT, vector);
+        q_decode_scalar(src, STRIDE, lanes, 14, COUNT, scalar);
+        match &= memcmp(vector, scalar, lanes * COUNT * sizeof(float)) == 0;
+    }
+    q_decode(src, STRIDE, 4, 14, COUNT, vector);
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_string_utf8(env, q_decode_impl(), NAPI_AUTO_LENGTH,
+                                      &v);
+    status |= napi_set_named_property(env, out, "impl", v);
+    status |= napi_get_boolean(env, match, &v);
+    status |= napi_set_named_property(env, out, "match", v);
+    status |= napi_create_array_with_length(env, 4, &v);
+    for (uint32_t i = 0; i < 4; i++) {
+        napi_value value;
+        status |= napi_create_double(env, vector[i], &value);
+        status |= napi_set_element(env, v, i, value);
+    }
+    status |= napi_set_named_property(env, out, "first", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_fast_euler(napi_env env, napi_callback_info info) {
+    enum { COUNT = 1000 };
+    static float quats[COUNT * 4], exact[COUNT * 3], fast[COUNT * 3];
+
+    // Random unit quaternions, and a few at gimbal lock and identity
+    uint32_t seed = 1;
+    for (size_t n = 0; n < COUNT; n++) {
+        float *q = &quats[n * 4];
+        float norm = 0;
+        for (int c = 0; c < 4; c++) {
+            seed = seed * 1103515245 + 12345;
+            q[c] = (float)(seed >> 8) / (1u << 23) - 1.0f;
+            norm += q[c] * q[c];
+        }
+        for (int c = 0; c < 4; c++) { q[c] /= sqrtf(norm); }
+    }
+    const float special[3][4] = {
+        {0, 0, 0, 1}, {(float)M_SQRT1_2, 0, 0, (float)M_SQRT1_2},
+        {-(float)M_SQRT1_2, 0, 0, (float)M_SQRT1_2}};
+    memcpy(quats, special, sizeof(special));
+
+    q_to_ypr_batch(quats, COUNT, EULER_EXACT, exact);
+    q_to_ypr_batch(quats, COUNT, EULER_FAST, fast);
+    double max_error = 0;
+    for (size_t n = 0; n < COUNT * 3; n++) {
+        double error = fabs(remainder(fast[n] - exact[n], 2 * M_PI));
+        if (error > max_error) { max_error = error; }
+    }
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_double(env, max_error, &v);
+    status |= napi_set_named_property(env, out, "maxError", v);
+    status |= napi_create_double(env, FAST_EULER_MAX_ERROR, &v);
+    status |= napi_set_named_property(env, out, "bound", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_recorder(napi_env env, napi_callback_info info) {
+    char path[] = "/tmp/bno08x_recorder_XXXXXX";
+    int fd = mkstemp(path);
+    uv_loop_t *loop;
+    if (fd < 0 || napi_get_uv_event_loop(env, &loop) != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't set up test.");
+        return NULL;
+    }
+    close(fd);
+
+    // Accelerometer only, room for two records
+    recorder_options_t options = {
+        .format = RECORDER_RAW,
+        .sensor_mask = 1ULL << SH2_ACCELEROMETER,
+        .capacity = 2,
+        .sync_interval_ms = 1000,
+    };
+    if (recorder_start(loop, path, &options) != 0) {
+        unlink(path);
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't start.");
+        return NULL;
+    }
+    uint8_t accel[10] = {SH2_ACCELEROMETER, 7, 0x02, 0, 0x00, 0x01};
+    uint8_t gyro[10] = {SH2_GYROSCOPE_CALIBRATED, 7, 0x03, 0};
+    sh2_SensorEventView_t view = {.timestamp_uS = 1000, .delay_uS = 50,
+                                  .len = 10, .reportId = SH2_ACCELEROMETER,
+                                  .report = accel};
+    recorder_append(&view, NULL);
+    view.reportId = SH2_GYROSCOPE_CALIBRATED; // Not recorded
+    view.report = gyro;
+    recorder_append(&view, NULL);
+    for (int n = 0; n < 2; n++) { // The second doesn't fit
+        accel[1]++;
+        view.timestamp_uS += 1000;
+        view.reportId = SH2_ACCELEROMETER;
+        view.report = accel;
+        recorder_append(&view, NULL);
+    }
+    recorder_stats_t stats;
+    int error = recorder_stop(&stats);
+
+    // Read it back
+    uint8_t header[RECORDER_HEADER_SIZE];
+    recorder_record_t records[2];
+    FILE *f = fopen(path, "rb");
+    long size = -1;
+    bool read = f != NULL &&
+                fread(header, sizeof(header), 1, f) == 1 &&
+                fread(records, sizeof(records), 1, f) == 1;
+    if (f != NULL) {
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+        fclose(f);
+    }
+    unlink(path);
+    if (error != 0 || !read) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Recording failed.");
+        return NULL;
+    }
+
+    // Header slot with a valid crc and the highest generation
+    recorder_header_t h = {0}, slot;
+    uint32_t valid_slots = 0;
+    for (int n = 0; n < 2; n++) {
+        memcpy(&slot, header + n * RECORDER_HEADER_SLOT_SIZE, sizeof(slot));
+        if (memcmp(slot.magic, RECORDER_MAGIC, sizeof(slot.magic)) != 0 ||
+            recorder_crc32(&slot, offsetof(recorder_header_t, crc)) !=
+                slot.crc) {
+            continue;
+        }
+        valid_slots++;
+        if (slot.generation > h.generation) { h = slot; }
+    }
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_int64(env, stats.records, &v);
+    status |= napi_set_named_property(env, out, "records", v);
+    status |= napi_create_int64(env, stats.dropped, &v);
+    status |= napi_set_named_property(env, out, "dropped", v);
+    status |= napi_create_int64(env, size, &v);
+    status |= napi_set_named_property(env, out, "fileSize", v);
+    status |= napi_create_uint32(env, valid_slots, &v);
+    status |= napi_set_named_property(env, out, "validSlots", v);
+    status |= napi_create_int64(env, h.committed, &v);
+    status |= napi_set_named_property(env, out, "committed", v);
+    status |= napi_get_boolean(env, h.flags & RECORDER_FLAG_CLOSED, &v);
+    status |= napi_set_named_property(env, out, "closed", v);
+    status |= napi_create_int64(env, h.start_monotonic_us, &v);
+    status |= napi_set_named_property(env, out, "startMonotonicMicros", v);
+    status |= napi_create_array_with_length(env, 2, &v);
+    for (uint32_t n = 0; n < 2; n++) {
+        napi_value record, value;
+        status |= napi_create_object(env, &record);
+        status |= napi_create_int64(env, records[n].timestamp_us, &value);
+        status |= napi_set_named_property(env, record, "timestamp", value);
+        status |= napi_create_uint32(env, records[n].sensor_id, &value);
+        status |= napi_set_named_property(env, record, "sensorId", value);
+        status |= napi_create_uint32(env, records[n].sequence, &value);
+        status |= napi_set_named_property(env, record, "sequence", value);
+        status |= napi_create_uint32(env, records[n].status, &value);
+        status |= napi_set_named_property(env, record, "status", value);
+        status |= napi_create_uint32(env, records[n].len, &value);
+        status |= napi_set_named_property(env, record, "len", value);
+        status |= napi_set_element(env, v, n, record);
+    }
+    status |= napi_set_named_property(env, out, "recordsRead", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_log_reader(napi_env env, napi_callback_info info) {
+    char path[] = "/tmp/bno08x_log_XXXXXX";
+    char idx_path[sizeof(path) + 4];
+    int fd = mkstemp(path);
+    uv_loop_t *loop;
+    if (fd < 0 || napi_get_uv_event_loop(env, &loop) != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't set up test.");
+        return NULL;
+    }
+    close(fd);
+    snprintf(idx_path, sizeof(idx_path), "%s.idx", path);
+
+    // 3000 accelerometer reports 1 ms apart, x = 1.0 (Q8), where every
+    // 100th is stamped 5 ms late, out of order with the next ones.
+    recorder_options_t options = {
+        .format = RECORDER_RAW,
+        .capacity = 3000,
+        .sync_interval_ms = 1000,
+    };
+    if (recorder_start(loop, path, &options) != 0) {
+        unlink(path);
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't start.");
+        return NULL;
+    }
+    uint8_t accel[10] = {SH2_ACCELEROMETER, 0, 0x03, 0, 0x00, 0x01};
+    sh2_SensorEventView_t view = {.len = 10,
+                                  .reportId = SH2_ACCELEROMETER,
+                                  .report = accel};
+    for (uint32_t n = 0; n < 3000; n++) {
+        accel[1] = n;
+        view.timestamp_uS = 1000 * (n + 1) + (n % 100 == 99 ? 5000 : 0);
+        recorder_append(&view, NULL);
+    }
+    recorder_stats_t stats;
+    recorder_stop(&stats);
+
+    log_reader_t log;
+    bool built = false, loaded = false;
+    int64_t seeks[3] = {-1, -1, -1};
+    float values[DECODED_VALUES_MAX] = {0};
+    uint8_t count = 0;
+    if (log_open(path, &log) == 0) {
+        built = !log.index_loaded;
+        log_close(&log);
+    }
+    if (log_open(path, &log) == 0) {
+        loaded = log.index_loaded;
+        // Record 1499 is stamped 1505000, so it's the first at or after
+        // both 1500500 and 1504000 although 1500 to 1503 are earlier.
+        seeks[0] = log_seek(&log, 1500500);
+        seeks[1] = log_seek(&log, 1504000);
+        seeks[2] = log_seek(&log, 10000000); // Past the end
+        count = log_record_values(&log, &log.records[0], values);
+        log_close(&log);
+    }
+    unlink(path);
+    unlink(idx_path);
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_get_boolean(env, built, &v);
+    status |= napi_set_named_property(env, out, "indexBuilt", v);
+    status |= napi_get_boolean(env, loaded, &v);
+    status |= napi_set_named_property(env, out, "indexLoaded", v);
+    status |= napi_create_array_with_length(env, 3, &v);
+    for (uint32_t n = 0; n < 3; n++) {
+        napi_value seek;
+        status |= napi_create_int64(env, seeks[n], &seek);
+        status |= napi_set_element(env, v, n, seek);
+    }
+    status |= napi_set_named_property(env, out, "seeks", v);
+    status |= napi_create_array_with_length(env, count, &v);
+    for (uint32_t n = 0; n < count; n++) {
+        napi_value value;
+        status |= napi_create_double(env, values[n], &value);
+        status |= napi_set_element(env, v, n, value);
+    }
+    status |= napi_set_named_property(env, out, "firstValues", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_log_replay_corrupt(napi_env env, napi_callback_info info) {
+    char path[] = "/tmp/bno08x_log_XXXXXX";
+    char idx_path[sizeof(path) + 4];
+    int fd = mkstemp(path);
+    uv_loop_t *loop;
+    if (fd < 0 || napi_get_uv_event_loop(env, &loop) != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't set up test.");
+        return NULL;
+    }
+    close(fd);
+    snprintf(idx_path, sizeof(idx_path), "%s.idx", path);
+
+    recorder_options_t options = {
+        .format = RECORDER_RAW,
+        .capacity = 4,
+        .sync_interval_ms = 1000,
+    };
+    if (recorder_start(loop, path, &options) != 0) {
+        unlink(path);
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't start.");
+        return NULL;
+    }
+    uint8_t accel[10] = {SH2_ACCELEROMETER, 0, 0x03, 0, 0x00, 0x01};
+    sh2_SensorEventView_t view = {.len = 10,
+                                  .reportId = SH2_ACCELEROMETER,
+                                  .report = accel};
+    for (uint32_t n = 0; n < 4; n++) {
+        view.timestamp_uS = 1000 * (n + 1);
+        recorder_append(&view, NULL);
+    }
+    recorder_stats_t stats;
+    recorder_stop(&stats);
+
+    // Corrupt the length of all but the first record: past the event's
+    // report, zero, and not the accelerometer's
+    const uint8_t lens[3] = {255, 0, 14};
+    fd = open(path, O_WRONLY);
+    bool corrupted = fd >= 0;
+    for (uint32_t n = 0; n < 3 && corrupted; n++) {
+        off_t at = RECORDER_HEADER_SIZE + (n + 1) * RECORDER_RECORD_SIZE +
+                   offsetof(recorder_record_t, len);
+        corrupted = pwrite(fd, &lens[n], 1, at) == 1;
+    }
+    if (fd >= 0) { close(fd); }
+
+    // Walk the records as replayLog(..) does
+    log_reader_t log;
+    uint32_t replayed = 0, decoded = 0;
+    bool opened = corrupted && log_open(path, &log) == 0;
+    if (opened) {
+        for (uint64_t n = 0; n < log.count; n++) {
+            sh2_SensorEventView_t record_view;
+            float values[DECODED_VALUES_MAX];
+            replayed += log_record_view(&log.records[n], &record_view);
+            decoded += log_report_values(&log.records[n], values) > 0;
+        }
+        log_close(&log);
+    }
+    unlink(path);
+    unlink(idx_path);
+    if (!opened) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't corrupt log.");
+        return NULL;
+    }
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_uint32(env, replayed, &v);
+    status |= napi_set_named_property(env, out, "replayed", v);
+    status |= napi_create_uint32(env, decoded, &v);
+    status |= napi_set_named_property(env, out, "decoded", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_stream_codec(napi_env env, napi_callback_info info) {
+    (void)info;
+    // 2000 rotation vector reports at 400 Hz with +-20 us of jitter and a
+    // slowly turning quaternion, one longer report and a delay change.
+    enum { COUNT = 2000 };
+    static recorder_record_t records[COUNT];
+    static uint8_t stream[COUNT * STREAM_MAX_RECORD + STREAM_HEADER_SIZE];
+    stream_encoder_t enc;
+    stream_encoder_init(&enc, SH2_ROTATION_VECTOR);
+    size_t size = 0, raw_size = 0;
+    for (uint32_t n = 0; n < COUNT; n++) {
+        recorder_record_t *rec = &records[n];
+        memset(rec, 0, sizeof(*rec));
+        rec->timestamp_us = 1000000 + 2500 * n + (n * 37) % 41 - 20;
+        rec->delay_us = n < 1000 ? 0 : 120;
+        rec->len = n == 1500 ? 15 : 14;
+        uint8_t *report = rec->payload.report;
+        report[0] = SH2_ROTATION_VECTOR;
+        report[1] = n;
+        report[2] = n < 100 ? 2 : 3;
+        double a = n * 0.002;
+        int16_t q[5] = {8192 * sin(a), 4915 * cos(a), 3276 * sin(0.7 * a),
+                        13107 * cos(a), 3000 + n % 3};
+        memcpy(&report[4], q, sizeof(q));
+        if (rec->len == 15) { report[14] = 0xAB; }
+        size += stream_encode(&enc, rec, &stream[size]);
+        raw_size += sizeof(rec->timestamp_us) + rec->len;
+    }
+
+    // Decode in 7 byte pieces, so records are cut off everywhere
+    stream_decoder_t dec;
+    stream_decoder_init(&dec);
+    uint32_t decoded = 0, mismatched = 0;
+    for (size_t off = 0; off < size; off += 7) {
+        size_t len = size - off < 7 ? size - off : 7;
+        const uint8_t *in = &stream[off];
+        while (len > 0) {
+            size_t used;
+            recorder_record_t rec;
+            stream_result_t result = stream_decode(&dec, in, len, &used, &rec);
+            if (result == STREAM_CORRUPT) { break; }
+            in += used;
+            len -= used;
+            if (result != STREAM_RECORD) { continue; }
+            const recorder_record_t *want = &records[decoded++];
+            mismatched += rec.timestamp_us != want->timestamp_us ||
+                          rec.delay_us != want->delay_us ||
+                          rec.len != want->len ||
+                          memcmp(rec.payload.report, want->payload.report,
+                                 want->len) != 0;
+        }
+    }
+
+    // A stream without the header
+    stream_decoder_init(&dec);
+    size_t used;
+    recorder_record_t rec;
+    bool corrupt = stream_decode(&dec, &stream[1], size - 1, &used, &rec) ==
+                   STREAM_CORRUPT;
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_uint32(env, decoded, &v);
+    status |= napi_set_named_property(env, out, "decoded", v);
+    status |= napi_create_uint32(env, mismatched, &v);
+    status |= napi_set_named_property(env, out, "mismatched", v);
+    status |= napi_create_double(env, (double)raw_size / size, &v);
+    status |= napi_set_named_property(env, out, "ratio", v);
+    status |= napi_get_boolean(env, corrupt, &v);
+    status |= napi_set_named_property(env, out, "corruptDetected", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_arrow_writer(napi_env env, napi_callback_info info) {
+    (void)info;
+    char path[] = "/tmp/bno08x_arrow_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't set up test.");
+        return NULL;
+    }
+    close(fd);
+
+    // 2500 rotation vectors in batches of 1000
+    arrow_writer_t w;
+    int error = arrow_open(&w, path, SH2_ROTATION_VECTOR, 1000);
+    for (uint32_t n = 0; n < 2500 && error == 0; n++) {
+        recorder_record_t rec = {.timestamp_us = 1000000 + 2500 * n,
+                                 .sequence = n,
+                                 .status = 3};
+        float values[DECODED_VALUES_MAX] = {n, 0.5f, -1, 2, 0.01f};
+        error = arrow_append(&w, &rec, values);
+    }
+    // The last 500 rows are written on close
+    arrow_block_t first = {0};
+    size_t batches = w.block_count;
+    if (batches > 0) { first = w.blocks[0]; }
+    if (error == 0) { error = arrow_close(&w); }
+
+    // The magic at both ends, and the first timestamp at the start of the
+    // first batch's body
+    char head[7] = {0}, tail[7] = {0};
+    int64_t timestamp = -1;
+    FILE *f = fopen(path, "rb");
+    if (f != NULL) {
+        if (fread(head, 1, 6, f) != 6 ||
+            fseek(f, first.offset + first.metadata_length, SEEK_SET) != 0 ||
+            fread(&timestamp, sizeof(timestamp), 1, f) != 1 ||
+            fseek(f, -6, SEEK_END) != 0 || fread(tail, 1, 6, f) != 6) {
+            error = EIO;
+        }
+        fclose(f);
+    }
+    unlink(path);
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_int32(env, error, &v);
+    status |= napi_set_named_property(env, out, "error", v);
+    status |= napi_create_string_utf8(env, head, NAPI_AUTO_LENGTH, &v);
+    status |= napi_set_named_property(env, out, "head", v);
+    status |= napi_create_string_utf8(env, tail, NAPI_AUTO_LENGTH, &v);
+    status |= napi_set_named_property(env, out, "tail", v);
+    status |= napi_create_int64(env, timestamp, &v);
+    status |= napi_set_named_property(env, out, "firstTimestamp", v);
+    status |= napi_create_uint32(env, batches, &v);
+    status |= napi_set_named_property(env, out, "batchesBeforeClose", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_history(napi_env env, napi_callback_info info) {
+    (void)info;
+    // 250 samples 1 ms apart with x = n in a history of 100
+    static double memory[2 * 100 * 3];
+    history_t h;
+    history_init(&h, memory, 100, 3);
+    for (uint32_t n = 0; n < 250; n++) {
+        float values[DECODED_VALUES_MAX] = {n, -1.0f * n, 0};
+        history_push(&h, 1000 * n, values);
+    }
+
+    uint64_t ranges[3][2];
+    history_last(&h, 10, &ranges[0][0], &ranges[0][1]);
+    history_window(&h, 205000, 215000, &ranges[1][0], &ranges[1][1]);
+    history_since(&h, 100, &ranges[2][0], &ranges[2][1]); // Overwritten
+
+    // Every retained sample in one piece, across the wrap
+    uint64_t first, end;
+    history_last(&h, 100, &first, &end);
+    const double *ts = h.timestamps + history_slot(&h, first);
+    const float *x = h.values + history_slot(&h, first);
+    const float *y = x + 2 * h.capacity;
+    bool contiguous = true;
+    for (uint64_t n = first; n < end; n++) {
+        contiguous &= ts[n - first] == 1000.0 * n && x[n - first] == n &&
+                      y[n - first] == -1.0f * n;
+    }
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    const char *names[3] = {"last", "window", "since"};
+    for (int q = 0; q < 3; q++) {
+        napi_value range;
+        status |= napi_create_array_with_length(env, 2, &range);
+        for (uint32_t i = 0; i < 2; i++) {
+            status |= napi_create_int64(env, ranges[q][i], &v);
+            status |= napi_set_element(env, range, i, v);
+        }
+        status |= napi_set_named_property(env, out, names[q], range);
+    }
+    status |= napi_get_boolean(env, contiguous, &v);
+    status |= napi_set_named_property(env, out, "contiguous", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_resampler(napi_env env, napi_callback_info info) {
+    (void)info;
+    // Accelerometer every 4 ms with x = t in ms, and a rotation vector every
+    // 10 ms turning about z at 10 mrad/ms, its sign flipped on every other
+    // sample. The rotation vector stops at 200 ms.
+    static resampler_t r;
+    const uint8_t ids[2] = {SH2_ACCELEROMETER, SH2_ROTATION_VECTOR};
+    resampler_init(&r, ids, 2, 5000, 20000);
+    for (uint64_t t = 1000; t <= 397000; t += 1000) {
+        float values[DECODED_VALUES_MAX] = {0};
+        if (t % 4000 == 1000) {
+            values[0] = t / 1000.0f;
+            resampler_push(&r, SH2_ACCELEROMETER, t, values);
+        }
+        if (t % 10000 == 2000 && t <= 202000) {
+            float half = t / 1000.0f * 0.01f / 2;
+            float sign = t % 20000 == 2000 ? 1.0f : -1.0f;
+            values[2] = sign * sinf(half);
+            values[3] = sign * cosf(half);
+            resampler_push(&r, SH2_ROTATION_VECTOR, t, values);
+        }
+    }
+
+    double accel_error = 0, angle_error = 0;
+    for (uint32_t f = 0; f < r.frames; f++) {
+        double t_ms = r.timestamps[f] / 1000;
+        const float *frame = r.values + f * r.stride;
+        accel_error = fmax(accel_error, fabs(frame[0] - t_ms));
+        // Held after the rotation vector stops
+        double expected = fmin(t_ms, 202) * 0.01;
+        const float *q = frame + r.streams[1].offset;
+        double angle = 2 * atan2(q[3] < 0 ? -q[2] : q[2], fabs(q[3]));
+        angle_error = fmax(angle_error, fabs(angle - expected));
+    }
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_uint32(env, r.frames, &v);
+    status |= napi_set_named_property(env, out, "frames", v);
+    status |= napi_create_double(env, r.frames ? r.timestamps[0] : 0, &v);
+    status |= napi_set_named_property(env, out, "firstTimestamp", v);
+    status |= napi_create_double(env, accel_error, &v);
+    status |= napi_set_named_property(env, out, "accelError", v);
+    status |= napi_create_double(env, angle_error, &v);
+    status |= napi_set_named_property(env, out, "angleError", v);
+    resampler_free(&r);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_stats(napi_env env, napi_callback_info info) {
+    (void)info;
+    // 1000 samples with x = n and y jumping around, into cumulative,
+    // tumbling and sliding statistics
+    stats_t windows[3];
+    stats_init(&windows[0], STATS_CUMULATIVE, 0, 2);
+    stats_init(&windows[1], STATS_TUMBLING, 300, 2);
+    stats_init(&windows[2], STATS_SLIDING, 100, 2);
+    float y[1000];
+    bool sliding_matches = true;
+    for (uint32_t n = 0; n < 1000; n++) {
+        y[n] = (float)((n * 37) % 101) - 50;
+        float values[DECODED_VALUES_MAX] = {n, y[n]};
+        for (int w = 0; w < 3; w++) { stats_push(&windows[w], n, values); }
+
+        // Sliding y against the retained samples
+        stats_value_t s[DECODED_VALUES_MAX];
+        uint64_t count = stats_snapshot(&windows[2], s);
+        uint32_t first = n + 1 - count;
+        double sum = 0, m2 = 0, min = INFINITY, max = -INFINITY;
+        for (uint32_t m = first; m <= n; m++) { sum += y[m]; }
+        for (uint32_t m = first; m <= n; m++) {
+            m2 += (y[m] - sum / count) * (y[m] - sum / count);
+            min = fmin(min, y[m]);
+            max = fmax(max, y[m]);
+        }
+        double variance = count > 1 ? m2 / (count - 1) : 0;
+        sliding_matches &= count == (n < 100 ? n + 1 : 100) &&
+                           fabs(s[1].mean - sum / count) < 1e-9 &&
+                           fabs(s[1].variance - variance) < 1e-6 &&
+                           s[1].min == min && s[1].max == max;
+    }
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    const char *names[3] = {"cumulative", "tumbling", "sliding"};
+    for (int w = 0; w < 3; w++) {
+        stats_value_t s[DECODED_VALUES_MAX];
+        uint64_t count = stats_snapshot(&windows[w], s);
+        stats_free(&windows[w]);
+        napi_value x;
+        status |= napi_create_object(env, &x);
+        status |= napi_create_int64(env, count, &v);
+        status |= napi_set_named_property(env, x, "count", v);
+        status |= napi_create_double(env, s[0].mean, &v);
+        status |= napi_set_named_property(env, x, "mean", v);
+        status |= napi_create_double(env, s[0].variance, &v);
+        status |= napi_set_named_property(env, x, "variance", v);
+        status |= napi_create_double(env, s[0].min, &v);
+        status |= napi_set_named_property(env, x, "min", v);
+        status |= napi_create_double(env, s[0].max, &v);
+        status |= napi_set_named_property(env, x, "max", v);
+        status |= napi_set_named_property(env, out, names[w], x);
+    }
+    status |= napi_get_boolean(env, sliding_matches, &v);
+    status |= napi_set_named_property(env, out, "slidingMatches", v);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+// Standard normal deviate from a xorshift generator
+static double gaussian(uint64_t *state) {
+    double u[2];
+    for (int n = 0; n < 2; n++) {
+        *state ^= *state << 13;
+        *state ^= *state >> 7;
+        *state ^= *state << 17;
+        u[n] = ((*state >> 11) + 0.5) / 9007199254740992.0;
+    }
+    return sqrt(-2 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+napi_value test_allan(napi_env env, napi_callback_info info) {
+    (void)info;
+    // 2^18 samples at 100 Hz: x is white noise of 0.05, so 0.005/sqrt(Hz),
+    // and y adds a bias walking at 0.0005/sqrt(s)
+    static allan_t a;
+    allan_init(&a, 16);
+    uint64_t random = 0x9E3779B97F4A7C15ULL;
+    double bias = 0;
+    for (uint32_t n = 0; n < 1u << 18; n++) {
+        bias += 0.0005 * sqrt(0.01) * gaussian(&random);
+        float values[DECODED_VALUES_MAX] = {
+            0.05 * gaussian(&random), 0.05 * gaussian(&random) + bias,
+            0.01 * gaussian(&random)};
+        allan_push(&a, 10000ULL * n, values);
+    }
+    allan_noise_t white, walk;
+    allan_noise(&a, 0, &white);
+    allan_noise(&a, 1, &walk);
+
+    napi_value out, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_double(env, allan_interval(&a), &v);
+    status |= napi_set_named_property(env, out, "interval", v);
+    status |= napi_create_double(env, allan_deviation(&a, 0, 0), &v);
+    status |= napi_set_named_property(env, out, "deviation", v);
+    status |= napi_create_double(env, white.noise_density, &v);
+    status |= napi_set_named_property(env, out, "noiseDensity", v);
+    status |= napi_create_double(env, white.bias_instability, &v);
+    status |= napi_set_named_property(env, out, "biasInstability", v);
+    status |= napi_create_double(env, white.rate_random_walk, &v);
+    status |= napi_set_named_property(env, out, "whiteRateRandomWalk", v);
+    status |= napi_create_double(env, walk.rate_random_walk, &v);
+    status |= napi_set_named_property(env, out, "rateRandomWalk", v);
+    // maxClusterSamples at and past the ends of its range
+    const uint32_t max_clusters[5] = {0, 1, 3, 1u << 20, (1u << 20) + 1};
+    napi_value levels;
+    status |= napi_create_array_with_length(env, 5, &levels);
+    for (uint32_t n = 0; n < 5; n++) {
+        status |= napi_create_uint32(env, allan_levels(max_clusters[n]), &v);
+        status |= napi_set_element(env, levels, n, v);
+    }
+    status |= napi_set_named_property(env, out, "levels", levels);
+    allan_free(&a);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_spectrum(napi_env env, napi_callback_info info) {
+    (void)info;
+    // 1024 samples at 400 Hz of x = 1 + 2 sin(2 pi 50 t), into Hann frames
+    // of 256 with half overlap, as spectra and as bands around 50 Hz
+    spectrum_t spectrum, bands;
+    const uint8_t lanes[1] = {0};
+    const float edges[4] = {0, 1, 40, 60};
+    spectrum_init(&spectrum, lanes, 1, 256, 128, SPECTRUM_HANN, NULL, 0);
+    spectrum_init(&bands, lanes, 1, 256, 128, SPECTRUM_HANN, edges, 3);
+    for (uint32_t n = 0; n < 1024; n++) {
+        float values[DECODED_VALUES_MAX] = {
+            1 + 2 * sin(2 * M_PI * 50 * n / 400.0)};
+        spectrum_push(&spectrum, 2500ULL * n, values);
+        spectrum_push(&bands, 2500ULL * n, values);
+    }
+
+    // Bin with the largest amplitude in the last frame, past DC
+    const float *last = spectrum.frames_out +
+                        (size_t)(spectrum.frames - 1) * spectrum.outputs;
+    uint32_t peak = 1;
+    for (uint32_t k = 1; k < spectrum.outputs; k++) {
+        if (last[k] > last[peak]) { peak = k; }
+    }
+
+    napi_value out, array, v;
+    napi_status status = napi_create_object(env, &out);
+    status |= napi_create_uint32(env, spectrum.frames, &v);
+    status |= napi_set_named_property(env, out, "frames", v);
+    status |= napi_create_double(env, spectrum.bin_hz[0], &v);
+    status |= napi_set_named_property(env, out, "binHz", v);
+    status |= napi_create_uint32(env, peak, &v);
+    status |= napi_set_named_property(env, out, "peakBin", v);
+    status |= napi_create_double(env, last[peak], &v);
+    status |= napi_set_named_property(env, out, "peakAmplitude", v);
+    status |= napi_create_double(env, last[0], &v);
+    status |= napi_set_named_property(env, out, "dc", v);
+    status |= napi_create_array_with_length(env, 3, &array);
+    for (uint32_t b = 0; b < 3; b++) {
+        status |= napi_create_double(env, bands.frames_out[b], &v);
+        status |= napi_set_element(env, array, b, v);
+    }
+    status |= napi_set_named_property(env, out, "bands", array);
+    spectrum_free(&spectrum);
+    spectrum_free(&bands);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+napi_value test_capture(napi_env env, napi_callback_info info) {
+    (void)info;
+    // Accelerometer at 1 kHz and gyro at 500 Hz captured 50 ms before to
+    // 20 ms after a tap at 500 ms, and an accelerometer spike at 800 ms
+    static capture_t c;
+    const uint8_t ids[2] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED};
+    capture_init(&c, ids, 2, 256, 50000, 20000);
+    c.trigger_mask = 1ULL << SH2_TAP_DETECTOR;
+    c.rules[0] = (capture_rule_t){SH2_ACCELEROMETER, CAPTURE_MAGNITUDE, 20,
+                                  NAN};
+    c.rule_count = 1;
+
+    uint32_t counts[2][2] = {{0}};
+    uint64_t triggers[2] = {0};
+    double first[2] = {0};
+    bool truncated = false;
+    uint32_t windows = 0;
+    for (uint64_t t = 1000; t <= 1000000 && windows < 2; t += 1000) {
+        float values[DECODED_VALUES_MAX] = {0, 0, t == 800000 ? 30 : 9.8f};
+        capture_push(&c, SH2_ACCELEROMETER, t, values);
+        if (t % 2000 == 0) {
+            capture_push(&c, SH2_GYROSCOPE_CALIBRATED, t, values);
+        }
+        if (t == 500000) { capture_push(&c, SH2_TAP_DETECTOR, t, values); }
+        if (c.ready) {
+            counts[windows][0] = c.rings[0].count;
+            counts[windows][1] = c.rings[1].count;
+            triggers[windows] = c.window_trigger_us;
+            first[windows] = c.rings[0].window_timestamps[0];
+            truncated |= c.truncated;
+            c.ready = false; // Taken
+            windows++;
+        }
+    }
+
+    napi_value out, array, v;
+    napi_status status = napi_create_object(env, &out);
+    const char *names[2] = {"tap", "spike"};
+    for (int w = 0; w < 2; w++) {
+        napi_value window;
+        status |= napi_create_object(env, &window);
+        status |= napi_create_int64(env, triggers[w], &v);
+        status |= napi_set_named_property(env, window, "trigger", v);
+        status |= napi_create_double(env, first[w], &v);
+        status |= napi_set_named_property(env, window, "first", v);
+        status |= napi_create_array_with_length(env, 2, &array);
+        for (uint32_t r = 0; r < 2; r++) {
+            status |= napi_create_uint32(env, counts[w][r], &v);
+            status |= napi_set_element(env, array, r, v);
+        }
+        status |= napi_set_named_property(env, window, "counts", array);
+        status |= napi_set_named_property(env, out, names[w], window);
+    }
+    status |= napi_get_boolean(env, truncated, &v);
+    status |= napi_set_named_property(env, out, "truncated", v);
+    capture_free(&c);
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
+
+// Stub HAL for test_service_until_idle. Each read reports the next state of
+// a script, and hands the driver an empty payload on a transfer.
+static const hal_read_state_t *drain_script;
+static uint32_t drain_script_len, drain_reads;
+static uint32_t drain_time_us;
+
+static int drain_hal_open(sh2_Hal_t *self) { return 0; }
+
+static void drain_hal_close(sh2_Hal_t *self) {}
+
+static int drain_hal_read(sh2_Hal_t *self, uint8_t *buffer, unsigned len,
+                          uint32_t *t_us) {
+    hal_read_state_t state = drain_reads < drain_script_len
+                                 ? drain_script[drain_reads]
+                                 : HAL_READ_IDLE;
+    drain_reads++;
+    hal_set_read_state(state);
+    if (state != HAL_READ_TRANSFER) { return 0; }
+    uint8_t transfer[5] = {5, 0, 6, (uint8_t)drain_reads, 0};
+    memcpy(buffer, transfer, sizeof(transfer));
+    *t_us = drain_time_us;
+    return sizeof(transfer);
+}
+
+static int drain_hal_write(sh2_Hal_t *self, uint8_t *buffer, unsigned len) {
+    return len;
+}
+
+// Jumps a second a call, so sh2_open(..) doesn't wait for the hub's reset.
+static uint32_t drain_hal_time_us(sh2_Hal_t *self) {
+    return drain_time_us += 1000000;
+}
+
+static service_stats_t drain(napi_env env, const void *owner,
+                             const hal_read_state_t *script, uint32_t len,
+                             uint32_t max_transfers) {
+    drain_script = script;
+    drain_script_len = len;
+    drain_reads = 0;
+    return service_until_idle(env, owner, max_transfers, 0);
+}
+
+napi_value test_service_until_idle(napi_env env, napi_callback_info info) {
+    static sh2_Hal_t hal = {.open = drain_hal_open,
+                            .close = drain_hal_close,
+                            .read = drain_hal_read,
+                            .write = drain_hal_write,
+                            .getTimeUs = drain_hal_time_us};
+    drain_script_len = 0;
+    if (sh2_open(&hal, NULL, NULL) != SH2_OK) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST, "Couldn't open stub.");
+        return NULL;
+    }
+
+    const hal_read_state_t script[] = {
+        HAL_READ_HEADER, HAL_READ_TRANSFER, HAL_READ_HEADER,
+        HAL_READ_TRANSFER, HAL_READ_HEADER, HAL_READ_TRANSFER,
+    };
+    const uint32_t len = sizeof(script) / sizeof(script[0]);
+    service_stats_t results[4];
+    results[0] = drain(env, NULL, script, len, 64);
+    results[1] = drain(env, NULL, script, len, 2);
+    // Another hub owner than the one draining, as if a callback reopened it
+    int other_owner;
+    results[2] = drain(env, &other_owner, script, len, 64);
+    // Closed, so the driver doesn't read. The state left from the last read
+    // isn't counted again.
+    sh2_close();
+    hal_set_read_state(HAL_READ_TRANSFER);
+    results[3] = drain(env, NULL, script, len, 64);
+
+    napi_value out;
+    napi_status status = napi_create_object(env, &out);
+    const char *names[4] = {"drained", "budget", "otherOwner", "closed"};
+    for (int n = 0; n < 4; n++) {
+        napi_value stats = node_from_c_ServiceStats(env, &results[n]);
+        status |= napi_set_named_property(env, out, names[n], stats);
+    }
+    if (status != napi_ok) {
+        napi_throw_error(env, ERROR_EXECUTING_TEST,
+                         "Couldn't set prop for out var");
+        return NULL;
+    }
+    return out; // Assert in TypeScript.
+}
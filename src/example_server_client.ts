@@ -11,13 +11,12 @@ export interface SensorData {
 export const sensorStream = new EventEmitter();
 
 let pollInterval: ReturnType<typeof setInterval>;
-const toMs = (us: bigint) => Number(us / 1000n);
 
 function callback(ev: any) {
     const data: SensorData = {
         type: SensorId[ev.reportId],
         values: {},
-        time: toMs(ev.timestampMicroseconds),
+        time: ev.timestampMicroseconds / 1000,
         delay: ev.delayMicroseconds / 1000,
     };
     switch (ev.reportId) {
@@ -52,7 +51,8 @@ export function startSensor(): void {
     const bus = process.env.BNO_BUS ? Number(process.env.BNO_BUS) : 1
     bindings.setI2CConfig(bus, 0x4b);
     bindings.open(() => { }, { cookie: {} });
-    bindings.setSensorCallback(callback, { cookie: {} });
+    bindings.setSensorCallback(callback, { cookie: {} },
+        { timestamp: 'float64' });
 
     const ON: SensorConfig = { alwaysOnEnabled: true, reportInterval_us: 20000 };
     const OFF: SensorConfig = { alwaysOnEnabled: false, reportInterval_us: 0 };
@@ -66,8 +66,9 @@ export function startSensor(): void {
     bindings.setSensorConfig(SensorId.SH2_ROTATION_VECTOR, ON);
     bindings.devOn();
 
+    // Drain everything the hub has queued, but don't hog the event loop.
     pollInterval = setInterval(() => {
-        bindings.service();
+        bindings.service({ maxTransfers: 64, maxMicros: 5000 });
     }, 100);
 }
 
@@ -0,0 +1,46 @@
+import { isMainThread, parentPort, Worker } from 'worker_threads'
+import { bindings, SensorConfig, SensorId } from '.'
+
+// Runs the sensor hub in a worker_thread so that servicing it never waits for
+// the main thread, which only receives the decoded values.
+
+const bus = process.env.BNO_BUS ? Number(process.env.BNO_BUS) : 1
+
+function worker(): void {
+    bindings.setI2CConfig(bus, 0x4b)
+    bindings.open(() => { }, { cookie: {} })
+    bindings.setSensorCallback((ev) => {
+        if (ev.reportId === SensorId.SH2_ROTATION_VECTOR) {
+            parentPort!.postMessage({
+                time: ev.timestampMicroseconds / 1000,
+                yaw: ev.yaw, pitch: ev.pitch, roll: ev.roll,
+            })
+        }
+    }, {}, { timestamp: 'float64' })
+
+    const ON: SensorConfig = { alwaysOnEnabled: true, reportInterval_us: 10000 }
+    bindings.setSensorConfig(SensorId.SH2_ROTATION_VECTOR, ON)
+    bindings.devOn()
+    bindings.usePolling()
+
+    parentPort!.on('message', (msg) => {
+        if (msg === 'stop') {
+            bindings.close()
+            parentPort!.close()
+        }
+    })
+}
+
+function main(): void {
+    const sensors = new Worker(__filename)
+    sensors.on('message', ({ time, yaw, pitch, roll }) => {
+        console.log(`ROT VECTOR, Yaw: ${yaw}, Pitch: ${pitch}, Roll: ${roll} -- Time: ${time}ms`)
+    })
+    setTimeout(() => sensors.postMessage('stop'), 5000)
+}
+
+if (isMainThread) {
+    main()
+} else {
+    worker()
+}
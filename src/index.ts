@@ -3,7 +3,18 @@ const binding = require('bindings')
 import {
     type SensorEvent, SensorCallback, SensorId, SensorConfig,
     AsyncEventId, AsyncEvent, ShtpEvent, SensorConfigResponse,
-    EventCallback, BNO08X
+    EventCallback, BNO08X, ServiceOptions, ServiceResult,
+    PollingOptions, InterruptOptions, LatestValue, SubscribeOptions,
+    SubscriberStats, SlabSensorEvent, SensorEventOf,
+    SensorCallbackOptions, Metrics, MetricsOptions, SensorCounts,
+    HubErrorRecord, ClockSyncOptions, ClockSyncStatus, GirvRingLayout,
+    FixedPointLayout, EulerMode, RecordingOptions, RecordingStats,
+    LogHandle, LogInfo, LogReadOptions, LogRange, ReplayOptions,
+    StreamDecoder, DecodedStream, ArrowExportOptions, ArrowExport,
+    HistoryRange, ResamplerOptions, ResamplerLayout, ResampledFrames,
+    StatsOptions, ValueStats, SensorStats, AllanVarianceOptions, AllanNoise,
+    AllanVariance, SpectrumOptions, SpectrumLayout, SpectrumFrames,
+    CaptureRule, CaptureOptions, CaptureLayout, CapturedWindow
 } from "./binding_types"
 
 export const bindings: BNO08X = binding('bno08x_native')
@@ -11,5 +22,16 @@ export {
     SensorEvent, SensorCallback, SensorId,
     SensorConfig, AsyncEventId, AsyncEvent,
     ShtpEvent, SensorConfigResponse, EventCallback,
-    BNO08X
+    BNO08X, ServiceOptions, ServiceResult, PollingOptions,
+    InterruptOptions, LatestValue, SubscribeOptions, SubscriberStats,
+    SlabSensorEvent, SensorEventOf, SensorCallbackOptions, Metrics,
+    MetricsOptions, SensorCounts, HubErrorRecord, ClockSyncOptions,
+    ClockSyncStatus, GirvRingLayout, FixedPointLayout,
+    EulerMode, RecordingOptions, RecordingStats, LogHandle, LogInfo,
+    LogReadOptions, LogRange, ReplayOptions, StreamDecoder, DecodedStream,
+    ArrowExportOptions, ArrowExport, HistoryRange, ResamplerOptions,
+    ResamplerLayout, ResampledFrames, StatsOptions, ValueStats, SensorStats,
+    AllanVarianceOptions, AllanNoise, AllanVariance, SpectrumOptions,
+    SpectrumLayout, SpectrumFrames, CaptureRule, CaptureOptions,
+    CaptureLayout, CapturedWindow
 }
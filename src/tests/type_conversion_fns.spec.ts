@@ -1,4 +1,4 @@
-import { AsyncEvent, AsyncEventId, SensorConfig, SensorConfigResponse, SensorEvent, SensorId, ShtpEvent } from '../binding_types';
+import { AsyncEvent, AsyncEventId, ClockSyncStatus, GirvRingLayout, LatestValue, Metrics, SensorConfig, SensorConfigResponse, SensorEvent, SensorId, ServiceResult, ShtpEvent, SlabSensorEvent, SubscriberStats } from '../binding_types';
 import { tests } from './test_loader';
 
 test('Converting SensorConfig from JavaScript object to C struct', () => {
@@ -53,10 +53,37 @@ test('Converting sh2_SensorEvent_t to JavaScript object', () => {
   expect(testObject.timestampMicroseconds).toStrictEqual(ts)
 })
 
+test('Converting SensorEvents with slab report storage', () => {
+  const [ev1, ev2]: SlabSensorEvent[] = tests.test_node_from_c_SensorEvent_slab()
+
+  expect(ev1.report).toBeInstanceOf(Uint8Array)
+  expect(Buffer.isBuffer(ev1.report)).toBe(false)
+  expect(Array.from(ev1.report)).toStrictEqual([1, 2, 3])
+  expect(Array.from(ev2.report)).toStrictEqual([4, 5])
+
+  // Both views share one slab.
+  expect(ev2.report.buffer).toBe(ev1.report.buffer)
+  expect(ev1.report.byteOffset).toBe(0)
+  expect(ev2.report.byteOffset).toBe(4)
+})
+
+test('Converting SensorEvents with float64 and hilo timestamps', () => {
+  const [first, second, hilo] = tests.test_node_from_c_SensorEvent_timestamps()
+
+  // float64 timestamps count from the first event of the session.
+  expect(first.timestampMicroseconds).toBe(0)
+  expect(second.timestampMicroseconds).toBe(2500)
+
+  expect(hilo.timestampMicroseconds).toBeUndefined()
+  expect(hilo.timestampMicrosecondsHi).toBe(5)
+  expect(hilo.timestampMicrosecondsLo).toBe(7)
+})
+
 test('Converting AsyncEvent to JavaScript object', () => {
   const testObject = tests.test_node_from_c_AsyncEvent()
-  const [withShtpEv, withSensorConfigResp]: AsyncEvent[] = [
-    testObject.withShtpEv, testObject.withSensorConfigResp]
+  const [withShtpEv, withSensorConfigResp, flushCompleted]: AsyncEvent[] = [
+    testObject.withShtpEv, testObject.withSensorConfigResp,
+    testObject.flushCompleted]
 
   console.log(withShtpEv)
 
@@ -66,4 +93,251 @@ test('Converting AsyncEvent to JavaScript object', () => {
   expect(withSensorConfigResp.eventId).toBe(AsyncEventId.GET_FEATURE_RESP)
   // SensorConfigResp has a test of its own. It not defined meaningfully.
   expect(withSensorConfigResp.sensorConfigResp).toBeDefined()
+
+  expect(flushCompleted.eventId).toBe(AsyncEventId.FLUSH_COMPLETED)
+  expect(flushCompleted.sensorId).toBe(SensorId.SH2_GYROSCOPE_CALIBRATED)
+  expect(flushCompleted.shtpEvent).toBeNull()
+})
+
+test('Converting service_stats_t to ServiceResult', () => {
+  const testObject: ServiceResult = tests.test_node_from_c_ServiceStats()
+
+  expect(testObject.transfers).toBe(12)
+  expect(testObject.serviceCalls).toBe(25)
+  expect(testObject.idle).toBe(true)
+  expect(testObject.elapsedMicros).toBe(12345)
+})
+
+test('Latest value table round trip to LatestValue', () => {
+  const testObject: LatestValue = tests.test_node_from_c_LatestValue()
+
+  expect(testObject.sensorId).toBe(SensorId.SH2_ACCELEROMETER)
+  expect(testObject.sequence).toBe(7)
+  expect(testObject.calibrationStatus).toBe(2)
+  expect(testObject.timestampMicroseconds).toStrictEqual(BigInt(12345))
+  expect(testObject.delayMicroseconds).toBe(300)
+  expect(testObject.x).toBe(1.5)
+  expect(testObject.y).toBe(-2.25)
+  expect(testObject.z).toBe(9.75)
+})
+
+test('Fan-out subscriber past maxPending to SubscriberStats', () => {
+  const result = tests.test_node_from_c_SubscriberStats()
+  const testObject: SubscriberStats = result
+
+  // 150 matching events, 100 kept by dropOldest, 10 taken.
+  expect(testObject.dropped).toBe(50)
+  expect(testObject.delivered).toBe(10)
+  expect(testObject.pending).toBe(90)
+  expect(testObject.paused).toBe(true)
+
+  // Wrapped past by the ring: the accelerometer subscriber lost all 100 of
+  // its events, the gyro one the first 76 of 1100 and took the rest.
+  const [accel, gyro]: SubscriberStats[] = result.overrun
+  expect(accel.dropped).toBe(100)
+  expect(accel.pending).toBe(0)
+  expect(gyro.dropped).toBe(76)
+  expect(gyro.delivered).toBe(1024)
+  expect(gyro.pending).toBe(0)
+})
+
+test('Converting metrics_t to Metrics', () => {
+  const testObject: Metrics = tests.test_node_from_c_Metrics()
+
+  expect(testObject.transport.rxInterruptedPayloads).toBe(3)
+  expect(testObject.transport.txDiscards).toBe(1)
+  expect(testObject.transport.rxBadChannel).toBe(0)
+  expect(testObject.driver.unknownReportIds).toBe(4)
+  expect(testObject.bus.transfers).toBe(100)
+  expect(testObject.bus.idleReads).toBe(20)
+  expect(testObject.bus.readErrors).toBe(2)
+  // Past 32 bits
+  expect(testObject.bus.readBytes).toBe(5000000000)
+  expect(testObject.host.pollOverruns).toBe(6)
+  expect(testObject.counts).toBeUndefined()
+  expect(testObject.errors).toBeUndefined()
+})
+
+test('Clock sync smooths a drifting, jittery report stream', () => {
+  const testObject = tests.test_clock_sync()
+  const sync: ClockSyncStatus = testObject
+
+  expect(sync.locked).toBe(true)
+  expect(sync.samples).toBe(128)
+  expect(sync.periodMicros).toBeCloseTo(10000.5, 0)
+  expect(Math.abs(sync.driftPpm - 50)).toBeLessThan(30)
+  // Latency stalls of 5 ms show in the original timestamps only.
+  expect(testObject.rawMaxErrorMicros).toBeGreaterThan(5000)
+  expect(testObject.maxErrorMicros).toBeLessThan(50)
+  expect(testObject.monotonic).toBe(true)
+})
+
+test('Gyro-integrated RV ring overwrites the oldest record', () => {
+  const ring: Float64Array = tests.test_girv_ring()
+  const record = (n: number) => GirvRingLayout.HEADER +
+    (n % ring[GirvRingLayout.CAPACITY]) * GirvRingLayout.RECORD
+
+  expect(ring[GirvRingLayout.WRITTEN]).toBe(3)
+  expect(ring[GirvRingLayout.CAPACITY]).toBe(2)
+  expect(ring.length).toBe(GirvRingLayout.HEADER + 2 * GirvRingLayout.RECORD)
+
+  // Records 1 and 2 (counting from 0); record 0 was overwritten.
+  expect(Array.from(ring.subarray(record(1), record(1) + GirvRingLayout.RECORD)))
+    .toStrictEqual([2000, 1, 0, 0, 1, 0, 0, -0.5])
+  expect(Array.from(ring.subarray(record(2), record(2) + GirvRingLayout.RECORD)))
+    .toStrictEqual([3000, 1.5, 0, 0, 1, 0, 0, -0.75])
+})
+
+test('Q-format decode matches the scalar loop', () => {
+  const decoded = tests.test_q_decode()
+
+  expect(['neon', 'sse2', 'avx2', 'scalar']).toContain(decoded.impl)
+  expect(decoded.match).toBe(true)
+  expect(decoded.first).toStrictEqual([1, -1, -2, 32767 / 16384])
+})
+
+test('Fast Euler angles stay within their documented error', () => {
+  const { maxError, bound } = tests.test_fast_euler()
+
+  expect(maxError).toBeGreaterThan(0)
+  expect(maxError).toBeLessThanOrEqual(bound)
+})
+
+test('Recorder writes fixed records and a committed header', () => {
+  const recording = tests.test_recorder()
+
+  expect(recording.records).toBe(2)
+  expect(recording.dropped).toBe(1)
+  // Trimmed to the header page and two 80 byte records
+  expect(recording.fileSize).toBe(4096 + 2 * 80)
+  expect(recording.validSlots).toBe(2)
+  expect(recording.committed).toBe(2)
+  expect(recording.closed).toBe(true)
+  // In the timestamps' clock, from the first record
+  expect(recording.startMonotonicMicros).toBe(1000)
+  expect(recording.recordsRead).toStrictEqual([
+    { timestamp: 1000, sensorId: 1, sequence: 7, status: 2, len: 10 },
+    { timestamp: 2000, sensorId: 1, sequence: 8, status: 2, len: 10 },
+  ])
+})
+
+test('Log reader seeks by time through its saved index', () => {
+  const log = tests.test_log_reader()
+
+  expect(log.indexBuilt).toBe(true)
+  expect(log.indexLoaded).toBe(true)
+  expect(log.seeks).toStrictEqual([1499, 1499, 3000])
+  expect(log.firstValues).toStrictEqual([1, 0, 0])
+})
+
+test('Log records with a corrupt length are dropped from replay', () => {
+  const log = tests.test_log_replay_corrupt()
+
+  // Only the first record kept the accelerometer report's length
+  expect(log.replayed).toBe(1)
+  expect(log.decoded).toBe(1)
+})
+
+test('Stream codec round trips reports split anywhere', () => {
+  const stream = tests.test_stream_codec()
+
+  expect(stream.decoded).toBe(2000)
+  expect(stream.mismatched).toBe(0)
+  expect(stream.ratio).toBeGreaterThan(3)
+  expect(stream.corruptDetected).toBe(true)
+})
+
+// This checks the framing only. To check a file's contents against a
+// reference reader, export a recording with exportLogToArrow(..) and read
+// it with pyarrow, installed outside the repo:
+//   pyarrow.ipc.open_file(path).read_all().validate(full=True)
+test('Arrow writer frames the file and its record batches', () => {
+  const arrow = tests.test_arrow_writer()
+
+  expect(arrow.error).toBe(0)
+  expect(arrow.head).toBe('ARROW1')
+  expect(arrow.tail).toBe('ARROW1')
+  expect(arrow.batchesBeforeClose).toBe(2)
+  expect(arrow.firstTimestamp).toBe(1000000)
+})
+
+test('History queries return ranges of retained samples in one piece', () => {
+  const history = tests.test_history()
+
+  expect(history.last).toStrictEqual([240, 250])
+  expect(history.window).toStrictEqual([205, 216])
+  expect(history.since).toStrictEqual([150, 250])
+  expect(history.contiguous).toBe(true)
+})
+
+test('Resampler aligns a vector and a quaternion to one grid', () => {
+  const resampled = tests.test_resampler()
+
+  expect(resampled.frames).toBe(75)
+  expect(resampled.firstTimestamp).toBe(5000)
+  expect(resampled.accelError).toBeLessThan(1e-4)
+  expect(resampled.angleError).toBeLessThan(1e-5)
+})
+
+test('Statistics of cumulative, tumbling and sliding windows', () => {
+  const stats = tests.test_stats()
+
+  expect(stats.cumulative).toMatchObject({ count: 1000, min: 0, max: 999 })
+  expect(stats.cumulative.mean).toBeCloseTo(499.5)
+  expect(stats.cumulative.variance).toBeCloseTo(83416.667, 2)
+  expect(stats.tumbling).toMatchObject({ count: 300, min: 600, max: 899 })
+  expect(stats.tumbling.mean).toBeCloseTo(749.5)
+  expect(stats.sliding).toMatchObject({ count: 100, min: 900, max: 999 })
+  expect(stats.sliding.variance).toBeCloseTo(841.667, 2)
+  expect(stats.slidingMatches).toBe(true)
+})
+
+test('Allan variance recovers white noise and bias random walk', () => {
+  const allan = tests.test_allan()
+
+  expect(allan.interval).toBeCloseTo(0.01)
+  expect(allan.deviation).toBeCloseTo(0.05, 2)
+  expect(allan.noiseDensity).toBeCloseTo(0.005, 3)
+  expect(allan.biasInstability).toBeLessThan(0.001)
+  expect(allan.whiteRateRandomWalk).toBeNaN()
+  expect(allan.rateRandomWalk).toBeGreaterThan(0.00025)
+  expect(allan.rateRandomWalk).toBeLessThan(0.001)
+  // maxClusterSamples 0, 1, 3, 2^20 and 2^20 + 1; 0 levels is rejected
+  expect(allan.levels).toStrictEqual([0, 1, 2, 21, 0])
+})
+
+test('Spectrum of a sinusoid peaks at its frequency and amplitude', () => {
+  const spectrum = tests.test_spectrum()
+
+  expect(spectrum.frames).toBe(7)
+  expect(spectrum.binHz).toBeCloseTo(1.5625)
+  expect(spectrum.peakBin).toBe(32)
+  expect(spectrum.peakAmplitude).toBeCloseTo(2, 3)
+  expect(spectrum.dc).toBeCloseTo(1, 3)
+  // The mean's square, across the two low bands, and the sinusoid's
+  expect(spectrum.bands[0] + spectrum.bands[1]).toBeCloseTo(1, 3)
+  expect(spectrum.bands[2]).toBeCloseTo(2, 3)
+})
+
+test('Capture keeps the window around detector and threshold triggers', () => {
+  const capture = tests.test_capture()
+
+  expect(capture.tap).toStrictEqual(
+    { trigger: 500000, first: 450000, counts: [71, 36] })
+  expect(capture.spike).toStrictEqual(
+    { trigger: 800000, first: 750000, counts: [71, 36] })
+  expect(capture.truncated).toBe(false)
+})
+
+test('Draining stops when idle, out of budget, or the hub goes away', () => {
+  const drain = tests.test_service_until_idle()
+
+  expect(drain.drained).toMatchObject(
+    { transfers: 3, serviceCalls: 7, idle: true })
+  expect(drain.budget).toMatchObject(
+    { transfers: 2, serviceCalls: 4, idle: false })
+  expect(drain.otherOwner).toMatchObject(
+    { transfers: 0, serviceCalls: 1, idle: false })
+  expect(drain.closed).toMatchObject(
+    { transfers: 0, serviceCalls: 1, idle: false })
 })